@@ -15,9 +15,13 @@
 #define CALLBACKLIST_H_588722158669
 
 #include "eventpolicies.h"
+#include "internal/slotcallbacklist_i.h"
+#include "internal/cowcallbacklist_i.h"
+#include "internal/nodepool_i.h"
 
 #include <functional>
 #include <mutex>
+#include <vector>
 #include <cassert>
 
 namespace eventpp {
@@ -57,19 +61,22 @@ private:
 	struct Node;
 	using NodePtr = std::shared_ptr<Node>;
 
-	struct Node
+	struct Node : public std::enable_shared_from_this<Node>
 	{
 		using Counter = unsigned int;
 
-		Node(const Callback_ & callback, const Counter counter)
-			: callback(callback), counter(counter)
+		template <typename C>
+		Node(C && callback, const Counter counter)
+			: previous(), next(), rawNext(nullptr), callback(std::forward<C>(callback)), counter(counter)
 		{
 		}
 
 		NodePtr previous;
 		NodePtr next;
+		// Mirror of next.get(), it's written under the mutex and read by the invoking without lock.
+		typename Threading::template Atomic<Node *> rawNext;
 		Callback_ callback;
-		Counter counter;
+		typename Threading::template Atomic<Counter> counter;
 	};
 
 	class Handle_ : public std::weak_ptr<Node>
@@ -85,11 +92,77 @@ private:
 		}
 	};
 
+	using NodeFactory = internal_::NodeFactory<
+		Node,
+		Threading,
+		typename SelectNodeAllocation<Policies, HasTypeNodeAllocation<Policies>::value>::Type
+	>;
+
 	using Counter = typename Node::Counter;
 	enum : Counter {
 		removedCounter = 0
 	};
 
+	using Epoch = unsigned int;
+
+	struct RetiredNode
+	{
+		NodePtr node;
+		Epoch epoch;
+	};
+
+	// The invoking walks the list via the raw pointers without locking the mutex
+	// or touching any shared_ptr reference counter.
+	// The nodes are reclaimed by epochs. An invoking enters the current epoch by
+	// increasing the reader count of the epoch parity. A removed node is retired
+	// with the epoch it's removed in, and freed once the epoch advanced twice.
+	// The epoch only advances when no invoking is left in the previous epoch,
+	// so no invoking can still see a freed node, and a continuous stream of
+	// overlapping invokings can't keep the retired nodes alive forever, only
+	// an invoking that runs for a long time delays the reclamation.
+	// The mutex is only locked when an invoking leaves and it's the last one
+	// in its epoch while there are retired nodes, to free the nodes.
+	class InvokingGuard
+	{
+	public:
+		explicit InvokingGuard(const CallbackListBase & callbackList)
+			: callbackList(callbackList), node(nullptr), counter(0), epoch(0), started(false)
+		{
+			epoch = callbackList.doEnterEpoch();
+			counter = callbackList.currentCounter.load(std::memory_order_acquire);
+			node = callbackList.rawHead.load(std::memory_order_acquire);
+		}
+
+		~InvokingGuard()
+		{
+			callbackList.doLeaveEpoch(epoch);
+		}
+
+		// The next node is read after the current node is invoked, so the nodes
+		// appended by the current callback can be seen when the counter overflows.
+		Node * nextNode() {
+			if(node != nullptr && started) {
+				node = node->rawNext.load(std::memory_order_acquire);
+			}
+			started = true;
+			while(node != nullptr) {
+				const Counter nodeCounter = node->counter.load(std::memory_order_relaxed);
+				if(nodeCounter != removedCounter && counter >= nodeCounter) {
+					break;
+				}
+				node = node->rawNext.load(std::memory_order_acquire);
+			}
+			return node;
+		}
+
+	private:
+		const CallbackListBase & callbackList;
+		Node * node;
+		Counter counter;
+		Epoch epoch;
+		bool started;
+	};
+
 public:
 	using Callback = Callback_;
 	using Handle = Handle_;
@@ -100,9 +173,16 @@ public:
 		:
 			head(),
 			tail(),
+			rawHead(nullptr),
 			mutex(),
-			currentCounter(0)
+			currentCounter(0),
+			epoch(0),
+			retiredList(),
+			hasRetiredNodes(false),
+			nodeFactory()
 	{
+		readerCounts[0].store(0);
+		readerCounts[1].store(0);
 	}
 
 	CallbackListBase(const CallbackListBase & other)
@@ -133,6 +213,8 @@ public:
 
 			head = std::move(other.head);
 			tail = std::move(other.tail);
+			rawHead.store(head.get(), std::memory_order_release);
+			other.rawHead.store(nullptr, std::memory_order_release);
 			currentCounter = other.currentCounter.load();
 		}
 		return *this;
@@ -149,6 +231,9 @@ public:
 		
 		swap(head, other.head);
 		swap(tail, other.tail);
+		nodeFactory.swap(other.nodeFactory);
+		rawHead.store(head.get(), std::memory_order_release);
+		other.rawHead.store(other.head.get(), std::memory_order_release);
 
 		const auto value = currentCounter.load();
 		currentCounter.exchange(other.currentCounter.load());
@@ -157,11 +242,10 @@ public:
 
 	bool empty() const {
 		// Don't lock the mutex for performance reason.
-		// !head still works even when the underlying raw pointer is garbled (for other thread is writting to head)
 		// And empty() doesn't guarantee the list is still empty after the function returned.
 		//std::lock_guard<Mutex> lockGuard(mutex);
 
-		return ! head;
+		return rawHead.load(std::memory_order_acquire) == nullptr;
 	}
 
 	operator bool() const {
@@ -170,59 +254,32 @@ public:
 
 	Handle append(const Callback & callback)
 	{
-		NodePtr node(doAllocateNode(callback));
-
-		std::lock_guard<Mutex> lockGuard(mutex);
-
-		if(head) {
-			node->previous = tail;
-			tail->next = node;
-			tail = node;
-		}
-		else {
-			head = node;
-			tail = node;
-		}
+		return doAppend(doAllocateNode(callback));
+	}
 
-		return Handle(node);
+	Handle append(Callback && callback)
+	{
+		return doAppend(doAllocateNode(std::move(callback)));
 	}
 
 	Handle prepend(const Callback & callback)
 	{
-		NodePtr node(doAllocateNode(callback));
-
-		std::lock_guard<Mutex> lockGuard(mutex);
-
-		if(head) {
-			node->next = head;
-			head->previous = node;
-			head = node;
-		}
-		else {
-			head = node;
-			tail = node;
-		}
+		return doPrepend(doAllocateNode(callback));
+	}
 
-		return Handle(node);
+	Handle prepend(Callback && callback)
+	{
+		return doPrepend(doAllocateNode(std::move(callback)));
 	}
 
 	Handle insert(const Callback & callback, const Handle & before)
 	{
-		// Disable this assertion because it's too slow in debug mode.
-		//assert(before.expired() || ownsHandle(before));
-
-		NodePtr beforeNode = before.lock();
-		if(beforeNode) {
-			NodePtr node(doAllocateNode(callback));
-
-			std::lock_guard<Mutex> lockGuard(mutex);
-
-			doInsert(node, beforeNode);
-
-			return Handle(node);
-		}
+		return doInsertCallback(callback, before);
+	}
 
-		return append(callback);
+	Handle insert(Callback && callback, const Handle & before)
+	{
+		return doInsertCallback(std::move(callback), before);
 	}
 
 	bool remove(const Handle & handle)
@@ -261,7 +318,7 @@ public:
 	template <typename Func>
 	void forEach(Func && func) const
 	{
-		doForEachIf([&func, this](NodePtr & node) -> bool {
+		doForEachIf([&func, this](Node * node) -> bool {
 			doForEachInvoke<void>(func, node);
 			return true;
 		});
@@ -270,7 +327,7 @@ public:
 	template <typename Func>
 	bool forEachIf(Func && func) const
 	{
-		return doForEachIf([&func, this](NodePtr & node) -> bool {
+		return doForEachIf([&func, this](Node * node) -> bool {
 			return doForEachInvoke<bool>(func, node);
 		});
 	}
@@ -296,54 +353,82 @@ public:
 	// We don't use the patch as main code because the patch generates longer code, and duplicated with doForEachIf.
 	void operator() (Args ...args) const
 	{
-		NodePtr node;
+		InvokingGuard guard(*this);
+		while(Node * node = guard.nextNode()) {
+			node->callback(args...);
+			if(! CanContinueInvoking::canContinueInvoking(args...)) {
+				break;
+			}
+		}
+	}
+#endif
 
-		{
-			std::lock_guard<Mutex> lockGuard(mutex);
-			node = head;
+private:
+	Handle doAppend(NodePtr node)
+	{
+		std::lock_guard<Mutex> lockGuard(mutex);
+
+		if(head) {
+			node->previous = tail;
+			tail->next = node;
+			tail->rawNext.store(node.get(), std::memory_order_release);
+			tail = node;
+		}
+		else {
+			head = node;
+			tail = node;
+			rawHead.store(node.get(), std::memory_order_release);
 		}
 
-		const Counter counter = currentCounter.load(std::memory_order_acquire);
+		return Handle(node);
+	}
 
-		while(node) {
-			if(node->counter != removedCounter && counter >= node->counter) {
-				node->callback(args...);
-				if(! CanContinueInvoking::canContinueInvoking(args...)) {
-					break;
-				}
-			}
+	Handle doPrepend(NodePtr node)
+	{
+		std::lock_guard<Mutex> lockGuard(mutex);
 
-			{
-				std::lock_guard<Mutex> lockGuard(mutex);
-				node = node->next;
-			}
+		if(head) {
+			node->next = head;
+			node->rawNext.store(head.get(), std::memory_order_relaxed);
+			head->previous = node;
+			head = node;
+		}
+		else {
+			head = node;
+			tail = node;
 		}
+		rawHead.store(node.get(), std::memory_order_release);
+
+		return Handle(node);
 	}
-#endif
 
-private:
-	template <typename F>
-	bool doForEachIf(F && f) const
+	template <typename C>
+	Handle doInsertCallback(C && callback, const Handle & before)
 	{
-		NodePtr node;
+		// Disable this assertion because it's too slow in debug mode.
+		//assert(before.expired() || ownsHandle(before));
+
+		NodePtr beforeNode = before.lock();
+		if(beforeNode) {
+			NodePtr node(doAllocateNode(std::forward<C>(callback)));
 
-		{
 			std::lock_guard<Mutex> lockGuard(mutex);
-			node = head;
-		}
 
-		const Counter counter = currentCounter.load(std::memory_order_acquire);
+			doInsert(node, beforeNode);
 
-		while(node) {
-			if(node->counter != removedCounter && counter >= node->counter) {
-				if(! f(node)) {
-					return false;
-				}
-			}
+			return Handle(node);
+		}
 
-			{
-				std::lock_guard<Mutex> lockGuard(mutex);
-				node = node->next;
+		return doAppend(doAllocateNode(std::forward<C>(callback)));
+	}
+
+	template <typename F>
+	bool doForEachIf(F && f) const
+	{
+		InvokingGuard guard(*this);
+		while(Node * node = guard.nextNode()) {
+			if(! f(node)) {
+				return false;
 			}
 		}
 
@@ -351,14 +436,14 @@ private:
 	}
 
 	template <typename RT, typename Func>
-	auto doForEachInvoke(Func && func, NodePtr & node) const
+	auto doForEachInvoke(Func && func, Node * node) const
 		-> typename std::enable_if<CanInvoke<Func, Handle, Callback &>::value, RT>::type
 	{
-		return func(Handle(node), node->callback);
+		return func(Handle(node->shared_from_this()), node->callback);
 	}
 
 	template <typename RT, typename Func>
-	auto doForEachInvoke(Func && func, NodePtr & node) const
+	auto doForEachInvoke(Func && func, Node * node) const
 		-> typename std::enable_if<CanInvoke<Func, Callback &>::value, RT>::type
 	{
 		return func(node->callback);
@@ -368,19 +453,23 @@ private:
 	{
 		node->previous = beforeNode->previous;
 		node->next = beforeNode;
+		node->rawNext.store(beforeNode.get(), std::memory_order_relaxed);
 		if(beforeNode->previous) {
 			beforeNode->previous->next = node;
+			beforeNode->previous->rawNext.store(node.get(), std::memory_order_release);
 		}
 		beforeNode->previous = node;
 
 		if(beforeNode == head) {
 			head = node;
+			rawHead.store(node.get(), std::memory_order_release);
 		}
 	}
 	
-	NodePtr doAllocateNode(const Callback & callback)
+	template <typename C>
+	NodePtr doAllocateNode(C && callback)
 	{
-		return std::make_shared<Node>(callback, getNextCounter());
+		return nodeFactory.allocate(mutex, std::forward<C>(callback), getNextCounter());
 	}
 	
 	void doFreeNode(NodePtr & node)
@@ -390,15 +479,21 @@ private:
 		}
 		if(node->previous) {
 			node->previous->next = node->next;
+			node->previous->rawNext.store(node->next.get(), std::memory_order_release);
 		}
 
 		// Mark it as deleted, this must be before the assignment of head and tail below,
 		// because node can be a reference to head or tail, and after the assignment, node
 		// can be null pointer.
-		node->counter = removedCounter;
+		node->counter.store(removedCounter, std::memory_order_relaxed);
+
+		// An invoking may still hold the raw pointer, keep the node alive until the epoch advanced twice.
+		retiredList.push_back(RetiredNode { node, epoch.load(std::memory_order_relaxed) });
+		hasRetiredNodes.store(true, std::memory_order_release);
 
 		if(head == node) {
 			head = node->next;
+			rawHead.store(head.get(), std::memory_order_release);
 		}
 		if(tail == node) {
 			tail = node->previous;
@@ -406,18 +501,73 @@ private:
 
 		// don't modify node->previous or node->next
 		// because node may be still used in a loop.
+
+		doFreeRetiredNodes();
+	}
+
+	Epoch doEnterEpoch() const
+	{
+		for(;;) {
+			const Epoch currentEpoch = epoch.load();
+			++readerCounts[currentEpoch & 1];
+			// The epoch may advance between the load and the increment,
+			// then the reader count of a stale epoch was increased, try again.
+			if(epoch.load() == currentEpoch) {
+				return currentEpoch;
+			}
+			--readerCounts[currentEpoch & 1];
+		}
+	}
+
+	void doLeaveEpoch(const Epoch readerEpoch) const
+	{
+		if(--readerCounts[readerEpoch & 1] == 0 && hasRetiredNodes.load(std::memory_order_acquire)) {
+			std::lock_guard<Mutex> lockGuard(mutex);
+			const_cast<CallbackListBase *>(this)->doFreeRetiredNodes();
+		}
+	}
+
+	// The mutex must be locked.
+	void doFreeRetiredNodes()
+	{
+		if(retiredList.empty()) {
+			return;
+		}
+
+		// Advance at most twice, each time only when no invoking is left in the previous epoch.
+		Epoch currentEpoch = epoch.load();
+		for(int i = 0; i < 2 && readerCounts[(currentEpoch + 1) & 1].load() == 0; ++i) {
+			++currentEpoch;
+			epoch.store(currentEpoch);
+		}
+
+		// The nodes are retired in the order of the epochs.
+		auto it = retiredList.begin();
+		while(it != retiredList.end() && currentEpoch - it->epoch >= 2) {
+			// Break the links, the nodes removed by doFreeAllNodes link to each other.
+			it->node->previous.reset();
+			it->node->next.reset();
+			++it;
+		}
+		retiredList.erase(retiredList.begin(), it);
+		hasRetiredNodes.store(! retiredList.empty(), std::memory_order_release);
 	}
 
 	void doFreeAllNodes() {
+		// An invoking may still walk the nodes, retire them instead of freeing them.
+		const Epoch currentEpoch = epoch.load(std::memory_order_relaxed);
 		NodePtr node = head;
 		head.reset();
+		tail.reset();
+		rawHead.store(nullptr, std::memory_order_release);
 		while(node) {
-			NodePtr next = node->next;
-			node->previous.reset();
-			node->next.reset();
-			node = next;
+			node->counter.store(removedCounter, std::memory_order_relaxed);
+			retiredList.push_back(RetiredNode { node, currentEpoch });
+			node = node->next;
 		}
-		node.reset();
+		hasRetiredNodes.store(! retiredList.empty(), std::memory_order_release);
+
+		doFreeRetiredNodes();
 	}
 
 	Counter getNextCounter()
@@ -428,7 +578,7 @@ private:
 				std::lock_guard<Mutex> lockGuard(mutex);
 				NodePtr node = head;
 				while(node) {
-					node->counter = 1;
+					node->counter.store(1, std::memory_order_relaxed);
 					node = node->next;
 				}
 			}
@@ -443,12 +593,13 @@ private:
 		NodePtr node;
 		const Counter counter = getNextCounter();
 		while(fromNode) {
-			const NodePtr nextNode(std::make_shared<Node>(fromNode->callback, counter));
+			const NodePtr nextNode(nodeFactory.allocate(mutex, fromNode->callback, counter));
 
 			nextNode->previous = node;
 
 			if(node) {
 				node->next = nextNode;
+				node->rawNext.store(nextNode.get(), std::memory_order_relaxed);
 			}
 			else {
 				node = nextNode;
@@ -460,14 +611,42 @@ private:
 		}
 
 		tail = node;
+		rawHead.store(head.get(), std::memory_order_release);
 	}
 
 private:
 	NodePtr head;
 	NodePtr tail;
+	typename Threading::template Atomic<Node *> rawHead;
 	mutable Mutex mutex;
 	typename Threading::template Atomic<Counter> currentCounter;
+	typename Threading::template Atomic<Epoch> epoch;
+	mutable typename Threading::template Atomic<int> readerCounts[2];
+	std::vector<RetiredNode> retiredList;
+	typename Threading::template Atomic<bool> hasRetiredNodes;
+	NodeFactory nodeFactory;
+
+};
+
+template <typename Prototype, typename Policies, typename Storage>
+struct SelectCallbackListBase;
+
+template <typename Prototype, typename Policies>
+struct SelectCallbackListBase <Prototype, Policies, CallbackListStorageLinkedList>
+{
+	using Type = CallbackListBase<Prototype, Policies>;
+};
 
+template <typename Prototype, typename Policies>
+struct SelectCallbackListBase <Prototype, Policies, CallbackListStorageSlotMap>
+{
+	using Type = SlotCallbackListBase<Prototype, Policies>;
+};
+
+template <typename Prototype, typename Policies>
+struct SelectCallbackListBase <Prototype, Policies, CallbackListStorageCopyOnWrite>
+{
+	using Type = CowCallbackListBase<Prototype, Policies>;
 };
 
 
@@ -478,10 +657,18 @@ template <
 	typename Prototype_,
 	typename Policies_ = DefaultPolicies
 >
-class CallbackList : public internal_::CallbackListBase<Prototype_, Policies_>, public TagCallbackList
+class CallbackList : public internal_::SelectCallbackListBase<
+		Prototype_,
+		Policies_,
+		typename internal_::SelectCallbackListStorage<Policies_, internal_::HasTypeCallbackListStorage<Policies_>::value>::Type
+	>::Type, public TagCallbackList
 {
 private:
-	using super = internal_::CallbackListBase<Prototype_, Policies_>;
+	using super = typename internal_::SelectCallbackListBase<
+		Prototype_,
+		Policies_,
+		typename internal_::SelectCallbackListStorage<Policies_, internal_::HasTypeCallbackListStorage<Policies_>::value>::Type
+	>::Type;
 	
 public:
 	using super::super;
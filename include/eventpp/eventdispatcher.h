@@ -84,11 +84,47 @@ protected:
 		internal_::HasTypeMixins<Policies_>::value
 	>::Type;
 
+	// A concurrent map synchronizes itself, so the listener mutex is not needed.
+	using ListenerMutex = typename std::conditional<
+		std::is_base_of<TagConcurrentMap, Map>::value,
+		SingleThreading::Mutex,
+		typename Threading::Mutex
+	>::type;
+
+	// A resolved event. It pins the CallbackList of the event, so dispatching with it
+	// doesn't look up the map.
+	class EventToken_
+	{
+	public:
+		EventToken_() : event(), callbackList(nullptr) {
+		}
+
+		const EventType_ & getEvent() const {
+			return event;
+		}
+
+		explicit operator bool() const {
+			return callbackList != nullptr;
+		}
+
+	private:
+		EventToken_(const EventType_ & event, CallbackList_ * callbackList)
+			: event(event), callbackList(callbackList)
+		{
+		}
+
+		EventType_ event;
+		CallbackList_ * callbackList;
+
+		friend class EventDispatcherBase;
+	};
+
 public:
 	using Handle = typename CallbackList_::Handle;
 	using Callback = Callback_;
 	using Event = EventType_;
 	using Mutex = typename Threading::Mutex;
+	using EventToken = EventToken_;
 
 public:
 	EventDispatcherBase()
@@ -132,25 +168,46 @@ public:
 
 	Handle appendListener(const Event & event, const Callback & callback)
 	{
-		std::lock_guard<Mutex> lockGuard(listenerMutex);
+		std::lock_guard<ListenerMutex> lockGuard(listenerMutex);
 
 		return eventCallbackListMap[event].append(callback);
 	}
 
+	Handle appendListener(const Event & event, Callback && callback)
+	{
+		std::lock_guard<ListenerMutex> lockGuard(listenerMutex);
+
+		return eventCallbackListMap[event].append(std::move(callback));
+	}
+
 	Handle prependListener(const Event & event, const Callback & callback)
 	{
-		std::lock_guard<Mutex> lockGuard(listenerMutex);
+		std::lock_guard<ListenerMutex> lockGuard(listenerMutex);
 
 		return eventCallbackListMap[event].prepend(callback);
 	}
 
+	Handle prependListener(const Event & event, Callback && callback)
+	{
+		std::lock_guard<ListenerMutex> lockGuard(listenerMutex);
+
+		return eventCallbackListMap[event].prepend(std::move(callback));
+	}
+
 	Handle insertListener(const Event & event, const Callback & callback, const Handle & before)
 	{
-		std::lock_guard<Mutex> lockGuard(listenerMutex);
+		std::lock_guard<ListenerMutex> lockGuard(listenerMutex);
 
 		return eventCallbackListMap[event].insert(callback, before);
 	}
 
+	Handle insertListener(const Event & event, Callback && callback, const Handle & before)
+	{
+		std::lock_guard<ListenerMutex> lockGuard(listenerMutex);
+
+		return eventCallbackListMap[event].insert(std::move(callback), before);
+	}
+
 	bool removeListener(const Event & event, const Handle handle)
 	{
 		CallbackList_ * callableList = doFindCallableList(event);
@@ -216,7 +273,8 @@ public:
 	}
 
 	template <typename T>
-	void dispatch(T && first, Args ...args) const
+	auto dispatch(T && first, Args ...args) const
+		-> typename std::enable_if<! std::is_same<typename std::decay<T>::type, EventToken>::value, void>::type
 	{
 		static_assert(ArgumentPassingMode::canExcludeEventType, "Dispatching arguments count doesn't match required (Event type should NOT be included).");
 
@@ -243,7 +301,49 @@ public:
 		}
 	}
 
+	// Return a token of event, the CallbackList of the event is created if it doesn't exist.
+	// The token is valid until the dispatcher is destroyed, assigned, moved or swapped.
+	EventToken getEventToken(const Event & event)
+	{
+		std::lock_guard<ListenerMutex> lockGuard(listenerMutex);
+
+		return EventToken(event, &eventCallbackListMap[event]);
+	}
+
+	// Same as directDispatch, but doesn't look up the event.
+	// The arguments are the same as directDispatch, they don't include the event
+	// unless the prototype includes the event.
+	void dispatch(const EventToken & token, Args ...args) const
+	{
+		directDispatch(token, std::forward<Args>(args)...);
+	}
+
+	void directDispatch(const EventToken & token, Args ...args) const
+	{
+		if(! internal_::ForEachMixins<MixinRoot, Mixins, DoMixinBeforeDispatch>::forEach(
+			this, typename std::add_lvalue_reference<Args>::type(args)...)) {
+			return;
+		}
+
+		if(token.callbackList) {
+			(*token.callbackList)(std::forward<Args>(args)...);
+		}
+	}
+
 protected:
+	// For EventQueue to store and restore a token in the queued events.
+	using CallbackListType = CallbackList_;
+
+	static CallbackList_ * doGetTokenCallbackList(const EventToken & token)
+	{
+		return token.callbackList;
+	}
+
+	static EventToken doMakeEventToken(const Event & event, CallbackList_ * callbackList)
+	{
+		return EventToken(event, callbackList);
+	}
+
 	const CallbackList_ * doFindCallableList(const Event & e) const
 	{
 		return doFindCallableListHelper(this, e);
@@ -260,7 +360,7 @@ private:
 	static auto doFindCallableListHelper(T * self, const Event & e)
 		-> typename std::conditional<std::is_const<T>::value, const CallbackList_ *, CallbackList_ *>::type
 	{
-		std::lock_guard<Mutex> lockGuard(self->listenerMutex);
+		std::lock_guard<ListenerMutex> lockGuard(self->listenerMutex);
 
 		auto it = self->eventCallbackListMap.find(e);
 		if(it != self->eventCallbackListMap.end()) {
@@ -290,7 +390,7 @@ private:
 
 private:
 	Map eventCallbackListMap;
-	mutable Mutex listenerMutex;
+	mutable ListenerMutex listenerMutex;
 };
 
 
@@ -21,6 +21,7 @@
 #include <map>
 #include <unordered_map>
 #include <list>
+#include <cstddef>
 
 namespace eventpp {
 
@@ -34,6 +35,10 @@ struct TagHeterCallbackList : public TagHeter {};
 struct TagHeterEventDispatcher : public TagHeter {};
 struct TagHeterEventQueue : public TagHeter {};
 
+// A Map policy derived from TagConcurrentMap synchronizes itself,
+// the dispatchers don't lock their listener mutex for it.
+struct TagConcurrentMap {};
+
 struct SpinLock
 {
 public:
@@ -108,6 +113,17 @@ struct SingleThreading
 			value = desired;
 			return previous;
 		}
+
+		bool compare_exchange_weak(T & expected, T desired,
+				std::memory_order /*order*/ = std::memory_order_seq_cst) noexcept
+		{
+			if(value == expected) {
+				value = desired;
+				return true;
+			}
+			expected = value;
+			return false;
+		}
 		
 		T operator ++ () noexcept
 		{
@@ -168,6 +184,116 @@ struct ArgumentPassingExcludeEvent
 	};
 };
 
+struct CallbackListStorageLinkedList
+{
+};
+
+struct CallbackListStorageSlotMap
+{
+};
+
+struct CallbackListStorageCopyOnWrite
+{
+};
+
+struct NodeAllocationDefault
+{
+};
+
+struct NodeAllocationPooled
+{
+};
+
+struct QueueFullBlock
+{
+};
+
+template <unsigned int TimeoutMilliseconds>
+struct QueueFullBlockFor
+{
+	enum : unsigned int {
+		timeoutMilliseconds = TimeoutMilliseconds
+	};
+};
+
+struct QueueFullSpin
+{
+};
+
+struct QueueFullFail
+{
+};
+
+struct QueueFullDropOldest
+{
+};
+
+struct QueueSingleConsumer
+{
+};
+
+struct QueueMultipleConsumers
+{
+};
+
+struct EventQueueStorageList
+{
+};
+
+template <
+	std::size_t Capacity,
+	typename QueueFull = QueueFullBlock,
+	typename Consumer = QueueSingleConsumer
+>
+struct EventQueueStorageRingBuffer
+{
+	enum : std::size_t {
+		capacity = Capacity
+	};
+	using QueueFullPolicy = QueueFull;
+	using ConsumerPolicy = Consumer;
+};
+
+struct QueueWaitBlock
+{
+};
+
+template <
+	unsigned int SpinCount = 1024,
+	unsigned int YieldCount = 16
+>
+struct QueueWaitSpinThenPark
+{
+	enum : unsigned int {
+		spinCount = SpinCount,
+		yieldCount = YieldCount
+	};
+};
+
+struct QueueUnbounded
+{
+};
+
+template <
+	std::size_t Capacity,
+	typename QueueFull = QueueFullBlock
+>
+struct QueueBounded
+{
+	enum : std::size_t {
+		capacity = Capacity
+	};
+	using QueueFullPolicy = QueueFull;
+};
+
+struct QueueCoalesceNone
+{
+};
+
+struct QueueCoalesceLastValue
+{
+};
+
 struct DefaultPolicies
 {
 };
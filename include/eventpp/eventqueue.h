@@ -16,9 +16,13 @@
 
 #include "eventdispatcher.h"
 #include "internal/eventqueue_i.h"
+#include "internal/ringeventqueue_i.h"
+#include "internal/timingwheel_i.h"
 
 #include <tuple>
 #include <chrono>
+#include <memory>
+#include <cstdint>
 
 namespace eventpp {
 
@@ -66,9 +70,18 @@ private:
 	using Policies = typename super::Policies;
 	using Threading = typename super::Threading;
 	using ConditionVariable = typename Threading::ConditionVariable;
+	using QueueWait = typename SelectQueueWait<Policies_, HasTypeQueueWait<Policies_>::value>::Type;
 
 	using QueuedEventArgumentsType = std::tuple<typename std::decay<Args>::type...>;
 
+	// Whether the arguments include the event, it's ambiguous if ArgumentPassingMode is
+	// ArgumentPassingAutoDetect, then the arguments include the event if getEvent accepts them.
+	enum {
+		argumentsIncludeEvent = super::ArgumentPassingMode::canIncludeEventType
+			&& (! super::ArgumentPassingMode::canExcludeEventType
+				|| HasFunctionGetEvent<Policies_, const typename std::decay<Args>::type & ...>::value)
+	};
+
 	struct QueuedEvent_
 	{
 		typename std::decay<typename super::Event>::type event;
@@ -85,18 +98,63 @@ private:
 		}
 	};
 
+protected:
+	// The item stored in the queue. callbackList is not nullptr if the event is
+	// enqueued with an EventToken, then processing doesn't look up the event.
+	struct QueuedItem : public QueuedEvent_
+	{
+		// makeEvent returns the event, so the event initializes the member directly as the arguments do.
+		template <typename MakeEvent, typename ...A>
+		QueuedItem(typename super::CallbackListType * callbackList, MakeEvent && makeEvent, A && ...args)
+			:
+				QueuedEvent_{ makeEvent(), QueuedEventArgumentsType(std::forward<A>(args)...) },
+				callbackList(callbackList)
+		{
+		}
+
+		typename super::CallbackListType * callbackList;
+	};
+
+private:
 	using BufferedItemList = typename SelectQueueList<
-		BufferedItem<QueuedEvent_>, 
+		BufferedItem<QueuedItem>, 
 		Policies_,
 		HasTemplateQueueList<Policies_>::value
 	>::Type;
 
+	using Coalescer = QueueCoalescer<
+		BufferedItem<QueuedItem>,
+		typename SelectGetCoalesceKey<
+			Policies_,
+			HasFunctionGetCoalesceKey<
+				Policies_,
+				const typename std::decay<typename super::Event>::type &,
+				const typename std::decay<Args>::type & ...
+			>::value
+		>::Type,
+		typename SelectQueueCoalesce<Policies_, HasTypeQueueCoalesce<Policies_>::value>::Type
+	>;
+
+	using Limiter = QueueLimiter<
+		typename SelectQueueCapacity<Policies_, HasTypeQueueCapacity<Policies_>::value>::Type,
+		Threading
+	>;
+	// enqueue returns bool if the queue is bounded.
+	using EnqueueResult = typename std::conditional<Limiter::enabled, bool, void>::type;
+
+	using TimingWheel_ = TimingWheel<QueuedItem>;
+	using TimerTick = typename TimingWheel_::Tick;
+	// The resolution of the delayed events.
+	using TimerDuration = std::chrono::milliseconds;
+
 public:
 	using QueuedEvent = QueuedEvent_;
 	using Event = typename super::Event;
 	using Handle = typename super::Handle;
 	using Callback = typename super::Callback;
 	using Mutex = typename super::Mutex;
+	using EventToken = typename super::EventToken;
+	using TimerHandle = typename TimingWheel_::Handle;
 
 	struct DisableQueueNotify
 	{
@@ -118,6 +176,178 @@ public:
 		EventQueueBase * queue;
 	};
 
+	// Passed to the builder of enqueueBulk. It has the same enqueue functions as
+	// EventQueue, the events are collected and queued when the builder returns.
+	class BulkEnqueuer
+	{
+	public:
+		template <typename ...A>
+		auto enqueue(A && ...args) -> typename std::enable_if<sizeof...(A) == sizeof...(Args), void>::type
+		{
+			doAddItem(EventQueueBase::doMakeQueuedEvent(std::forward<A>(args)...));
+		}
+
+		template <typename T, typename ...A>
+		auto enqueue(T && first, A && ...args) -> typename std::enable_if<
+				sizeof...(A) == sizeof...(Args)
+					&& ! std::is_same<typename std::decay<T>::type, EventToken>::value,
+				void
+			>::type
+		{
+			doAddItem(EventQueueBase::doMakeQueuedEvent(std::forward<T>(first), std::forward<A>(args)...));
+		}
+
+		template <typename ...A>
+		auto enqueue(const EventToken & token, A && ...args) -> typename std::enable_if<sizeof...(A) == sizeof...(Args), void>::type
+		{
+			doAddItem(EventQueueBase::doMakeQueuedEvent(token, std::forward<A>(args)...));
+		}
+
+	private:
+		// The free items are taken from the queue on demand, at most freeItemBatchSize at once,
+		// so a small bulk doesn't take the free items that the other producers need.
+		enum : std::size_t {
+			freeItemBatchSize = 16
+		};
+
+		explicit BulkEnqueuer(EventQueueBase * queue) : queue(queue), itemList(), freeItemList(), itemCount(0)
+		{
+		}
+
+		void doAddItem(QueuedItem && item)
+		{
+			if(freeItemList.empty()) {
+				queue->doTakeFreeItems(freeItemList, freeItemBatchSize);
+				if(freeItemList.empty()) {
+					freeItemList.emplace_back();
+				}
+			}
+
+			auto it = freeItemList.begin();
+			it->set(std::move(item));
+			itemList.splice(itemList.end(), freeItemList, it);
+			++itemCount;
+		}
+
+		EventQueueBase * queue;
+		BufferedItemList itemList;
+		BufferedItemList freeItemList;
+		std::size_t itemCount;
+
+		friend class EventQueueBase;
+	};
+
+	// A staging buffer owned by one producer thread. enqueue only appends to the buffer,
+	// it doesn't lock any mutex or touch any atomic variable. The events are published to
+	// the queue in their order when publishThreshold events are staged, when flush is called,
+	// or when the buffer is destroyed. Publishing is the only step which locks the queue, and
+	// it's done by the owner thread, so it follows the QueueCapacity policy as enqueue does.
+	// A StagingBuffer must not be used by more than one thread at the same time, and must be
+	// destroyed before the queue.
+	class StagingBuffer
+	{
+	public:
+		explicit StagingBuffer(EventQueueBase * queue, const std::size_t publishThreshold = 64)
+			:
+				queue(queue),
+				publishThreshold(publishThreshold > 0 ? publishThreshold : 1),
+				stagedCount(0),
+				itemList(),
+				freeItemList()
+		{
+		}
+
+		~StagingBuffer()
+		{
+			flush();
+
+			if(! freeItemList.empty()) {
+				std::lock_guard<Mutex> queueListLock(queue->freeListMutex);
+				queue->freeList.splice(queue->freeList.end(), freeItemList);
+			}
+		}
+
+		StagingBuffer(const StagingBuffer &) = delete;
+		StagingBuffer & operator = (const StagingBuffer &) = delete;
+
+		template <typename ...A>
+		auto enqueue(A && ...args) -> typename std::enable_if<sizeof...(A) == sizeof...(Args), void>::type
+		{
+			doAddItem(EventQueueBase::doMakeQueuedEvent(std::forward<A>(args)...));
+		}
+
+		template <typename T, typename ...A>
+		auto enqueue(T && first, A && ...args) -> typename std::enable_if<
+				sizeof...(A) == sizeof...(Args)
+					&& ! std::is_same<typename std::decay<T>::type, EventToken>::value,
+				void
+			>::type
+		{
+			doAddItem(EventQueueBase::doMakeQueuedEvent(std::forward<T>(first), std::forward<A>(args)...));
+		}
+
+		template <typename ...A>
+		auto enqueue(const EventToken & token, A && ...args) -> typename std::enable_if<sizeof...(A) == sizeof...(Args), void>::type
+		{
+			doAddItem(EventQueueBase::doMakeQueuedEvent(token, std::forward<A>(args)...));
+		}
+
+		// Publish the staged events to the queue.
+		// Return the count of the published events, the rejected events are not counted.
+		std::size_t flush()
+		{
+			if(itemList.empty()) {
+				return 0;
+			}
+
+			BufferedItemList droppedList;
+			std::size_t rejectedCount;
+			{
+				std::unique_lock<Mutex> queueListLock(queue->queueListMutex);
+				rejectedCount = queue->doAppendItems(queueListLock, itemList, droppedList, true);
+			}
+			queue->doNotifyQueueAvailable();
+
+			const std::size_t publishedCount = stagedCount - rejectedCount;
+			stagedCount = 0;
+
+			// The coalesced and rejected items are left in itemList, they are reused by this buffer.
+			freeItemList.splice(freeItemList.end(), itemList);
+			if(! droppedList.empty()) {
+				std::lock_guard<Mutex> queueListLock(queue->freeListMutex);
+				queue->freeList.splice(queue->freeList.end(), droppedList);
+			}
+
+			return publishedCount;
+		}
+
+	private:
+		void doAddItem(QueuedItem && item)
+		{
+			// The free items are taken from the queue in batches.
+			if(freeItemList.empty()) {
+				queue->doTakeFreeItems(freeItemList, publishThreshold);
+				if(freeItemList.empty()) {
+					freeItemList.emplace_back();
+				}
+			}
+
+			auto it = freeItemList.begin();
+			it->set(std::move(item));
+			itemList.splice(itemList.end(), freeItemList, it);
+
+			if(++stagedCount >= publishThreshold) {
+				flush();
+			}
+		}
+
+		EventQueueBase * queue;
+		std::size_t publishThreshold;
+		std::size_t stagedCount;
+		BufferedItemList itemList;
+		BufferedItemList freeItemList;
+	};
+
 public:
 	EventQueueBase()
 		:
@@ -125,72 +355,199 @@ public:
 			queueListConditionVariable(),
 			queueEmptyCounter(0),
 			queueNotifyCounter(0),
+			queueWaiterCounter(0),
 			queueListMutex(),
 			queueList(),
+			coalescer(),
+			limiter(),
 			freeListMutex(),
-			freeList()
+			freeList(),
+			timerMutex(),
+			timingWheel(),
+			timerDueTick(TimingWheel_::noTick),
+			timerEpoch(std::chrono::steady_clock::now())
 	{
 	}
 
 	EventQueueBase(const EventQueueBase & other)
-		: super(other)
+		:
+			super(other),
+			queueEmptyCounter(0),
+			queueNotifyCounter(0),
+			queueWaiterCounter(0),
+			timerDueTick(TimingWheel_::noTick),
+			timerEpoch(std::chrono::steady_clock::now())
 	{
 	}
 
 	EventQueueBase(EventQueueBase && other) noexcept
-		: super(std::move(other))
+		:
+			super(std::move(other)),
+			queueEmptyCounter(0),
+			queueNotifyCounter(0),
+			queueWaiterCounter(0),
+			timerDueTick(TimingWheel_::noTick),
+			timerEpoch(std::chrono::steady_clock::now())
 	{
+		other.doResetQueuedCallbackLists();
 	}
 
 	EventQueueBase & operator = (const EventQueueBase & other)
 	{
 		super::operator = (other);
+		doResetQueuedCallbackLists();
 		return *this;
 	}
 	
 	EventQueueBase & operator = (EventQueueBase && other) noexcept
 	{
 		super::operator = (std::move(other));
+		doResetQueuedCallbackLists();
+		other.doResetQueuedCallbackLists();
 		return *this;
 	}
 
 	template <typename ...A>
-	auto enqueue(A && ...args) -> typename std::enable_if<sizeof...(A) == sizeof...(Args), void>::type
+	auto enqueue(A && ...args) -> typename std::enable_if<sizeof...(A) == sizeof...(Args), EnqueueResult>::type
 	{
-		static_assert(super::ArgumentPassingMode::canIncludeEventType, "Enqueuing arguments count doesn't match required (Event type should be included).");
+		return doEnqueueAndNotify([&args...]() {
+			return doMakeQueuedEvent(std::forward<A>(args)...);
+		});
+	}
 
-		using GetEvent = typename SelectGetEvent<Policies_, EventType_, HasFunctionGetEvent<Policies_, A...>::value>::Type;
+	template <typename T, typename ...A>
+	auto enqueue(T && first, A && ...args) -> typename std::enable_if<
+			sizeof...(A) == sizeof...(Args)
+				&& ! std::is_same<typename std::decay<T>::type, EventToken>::value,
+			EnqueueResult
+		>::type
+	{
+		return doEnqueueAndNotify([&first, &args...]() {
+			return doMakeQueuedEvent(std::forward<T>(first), std::forward<A>(args)...);
+		});
+	}
 
-		doEnqueue(QueuedEvent{
-			GetEvent::getEvent(args...),
-			QueuedEventArgumentsType(std::forward<A>(args)...)
+	// The arguments are the same as directDispatch, they don't include the event
+	// unless the prototype includes the event.
+	template <typename ...A>
+	auto enqueue(const EventToken & token, A && ...args) -> typename std::enable_if<sizeof...(A) == sizeof...(Args), EnqueueResult>::type
+	{
+		return doEnqueueAndNotify([&token, &args...]() {
+			return doMakeQueuedEvent(token, std::forward<A>(args)...);
 		});
+	}
 
-		if(doCanProcess()) {
-			queueListConditionVariable.notify_one();
-		}
+	// Enqueue event with the arguments default constructed in the queue, then fill is
+	// invoked with a reference to each argument to fill it in place, before the event
+	// is put in the queue. fill must not enqueue to or process the queue.
+	template <typename F>
+	EnqueueResult enqueueWith(const Event & event, F && fill)
+	{
+		static_assert(! argumentsIncludeEvent, "The arguments include the event, use enqueueWith(fill) which gets the event from the filled arguments.");
+
+		return doEnqueueAndNotify(
+			[&event]() {
+				return QueuedItem(nullptr, [&event]() {
+					return event;
+				});
+			},
+			[&fill](QueuedEvent & queuedEvent) {
+				doFillArguments(fill, queuedEvent.arguments, typename MakeIndexSequence<sizeof...(Args)>::Type());
+			}
+		);
 	}
 
-	template <typename T, typename ...A>
-	auto enqueue(T && first, A && ...args) -> typename std::enable_if<sizeof...(A) == sizeof...(Args), void>::type
+	// Same as above, for the prototypes which include the event. The event is got
+	// from the arguments after fill returns.
+	template <typename F>
+	EnqueueResult enqueueWith(F && fill)
 	{
-		static_assert(super::ArgumentPassingMode::canExcludeEventType, "Enqueuing arguments count doesn't match required (Event type should NOT be included).");
+		static_assert(argumentsIncludeEvent, "The arguments don't include the event, use enqueueWith(event, fill).");
+
+		return doEnqueueAndNotify(
+			[]() {
+				return QueuedItem(nullptr, []() {
+					return typename std::decay<Event>::type();
+				});
+			},
+			[&fill](QueuedEvent & queuedEvent) {
+				doFillArguments(fill, queuedEvent.arguments, typename MakeIndexSequence<sizeof...(Args)>::Type());
+				queuedEvent.event = doGetArgumentsEvent(queuedEvent.arguments, typename MakeIndexSequence<sizeof...(Args)>::Type());
+			}
+		);
+	}
+
+	// Enqueue the events which the builder adds to the BulkEnqueuer.
+	// The free items are taken in batches, the events are moved to the queue
+	// under one lock, and the waiting thread is notified once.
+	// Return the count of the enqueued events, the rejected events are not counted.
+	template <typename Builder>
+	std::size_t enqueueBulk(Builder && builder)
+	{
+		return doEnqueueBulk(std::forward<Builder>(builder), true);
+	}
 
-		using GetEvent = typename SelectGetEvent<Policies_, EventType_, HasFunctionGetEvent<Policies_, T &&, A...>::value>::Type;
 
-		doEnqueue(QueuedEvent{
-			GetEvent::getEvent(std::forward<T>(first), args...),
-			QueuedEventArgumentsType(std::forward<A>(args)...)
+	// Each element is the arguments of one enqueue, either a std::tuple of the arguments,
+	// or the argument itself if enqueue takes only one argument.
+	template <typename Iterator>
+	std::size_t enqueueRange(Iterator first, Iterator last)
+	{
+		return enqueueBulk([first, last](BulkEnqueuer & enqueuer) {
+			for(Iterator it = first; it != last; ++it) {
+				enqueueRangeElement(enqueuer, *it);
+			}
 		});
+	}
 
-		if(doCanProcess()) {
-			queueListConditionVariable.notify_one();
-		}
+	// Enqueue the event when duration elapses. The event is put in the queue by the first
+	// process function called after it's due, the resolution is one millisecond.
+	// The returned handle can be passed to cancelTimer.
+	template <class Rep, class Period, typename ...A>
+	TimerHandle enqueueAfter(const std::chrono::duration<Rep, Period> & duration, A && ...args)
+	{
+		return enqueueAt(std::chrono::steady_clock::now() + duration, std::forward<A>(args)...);
 	}
 
+	template <class Duration, typename ...A>
+	TimerHandle enqueueAt(const std::chrono::time_point<std::chrono::steady_clock, Duration> & timePoint, A && ...args)
+	{
+		return doEnqueueTimer(doGetTimerTick(timePoint), doMakeQueuedEvent(std::forward<A>(args)...));
+	}
+
+	// Cancel a delayed event which is not put in the queue yet.
+	// Return false if the event is already in the queue or cancelled.
+	bool cancelTimer(const TimerHandle & handle)
+	{
+		std::lock_guard<Mutex> timerLock(timerMutex);
+		return timingWheel && timingWheel->cancel(handle);
+	}
+
+	// A due delayed event counts, since the process and take functions put it in the queue.
 	bool emptyQueue() const
 	{
-		return queueList.empty() && (queueEmptyCounter.load(std::memory_order_acquire) == 0);
+		return queueList.empty() && (queueEmptyCounter.load(std::memory_order_acquire) == 0)
+			&& ! doHasDueTimer();
+	}
+
+	// The count of the events which are rejected or dropped because the queue is full.
+	// It's always 0 if the queue is unbounded.
+	std::size_t getDroppedEventCount() const
+	{
+		return limiter.getDroppedEventCount();
+	}
+
+	// The count of the enqueues which wait because the queue is full.
+	std::size_t getBlockedEnqueueCount() const
+	{
+		return limiter.getBlockedEnqueueCount();
+	}
+
+	// The count of the due delayed events which are put in the queue beyond the capacity,
+	// because the consumer can't wait for itself. It's always 0 if the queue is unbounded.
+	std::size_t getOverflowEventCount() const
+	{
+		return limiter.getOverflowEventCount();
 	}
 	
 	void clearEvents()
@@ -198,10 +555,26 @@ public:
 		if(! queueList.empty()) {
 			BufferedItemList tempList;
 
-			{
-				std::lock_guard<Mutex> queueListLock(queueListMutex);
-				std::swap(queueList, tempList);
+			doTakeAllEvents(tempList);
+
+			if(! tempList.empty()) {
+				for(auto & item : tempList) {
+					item.clear();
+				}
+
+				std::lock_guard<Mutex> queueListLock(freeListMutex);
+				freeList.splice(freeList.end(), tempList);
 			}
+		}
+	}
+
+	// Clear the queued events of event without dispatching them, the other events stay in the queue.
+	void clearEvents(const Event & event)
+	{
+		if(! queueList.empty()) {
+			BufferedItemList tempList;
+
+			doTakeEventsOf(event, tempList);
 
 			if(! tempList.empty()) {
 				for(auto & item : tempList) {
@@ -216,6 +589,8 @@ public:
 
 	bool process()
 	{
+		doExpireTimers();
+
 		if(! queueList.empty()) {
 			BufferedItemList tempList;
 
@@ -223,10 +598,7 @@ public:
 			// even though queueList is swapped to empty.
 			CounterGuard<decltype(queueEmptyCounter)> counterGuard(queueEmptyCounter);
 
-			{
-				std::lock_guard<Mutex> queueListLock(queueListMutex);
-				std::swap(queueList, tempList);
-			}
+			doTakeAllEvents(tempList);
 
 			if(! tempList.empty()) {
 				for(auto & item : tempList) {
@@ -249,6 +621,8 @@ public:
 
 	bool processOne()
 	{
+		doExpireTimers();
+
 		if(! queueList.empty()) {
 			BufferedItemList tempList;
 
@@ -259,6 +633,8 @@ public:
 			{
 				std::lock_guard<Mutex> queueListLock(queueListMutex);
 				if(! queueList.empty()) {
+					coalescer.remove(queueList.front());
+					limiter.takeOne();
 					tempList.splice(tempList.end(), queueList, queueList.begin());
 				}
 			}
@@ -281,9 +657,62 @@ public:
 		return false;
 	}
 
+	// Process the queued events of event in the order they are queued, the other events stay in the queue.
+	// If the QueueList policy is IndexedQueueList, it costs as much as the count of the events of event,
+	// otherwise the queue is scanned under the lock.
+	bool processEvent(const Event & event)
+	{
+		doExpireTimers();
+
+		if(! queueList.empty()) {
+			BufferedItemList tempList;
+
+			// Use a counter to tell the queue list is not empty during processing
+			// even though the events are taken.
+			CounterGuard<decltype(queueEmptyCounter)> counterGuard(queueEmptyCounter);
+
+			doTakeEventsOf(event, tempList);
+
+			if(! tempList.empty()) {
+				for(auto & item : tempList) {
+					doDispatchQueuedEvent(
+						item.get(),
+						typename MakeIndexSequence<sizeof...(Args)>::Type()
+					);
+					item.clear();
+				}
+
+				std::lock_guard<Mutex> queueListLock(freeListMutex);
+				freeList.splice(freeList.end(), tempList);
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Process at most maxEvents events. The remaining events stay at the head of the queue.
+	bool processN(const std::size_t maxEvents)
+	{
+		ProcessCountBudget budget(maxEvents);
+		return doProcessWithBudget(budget);
+	}
+
+	// Process the events until duration elapses. The clock is checked every several events,
+	// so the time may exceed the duration by the time of processing those events.
+	template <class Rep, class Period>
+	bool processFor(const std::chrono::duration<Rep, Period> & duration)
+	{
+		ProcessTimeBudget budget(duration);
+		return doProcessWithBudget(budget);
+	}
+
 	template <typename Predictor>
 	bool processIf(Predictor && predictor)
 	{
+		doExpireTimers();
+
 		if(! queueList.empty()) {
 			BufferedItemList tempList;
 			BufferedItemList idleList;
@@ -292,10 +721,8 @@ public:
 			// even though queueList is swapped to empty.
 			CounterGuard<decltype(queueEmptyCounter)> counterGuard(queueEmptyCounter);
 
-			{
-				std::lock_guard<Mutex> queueListLock(queueListMutex);
-				std::swap(queueList, tempList);
-			}
+			const std::size_t takenCount = doTakeAllEvents(tempList);
+			std::size_t processedCount = 0;
 
 			if(! tempList.empty()) {
 				for(auto it = tempList.begin(); it != tempList.end(); ) {
@@ -313,16 +740,14 @@ public:
 						auto tempIt = it;
 						++it;
 						idleList.splice(idleList.end(), tempList, tempIt);
+						++processedCount;
 					}
 					else {
 						++it;
 					}
 				}
 
-				if (! tempList.empty()) {
-					std::lock_guard<Mutex> queueListLock(queueListMutex);
-					queueList.splice(queueList.begin(), tempList);
-				}
+				doPutBackEvents(tempList, takenCount - processedCount);
 
 				if(! idleList.empty()) {
 					std::lock_guard<Mutex> queueListLock(freeListMutex);
@@ -339,6 +764,8 @@ public:
 	template <typename Predictor>
 	bool processUntil(Predictor && predictor)
 	{
+		doExpireTimers();
+
 		if(! queueList.empty()) {
 			BufferedItemList tempList;
 			BufferedItemList idleList;
@@ -347,10 +774,8 @@ public:
 			// even though queueList is swapped to empty.
 			CounterGuard<decltype(queueEmptyCounter)> counterGuard(queueEmptyCounter);
 
-			{
-				std::lock_guard<Mutex> queueListLock(queueListMutex);
-				std::swap(queueList, tempList);
-			}
+			const std::size_t takenCount = doTakeAllEvents(tempList);
+			std::size_t processedCount = 0;
 
 			if(! tempList.empty()) {
 				for(auto it = tempList.begin(); it != tempList.end(); ) {
@@ -371,13 +796,11 @@ public:
 						auto tempIt = it;
 						++it;
 						idleList.splice(idleList.end(), tempList, tempIt);
+						++processedCount;
 					}
 				}
 
-				if (! tempList.empty()) {
-					std::lock_guard<Mutex> queueListLock(queueListMutex);
-					queueList.splice(queueList.begin(), tempList);
-				}
+				doPutBackEvents(tempList, takenCount - processedCount);
 
 				if(! idleList.empty()) {
 					std::lock_guard<Mutex> queueListLock(freeListMutex);
@@ -391,21 +814,40 @@ public:
 		return false;
 	}
 	
+	// Also return when a delayed event may be due, then a process or take function puts it in the queue.
 	void wait() const
 	{
+		if(spinBeforePark([this]() -> bool { return doCanProcessOrTimerDue(); }, QueueWait())) {
+			return;
+		}
+
+		CounterGuard<decltype(queueWaiterCounter)> counterGuard(queueWaiterCounter);
 		std::unique_lock<Mutex> queueListLock(queueListMutex);
-		queueListConditionVariable.wait(queueListLock, [this]() -> bool {
-			return doCanProcess();
-		});
+		doWaitUntil(queueListLock, false, std::chrono::steady_clock::time_point());
 	}
 
 	template <class Rep, class Period>
 	bool waitFor(const std::chrono::duration<Rep, Period> & duration) const
 	{
+		// Don't spin if the caller only polls the queue.
+		if(duration > std::chrono::duration<Rep, Period>::zero()
+			&& spinBeforePark([this]() -> bool { return doCanProcessOrTimerDue(); }, QueueWait())) {
+			return true;
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		// Treat a duration too long for time_point as no timeout.
+		const bool hasTimeout = duration < std::chrono::duration_cast<std::chrono::duration<Rep, Period> >(
+			std::chrono::steady_clock::time_point::max() - now
+		);
+
+		CounterGuard<decltype(queueWaiterCounter)> counterGuard(queueWaiterCounter);
 		std::unique_lock<Mutex> queueListLock(queueListMutex);
-		return queueListConditionVariable.wait_for(queueListLock, duration, [this]() -> bool {
-			return doCanProcess();
-		});
+		return doWaitUntil(
+			queueListLock,
+			hasTimeout,
+			hasTimeout ? now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration) : now
+		);
 	}
 
 	using super::dispatch;
@@ -422,6 +864,8 @@ public:
 
 	bool peekEvent(QueuedEvent * queuedEvent)
 	{
+		doExpireTimers();
+
 		if(! queueList.empty()) {
 			std::lock_guard<Mutex> queueListLock(queueListMutex);
 			
@@ -436,6 +880,8 @@ public:
 
 	bool takeEvent(QueuedEvent * queuedEvent)
 	{
+		doExpireTimers();
+
 		if(! queueList.empty()) {
 			BufferedItemList tempList;
 
@@ -443,6 +889,8 @@ public:
 				std::lock_guard<Mutex> queueListLock(queueListMutex);
 
 				if(! queueList.empty()) {
+					coalescer.remove(queueList.front());
+					limiter.takeOne();
 					tempList.splice(tempList.end(), queueList, queueList.begin());
 				}
 			}
@@ -461,12 +909,392 @@ public:
 		return false;
 	}
 
+	// Move at most maxCount events to out, in the order they would be processed.
+	// The queue is locked once to take the events, and once to recycle the items.
+	// Return the count of the events taken.
+	template <typename OutputIterator>
+	std::size_t takeEvents(OutputIterator out, const std::size_t maxCount)
+	{
+		doExpireTimers();
+
+		std::size_t takenCount = 0;
+
+		if(! queueList.empty() && maxCount > 0) {
+			BufferedItemList tempList;
+
+			{
+				std::lock_guard<Mutex> queueListLock(queueListMutex);
+
+				while(takenCount < maxCount && ! queueList.empty()) {
+					coalescer.remove(queueList.front());
+					tempList.splice(tempList.end(), queueList, queueList.begin());
+					++takenCount;
+				}
+				limiter.take(takenCount);
+			}
+
+			if(! tempList.empty()) {
+				for(auto & item : tempList) {
+					*out = static_cast<QueuedEvent &&>(item.get());
+					++out;
+					item.clear();
+				}
+
+				std::lock_guard<Mutex> queueListLock(freeListMutex);
+				freeList.splice(freeList.end(), tempList);
+			}
+		}
+
+		return takenCount;
+	}
+
+	// Invoke func with each queued event by const reference, in the order they would be processed.
+	// If func returns bool, false stops the visiting. The queue is locked during the visiting,
+	// func must not enqueue to or process the queue.
+	template <typename F>
+	void peekEvents(F && func)
+	{
+		doExpireTimers();
+
+		if(! queueList.empty()) {
+			std::lock_guard<Mutex> queueListLock(queueListMutex);
+
+			for(const auto & item : queueList) {
+				if(! internal_::visitQueuedEvent(func, static_cast<const QueuedEvent &>(item.get()))) {
+					break;
+				}
+			}
+		}
+	}
+
 protected:
+	template <typename Budget>
+	bool doProcessWithBudget(Budget & budget)
+	{
+		doExpireTimers();
+
+		if(! queueList.empty()) {
+			BufferedItemList tempList;
+			BufferedItemList idleList;
+
+			// Use a counter to tell the queue list is not empty during processing
+			// even though queueList is swapped to empty.
+			CounterGuard<decltype(queueEmptyCounter)> counterGuard(queueEmptyCounter);
+
+			const std::size_t takenCount = doTakeAllEvents(tempList);
+			std::size_t processedCount = 0;
+
+			if(! tempList.empty()) {
+				while(! tempList.empty() && budget.available(1) > 0) {
+					budget.consume(1);
+
+					auto it = tempList.begin();
+					doDispatchQueuedEvent(
+						it->get(),
+						typename MakeIndexSequence<sizeof...(Args)>::Type()
+					);
+					it->clear();
+
+					idleList.splice(idleList.end(), tempList, it);
+					++processedCount;
+				}
+
+				doPutBackEvents(tempList, takenCount - processedCount);
+
+				if(! idleList.empty()) {
+					std::lock_guard<Mutex> queueListLock(freeListMutex);
+					freeList.splice(freeList.end(), idleList);
+
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	// The due delayed events are put in the queue by the consumer, canBlock is false for them.
+	// Return the count of the enqueued events.
+	template <typename Builder>
+	std::size_t doEnqueueBulk(Builder && builder, const bool canBlock)
+	{
+		BulkEnqueuer enqueuer(this);
+
+		builder(enqueuer);
+
+		std::size_t rejectedCount = 0;
+		if(! enqueuer.itemList.empty()) {
+			{
+				std::unique_lock<Mutex> queueListLock(queueListMutex);
+				rejectedCount = doAppendItems(queueListLock, enqueuer.itemList, enqueuer.freeItemList, canBlock);
+			}
+
+			doNotifyQueueAvailable();
+
+			// The coalesced and rejected items are left in itemList.
+			enqueuer.freeItemList.splice(enqueuer.freeItemList.end(), enqueuer.itemList);
+		}
+
+		if(! enqueuer.freeItemList.empty()) {
+			std::lock_guard<Mutex> queueListLock(freeListMutex);
+			freeList.splice(freeList.end(), enqueuer.freeItemList);
+		}
+
+		return enqueuer.itemCount - rejectedCount;
+	}
+
+	// queueListLock must be locked. Append the items to the queue list within the capacity.
+	// The items which are coalesced or rejected are cleared and left in itemList, the events
+	// dropped from the queue to make room are moved to droppedList.
+	// Return the count of the rejected items.
+	std::size_t doAppendItems(
+			std::unique_lock<Mutex> & queueListLock,
+			BufferedItemList & itemList,
+			BufferedItemList & droppedList,
+			const bool canBlock
+		)
+	{
+		if(! Limiter::enabled) {
+			coalescer.append(queueList, itemList);
+			return 0;
+		}
+
+		return coalescer.append(
+			queueList,
+			itemList,
+			[this, &queueListLock, &droppedList, canBlock]() -> bool {
+				return limiter.admit(queueListLock, queueList, droppedList, canBlock, [this](const BufferedItem<QueuedItem> & item) {
+					coalescer.remove(item);
+				});
+			},
+			[this]() {
+				limiter.release();
+			}
+		);
+	}
+
+	// Take all events in the queue to itemList.
+	// Return the count of the events, it's only counted if the queue is bounded.
+	std::size_t doTakeAllEvents(BufferedItemList & itemList)
+	{
+		std::lock_guard<Mutex> queueListLock(queueListMutex);
+		std::swap(queueList, itemList);
+		coalescer.clear();
+		return limiter.takeAll();
+	}
+
+	// Take the events of event to itemList.
+	void doTakeEventsOf(const Event & event, BufferedItemList & itemList)
+	{
+		std::lock_guard<Mutex> queueListLock(queueListMutex);
+		const std::size_t count = doSpliceEventsOf(
+			event,
+			itemList,
+			std::integral_constant<bool, HasFunctionSpliceEvent<BufferedItemList, Event>::value>()
+		);
+		if(Coalescer::enabled) {
+			for(const auto & item : itemList) {
+				coalescer.remove(item);
+			}
+		}
+		limiter.take(count);
+	}
+
+	std::size_t doSpliceEventsOf(const Event & event, BufferedItemList & itemList, std::true_type)
+	{
+		return itemList.spliceEvent(itemList.end(), queueList, event);
+	}
+
+	std::size_t doSpliceEventsOf(const Event & event, BufferedItemList & itemList, std::false_type)
+	{
+		std::size_t count = 0;
+		for(auto it = queueList.begin(); it != queueList.end(); ) {
+			auto current = it;
+			++it;
+			if(current->get().event == event) {
+				itemList.splice(itemList.end(), queueList, current);
+				++count;
+			}
+		}
+		return count;
+	}
+
+	// Put the events which are taken but not processed back to the front of the queue.
+	// itemCount is the count of the events in itemList, it's only used if the queue is bounded.
+	void doPutBackEvents(BufferedItemList & itemList, const std::size_t itemCount)
+	{
+		if(! itemList.empty()) {
+			{
+				std::lock_guard<Mutex> queueListLock(queueListMutex);
+				const std::size_t droppedCount = coalescer.prepend(queueList, itemList);
+				limiter.putBack(itemCount - droppedCount);
+			}
+
+			// The items dropped by coalescing are left in itemList.
+			if(! itemList.empty()) {
+				std::lock_guard<Mutex> queueListLock(freeListMutex);
+				freeList.splice(freeList.end(), itemList);
+			}
+		}
+	}
+
+	void doNotifyQueueAvailable()
+	{
+		if(hasParkedWaiter(queueWaiterCounter, QueueWait()) && doCanProcess()) {
+			queueListConditionVariable.notify_one();
+		}
+	}
+
+	void doTakeFreeItems(BufferedItemList & itemList, const std::size_t maxCount)
+	{
+		if(! freeList.empty()) {
+			std::lock_guard<Mutex> queueListLock(freeListMutex);
+			for(std::size_t i = 0; i < maxCount && ! freeList.empty(); ++i) {
+				itemList.splice(itemList.end(), freeList, freeList.begin());
+			}
+		}
+	}
+
 	bool doCanProcess() const
 	{
 		return ! emptyQueue() && doCanNotifyQueueAvailable();
 	}
 
+	bool doCanProcessOrTimerDue() const
+	{
+		return doCanProcess() || doHasDueTimer();
+	}
+
+	bool doHasDueTimer() const
+	{
+		const TimerTick dueTick = timerDueTick.load(std::memory_order_acquire);
+		return dueTick != TimingWheel_::noTick
+			&& dueTick <= doGetTimerTick(std::chrono::steady_clock::now(), false);
+	}
+
+	// queueListLock must be locked. Wake up at the due tick of the timing wheel, or when
+	// an earlier delayed event is enqueued. Return false on timeout.
+	bool doWaitUntil(
+			std::unique_lock<Mutex> & queueListLock,
+			const bool hasTimeout,
+			const std::chrono::steady_clock::time_point & timeoutTime
+		) const
+	{
+		for(;;) {
+			if(doCanProcessOrTimerDue()) {
+				return true;
+			}
+
+			const auto now = std::chrono::steady_clock::now();
+			if(hasTimeout && now >= timeoutTime) {
+				return false;
+			}
+
+			const TimerTick dueTick = timerDueTick.load(std::memory_order_acquire);
+			auto canWakeUp = [this, dueTick]() -> bool {
+				return doCanProcess() || timerDueTick.load(std::memory_order_acquire) != dueTick;
+			};
+
+			if(dueTick == TimingWheel_::noTick) {
+				if(! hasTimeout) {
+					queueListConditionVariable.wait(queueListLock, canWakeUp);
+				}
+				else {
+					queueListConditionVariable.wait_for(queueListLock, timeoutTime - now, canWakeUp);
+				}
+			}
+			else {
+				auto wakeUpTime = timerEpoch + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					TimerDuration(static_cast<typename TimerDuration::rep>(dueTick))
+				);
+				if(hasTimeout && timeoutTime < wakeUpTime) {
+					wakeUpTime = timeoutTime;
+				}
+				queueListConditionVariable.wait_for(queueListLock, wakeUpTime - now, canWakeUp);
+			}
+		}
+	}
+
+	// Round up for a deadline, so the event is never enqueued early, and down for the
+	// current time.
+	template <class Duration>
+	TimerTick doGetTimerTick(
+			const std::chrono::time_point<std::chrono::steady_clock, Duration> & timePoint,
+			const bool roundUp = true
+		) const
+	{
+		if(timePoint <= timerEpoch) {
+			return 0;
+		}
+
+		const auto elapsed = timePoint - timerEpoch;
+		TimerTick tick = static_cast<TimerTick>(std::chrono::duration_cast<TimerDuration>(elapsed).count());
+		if(roundUp && TimerDuration(static_cast<typename TimerDuration::rep>(tick)) < elapsed) {
+			++tick;
+		}
+		return tick;
+	}
+
+	TimerHandle doEnqueueTimer(const TimerTick tick, QueuedItem && item)
+	{
+		TimerHandle handle;
+		bool isDue = false;
+		bool isEarliest = false;
+
+		{
+			std::lock_guard<Mutex> timerLock(timerMutex);
+
+			if(! timingWheel) {
+				timingWheel.reset(new TimingWheel_());
+			}
+
+			// The wheel never advances past the current tick, so a tick not in the
+			// future is always before the ticks in the wheel.
+			if(tick <= doGetTimerTick(std::chrono::steady_clock::now(), false)) {
+				isDue = true;
+			}
+			else {
+				handle = timingWheel->add(tick, std::move(item));
+				if(tick < timerDueTick.load(std::memory_order_relaxed)) {
+					timerDueTick.store(tick, std::memory_order_release);
+					isEarliest = true;
+				}
+			}
+		}
+
+		// The same as enqueue, the caller is a producer.
+		if(isDue && doEnqueue(std::move(item), true)) {
+			doNotifyQueueAvailable();
+		}
+		else if(isEarliest && hasParkedWaiter(queueWaiterCounter, QueueWait())) {
+			// Lock to not lose the notification when the waiter is going to wait.
+			std::lock_guard<Mutex> queueListLock(queueListMutex);
+			queueListConditionVariable.notify_one();
+		}
+
+		return handle;
+	}
+
+	// Put the due delayed events in the queue.
+	void doExpireTimers()
+	{
+		if(! doHasDueTimer()) {
+			return;
+		}
+
+		doEnqueueBulk([this](BulkEnqueuer & enqueuer) {
+			std::lock_guard<Mutex> timerLock(timerMutex);
+
+			timingWheel->advance(
+				doGetTimerTick(std::chrono::steady_clock::now(), false),
+				[&enqueuer](QueuedItem && item) {
+					enqueuer.doAddItem(std::move(item));
+				}
+			);
+			timerDueTick.store(timingWheel->getDueTick(), std::memory_order_release);
+		}, false);
+	}
+
 	bool doCanNotifyQueueAvailable() const
 	{
 		return queueNotifyCounter.load(std::memory_order_acquire) == 0;
@@ -475,7 +1303,46 @@ protected:
 	template <typename T, size_t ...Indexes>
 	void doDispatchQueuedEvent(T && item, IndexSequence<Indexes...>)
 	{
-		this->directDispatch(item.event, std::get<Indexes>(item.arguments)...);
+		typename super::CallbackListType * callbackList = doGetQueuedCallbackList(item);
+		if(callbackList != nullptr) {
+			this->directDispatch(
+				super::doMakeEventToken(item.event, callbackList),
+				std::get<Indexes>(item.arguments)...
+			);
+		}
+		else {
+			this->directDispatch(item.event, std::get<Indexes>(item.arguments)...);
+		}
+	}
+
+	static typename super::CallbackListType * doGetQueuedCallbackList(const QueuedItem & item)
+	{
+		return item.callbackList;
+	}
+
+	// The callback lists which the queued tokens point to belong to the replaced
+	// listeners after the queue is assigned, so the queued events are looked up again.
+	void doResetQueuedCallbackLists()
+	{
+		{
+			std::lock_guard<Mutex> queueListLock(queueListMutex);
+			for(auto & item : queueList) {
+				item.get().callbackList = nullptr;
+			}
+		}
+
+		std::lock_guard<Mutex> timerLock(timerMutex);
+		if(timingWheel) {
+			timingWheel->forEach([](QueuedItem & item) {
+				item.callbackList = nullptr;
+			});
+		}
+	}
+
+	// The event passed to dispatch doesn't keep the token.
+	static typename super::CallbackListType * doGetQueuedCallbackList(const QueuedEvent & /*item*/)
+	{
+		return nullptr;
 	}
 
 	template <typename F, typename T, size_t ...Indexes>
@@ -498,7 +1365,131 @@ protected:
 		return func();
 	}
 
-	void doEnqueue(QueuedEvent && item)
+	template <typename ...A>
+	static auto doMakeQueuedEvent(A && ...args)
+		-> typename std::enable_if<sizeof...(A) == sizeof...(Args), QueuedItem>::type
+	{
+		static_assert(super::ArgumentPassingMode::canIncludeEventType, "Enqueuing arguments count doesn't match required (Event type should be included).");
+
+		using GetEvent = typename SelectGetEvent<Policies_, EventType_, HasFunctionGetEvent<Policies_, A...>::value>::Type;
+
+		return QueuedItem(
+			nullptr,
+			[&args...]() {
+				return GetEvent::getEvent(args...);
+			},
+			std::forward<A>(args)...
+		);
+	}
+
+	template <typename T, typename ...A>
+	static auto doMakeQueuedEvent(T && first, A && ...args) -> typename std::enable_if<
+			sizeof...(A) == sizeof...(Args)
+				&& ! std::is_same<typename std::decay<T>::type, EventToken>::value,
+			QueuedItem
+		>::type
+	{
+		static_assert(super::ArgumentPassingMode::canExcludeEventType, "Enqueuing arguments count doesn't match required (Event type should NOT be included).");
+
+		using GetEvent = typename SelectGetEvent<Policies_, EventType_, HasFunctionGetEvent<Policies_, T &&, A...>::value>::Type;
+
+		return QueuedItem(
+			nullptr,
+			[&first, &args...]() {
+				return GetEvent::getEvent(std::forward<T>(first), args...);
+			},
+			std::forward<A>(args)...
+		);
+	}
+
+	// The arguments are the same as directDispatch, they don't include the event
+	// unless the prototype includes the event.
+	template <typename ...A>
+	static auto doMakeQueuedEvent(const EventToken & token, A && ...args)
+		-> typename std::enable_if<sizeof...(A) == sizeof...(Args), QueuedItem>::type
+	{
+		return QueuedItem(
+			super::doGetTokenCallbackList(token),
+			[&token]() {
+				return token.getEvent();
+			},
+			std::forward<A>(args)...
+		);
+	}
+
+	template <typename F, typename T, size_t ...Indexes>
+	static void doFillArguments(F & fill, T & arguments, IndexSequence<Indexes...>)
+	{
+		fill(std::get<Indexes>(arguments)...);
+	}
+
+	template <typename T, size_t ...Indexes>
+	static typename std::decay<Event>::type doGetArgumentsEvent(const T & arguments, IndexSequence<Indexes...>)
+	{
+		using GetEvent = typename SelectGetEvent<
+			Policies_,
+			EventType_,
+			HasFunctionGetEvent<Policies_, const typename std::decay<Args>::type & ...>::value
+		>::Type;
+
+		return GetEvent::getEvent(std::get<Indexes>(arguments)...);
+	}
+
+	// Return whether the event is put in the queue, the result is void if the queue is unbounded.
+	template <typename Make>
+	EnqueueResult doEnqueueAndNotify(Make && make)
+	{
+		return doEnqueueAndNotify(std::forward<Make>(make), [](QueuedEvent &) {});
+	}
+
+	template <typename Make, typename Fill>
+	EnqueueResult doEnqueueAndNotify(Make && make, Fill && fill)
+	{
+		const bool queued = doEnqueueInPlace(make, fill, true);
+		if(queued) {
+			doNotifyQueueAvailable();
+		}
+		return static_cast<EnqueueResult>(queued);
+	}
+
+	// Return false if the queue is full and the event is rejected.
+	bool doEnqueue(QueuedItem && item, const bool canBlock)
+	{
+		if(Coalescer::enabled) {
+			std::lock_guard<Mutex> queueListLock(queueListMutex);
+			if(coalescer.replace(item)) {
+				return true;
+			}
+		}
+
+		return doAppendNewItem(
+			[&item]() {
+				return std::move(item);
+			},
+			[](QueuedEvent &) {},
+			canBlock
+		);
+	}
+
+	// The event returned by make is constructed in a free item directly (guaranteed since
+	// C++17, elided by the compilers before), then fill is invoked with it, so the event
+	// and its arguments are not moved.
+	// If the queue coalesces, the event is constructed outside of the queue, since it
+	// may be moved to a pending event.
+	template <typename Make, typename Fill>
+	bool doEnqueueInPlace(Make & make, Fill & fill, const bool canBlock)
+	{
+		if(Coalescer::enabled) {
+			QueuedItem item(make());
+			fill(item);
+			return doEnqueue(std::move(item), canBlock);
+		}
+
+		return doAppendNewItem(make, fill, canBlock);
+	}
+
+	template <typename Make, typename Fill>
+	bool doAppendNewItem(Make && make, Fill && fill, const bool canBlock)
 	{
 		BufferedItemList tempList;
 		if(! freeList.empty()) {
@@ -514,23 +1505,71 @@ protected:
 			tempList.emplace_back();
 		}
 
-		auto it = tempList.begin();
-		it->set(std::move(item));
+		tempList.begin()->setWith(make);
+		fill(tempList.begin()->get());
 
-		std::lock_guard<Mutex> queueListLock(queueListMutex);
-		queueList.splice(queueList.end(), tempList, it);
+		BufferedItemList droppedList;
+		std::size_t rejectedCount;
+		{
+			std::unique_lock<Mutex> queueListLock(queueListMutex);
+			rejectedCount = doAppendItems(queueListLock, tempList, droppedList, canBlock);
+		}
+
+		// The item is left in tempList if it's rejected, or another thread enqueued
+		// the same key after replace was checked.
+		tempList.splice(tempList.end(), droppedList);
+		if(! tempList.empty()) {
+			std::lock_guard<Mutex> queueListLock(freeListMutex);
+			freeList.splice(freeList.end(), tempList);
+		}
+
+		return rejectedCount == 0;
 	}
 
 private:
 	mutable ConditionVariable queueListConditionVariable;
 	typename Threading::template Atomic<int> queueEmptyCounter;
 	typename Threading::template Atomic<int> queueNotifyCounter;
+	mutable typename Threading::template Atomic<int> queueWaiterCounter;
 	mutable Mutex queueListMutex;
 	BufferedItemList queueList;
+	// Guarded by queueListMutex.
+	Coalescer coalescer;
+	// Guarded by queueListMutex, except the counters.
+	Limiter limiter;
 	Mutex freeListMutex;
 	BufferedItemList freeList;
+	Mutex timerMutex;
+	// Created when the first delayed event is enqueued.
+	std::unique_ptr<TimingWheel_> timingWheel;
+	// Not after the earliest delayed event, or noTick if there is none.
+	typename Threading::template Atomic<TimerTick> timerDueTick;
+	std::chrono::steady_clock::time_point timerEpoch;
+};
+
+template <typename Event, typename Prototype, typename Policies, typename Storage>
+struct SelectEventQueueBase;
+
+template <typename Event, typename Prototype, typename Policies>
+struct SelectEventQueueBase <Event, Prototype, Policies, EventQueueStorageList>
+{
+	using Type = EventQueueBase<Event, Prototype, Policies>;
 };
 
+template <typename Event, typename Prototype, typename Policies, std::size_t Capacity, typename QueueFull, typename Consumer>
+struct SelectEventQueueBase <Event, Prototype, Policies, EventQueueStorageRingBuffer<Capacity, QueueFull, Consumer> >
+{
+	using Type = RingEventQueueBase<Event, Prototype, Policies>;
+};
+
+template <typename Event, typename Prototype, typename Policies>
+using EventQueueBaseType = typename SelectEventQueueBase<
+	Event,
+	Prototype,
+	Policies,
+	typename SelectEventQueueStorage<Policies, HasTypeEventQueueStorage<Policies>::value>::Type
+>::Type;
+
 } //namespace internal_
 
 template <
@@ -539,13 +1578,13 @@ template <
 	typename Policies_ = DefaultPolicies
 >
 class EventQueue : public internal_::InheritMixins<
-		internal_::EventQueueBase<Event_, Prototype_, Policies_>,
+		internal_::EventQueueBaseType<Event_, Prototype_, Policies_>,
 		typename internal_::SelectMixins<Policies_, internal_::HasTypeMixins<Policies_>::value >::Type
 	>::Type, public TagEventDispatcher, public TagEventQueue
 {
 private:
 	using super = typename internal_::InheritMixins<
-		internal_::EventQueueBase<Event_, Prototype_, Policies_>,
+		internal_::EventQueueBaseType<Event_, Prototype_, Policies_>,
 		typename internal_::SelectMixins<Policies_, internal_::HasTypeMixins<Policies_>::value >::Type
 	>::Type;
 
@@ -67,6 +67,13 @@ protected:
 		internal_::HasTypeMixins<Policies_>::value
 	>::Type;
 
+	// A concurrent map synchronizes itself, so the listener mutex is not needed.
+	using ListenerMutex = typename std::conditional<
+		std::is_base_of<TagConcurrentMap, Map>::value,
+		SingleThreading::Mutex,
+		typename Threading::Mutex
+	>::type;
+
 public:
 	using PrototypeList = PrototypeList_;
 	using Handle = typename CallbackList_::Handle;
@@ -116,7 +123,7 @@ public:
 	template <typename C>
 	Handle appendListener(const Event & event, const C & callback)
 	{
-		std::lock_guard<Mutex> lockGuard(listenerMutex);
+		std::lock_guard<ListenerMutex> lockGuard(listenerMutex);
 
 		return eventCallbackListMap[event].append(callback);
 	}
@@ -124,7 +131,7 @@ public:
 	template <typename C>
 	Handle prependListener(const Event & event, const C & callback)
 	{
-		std::lock_guard<Mutex> lockGuard(listenerMutex);
+		std::lock_guard<ListenerMutex> lockGuard(listenerMutex);
 
 		return eventCallbackListMap[event].prepend(callback);
 	}
@@ -132,7 +139,7 @@ public:
 	template <typename C>
 	Handle insertListener(const Event & event, const C & callback, const Handle & before)
 	{
-		std::lock_guard<Mutex> lockGuard(listenerMutex);
+		std::lock_guard<ListenerMutex> lockGuard(listenerMutex);
 
 		return eventCallbackListMap[event].insert(callback, before);
 	}
@@ -255,7 +262,7 @@ private:
 	static auto doFindCallableListHelper(T * self, const Event & e)
 		-> typename std::conditional<std::is_const<T>::value, const CallbackList_ *, CallbackList_ *>::type
 	{
-		std::lock_guard<Mutex> lockGuard(self->listenerMutex);
+		std::lock_guard<ListenerMutex> lockGuard(self->listenerMutex);
 
 		auto it = self->eventCallbackListMap.find(e);
 		if(it != self->eventCallbackListMap.end()) {
@@ -287,7 +294,7 @@ private:
 
 private:
 	Map eventCallbackListMap;
-	mutable Mutex listenerMutex;
+	mutable ListenerMutex listenerMutex;
 };
 
 } //namespace internal_
@@ -54,6 +54,11 @@ private:
 	using Policies = typename super::Policies;
 	using Threading = typename super::Threading;
 	using ConditionVariable = typename Threading::ConditionVariable;
+	using QueueWait = typename SelectQueueWait<Policies_, HasTypeQueueWait<Policies_>::value>::Type;
+	using Limiter = QueueLimiter<
+		typename SelectQueueCapacity<Policies_, HasTypeQueueCapacity<Policies_>::value>::Type,
+		Threading
+	>;
 
 	struct QueuedItemBase;
 	using ItemDispatcher = void (*)(const HeterEventQueueBase *, const QueuedItemBase &);
@@ -96,6 +101,55 @@ public:
 	using Event = typename super::Event;
 	using Handle = typename super::Handle;
 	using Mutex = typename super::Mutex;
+	// enqueue returns bool if the queue is bounded.
+	using EnqueueResult = typename std::conditional<Limiter::enabled, bool, void>::type;
+
+	// Passed to the builder of enqueueBulk. It has the same enqueue function as
+	// HeterEventQueue, the events are collected and queued when the builder returns.
+	class BulkEnqueuer
+	{
+	public:
+		template <typename T, typename ...Args>
+		void enqueue(T && first, Args && ...args)
+		{
+			HeterEventQueueBase::doEnqueue<ArgumentPassingMode>(*this, std::forward<T>(first), std::forward<Args>(args)...);
+		}
+
+	private:
+		// The free items are taken from the queue on demand, at most freeItemBatchSize at once,
+		// so a small bulk doesn't take the free items that the other producers need.
+		enum : std::size_t {
+			freeItemBatchSize = 16
+		};
+
+		explicit BulkEnqueuer(HeterEventQueueBase * queue) : queue(queue), itemList(), freeItemList(), itemCount(0)
+		{
+		}
+
+		template <typename T>
+		bool doEnqueueItem(T && item)
+		{
+			if(freeItemList.empty()) {
+				queue->doTakeFreeItems(freeItemList, freeItemBatchSize);
+				if(freeItemList.empty()) {
+					freeItemList.emplace_back();
+				}
+			}
+
+			auto it = freeItemList.begin();
+			it->set(std::move(item));
+			itemList.splice(itemList.end(), freeItemList, it);
+			++itemCount;
+			return true;
+		}
+
+		HeterEventQueueBase * queue;
+		BufferedItemList itemList;
+		BufferedItemList freeItemList;
+		std::size_t itemCount;
+
+		friend class HeterEventQueueBase;
+	};
 
 public:
 	HeterEventQueueBase()
@@ -104,20 +158,30 @@ public:
 		queueListConditionVariable(),
 		queueEmptyCounter(0),
 		queueNotifyCounter(0),
+		queueWaiterCounter(0),
 		queueListMutex(),
 		queueList(),
+		limiter(),
 		freeListMutex(),
 		freeList()
 	{
 	}
 
 	HeterEventQueueBase(const HeterEventQueueBase & other)
-		: super(other)
+		:
+		super(other),
+		queueEmptyCounter(0),
+		queueNotifyCounter(0),
+		queueWaiterCounter(0)
 	{
 	}
 
 	HeterEventQueueBase(HeterEventQueueBase && other) noexcept
-		: super(std::move(other))
+		:
+		super(std::move(other)),
+		queueEmptyCounter(0),
+		queueNotifyCounter(0),
+		queueWaiterCounter(0)
 	{
 	}
 
@@ -133,10 +197,59 @@ public:
 		return *this;
 	}
 
+	// Return whether the event is put in the queue, the result is void if the queue is unbounded.
 	template <typename T, typename ...Args>
-	void enqueue(T && first, Args && ...args)
+	EnqueueResult enqueue(T && first, Args && ...args)
 	{
-		doEnqueue<ArgumentPassingMode>(std::forward<T>(first), std::forward<Args>(args)...);
+		const bool queued = doEnqueue<ArgumentPassingMode>(*this, std::forward<T>(first), std::forward<Args>(args)...);
+		if(queued) {
+			doNotifyQueueAvailable();
+		}
+		return static_cast<EnqueueResult>(queued);
+	}
+
+	// Enqueue the events which the builder adds to the BulkEnqueuer.
+	// The free items are taken in batches, the events are moved to the queue
+	// under one lock, and the waiting thread is notified once.
+	// Return the count of the enqueued events, the rejected events are not counted.
+	template <typename Builder>
+	std::size_t enqueueBulk(Builder && builder)
+	{
+		BulkEnqueuer enqueuer(this);
+
+		builder(enqueuer);
+
+		std::size_t rejectedCount = 0;
+		if(! enqueuer.itemList.empty()) {
+			{
+				std::unique_lock<Mutex> queueListLock(queueListMutex);
+				rejectedCount = doAppendItems(queueListLock, enqueuer.itemList, enqueuer.freeItemList);
+			}
+
+			doNotifyQueueAvailable();
+
+			// The rejected items are left in itemList.
+			enqueuer.freeItemList.splice(enqueuer.freeItemList.end(), enqueuer.itemList);
+		}
+
+		if(! enqueuer.freeItemList.empty()) {
+			std::lock_guard<Mutex> queueListLock(freeListMutex);
+			freeList.splice(freeList.end(), enqueuer.freeItemList);
+		}
+
+		return enqueuer.itemCount - rejectedCount;
+	}
+
+	// Each element is the arguments of one enqueue, either a std::tuple of the arguments,
+	// or the argument itself if enqueue takes only one argument.
+	template <typename Iterator>
+	std::size_t enqueueRange(Iterator first, Iterator last)
+	{
+		return enqueueBulk([first, last](BulkEnqueuer & enqueuer) {
+			for(Iterator it = first; it != last; ++it) {
+				enqueueRangeElement(enqueuer, *it);
+			}
+		});
 	}
 
 	bool emptyQueue() const
@@ -144,6 +257,19 @@ public:
 		return queueList.empty() && (queueEmptyCounter.load(std::memory_order_acquire) == 0);
 	}
 
+	// The count of the events which are rejected or dropped because the queue is full.
+	// It's always 0 if the queue is unbounded.
+	std::size_t getDroppedEventCount() const
+	{
+		return limiter.getDroppedEventCount();
+	}
+
+	// The count of the enqueues which wait because the queue is full.
+	std::size_t getBlockedEnqueueCount() const
+	{
+		return limiter.getBlockedEnqueueCount();
+	}
+
 	void clearEvents()
 	{
 		if(! queueList.empty()) {
@@ -152,6 +278,7 @@ public:
 			{
 				std::lock_guard<Mutex> queueListLock(queueListMutex);
 				std::swap(queueList, tempList);
+				limiter.takeAll();
 			}
 
 			if(! tempList.empty()) {
@@ -177,6 +304,7 @@ public:
 			{
 				std::lock_guard<Mutex> queueListLock(queueListMutex);
 				std::swap(queueList, tempList);
+				limiter.takeAll();
 			}
 
 			if(! tempList.empty()) {
@@ -208,6 +336,7 @@ public:
 				std::lock_guard<Mutex> queueListLock(queueListMutex);
 				if(! queueList.empty()) {
 					tempList.splice(tempList.end(), queueList, queueList.begin());
+					limiter.takeOne();
 				}
 			}
 
@@ -226,6 +355,22 @@ public:
 		return false;
 	}
 
+	// Process at most maxEvents events. The remaining events stay at the head of the queue.
+	bool processN(const std::size_t maxEvents)
+	{
+		ProcessCountBudget budget(maxEvents);
+		return doProcessWithBudget(budget);
+	}
+
+	// Process the events until duration elapses. The clock is checked every several events,
+	// so the time may exceed the duration by the time of processing those events.
+	template <class Rep, class Period>
+	bool processFor(const std::chrono::duration<Rep, Period> & duration)
+	{
+		ProcessTimeBudget budget(duration);
+		return doProcessWithBudget(budget);
+	}
+
 	template <typename F>
 	bool processIf(F && func)
 	{
@@ -239,6 +384,11 @@ public:
 
 	void wait() const
 	{
+		if(spinBeforePark([this]() -> bool { return doCanProcess(); }, QueueWait())) {
+			return;
+		}
+
+		CounterGuard<decltype(queueWaiterCounter)> counterGuard(queueWaiterCounter);
 		std::unique_lock<Mutex> queueListLock(queueListMutex);
 		queueListConditionVariable.wait(queueListLock, [this]() -> bool {
 			return doCanProcess();
@@ -248,6 +398,13 @@ public:
 	template <class Rep, class Period>
 	bool waitFor(const std::chrono::duration<Rep, Period> & duration) const
 	{
+		// Don't spin if the caller only polls the queue.
+		if(duration > std::chrono::duration<Rep, Period>::zero()
+			&& spinBeforePark([this]() -> bool { return doCanProcess(); }, QueueWait())) {
+			return true;
+		}
+
+		CounterGuard<decltype(queueWaiterCounter)> counterGuard(queueWaiterCounter);
 		std::unique_lock<Mutex> queueListLock(queueListMutex);
 		return queueListConditionVariable.wait_for(queueListLock, duration, [this]() -> bool {
 			return doCanProcess();
@@ -257,6 +414,62 @@ public:
 	using super::dispatch;
 
 private:
+	template <typename Budget>
+	bool doProcessWithBudget(Budget & budget)
+	{
+		if(! queueList.empty()) {
+			BufferedItemList tempList;
+			BufferedItemList idleList;
+
+			// Use a counter to tell the queue list is not empty during processing
+			// even though queueList is swapped to empty.
+			CounterGuard<decltype(queueEmptyCounter)> counterGuard(queueEmptyCounter);
+
+			std::size_t takenCount;
+			std::size_t processedCount = 0;
+			{
+				std::lock_guard<Mutex> queueListLock(queueListMutex);
+				std::swap(queueList, tempList);
+				takenCount = limiter.takeAll();
+			}
+
+			if(! tempList.empty()) {
+				while(! tempList.empty() && budget.available(1) > 0) {
+					budget.consume(1);
+
+					auto it = tempList.begin();
+					doDispatchQueuedEvent(it->template get<QueuedItemBase>());
+					it->clear();
+
+					idleList.splice(idleList.end(), tempList, it);
+					++processedCount;
+				}
+
+				if (! tempList.empty()) {
+					std::lock_guard<Mutex> queueListLock(queueListMutex);
+					queueList.splice(queueList.begin(), tempList);
+					limiter.putBack(takenCount - processedCount);
+				}
+
+				if(! idleList.empty()) {
+					std::lock_guard<Mutex> queueListLock(freeListMutex);
+					freeList.splice(freeList.end(), idleList);
+
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	void doNotifyQueueAvailable()
+	{
+		if(hasParkedWaiter(queueWaiterCounter, QueueWait()) && doCanProcess()) {
+			queueListConditionVariable.notify_one();
+		}
+	}
+
 	bool doCanProcess() const
 	{
 		return ! emptyQueue() && doCanNotifyQueueAvailable();
@@ -299,9 +512,12 @@ private:
 		// even though queueList is swapped to empty.
 		CounterGuard<decltype(queueEmptyCounter)> counterGuard(queueEmptyCounter);
 
+		std::size_t takenCount;
+		std::size_t processedCount = 0;
 		{
 			std::lock_guard<Mutex> queueListLock(queueListMutex);
 			std::swap(queueList, tempList);
+			takenCount = limiter.takeAll();
 		}
 
 		if(! tempList.empty()) {
@@ -324,6 +540,7 @@ private:
 					auto tempIt = it;
 					++it;
 					idleList.splice(idleList.end(), tempList, tempIt);
+					++processedCount;
 				}
 				else {
 					++it;
@@ -333,6 +550,7 @@ private:
 			if (! tempList.empty()) {
 				std::lock_guard<Mutex> queueListLock(queueListMutex);
 				queueList.splice(queueList.begin(), tempList);
+				limiter.putBack(takenCount - processedCount);
 			}
 
 			if(! idleList.empty()) {
@@ -370,9 +588,9 @@ private:
 		return func(std::forward<Args>(args)...);
 	}
 
-	template <typename ArgumentMode, typename T, typename ...Args>
-	auto doEnqueue(T && first, Args && ...args)
-		-> typename std::enable_if<std::is_same<ArgumentMode, ArgumentPassingIncludeEvent>::value>::type
+	template <typename ArgumentMode, typename Target, typename T, typename ...Args>
+	static auto doEnqueue(Target & target, T && first, Args && ...args)
+		-> typename std::enable_if<std::is_same<ArgumentMode, ArgumentPassingIncludeEvent>::value, bool>::type
 	{
 		using GetEvent = typename SelectGetEvent<Policies_, EventType_, HasFunctionGetEvent<Policies_, T &&, Args...>::value>::Type;
 		using PrototypeInfo = FindPrototypeByArgs<PrototypeList_, T, Args...>;
@@ -381,21 +599,17 @@ private:
 		static_assert(PrototypeInfo::index >= 0, "Can't find invoker for the given argument types.");
 		static_assert(std::tuple_size<typename PrototypeInfo::ArgsTuple>::value == 1 + sizeof...(Args), "Arguments count mismatch.");
 
-		doEnqueueItem(QueuedItemType(
+		return target.doEnqueueItem(QueuedItemType(
 			PrototypeInfo::index,
 			GetEvent::getEvent(std::forward<T>(first), args...),
 			&HeterEventQueueBase::doDispatchItem<PrototypeInfo>,
 			typename PrototypeInfo::ArgsTuple(std::forward<T>(first), std::forward<Args>(args)...)
 		));
-
-		if(doCanProcess()) {
-			queueListConditionVariable.notify_one();
-		}
 	}
 
-	template <typename ArgumentMode, typename T, typename ...Args>
-	auto doEnqueue(T && first, Args && ...args)
-		-> typename std::enable_if<std::is_same<ArgumentMode, ArgumentPassingExcludeEvent>::value>::type
+	template <typename ArgumentMode, typename Target, typename T, typename ...Args>
+	static auto doEnqueue(Target & target, T && first, Args && ...args)
+		-> typename std::enable_if<std::is_same<ArgumentMode, ArgumentPassingExcludeEvent>::value, bool>::type
 	{
 		using GetEvent = typename SelectGetEvent<Policies_, EventType_, HasFunctionGetEvent<Policies_, T &&, Args...>::value>::Type;
 		using PrototypeInfo = FindPrototypeByArgs<PrototypeList_, Args...>;
@@ -404,20 +618,17 @@ private:
 		static_assert(PrototypeInfo::index >= 0, "Can't find invoker for the given argument types.");
 		static_assert(std::tuple_size<typename PrototypeInfo::ArgsTuple>::value == sizeof...(Args), "Arguments count mismatch.");
 
-		doEnqueueItem(QueuedItemType(
+		return target.doEnqueueItem(QueuedItemType(
 			PrototypeInfo::index,
 			GetEvent::getEvent(std::forward<T>(first), args...),
 			&HeterEventQueueBase::doDispatchItem<PrototypeInfo>,
 			typename PrototypeInfo::ArgsTuple(std::forward<Args>(args)...)
 		));
-
-		if(doCanProcess()) {
-			queueListConditionVariable.notify_one();
-		}
 	}
 
+	// Return false if the queue is full and the event is rejected.
 	template <typename T>
-	void doEnqueueItem(T && item)
+	bool doEnqueueItem(T && item)
 	{
 		BufferedItemList tempList;
 		if(! freeList.empty()) {
@@ -436,16 +647,72 @@ private:
 		auto it = tempList.begin();
 		it->set(std::move(item));
 
-		std::lock_guard<Mutex> queueListLock(queueListMutex);
-		queueList.splice(queueList.end(), tempList, it);
+		BufferedItemList droppedList;
+		std::size_t rejectedCount;
+		{
+			std::unique_lock<Mutex> queueListLock(queueListMutex);
+			rejectedCount = doAppendItems(queueListLock, tempList, droppedList);
+		}
+
+		// The item is left in tempList if it's rejected.
+		tempList.splice(tempList.end(), droppedList);
+		if(! tempList.empty()) {
+			std::lock_guard<Mutex> queueListLock(freeListMutex);
+			freeList.splice(freeList.end(), tempList);
+		}
+
+		return rejectedCount == 0;
+	}
+
+	void doTakeFreeItems(BufferedItemList & itemList, const std::size_t maxCount)
+	{
+		if(! freeList.empty()) {
+			std::lock_guard<Mutex> queueListLock(freeListMutex);
+			for(std::size_t i = 0; i < maxCount && ! freeList.empty(); ++i) {
+				itemList.splice(itemList.end(), freeList, freeList.begin());
+			}
+		}
+	}
+
+	// queueListLock must be locked. Append the items to the queue list within the capacity.
+	// The items which are rejected are cleared and left in itemList, the events dropped
+	// from the queue to make room are moved to droppedList.
+	// Return the count of the rejected items.
+	std::size_t doAppendItems(
+			std::unique_lock<Mutex> & queueListLock,
+			BufferedItemList & itemList,
+			BufferedItemList & droppedList
+		)
+	{
+		if(! Limiter::enabled) {
+			queueList.splice(queueList.end(), itemList);
+			return 0;
+		}
+
+		std::size_t rejectedCount = 0;
+		for(auto it = itemList.begin(); it != itemList.end(); ) {
+			auto current = it;
+			++it;
+			if(limiter.admit(queueListLock, queueList, droppedList, true, [](const BufferedQueuedItem & /*item*/) {})) {
+				queueList.splice(queueList.end(), itemList, current);
+			}
+			else {
+				current->clear();
+				++rejectedCount;
+			}
+		}
+		return rejectedCount;
 	}
 
 private:
 	mutable ConditionVariable queueListConditionVariable;
 	typename Threading::template Atomic<int> queueEmptyCounter;
 	typename Threading::template Atomic<int> queueNotifyCounter;
+	mutable typename Threading::template Atomic<int> queueWaiterCounter;
 	mutable Mutex queueListMutex;
 	BufferedItemList queueList;
+	// Guarded by queueListMutex, except the counters.
+	Limiter limiter;
 	Mutex freeListMutex;
 	BufferedItemList freeList;
 };
@@ -0,0 +1,478 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COWCALLBACKLIST_I_H
+#define COWCALLBACKLIST_I_H
+
+#include "../eventpolicies.h"
+
+#include <functional>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <cstdint>
+
+namespace eventpp {
+
+namespace internal_ {
+
+// CallbackList storage that publishes an immutable snapshot of the callbacks.
+// append/prepend/insert/remove copy the current snapshot under the mutex and
+// swap in the new one. The snapshot is a contiguous array of shared entries, so
+// a change copies the pointers but never the callbacks, and invoking only walks
+// the array. Invoking holds a reference to the snapshot, so the callbacks added
+// during invoking are naturally not invoked, and a replaced snapshot is freed by
+// whoever releases the last reference, the list or the last invoking that still
+// holds it. remove marks the entry as removed, the invokings which still hold an
+// older snapshot skip it.
+template <
+	typename Prototype,
+	typename PoliciesType
+>
+class CowCallbackListBase;
+
+template <
+	typename PoliciesType,
+	typename ReturnType, typename ...Args
+>
+class CowCallbackListBase<
+	ReturnType (Args...),
+	PoliciesType
+>
+{
+private:
+	using Policies = PoliciesType;
+
+	using Threading = typename SelectThreading<Policies, HasTypeThreading<Policies>::value>::Type;
+
+	using Callback_ = typename SelectCallback<
+		Policies,
+		HasTypeCallback<Policies>::value,
+		std::function<ReturnType (Args...)>
+	>::Type;
+
+	using CanContinueInvoking = typename SelectCanContinueInvoking<
+		Policies, HasFunctionCanContinueInvoking<Policies, Args...>::value
+	>::Type;
+
+	using Id = std::uint64_t;
+	using Phase = unsigned int;
+
+	// An entry is shared by all snapshots which contain it.
+	struct Entry
+	{
+		template <typename C>
+		Entry(C && callback, const Id id)
+			: callback(std::forward<C>(callback)), id(id), removed(false)
+		{
+		}
+
+		Callback_ callback;
+		Id id;
+		typename Threading::template Atomic<bool> removed;
+	};
+
+	using EntryPtr = std::shared_ptr<Entry>;
+
+	// An empty list has no snapshot, a snapshot always has at least one entry.
+	struct Snapshot
+	{
+		Snapshot()
+			: referenceCount(1), entryList()
+		{
+		}
+
+		typename Threading::template Atomic<int> referenceCount;
+		std::vector<EntryPtr> entryList;
+	};
+
+	class Handle_
+	{
+	public:
+		Handle_() noexcept
+			: id(0)
+		{
+		}
+
+		operator bool () const noexcept {
+			return id != 0;
+		}
+
+		bool operator == (const Handle_ & other) const noexcept {
+			return id == other.id;
+		}
+
+		bool operator != (const Handle_ & other) const noexcept {
+			return ! operator == (other);
+		}
+
+	private:
+		explicit Handle_(const Id id) noexcept
+			: id(id)
+		{
+		}
+
+	private:
+		Id id;
+
+		friend class CowCallbackListBase;
+	};
+
+	class InvokingGuard
+	{
+	public:
+		explicit InvokingGuard(const CowCallbackListBase & callbackList)
+			: snapshot(callbackList.doAcquireSnapshot())
+		{
+		}
+
+		~InvokingGuard()
+		{
+			doReleaseSnapshot(snapshot);
+		}
+
+		const Snapshot * getSnapshot() const {
+			return snapshot;
+		}
+
+	private:
+		Snapshot * snapshot;
+	};
+
+public:
+	using Callback = Callback_;
+	using Handle = Handle_;
+	using Mutex = typename Threading::Mutex;
+
+public:
+	CowCallbackListBase() noexcept
+		:
+			snapshot(nullptr),
+			mutex(),
+			nextId(1),
+			acquiringPhase(0)
+	{
+		acquiringCounts[0].store(0);
+		acquiringCounts[1].store(0);
+	}
+
+	CowCallbackListBase(const CowCallbackListBase & other)
+		: CowCallbackListBase()
+	{
+		cloneFrom(other);
+	}
+
+	CowCallbackListBase(CowCallbackListBase && other) noexcept
+		: CowCallbackListBase()
+	{
+		swap(other);
+	}
+
+	CowCallbackListBase & operator = (const CowCallbackListBase & other) {
+		if(this != &other) {
+			CowCallbackListBase copied(other);
+			swap(copied);
+		}
+		return *this;
+	}
+
+	CowCallbackListBase & operator = (CowCallbackListBase && other) noexcept {
+		if(this != &other) {
+			CowCallbackListBase moved(std::move(other));
+			swap(moved);
+		}
+		return *this;
+	}
+
+	~CowCallbackListBase() {
+		// Don't lock mutex here since it may throw exception
+
+		doReleaseSnapshot(snapshot.load());
+	}
+
+	void swap(CowCallbackListBase & other) noexcept {
+		using std::swap;
+
+		swap(nextId, other.nextId);
+
+		Snapshot * const snapshotValue = snapshot.load();
+		snapshot.store(other.snapshot.load());
+		other.snapshot.store(snapshotValue);
+	}
+
+	bool empty() const {
+		return snapshot.load(std::memory_order_acquire) == nullptr;
+	}
+
+	operator bool() const {
+		return ! empty();
+	}
+
+	Handle append(const Callback & callback)
+	{
+		return doInsertEntry(callback, Handle(), true);
+	}
+
+	Handle append(Callback && callback)
+	{
+		return doInsertEntry(std::move(callback), Handle(), true);
+	}
+
+	Handle prepend(const Callback & callback)
+	{
+		return doInsertEntry(callback, Handle(), false);
+	}
+
+	Handle prepend(Callback && callback)
+	{
+		return doInsertEntry(std::move(callback), Handle(), false);
+	}
+
+	Handle insert(const Callback & callback, const Handle & before)
+	{
+		return doInsertEntry(callback, before, true);
+	}
+
+	Handle insert(Callback && callback, const Handle & before)
+	{
+		return doInsertEntry(std::move(callback), before, true);
+	}
+
+	bool remove(const Handle & handle)
+	{
+		std::lock_guard<Mutex> lockGuard(mutex);
+
+		const Snapshot * current = snapshot.load(std::memory_order_relaxed);
+		const int index = doFindEntry(current, handle);
+		if(index < 0) {
+			return false;
+		}
+
+		current->entryList[index]->removed.store(true, std::memory_order_release);
+
+		std::unique_ptr<Snapshot> newSnapshot;
+		if(current->entryList.size() > 1) {
+			newSnapshot.reset(new Snapshot());
+			newSnapshot->entryList.reserve(current->entryList.size() - 1);
+			newSnapshot->entryList.insert(newSnapshot->entryList.end(), current->entryList.begin(), current->entryList.begin() + index);
+			newSnapshot->entryList.insert(newSnapshot->entryList.end(), current->entryList.begin() + index + 1, current->entryList.end());
+		}
+		doPublish(newSnapshot.release());
+
+		return true;
+	}
+
+	bool ownsHandle(const Handle & handle) const
+	{
+		std::lock_guard<Mutex> lockGuard(mutex);
+
+		return doFindEntry(snapshot.load(std::memory_order_relaxed), handle) >= 0;
+	}
+
+	template <typename Func>
+	void forEach(Func && func) const
+	{
+		InvokingGuard guard(*this);
+		const Snapshot * current = guard.getSnapshot();
+		if(current != nullptr) {
+			for(const EntryPtr & entry : current->entryList) {
+				if(! doIsRemoved(*entry)) {
+					doForEachInvoke<void>(func, *entry);
+				}
+			}
+		}
+	}
+
+	template <typename Func>
+	bool forEachIf(Func && func) const
+	{
+		InvokingGuard guard(*this);
+		const Snapshot * current = guard.getSnapshot();
+		if(current != nullptr) {
+			for(const EntryPtr & entry : current->entryList) {
+				if(! doIsRemoved(*entry)) {
+					if(! doForEachInvoke<bool>(func, *entry)) {
+						return false;
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	void operator() (Args ...args) const
+	{
+		InvokingGuard guard(*this);
+		const Snapshot * current = guard.getSnapshot();
+		if(current != nullptr) {
+			for(const EntryPtr & entry : current->entryList) {
+				if(! doIsRemoved(*entry)) {
+					// Don't std::forward args, see the comment in CallbackListBase::operator().
+					entry->callback(args...);
+					if(! CanContinueInvoking::canContinueInvoking(args...)) {
+						break;
+					}
+				}
+			}
+		}
+	}
+
+private:
+	// Whether the entry is removed after the invoking acquired the snapshot.
+	static bool doIsRemoved(const Entry & entry)
+	{
+		return entry.removed.load(std::memory_order_acquire);
+	}
+
+	template <typename RT, typename Func>
+	auto doForEachInvoke(Func && func, Entry & entry) const
+		-> typename std::enable_if<CanInvoke<Func, Handle, Callback &>::value, RT>::type
+	{
+		return func(Handle(entry.id), entry.callback);
+	}
+
+	template <typename RT, typename Func>
+	auto doForEachInvoke(Func && func, Entry & entry) const
+		-> typename std::enable_if<CanInvoke<Func, Callback &>::value, RT>::type
+	{
+		return func(entry.callback);
+	}
+
+	// If before is not found, the callback is appended when atBack is true, otherwise prepended.
+	template <typename C>
+	Handle doInsertEntry(C && callback, const Handle & before, const bool atBack)
+	{
+		std::lock_guard<Mutex> lockGuard(mutex);
+
+		const Snapshot * current = snapshot.load(std::memory_order_relaxed);
+		const std::size_t size = (current == nullptr ? 0 : current->entryList.size());
+		std::size_t index = (atBack ? size : 0);
+		if(before) {
+			const int beforeIndex = doFindEntry(current, before);
+			if(beforeIndex >= 0) {
+				index = (std::size_t)beforeIndex;
+			}
+		}
+
+		const Id id = nextId++;
+		std::unique_ptr<Snapshot> newSnapshot(new Snapshot());
+		newSnapshot->entryList.reserve(size + 1);
+		if(current != nullptr) {
+			newSnapshot->entryList.insert(newSnapshot->entryList.end(), current->entryList.begin(), current->entryList.begin() + index);
+		}
+		newSnapshot->entryList.push_back(std::make_shared<Entry>(std::forward<C>(callback), id));
+		if(current != nullptr) {
+			newSnapshot->entryList.insert(newSnapshot->entryList.end(), current->entryList.begin() + index, current->entryList.end());
+		}
+		doPublish(newSnapshot.release());
+
+		return Handle(id);
+	}
+
+	static int doFindEntry(const Snapshot * current, const Handle & handle)
+	{
+		if(current != nullptr && handle) {
+			for(std::size_t i = 0; i < current->entryList.size(); ++i) {
+				if(current->entryList[i]->id == handle.id) {
+					return (int)i;
+				}
+			}
+		}
+		return -1;
+	}
+
+	// Loading the snapshot pointer and increasing the reference count is not one atomic step.
+	// The reader is counted in the acquiring count of the current phase during the two steps,
+	// so doPublish knows when no reader can still increase the count of the old snapshot.
+	Snapshot * doAcquireSnapshot() const
+	{
+		for(;;) {
+			const Phase phase = acquiringPhase.load();
+			++acquiringCounts[phase & 1];
+			// The phase may change between the load and the increment, try again.
+			if(acquiringPhase.load() == phase) {
+				Snapshot * current = snapshot.load();
+				if(current != nullptr) {
+					++current->referenceCount;
+				}
+				--acquiringCounts[phase & 1];
+				return current;
+			}
+			--acquiringCounts[phase & 1];
+		}
+	}
+
+	static void doReleaseSnapshot(Snapshot * current)
+	{
+		if(current != nullptr && --current->referenceCount == 0) {
+			delete current;
+		}
+	}
+
+	// Must be called with the mutex locked.
+	void doPublish(Snapshot * newSnapshot)
+	{
+		Snapshot * oldSnapshot = snapshot.exchange(newSnapshot);
+
+		// Wait for the readers which may have loaded the old pointer and not increased its count yet.
+		// It's only a few instructions for each reader, the readers starting after the phase
+		// is changed go to the other acquiring count and never see the old pointer.
+		const Phase phase = acquiringPhase.load();
+		acquiringPhase.store(phase + 1);
+		while(acquiringCounts[phase & 1].load() != 0) {
+			std::this_thread::yield();
+		}
+
+		doReleaseSnapshot(oldSnapshot);
+	}
+
+	void cloneFrom(const CowCallbackListBase & other)
+	{
+		Snapshot * otherSnapshot = other.doAcquireSnapshot();
+		if(otherSnapshot == nullptr) {
+			return;
+		}
+
+		std::unique_ptr<Snapshot> newSnapshot(new Snapshot());
+		try {
+			newSnapshot->entryList.reserve(otherSnapshot->entryList.size());
+			// The copied list has its own entries, removing from it doesn't mark the entries of other.
+			for(const EntryPtr & entry : otherSnapshot->entryList) {
+				newSnapshot->entryList.push_back(std::make_shared<Entry>(entry->callback, nextId++));
+			}
+		}
+		catch(...) {
+			doReleaseSnapshot(otherSnapshot);
+			throw;
+		}
+		doReleaseSnapshot(otherSnapshot);
+		snapshot.store(newSnapshot.release(), std::memory_order_release);
+	}
+
+private:
+	typename Threading::template Atomic<Snapshot *> snapshot;
+	mutable Mutex mutex;
+	Id nextId;
+	typename Threading::template Atomic<Phase> acquiringPhase;
+	mutable typename Threading::template Atomic<int> acquiringCounts[2];
+};
+
+
+} //namespace internal_
+
+} //namespace eventpp
+
+#endif
+
@@ -35,6 +35,50 @@ struct HasTypeCallback
 template <typename T, bool, typename D> struct SelectCallback { using Type = typename T::Callback; };
 template <typename T, typename D> struct SelectCallback<T, false, D> { using Type = D; };
 
+template <typename T>
+struct HasTypeCallbackListStorage
+{
+	template <typename C> static std::true_type test(typename C::CallbackListStorage *) ;
+	template <typename C> static std::false_type test(...);    
+
+	enum { value = !! decltype(test<T>(0))() };
+};
+template <typename T, bool> struct SelectCallbackListStorage { using Type = typename T::CallbackListStorage; };
+template <typename T> struct SelectCallbackListStorage <T, false> { using Type = CallbackListStorageLinkedList; };
+
+template <typename T>
+struct HasTypeNodeAllocation
+{
+	template <typename C> static std::true_type test(typename C::NodeAllocation *) ;
+	template <typename C> static std::false_type test(...);    
+
+	enum { value = !! decltype(test<T>(0))() };
+};
+template <typename T, bool> struct SelectNodeAllocation { using Type = typename T::NodeAllocation; };
+template <typename T> struct SelectNodeAllocation <T, false> { using Type = NodeAllocationDefault; };
+
+template <typename T>
+struct HasTypeEventQueueStorage
+{
+	template <typename C> static std::true_type test(typename C::EventQueueStorage *) ;
+	template <typename C> static std::false_type test(...);    
+
+	enum { value = !! decltype(test<T>(0))() };
+};
+template <typename T, bool> struct SelectEventQueueStorage { using Type = typename T::EventQueueStorage; };
+template <typename T> struct SelectEventQueueStorage <T, false> { using Type = EventQueueStorageList; };
+
+template <typename T>
+struct HasTypeQueueWait
+{
+	template <typename C> static std::true_type test(typename C::QueueWait *) ;
+	template <typename C> static std::false_type test(...);    
+
+	enum { value = !! decltype(test<T>(0))() };
+};
+template <typename T, bool> struct SelectQueueWait { using Type = typename T::QueueWait; };
+template <typename T> struct SelectQueueWait <T, false> { using Type = QueueWaitBlock; };
+
 template <typename T, typename ...Args>
 struct HasFunctionGetEvent
 {
@@ -54,6 +98,46 @@ struct DefaultGetEvent
 template <typename T, typename Key, bool> struct SelectGetEvent { using Type = T; };
 template <typename T, typename Key> struct SelectGetEvent<T, Key, false> { using Type = DefaultGetEvent<Key>; };
 
+template <typename T>
+struct HasTypeQueueCapacity
+{
+	template <typename C> static std::true_type test(typename C::QueueCapacity *) ;
+	template <typename C> static std::false_type test(...);    
+
+	enum { value = !! decltype(test<T>(0))() };
+};
+template <typename T, bool> struct SelectQueueCapacity { using Type = typename T::QueueCapacity; };
+template <typename T> struct SelectQueueCapacity <T, false> { using Type = QueueUnbounded; };
+
+template <typename T>
+struct HasTypeQueueCoalesce
+{
+	template <typename C> static std::true_type test(typename C::QueueCoalesce *) ;
+	template <typename C> static std::false_type test(...);    
+
+	enum { value = !! decltype(test<T>(0))() };
+};
+template <typename T, bool> struct SelectQueueCoalesce { using Type = typename T::QueueCoalesce; };
+template <typename T> struct SelectQueueCoalesce <T, false> { using Type = QueueCoalesceNone; };
+
+template <typename T, typename ...Args>
+struct HasFunctionGetCoalesceKey
+{
+	template <typename C> static std::true_type test(decltype(C::getCoalesceKey(std::declval<Args>()...)) *);
+	template <typename C> static std::false_type test(...);
+	
+	enum { value = !! decltype(test<T>(0))() };
+};
+struct DefaultGetCoalesceKey
+{
+	template <typename E, typename ...Args>
+	static const E & getCoalesceKey(const E & e, const Args & ...) {
+		return e;
+	}
+};
+template <typename T, bool> struct SelectGetCoalesceKey { using Type = T; };
+template <typename T> struct SelectGetCoalesceKey<T, false> { using Type = DefaultGetCoalesceKey; };
+
 template <typename T, typename ...Args>
 struct HasFunctionCanContinueInvoking
 {
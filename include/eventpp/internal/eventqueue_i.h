@@ -3,6 +3,20 @@
 
 #include <array>
 #include <cassert>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <cstddef>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#endif
 
 namespace eventpp {
 
@@ -46,6 +60,166 @@ void commonDtor(void * instance)
 	reinterpret_cast<T *>(instance)->~T();
 }
 
+template <typename T>
+struct IsTuple : std::false_type
+{
+};
+
+template <typename ...A>
+struct IsTuple <std::tuple<A...> > : std::true_type
+{
+};
+
+// used by enqueueRange. An element which is a std::tuple is unpacked to the arguments,
+// any other element is passed as the only argument.
+template <typename Enqueuer, typename T, size_t ...Indexes>
+auto enqueueTupleElement(Enqueuer & enqueuer, T && element, IndexSequence<Indexes...>)
+	-> decltype(enqueuer.enqueue(std::get<Indexes>(std::forward<T>(element))...))
+{
+	return enqueuer.enqueue(std::get<Indexes>(std::forward<T>(element))...);
+}
+
+template <typename Enqueuer, typename T>
+auto enqueueRangeElement(Enqueuer & enqueuer, T && element)
+	-> typename std::enable_if<IsTuple<typename std::decay<T>::type>::value,
+		decltype(enqueueTupleElement(
+			enqueuer,
+			std::forward<T>(element),
+			typename MakeIndexSequence<std::tuple_size<typename std::decay<T>::type>::value>::Type()
+		))
+	>::type
+{
+	return enqueueTupleElement(
+		enqueuer,
+		std::forward<T>(element),
+		typename MakeIndexSequence<std::tuple_size<typename std::decay<T>::type>::value>::Type()
+	);
+}
+
+template <typename Enqueuer, typename T>
+auto enqueueRangeElement(Enqueuer & enqueuer, T && element)
+	-> typename std::enable_if<! IsTuple<typename std::decay<T>::type>::value,
+		decltype(enqueuer.enqueue(std::forward<T>(element)))
+	>::type
+{
+	return enqueuer.enqueue(std::forward<T>(element));
+}
+
+
+// Hint the CPU that the thread is spinning.
+inline void cpuRelax()
+{
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	_mm_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+	__builtin_ia32_pause();
+#endif
+}
+
+// used by the event queues before a consumer parks on the condition variable.
+// Return true if canProcess becomes true while spinning.
+template <typename F>
+bool spinBeforePark(F && /*canProcess*/, QueueWaitBlock)
+{
+	return false;
+}
+
+template <typename F, unsigned int SpinCount, unsigned int YieldCount>
+bool spinBeforePark(F && canProcess, QueueWaitSpinThenPark<SpinCount, YieldCount>)
+{
+	for(unsigned int i = 0; i < SpinCount; ++i) {
+		if(canProcess()) {
+			return true;
+		}
+		cpuRelax();
+	}
+	for(unsigned int i = 0; i < YieldCount; ++i) {
+		if(canProcess()) {
+			return true;
+		}
+		std::this_thread::yield();
+	}
+	return false;
+}
+
+// used by the event queues to decide whether enqueue should notify the condition variable.
+// QueueWaitBlock always notifies. QueueWaitSpinThenPark only notifies if a consumer is parked,
+// the consumer increases waiterCounter before it checks the queue under the queue mutex,
+// and the producer changes the queue under the same mutex before it reads the counter,
+// so either the consumer sees the event or the producer sees the consumer.
+template <typename Counter>
+bool hasParkedWaiter(const Counter & /*waiterCounter*/, QueueWaitBlock)
+{
+	return true;
+}
+
+template <typename Counter, unsigned int SpinCount, unsigned int YieldCount>
+bool hasParkedWaiter(const Counter & waiterCounter, QueueWaitSpinThenPark<SpinCount, YieldCount>)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	return waiterCounter.load(std::memory_order_relaxed) > 0;
+}
+
+// used by processN and processFor to limit how many events are processed.
+// available(n) returns how many of the next n events can be processed,
+// consume(n) tells the budget that n events are taken.
+class ProcessCountBudget
+{
+public:
+	explicit ProcessCountBudget(const std::size_t maxCount) : remaining(maxCount) {
+	}
+
+	std::size_t available(const std::size_t n) const {
+		return (std::min)(n, remaining);
+	}
+
+	void consume(const std::size_t n) {
+		remaining -= n;
+	}
+
+private:
+	std::size_t remaining;
+};
+
+// Reading the clock is much slower than dispatching a trivial event,
+// so the clock is only checked once every checkInterval events.
+class ProcessTimeBudget
+{
+private:
+	using Clock = std::chrono::steady_clock;
+
+	enum : std::size_t {
+		checkInterval = 16
+	};
+
+public:
+	template <class Rep, class Period>
+	explicit ProcessTimeBudget(const std::chrono::duration<Rep, Period> & duration)
+		:
+			deadline(Clock::now() + std::chrono::duration_cast<Clock::duration>(duration)),
+			uncheckedCount(checkInterval),
+			expired(false)
+	{
+	}
+
+	std::size_t available(const std::size_t n) {
+		if(uncheckedCount >= checkInterval) {
+			uncheckedCount = 0;
+			expired = expired || Clock::now() >= deadline;
+		}
+		return expired ? 0 : (std::min)(n, checkInterval - uncheckedCount);
+	}
+
+	void consume(const std::size_t n) {
+		uncheckedCount += n;
+	}
+
+private:
+	Clock::time_point deadline;
+	std::size_t uncheckedCount;
+	bool expired;
+};
+
 // used by EventQueue
 template <typename T>
 class BufferedItem
@@ -76,6 +250,17 @@ public:
 		dtor = &commonDtor<T>;
 	}
 
+	// Construct the item with the value returned by make. If make returns a prvalue,
+	// it initializes the item directly. That's guaranteed since C++17; before C++17
+	// it's an elidable move, which the compilers elide but T must still be movable.
+	template <typename F>
+	void setWith(F && make) {
+		assert(dtor == nullptr);
+
+		new (buffer.data()) T(make());
+		dtor = &commonDtor<T>;
+	}
+
 	T & get() {
 		assert(dtor != nullptr);
 
@@ -104,6 +289,414 @@ private:
 	DtorFunc dtor;
 };
 
+// used by EventQueue::processEvent and clearEvents(event) to detect a QueueList which
+// can move the items of one event without scanning the list, such as IndexedQueueList.
+template <typename ItemList, typename Event>
+struct HasFunctionSpliceEvent
+{
+	template <typename C> static std::true_type test(decltype(std::declval<C &>().spliceEvent(
+		std::declval<typename C::const_iterator>(), std::declval<C &>(), std::declval<const Event &>())) *);
+	template <typename C> static std::false_type test(...);
+
+	enum { value = !! decltype(test<ItemList>(0))() };
+};
+
+// used by peekEvents, the visitor stops the visiting if it returns false.
+template <typename F, typename T>
+auto visitQueuedEvent(F & func, const T & queuedEvent)
+	-> typename std::enable_if<std::is_same<decltype(func(queuedEvent)), bool>::value, bool>::type
+{
+	return func(queuedEvent);
+}
+
+template <typename F, typename T>
+auto visitQueuedEvent(F & func, const T & queuedEvent)
+	-> typename std::enable_if<! std::is_same<decltype(func(queuedEvent)), bool>::value, bool>::type
+{
+	func(queuedEvent);
+	return true;
+}
+
+// used by EventQueue to coalesce the pending events which have the same key, see policy QueueCoalesce.
+// Item is the BufferedItem in the queue list, the functions must be called with the queue list locked.
+template <typename Item, typename GetKey, typename Coalesce>
+class QueueCoalescer;
+
+template <typename Item, typename GetKey>
+class QueueCoalescer <Item, GetKey, QueueCoalesceNone>
+{
+private:
+	using Value = typename Item::ValueType;
+
+public:
+	enum { enabled = false };
+
+	bool replace(Value & /*value*/) {
+		return false;
+	}
+
+	template <typename ItemList>
+	void append(ItemList & queueList, ItemList & itemList) {
+		queueList.splice(queueList.end(), itemList);
+	}
+
+	// The same as append, but an item is appended only if admit returns true,
+	// otherwise it's cleared and left in itemList. release is not used.
+	// Return the count of the items which are not admitted.
+	template <typename ItemList, typename Admit, typename Release>
+	std::size_t append(ItemList & queueList, ItemList & itemList, Admit && admit, Release && /*release*/) {
+		std::size_t rejectedCount = 0;
+		for(auto it = itemList.begin(); it != itemList.end(); ) {
+			auto current = it;
+			++it;
+			if(admit()) {
+				queueList.splice(queueList.end(), itemList, current);
+			}
+			else {
+				current->clear();
+				++rejectedCount;
+			}
+		}
+		return rejectedCount;
+	}
+
+	// Return the count of the items which are dropped.
+	template <typename ItemList>
+	std::size_t prepend(ItemList & queueList, ItemList & itemList) {
+		queueList.splice(queueList.begin(), itemList);
+		return 0;
+	}
+
+	void remove(const Item & /*item*/) {
+	}
+
+	void clear() {
+	}
+};
+
+// Keeps a map from the key to the pending item in the queue list.
+template <typename Item, typename GetKey>
+class QueueCoalescer <Item, GetKey, QueueCoalesceLastValue>
+{
+private:
+	using Value = typename Item::ValueType;
+	using ArgumentIndexes = typename MakeIndexSequence<
+		std::tuple_size<decltype(std::declval<Value>().arguments)>::value
+	>::Type;
+
+	template <size_t ...Indexes>
+	static auto doGetKey(const Value & value, IndexSequence<Indexes...>)
+		-> decltype(GetKey::getCoalesceKey(value.event, std::get<Indexes>(value.arguments)...))
+	{
+		return GetKey::getCoalesceKey(value.event, std::get<Indexes>(value.arguments)...);
+	}
+
+	using Key = typename std::decay<decltype(doGetKey(std::declval<const Value &>(), ArgumentIndexes()))>::type;
+
+	using ItemMap = typename std::conditional<
+		HasHash<Key>::value,
+		std::unordered_map<Key, Item *>,
+		std::map<Key, Item *>
+	>::type;
+
+public:
+	enum { enabled = true };
+
+	// Replace the pending item which has the same key as value.
+	// Return false if there is no such item.
+	bool replace(Value & value) {
+		auto it = itemMap.find(doGetKey(value, ArgumentIndexes()));
+		if(it == itemMap.end()) {
+			return false;
+		}
+		it->second->get() = std::move(value);
+		return true;
+	}
+
+	// Move the items to the end of queueList. An item which has the same key as a
+	// pending item replaces the pending item, then it's cleared and left in itemList.
+	template <typename ItemList>
+	void append(ItemList & queueList, ItemList & itemList) {
+		for(auto it = itemList.begin(); it != itemList.end(); ) {
+			auto current = it;
+			++it;
+			auto result = itemMap.insert(std::make_pair(doGetKey(current->get(), ArgumentIndexes()), &*current));
+			if(result.second) {
+				queueList.splice(queueList.end(), itemList, current);
+			}
+			else {
+				result.first->second->get() = std::move(current->get());
+				current->clear();
+			}
+		}
+	}
+
+	// The same as append, but an item which doesn't replace a pending item is appended only
+	// if admit returns true, otherwise it's cleared and left in itemList. admit may unlock the
+	// queue list while it waits, then release is called if the key becomes pending meanwhile.
+	// Return the count of the items which are not admitted.
+	template <typename ItemList, typename Admit, typename Release>
+	std::size_t append(ItemList & queueList, ItemList & itemList, Admit && admit, Release && release) {
+		std::size_t rejectedCount = 0;
+		for(auto it = itemList.begin(); it != itemList.end(); ) {
+			auto current = it;
+			++it;
+			const Key key = doGetKey(current->get(), ArgumentIndexes());
+			auto found = itemMap.find(key);
+			if(found == itemMap.end()) {
+				if(! admit()) {
+					current->clear();
+					++rejectedCount;
+					continue;
+				}
+				found = itemMap.find(key);
+				if(found == itemMap.end()) {
+					itemMap.insert(std::make_pair(key, &*current));
+					queueList.splice(queueList.end(), itemList, current);
+					continue;
+				}
+				release();
+			}
+			found->second->get() = std::move(current->get());
+			current->clear();
+		}
+		return rejectedCount;
+	}
+
+	// Move the items back to the front of queueList after they are taken but not processed.
+	// They are older than the pending items, so an item which has the same key as a
+	// pending item is dropped, then it's cleared and left in itemList.
+	// Return the count of the items which are dropped.
+	template <typename ItemList>
+	std::size_t prepend(ItemList & queueList, ItemList & itemList) {
+		std::size_t droppedCount = 0;
+		ItemList keptList;
+		for(auto it = itemList.begin(); it != itemList.end(); ) {
+			auto current = it;
+			++it;
+			if(itemMap.insert(std::make_pair(doGetKey(current->get(), ArgumentIndexes()), &*current)).second) {
+				keptList.splice(keptList.end(), itemList, current);
+			}
+			else {
+				current->clear();
+				++droppedCount;
+			}
+		}
+		queueList.splice(queueList.begin(), keptList);
+		return droppedCount;
+	}
+
+	// The item is taken from the queue list.
+	void remove(const Item & item) {
+		itemMap.erase(doGetKey(item.get(), ArgumentIndexes()));
+	}
+
+	// All items are taken from the queue list.
+	void clear() {
+		itemMap.clear();
+	}
+
+private:
+	ItemMap itemMap;
+};
+
+// used by EventQueue and HeterEventQueue to limit the count of the events in the queue list,
+// see policy QueueCapacity. The events taken by the processing are not counted.
+// The functions must be called with the queue list mutex locked, except the getters of the counters.
+template <typename QueueCapacity, typename Threading>
+class QueueLimiter;
+
+template <typename Threading>
+class QueueLimiter <QueueUnbounded, Threading>
+{
+public:
+	enum { enabled = false };
+
+	template <typename Lock, typename ItemList, typename F>
+	bool admit(Lock & /*lock*/, ItemList & /*queueList*/, ItemList & /*droppedList*/, const bool /*canBlock*/, F && /*onDrop*/) {
+		return true;
+	}
+
+	void release() {
+	}
+
+	void putBack(const std::size_t /*count*/) {
+	}
+
+	void takeOne() {
+	}
+
+	void take(const std::size_t /*count*/) {
+	}
+
+	std::size_t takeAll() {
+		return 0;
+	}
+
+	std::size_t getDroppedEventCount() const {
+		return 0;
+	}
+
+	std::size_t getBlockedEnqueueCount() const {
+		return 0;
+	}
+
+	std::size_t getOverflowEventCount() const {
+		return 0;
+	}
+};
+
+template <std::size_t Capacity, typename QueueFull, typename Threading>
+class QueueLimiter <QueueBounded<Capacity, QueueFull>, Threading>
+{
+private:
+	static_assert(Capacity > 0, "Capacity of QueueBounded must be greater than 0.");
+
+	using ConditionVariable = typename Threading::ConditionVariable;
+
+public:
+	enum { enabled = true };
+
+	QueueLimiter() : size(0), waiterCount(0), notFullConditionVariable(), droppedCount(0), blockedCount(0), overflowCount(0) {
+	}
+
+	// Make room for one event and count it. Return false if the event can't be put in the queue.
+	// If canBlock is false, the policies which wait exceed the capacity instead and count the
+	// overflow, that's for the events put in the queue by the consumer thread. QueueFullFail and
+	// QueueFullDropOldest don't wait, they apply the same. QueueFullDropOldest moves the oldest
+	// events to droppedList, onDrop is invoked with each of them before it's cleared.
+	template <typename Lock, typename ItemList, typename F>
+	bool admit(Lock & lock, ItemList & queueList, ItemList & droppedList, const bool canBlock, F && onDrop) {
+		if(size >= Capacity) {
+			if(! doMakeRoom(lock, queueList, droppedList, canBlock, onDrop, QueueFull())) {
+				++droppedCount;
+				return false;
+			}
+			if(size >= Capacity) {
+				++overflowCount;
+			}
+		}
+
+		++size;
+		// The waiters are woken up one by one, pass on if there is still room.
+		if(waiterCount > 0 && size < Capacity) {
+			notFullConditionVariable.notify_one();
+		}
+		return true;
+	}
+
+	// An admitted event is not put in the queue.
+	void release() {
+		--size;
+		doNotifyNotFull();
+	}
+
+	// The events taken but not processed are put back.
+	void putBack(const std::size_t count) {
+		size += count;
+	}
+
+	void takeOne() {
+		--size;
+		doNotifyNotFull();
+	}
+
+	void take(const std::size_t count) {
+		size -= count;
+		doNotifyNotFull();
+	}
+
+	// Return the count of the events taken.
+	std::size_t takeAll() {
+		const std::size_t count = size;
+		size = 0;
+		doNotifyNotFull();
+		return count;
+	}
+
+	std::size_t getDroppedEventCount() const {
+		return droppedCount.load(std::memory_order_relaxed);
+	}
+
+	std::size_t getBlockedEnqueueCount() const {
+		return blockedCount.load(std::memory_order_relaxed);
+	}
+
+	// The count of the events put in the queue beyond the capacity.
+	std::size_t getOverflowEventCount() const {
+		return overflowCount.load(std::memory_order_relaxed);
+	}
+
+private:
+	void doNotifyNotFull() {
+		if(waiterCount > 0) {
+			notFullConditionVariable.notify_one();
+		}
+	}
+
+	template <typename Lock, typename ItemList, typename F>
+	bool doMakeRoom(Lock & lock, ItemList & /*queueList*/, ItemList & /*droppedList*/, const bool canBlock, F && /*onDrop*/, QueueFullBlock) {
+		if(canBlock) {
+			++blockedCount;
+			CounterGuard<std::size_t> counterGuard(waiterCount);
+			notFullConditionVariable.wait(lock, [this]() -> bool {
+				return size < Capacity;
+			});
+		}
+		return true;
+	}
+
+	template <typename Lock, typename ItemList, typename F, unsigned int TimeoutMilliseconds>
+	bool doMakeRoom(Lock & lock, ItemList & /*queueList*/, ItemList & /*droppedList*/, const bool canBlock, F && /*onDrop*/, QueueFullBlockFor<TimeoutMilliseconds>) {
+		if(canBlock) {
+			++blockedCount;
+			CounterGuard<std::size_t> counterGuard(waiterCount);
+			return notFullConditionVariable.wait_for(lock, std::chrono::milliseconds(TimeoutMilliseconds), [this]() -> bool {
+				return size < Capacity;
+			});
+		}
+		return true;
+	}
+
+	template <typename Lock, typename ItemList, typename F>
+	bool doMakeRoom(Lock & lock, ItemList & /*queueList*/, ItemList & /*droppedList*/, const bool canBlock, F && /*onDrop*/, QueueFullSpin) {
+		if(canBlock) {
+			++blockedCount;
+			while(size >= Capacity) {
+				lock.unlock();
+				std::this_thread::yield();
+				lock.lock();
+			}
+		}
+		return true;
+	}
+
+	template <typename Lock, typename ItemList, typename F>
+	bool doMakeRoom(Lock & /*lock*/, ItemList & /*queueList*/, ItemList & /*droppedList*/, const bool /*canBlock*/, F && /*onDrop*/, QueueFullFail) {
+		return false;
+	}
+
+	template <typename Lock, typename ItemList, typename F>
+	bool doMakeRoom(Lock & /*lock*/, ItemList & queueList, ItemList & droppedList, const bool /*canBlock*/, F && onDrop, QueueFullDropOldest) {
+		while(size >= Capacity && ! queueList.empty()) {
+			auto it = queueList.begin();
+			onDrop(*it);
+			it->clear();
+			droppedList.splice(droppedList.end(), queueList, it);
+			--size;
+			++droppedCount;
+		}
+		return size < Capacity;
+	}
+
+private:
+	std::size_t size;
+	std::size_t waiterCount;
+	ConditionVariable notFullConditionVariable;
+	typename Threading::template Atomic<std::size_t> droppedCount;
+	typename Threading::template Atomic<std::size_t> blockedCount;
+	typename Threading::template Atomic<std::size_t> overflowCount;
+};
 
 // used by HeterEventQueue
 template <size_t Size>
@@ -0,0 +1,244 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NODEPOOL_I_H
+#define NODEPOOL_I_H
+
+#include "../eventpolicies.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <new>
+
+namespace eventpp {
+
+namespace internal_ {
+
+// A pool of fixed size memory blocks. The block size is determined by the first allocation,
+// larger requests go to operator new directly.
+// The pool is shared by the allocators in the shared_ptr control blocks, so it's alive
+// until the last node and the last weak pointer (Handle) to the node are gone.
+template <typename Mutex>
+class NodePool
+{
+private:
+	enum {
+		blocksPerChunk = 64
+	};
+
+	struct FreeBlock
+	{
+		FreeBlock * next;
+	};
+
+public:
+	NodePool()
+		: mutex(), blockSize(0), freeHead(nullptr), chunkList()
+	{
+	}
+
+	~NodePool()
+	{
+		for(void * chunk : chunkList) {
+			::operator delete(chunk);
+		}
+	}
+
+	NodePool(const NodePool &) = delete;
+	NodePool & operator = (const NodePool &) = delete;
+
+	void * allocate(const std::size_t size)
+	{
+		std::unique_lock<Mutex> lockGuard(mutex);
+
+		if(blockSize == 0) {
+			constexpr std::size_t alignment = alignof(std::max_align_t);
+			blockSize = (size + alignment - 1) / alignment * alignment;
+		}
+		if(size > blockSize) {
+			lockGuard.unlock();
+			return ::operator new(size);
+		}
+
+		if(freeHead == nullptr) {
+			doGrow();
+		}
+		FreeBlock * block = freeHead;
+		freeHead = block->next;
+		return block;
+	}
+
+	void deallocate(void * p, const std::size_t size)
+	{
+		std::unique_lock<Mutex> lockGuard(mutex);
+
+		if(size > blockSize) {
+			lockGuard.unlock();
+			::operator delete(p);
+			return;
+		}
+
+		FreeBlock * block = static_cast<FreeBlock *>(p);
+		block->next = freeHead;
+		freeHead = block;
+	}
+
+private:
+	void doGrow()
+	{
+		char * chunk = static_cast<char *>(::operator new(blockSize * blocksPerChunk));
+		chunkList.push_back(chunk);
+		for(std::size_t i = blocksPerChunk; i > 0; --i) {
+			FreeBlock * block = reinterpret_cast<FreeBlock *>(chunk + (i - 1) * blockSize);
+			block->next = freeHead;
+			freeHead = block;
+		}
+	}
+
+private:
+	Mutex mutex;
+	std::size_t blockSize;
+	FreeBlock * freeHead;
+	std::vector<void *> chunkList;
+};
+
+template <typename T, typename Mutex>
+class NodePoolAllocator
+{
+public:
+	using value_type = T;
+	using Pool = NodePool<Mutex>;
+
+	template <typename U>
+	struct rebind
+	{
+		using other = NodePoolAllocator<U, Mutex>;
+	};
+
+public:
+	explicit NodePoolAllocator(std::shared_ptr<Pool> pool) noexcept
+		: pool(std::move(pool))
+	{
+	}
+
+	template <typename U>
+	NodePoolAllocator(const NodePoolAllocator<U, Mutex> & other) noexcept
+		: pool(other.pool)
+	{
+	}
+
+	T * allocate(const std::size_t n)
+	{
+		return static_cast<T *>(pool->allocate(sizeof(T) * n));
+	}
+
+	void deallocate(T * p, const std::size_t n) noexcept
+	{
+		pool->deallocate(p, sizeof(T) * n);
+	}
+
+	template <typename U>
+	bool operator == (const NodePoolAllocator<U, Mutex> & other) const noexcept {
+		return pool == other.pool;
+	}
+
+	template <typename U>
+	bool operator != (const NodePoolAllocator<U, Mutex> & other) const noexcept {
+		return pool != other.pool;
+	}
+
+private:
+	template <typename U, typename M>
+	friend class NodePoolAllocator;
+
+	std::shared_ptr<Pool> pool;
+};
+
+template <typename Node, typename Threading, typename NodeAllocation>
+class NodeFactory;
+
+template <typename Node, typename Threading>
+class NodeFactory <Node, Threading, NodeAllocationDefault>
+{
+public:
+	template <typename ...A>
+	std::shared_ptr<Node> allocate(typename Threading::Mutex & /*mutex*/, A && ...args)
+	{
+		return std::make_shared<Node>(std::forward<A>(args)...);
+	}
+
+	void swap(NodeFactory & /*other*/) noexcept {
+	}
+};
+
+template <typename Node, typename Threading>
+class NodeFactory <Node, Threading, NodeAllocationPooled>
+{
+private:
+	using Mutex = typename Threading::Mutex;
+	using Pool = NodePool<Mutex>;
+
+public:
+	NodeFactory() noexcept
+		: pool(), hasPool(false)
+	{
+	}
+
+	// Each CallbackList has its own pool, don't share it in copying.
+	NodeFactory(const NodeFactory &) noexcept
+		: NodeFactory()
+	{
+	}
+
+	NodeFactory & operator = (const NodeFactory &) noexcept {
+		return *this;
+	}
+
+	// mutex is the mutex of the CallbackList, it guards creating the pool.
+	template <typename ...A>
+	std::shared_ptr<Node> allocate(Mutex & mutex, A && ...args)
+	{
+		// The pool is created on demand, so an empty CallbackList doesn't allocate anything.
+		if(! hasPool.load(std::memory_order_acquire)) {
+			std::lock_guard<Mutex> lockGuard(mutex);
+			if(! pool) {
+				pool = std::make_shared<Pool>();
+				hasPool.store(true, std::memory_order_release);
+			}
+		}
+		return std::allocate_shared<Node>(NodePoolAllocator<Node, Mutex>(pool), std::forward<A>(args)...);
+	}
+
+	void swap(NodeFactory & other) noexcept {
+		using std::swap;
+		swap(pool, other.pool);
+
+		const bool value = hasPool.load();
+		hasPool.store(other.hasPool.load());
+		other.hasPool.store(value);
+	}
+
+private:
+	std::shared_ptr<Pool> pool;
+	typename Threading::template Atomic<bool> hasPool;
+};
+
+
+} //namespace internal_
+
+} //namespace eventpp
+
+#endif
+
@@ -0,0 +1,991 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RINGEVENTQUEUE_I_H
+#define RINGEVENTQUEUE_I_H
+
+#include "../eventdispatcher.h"
+#include "eventqueue_i.h"
+
+#include <type_traits>
+#include <tuple>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+
+namespace eventpp {
+
+namespace internal_ {
+
+// EventQueue storage that keeps the queued events in a bounded ring of preallocated
+// slots. Each slot has a sequence number which tells whether it's free or holds a
+// published event. A producer claims a slot with a CAS on the tail, constructs the
+// event in it and publishes it by storing the sequence, so enqueue doesn't lock any
+// mutex or allocate memory.
+// With a single consumer, the consumer side is guarded by a mutex which is locked
+// once per process(), and it walks the slots from the head without any CAS.
+// With multiple consumers, each consumer claims a batch of published slots with a
+// CAS on the head, dispatches them in place and then frees them, so the consumers
+// process the queue concurrently without any lock.
+template <
+	typename EventType_,
+	typename Prototype_,
+	typename Policies_
+>
+class RingEventQueueBase;
+
+template <
+	typename EventType_,
+	typename Policies_,
+	typename ReturnType, typename ...Args
+>
+class RingEventQueueBase <
+		EventType_,
+		ReturnType (Args...),
+		Policies_
+	> : public EventDispatcherBase<
+		EventType_,
+		ReturnType (Args...),
+		Policies_,
+		RingEventQueueBase <
+			EventType_,
+			ReturnType (Args...),
+			Policies_
+		>
+	>
+{
+private:
+	using super = EventDispatcherBase<
+		EventType_,
+		ReturnType (Args...),
+		Policies_,
+		RingEventQueueBase <
+			EventType_,
+			ReturnType (Args...),
+			Policies_
+		>
+	>;
+
+	using Policies = typename super::Policies;
+	using Threading = typename super::Threading;
+	using ConditionVariable = typename Threading::ConditionVariable;
+	using QueueWait = typename SelectQueueWait<Policies_, HasTypeQueueWait<Policies_>::value>::Type;
+
+	using Storage = typename SelectEventQueueStorage<Policies_, HasTypeEventQueueStorage<Policies_>::value>::Type;
+	using QueueFullPolicy = typename Storage::QueueFullPolicy;
+	using ConsumerPolicy = typename Storage::ConsumerPolicy;
+
+	enum {
+		multipleConsumers = std::is_same<ConsumerPolicy, QueueMultipleConsumers>::value
+	};
+
+	// Multiple consumers claim the slots with CAS, they don't need the consumer mutex.
+	using ConsumerMutex = typename std::conditional<
+		multipleConsumers,
+		SingleThreading::Mutex,
+		typename Threading::Mutex
+	>::type;
+
+	using QueuedEventArgumentsType = std::tuple<typename std::decay<Args>::type...>;
+
+	struct QueuedEvent_
+	{
+		typename std::decay<typename super::Event>::type event;
+		QueuedEventArgumentsType arguments;
+
+		typename super::Event getEvent() const {
+			return event;
+		}
+
+		template <std::size_t N>
+		auto getArgument() const
+			-> typename std::tuple_element<N, std::tuple<Args...> >::type {
+			return std::get<N>(arguments);
+		}
+	};
+
+protected:
+	// The item stored in the slots. callbackList is not nullptr if the event is
+	// enqueued with an EventToken, then processing doesn't look up the event.
+	struct QueuedItem : public QueuedEvent_
+	{
+		// makeEvent returns the event, so the event initializes the member directly as the arguments do.
+		template <typename MakeEvent, typename ...A>
+		QueuedItem(typename super::CallbackListType * callbackList, MakeEvent && makeEvent, A && ...args)
+			:
+				QueuedEvent_{ makeEvent(), QueuedEventArgumentsType(std::forward<A>(args)...) },
+				callbackList(callbackList)
+		{
+		}
+
+		typename super::CallbackListType * callbackList;
+	};
+
+private:
+
+	using Sequence = std::size_t;
+	using Atomic = typename Threading::template Atomic<Sequence>;
+
+	enum : Sequence {
+		capacity = Storage::capacity,
+		mask = capacity - 1
+	};
+
+	static_assert(capacity >= 2 && (capacity & mask) == 0, "The capacity of EventQueueStorageRingBuffer must be power of 2.");
+	// A slot is claimed before the event is moved in, a claimed slot can't be given back,
+	// and the consumer would wait for it forever if the move throws.
+	static_assert(std::is_nothrow_move_constructible<QueuedItem>::value,
+		"EventQueueStorageRingBuffer requires the event and the arguments to be nothrow move constructible.");
+
+	enum : std::size_t {
+		cacheLineSize = 64
+	};
+
+	// How many slots a consumer claims at once. A single consumer doesn't need to
+	// batch since it doesn't CAS on the head.
+	enum : Sequence {
+		claimBatchSize = multipleConsumers ? 16 : 1
+	};
+
+	struct Slot
+	{
+		// sequence == position: the slot is free for the producer at position.
+		// sequence == position + 1: the slot holds the published event at position.
+		Atomic sequence;
+		BufferedItem<QueuedItem> item;
+	};
+
+public:
+	using QueuedEvent = QueuedEvent_;
+	using Event = typename super::Event;
+	using Handle = typename super::Handle;
+	using Callback = typename super::Callback;
+	using Mutex = typename super::Mutex;
+	using EventToken = typename super::EventToken;
+
+	struct DisableQueueNotify
+	{
+		DisableQueueNotify(RingEventQueueBase * queue)
+			: queue(queue)
+		{
+			++queue->queueNotifyCounter;
+		}
+
+		~DisableQueueNotify()
+		{
+			--queue->queueNotifyCounter;
+
+			if(queue->doCanNotifyQueueAvailable() && ! queue->emptyQueue()) {
+				std::lock_guard<Mutex> queueListLock(queue->queueListMutex);
+				queue->queueListConditionVariable.notify_one();
+			}
+		}
+
+		RingEventQueueBase * queue;
+	};
+
+	// Passed to the builder of enqueueBulk. enqueue returns false if the queue is full
+	// and QueueFull is QueueFullFail.
+	class BulkEnqueuer
+	{
+	public:
+		template <typename ...A>
+		auto enqueue(A && ...args) -> typename std::enable_if<sizeof...(A) == sizeof...(Args), bool>::type
+		{
+			return doAddItem(RingEventQueueBase::doMakeQueuedEvent(std::forward<A>(args)...));
+		}
+
+		template <typename T, typename ...A>
+		auto enqueue(T && first, A && ...args) -> typename std::enable_if<
+				sizeof...(A) == sizeof...(Args)
+					&& ! std::is_same<typename std::decay<T>::type, EventToken>::value,
+				bool
+			>::type
+		{
+			return doAddItem(RingEventQueueBase::doMakeQueuedEvent(std::forward<T>(first), std::forward<A>(args)...));
+		}
+
+		template <typename ...A>
+		auto enqueue(const EventToken & token, A && ...args) -> typename std::enable_if<sizeof...(A) == sizeof...(Args), bool>::type
+		{
+			return doAddItem(RingEventQueueBase::doMakeQueuedEvent(token, std::forward<A>(args)...));
+		}
+
+	private:
+		explicit BulkEnqueuer(RingEventQueueBase * queue) : queue(queue), enqueuedCount(0)
+		{
+		}
+
+		bool doAddItem(QueuedItem && item)
+		{
+			if(queue->doPublish(std::move(item))) {
+				++enqueuedCount;
+				return true;
+			}
+
+			return false;
+		}
+
+		RingEventQueueBase * queue;
+		std::size_t enqueuedCount;
+
+		friend class RingEventQueueBase;
+	};
+
+public:
+	RingEventQueueBase()
+		:
+			super(),
+			slotList(new Slot[capacity]),
+			tail(0),
+			head(0),
+			queueWaiterCounter(0),
+			notFullWaiterCounter(0),
+			queueNotifyCounter(0),
+			queueListConditionVariable(),
+			queueListMutex(),
+			notFullConditionVariable(),
+			notFullMutex(),
+			consumerMutex()
+	{
+		for(Sequence i = 0; i < capacity; ++i) {
+			slotList[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	RingEventQueueBase(const RingEventQueueBase & other)
+		: RingEventQueueBase()
+	{
+		super::operator = (other);
+	}
+
+	RingEventQueueBase(RingEventQueueBase && other) noexcept
+		: RingEventQueueBase()
+	{
+		super::operator = (std::move(other));
+		other.doResetQueuedCallbackLists();
+	}
+
+	RingEventQueueBase & operator = (const RingEventQueueBase & other)
+	{
+		super::operator = (other);
+		doResetQueuedCallbackLists();
+		return *this;
+	}
+
+	RingEventQueueBase & operator = (RingEventQueueBase && other) noexcept
+	{
+		super::operator = (std::move(other));
+		doResetQueuedCallbackLists();
+		other.doResetQueuedCallbackLists();
+		return *this;
+	}
+
+	template <typename ...A>
+	auto enqueue(A && ...args) -> typename std::enable_if<sizeof...(A) == sizeof...(Args), bool>::type
+	{
+		return doEnqueue(doMakeQueuedEvent(std::forward<A>(args)...));
+	}
+
+	template <typename T, typename ...A>
+	auto enqueue(T && first, A && ...args) -> typename std::enable_if<
+			sizeof...(A) == sizeof...(Args)
+				&& ! std::is_same<typename std::decay<T>::type, EventToken>::value,
+			bool
+		>::type
+	{
+		return doEnqueue(doMakeQueuedEvent(std::forward<T>(first), std::forward<A>(args)...));
+	}
+
+	template <typename ...A>
+	auto enqueue(const EventToken & token, A && ...args) -> typename std::enable_if<sizeof...(A) == sizeof...(Args), bool>::type
+	{
+		return doEnqueue(doMakeQueuedEvent(token, std::forward<A>(args)...));
+	}
+
+	// Each event still claims its own slot, the waiting thread is notified once.
+	// Return the number of enqueued events, which is less than the number of events
+	// the builder added if the queue is full and QueueFull is QueueFullFail.
+	template <typename Builder>
+	std::size_t enqueueBulk(Builder && builder)
+	{
+		BulkEnqueuer enqueuer(this);
+		builder(enqueuer);
+
+		if(enqueuer.enqueuedCount > 0) {
+			doNotifyQueueAvailable();
+		}
+
+		return enqueuer.enqueuedCount;
+	}
+
+	template <typename Iterator>
+	std::size_t enqueueRange(Iterator first, Iterator last)
+	{
+		return enqueueBulk([first, last](BulkEnqueuer & enqueuer) {
+			for(Iterator it = first; it != last; ++it) {
+				enqueueRangeElement(enqueuer, *it);
+			}
+		});
+	}
+
+	bool emptyQueue() const
+	{
+		const Sequence position = head.load(std::memory_order_acquire);
+		return slotList[position & mask].sequence.load(std::memory_order_acquire) != position + 1;
+	}
+
+	void clearEvents()
+	{
+		if(! emptyQueue()) {
+			std::lock_guard<ConsumerMutex> consumerLock(consumerMutex);
+
+			const Sequence end = tail.load(std::memory_order_acquire);
+			Sequence position;
+			Sequence count;
+			while((count = doClaim(position, end, claimBatchSize)) > 0) {
+				for(; count > 0; --count, ++position) {
+					slotList[position & mask].item.clear();
+					doReleaseSlot(position);
+				}
+			}
+
+			doNotifyNotFull();
+		}
+	}
+
+	bool process()
+	{
+		if(! emptyQueue()) {
+			std::lock_guard<ConsumerMutex> consumerLock(consumerMutex);
+
+			// Events enqueued during processing are left to the next process().
+			const Sequence end = tail.load(std::memory_order_acquire);
+			Sequence position;
+			Sequence count;
+			bool processed = false;
+			while((count = doClaim(position, end, claimBatchSize)) > 0) {
+				for(; count > 0; --count, ++position) {
+					doDispatchSlot(position);
+				}
+				processed = true;
+			}
+
+			if(processed) {
+				doNotifyNotFull();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool processOne()
+	{
+		if(! emptyQueue()) {
+			std::lock_guard<ConsumerMutex> consumerLock(consumerMutex);
+
+			Sequence position;
+			if(doClaim(position, tail.load(std::memory_order_acquire), 1) > 0) {
+				doDispatchSlot(position);
+				doNotifyNotFull();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Process at most maxEvents events. The remaining events stay at the head of the queue.
+	bool processN(const std::size_t maxEvents)
+	{
+		ProcessCountBudget budget(maxEvents);
+		return doProcessWithBudget(budget);
+	}
+
+	// Process the events until duration elapses. The clock is checked every several events,
+	// so the time may exceed the duration by the time of processing those events.
+	template <class Rep, class Period>
+	bool processFor(const std::chrono::duration<Rep, Period> & duration)
+	{
+		ProcessTimeBudget budget(duration);
+		return doProcessWithBudget(budget);
+	}
+
+	template <typename Predictor>
+	bool processIf(Predictor && predictor)
+	{
+		static_assert(! multipleConsumers, "processIf is not supported with QueueMultipleConsumers.");
+
+		if(! emptyQueue()) {
+			std::lock_guard<ConsumerMutex> consumerLock(consumerMutex);
+
+			const Sequence end = tail.load(std::memory_order_acquire);
+			const Sequence begin = head.load(std::memory_order_relaxed);
+			Sequence position = begin;
+			bool processed = false;
+			while(position != end && doIsPublished(position)) {
+				BufferedItem<QueuedItem> & item = slotList[position & mask].item;
+				if(doInvokeFuncWithQueuedEvent(
+						predictor,
+						item.get(),
+						typename MakeIndexSequence<sizeof...(Args)>::Type())
+					) {
+					doDispatchQueuedEvent(
+						item.get(),
+						typename MakeIndexSequence<sizeof...(Args)>::Type()
+					);
+					item.clear();
+					processed = true;
+				}
+				++position;
+			}
+
+			if(processed) {
+				// Move the remaining events to the back of the walked slots, keeping
+				// their order, then release the emptied slots at the head.
+				Sequence target = position;
+				while(position != begin) {
+					--position;
+					BufferedItem<QueuedItem> & item = slotList[position & mask].item;
+					if(! item.empty()) {
+						--target;
+						if(target != position) {
+							slotList[target & mask].item.set(std::move(item.get()));
+							item.clear();
+						}
+					}
+				}
+				for(position = begin; position != target; ++position) {
+					doReleaseSlot(position);
+				}
+
+				doNotifyNotFull();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	template <typename Predictor>
+	bool processUntil(Predictor && predictor)
+	{
+		static_assert(! multipleConsumers, "processUntil is not supported with QueueMultipleConsumers.");
+
+		if(! emptyQueue()) {
+			std::lock_guard<ConsumerMutex> consumerLock(consumerMutex);
+
+			const Sequence end = tail.load(std::memory_order_acquire);
+			Sequence position = head.load(std::memory_order_relaxed);
+			const Sequence begin = position;
+			while(position != end && doIsPublished(position)) {
+				if(doInvokeFuncWithQueuedEvent(
+						predictor,
+						slotList[position & mask].item.get(),
+						typename MakeIndexSequence<sizeof...(Args)>::Type())
+					) {
+					break;
+				}
+				doDispatchSlot(position);
+				++position;
+			}
+
+			if(position != begin) {
+				doNotifyNotFull();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void wait() const
+	{
+		if(spinBeforePark([this]() -> bool { return doCanProcess(); }, QueueWait())) {
+			return;
+		}
+
+		CounterGuard<Atomic> counterGuard(queueWaiterCounter);
+		std::unique_lock<Mutex> queueListLock(queueListMutex);
+		queueListConditionVariable.wait(queueListLock, [this]() -> bool {
+			return doCanProcess();
+		});
+	}
+
+	template <class Rep, class Period>
+	bool waitFor(const std::chrono::duration<Rep, Period> & duration) const
+	{
+		// Don't spin if the caller only polls the queue.
+		if(duration > std::chrono::duration<Rep, Period>::zero()
+			&& spinBeforePark([this]() -> bool { return doCanProcess(); }, QueueWait())) {
+			return true;
+		}
+
+		CounterGuard<Atomic> counterGuard(queueWaiterCounter);
+		std::unique_lock<Mutex> queueListLock(queueListMutex);
+		return queueListConditionVariable.wait_for(queueListLock, duration, [this]() -> bool {
+			return doCanProcess();
+		});
+	}
+
+	using super::dispatch;
+
+	template <typename U>
+	auto dispatch(const U & queuedEvent)
+		-> typename std::enable_if<std::is_same<U, QueuedEvent>::value, void>::type
+	{
+		doDispatchQueuedEvent(
+			queuedEvent,
+			typename MakeIndexSequence<sizeof...(Args)>::Type()
+		);
+	}
+
+	bool peekEvent(QueuedEvent * queuedEvent)
+	{
+		static_assert(! multipleConsumers, "peekEvent is not supported with QueueMultipleConsumers.");
+
+		if(! emptyQueue()) {
+			std::lock_guard<ConsumerMutex> consumerLock(consumerMutex);
+
+			const Sequence position = head.load(std::memory_order_relaxed);
+			if(doIsPublished(position)) {
+				*queuedEvent = slotList[position & mask].item.get();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool takeEvent(QueuedEvent * queuedEvent)
+	{
+		if(! emptyQueue()) {
+			std::lock_guard<ConsumerMutex> consumerLock(consumerMutex);
+
+			Sequence position;
+			if(doClaim(position, tail.load(std::memory_order_acquire), 1) > 0) {
+				BufferedItem<QueuedItem> & item = slotList[position & mask].item;
+				*queuedEvent = std::move(item.get());
+				item.clear();
+				doReleaseSlot(position);
+				doNotifyNotFull();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	template <typename OutputIterator>
+	std::size_t takeEvents(OutputIterator out, const std::size_t maxCount)
+	{
+		std::size_t takenCount = 0;
+
+		if(! emptyQueue() && maxCount > 0) {
+			std::lock_guard<ConsumerMutex> consumerLock(consumerMutex);
+
+			const Sequence end = tail.load(std::memory_order_acquire);
+			Sequence position;
+			Sequence count;
+			while(takenCount < maxCount
+				&& (count = doClaim(position, end, (std::min)(maxCount - takenCount, static_cast<Sequence>(claimBatchSize)))) > 0
+			) {
+				takenCount += count;
+				for(; count > 0; --count, ++position) {
+					BufferedItem<QueuedItem> & item = slotList[position & mask].item;
+					*out = static_cast<QueuedEvent &&>(item.get());
+					++out;
+					item.clear();
+					doReleaseSlot(position);
+				}
+			}
+
+			if(takenCount > 0) {
+				doNotifyNotFull();
+			}
+		}
+
+		return takenCount;
+	}
+
+	template <typename F>
+	void peekEvents(F && func)
+	{
+		static_assert(! multipleConsumers, "peekEvents is not supported with QueueMultipleConsumers.");
+
+		if(! emptyQueue()) {
+			std::lock_guard<ConsumerMutex> consumerLock(consumerMutex);
+
+			const Sequence end = tail.load(std::memory_order_acquire);
+			for(Sequence position = head.load(std::memory_order_relaxed);
+				position != end && doIsPublished(position);
+				++position
+			) {
+				if(! visitQueuedEvent(func, static_cast<const QueuedEvent &>(slotList[position & mask].item.get()))) {
+					break;
+				}
+			}
+		}
+	}
+
+protected:
+	bool doCanProcess() const
+	{
+		return ! emptyQueue() && doCanNotifyQueueAvailable();
+	}
+
+	bool doCanNotifyQueueAvailable() const
+	{
+		return queueNotifyCounter.load(std::memory_order_acquire) == 0;
+	}
+
+	template <typename T, size_t ...Indexes>
+	void doDispatchQueuedEvent(T && item, IndexSequence<Indexes...>)
+	{
+		typename super::CallbackListType * callbackList = doGetQueuedCallbackList(item);
+		if(callbackList != nullptr) {
+			this->directDispatch(
+				super::doMakeEventToken(item.event, callbackList),
+				std::get<Indexes>(item.arguments)...
+			);
+		}
+		else {
+			this->directDispatch(item.event, std::get<Indexes>(item.arguments)...);
+		}
+	}
+
+	static typename super::CallbackListType * doGetQueuedCallbackList(const QueuedItem & item)
+	{
+		return item.callbackList;
+	}
+
+	// The callback lists which the queued tokens point to belong to the replaced
+	// listeners after the queue is assigned, so the queued events are looked up again.
+	// The queue must not be used by other threads during the assignment.
+	void doResetQueuedCallbackLists()
+	{
+		std::lock_guard<ConsumerMutex> consumerLock(consumerMutex);
+
+		const Sequence end = tail.load(std::memory_order_acquire);
+		for(Sequence position = head.load(std::memory_order_relaxed);
+			position != end && doIsPublished(position);
+			++position
+		) {
+			slotList[position & mask].item.get().callbackList = nullptr;
+		}
+	}
+
+	// The event passed to dispatch doesn't keep the token.
+	static typename super::CallbackListType * doGetQueuedCallbackList(const QueuedEvent & /*item*/)
+	{
+		return nullptr;
+	}
+
+	template <typename F, typename T, size_t ...Indexes>
+	bool doInvokeFuncWithQueuedEvent(F && func, T && item, IndexSequence<Indexes...>) const
+	{
+		return doInvokeFuncWithQueuedEventHelper(std::forward<F>(func), std::get<Indexes>(item.arguments)...);
+	}
+
+	template <typename F>
+	auto doInvokeFuncWithQueuedEventHelper(F && func, Args ...args) const
+		-> typename std::enable_if<! CanInvoke<F>::value, bool>::type
+	{
+		return func(std::forward<Args>(args)...);
+	}
+
+	template <typename F>
+	auto doInvokeFuncWithQueuedEventHelper(F && func, Args .../*args*/) const
+		-> typename std::enable_if<CanInvoke<F>::value, bool>::type
+	{
+		return func();
+	}
+
+	template <typename ...A>
+	static auto doMakeQueuedEvent(A && ...args)
+		-> typename std::enable_if<sizeof...(A) == sizeof...(Args), QueuedItem>::type
+	{
+		static_assert(super::ArgumentPassingMode::canIncludeEventType, "Enqueuing arguments count doesn't match required (Event type should be included).");
+
+		using GetEvent = typename SelectGetEvent<Policies_, EventType_, HasFunctionGetEvent<Policies_, A...>::value>::Type;
+
+		return QueuedItem(
+			nullptr,
+			[&args...]() {
+				return GetEvent::getEvent(args...);
+			},
+			std::forward<A>(args)...
+		);
+	}
+
+	template <typename T, typename ...A>
+	static auto doMakeQueuedEvent(T && first, A && ...args) -> typename std::enable_if<
+			sizeof...(A) == sizeof...(Args)
+				&& ! std::is_same<typename std::decay<T>::type, EventToken>::value,
+			QueuedItem
+		>::type
+	{
+		static_assert(super::ArgumentPassingMode::canExcludeEventType, "Enqueuing arguments count doesn't match required (Event type should NOT be included).");
+
+		using GetEvent = typename SelectGetEvent<Policies_, EventType_, HasFunctionGetEvent<Policies_, T &&, A...>::value>::Type;
+
+		return QueuedItem(
+			nullptr,
+			[&first, &args...]() {
+				return GetEvent::getEvent(std::forward<T>(first), args...);
+			},
+			std::forward<A>(args)...
+		);
+	}
+
+	template <typename ...A>
+	static auto doMakeQueuedEvent(const EventToken & token, A && ...args)
+		-> typename std::enable_if<sizeof...(A) == sizeof...(Args), QueuedItem>::type
+	{
+		return QueuedItem(
+			super::doGetTokenCallbackList(token),
+			[&token]() {
+				return token.getEvent();
+			},
+			std::forward<A>(args)...
+		);
+	}
+
+	template <typename Budget>
+	bool doProcessWithBudget(Budget & budget)
+	{
+		if(! emptyQueue()) {
+			std::lock_guard<ConsumerMutex> consumerLock(consumerMutex);
+
+			const Sequence end = tail.load(std::memory_order_acquire);
+			Sequence position;
+			Sequence count;
+			bool processed = false;
+			for(;;) {
+				const Sequence maxCount = budget.available(claimBatchSize);
+				if(maxCount == 0) {
+					break;
+				}
+				count = doClaim(position, end, maxCount);
+				if(count == 0) {
+					break;
+				}
+				budget.consume(count);
+				for(; count > 0; --count, ++position) {
+					doDispatchSlot(position);
+				}
+				processed = true;
+			}
+
+			if(processed) {
+				doNotifyNotFull();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool doEnqueue(QueuedItem && item)
+	{
+		if(doPublish(std::move(item))) {
+			doNotifyQueueAvailable();
+			return true;
+		}
+
+		return false;
+	}
+
+	// Store the item in a slot without notifying the consumer.
+	bool doPublish(QueuedItem && item)
+	{
+		Sequence position = tail.load(std::memory_order_relaxed);
+		Slot * slot;
+		for(;;) {
+			slot = &slotList[position & mask];
+			const std::intptr_t diff = static_cast<std::intptr_t>(slot->sequence.load(std::memory_order_acquire))
+				- static_cast<std::intptr_t>(position);
+			if(diff == 0) {
+				if(tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			}
+			else {
+				if(diff < 0) {
+					// The events published by enqueueBulk are not notified yet,
+					// the consumer must be woken up to make room for them.
+					doNotifyQueueAvailable();
+					if(! doWaitNotFull(position, QueueFullPolicy())) {
+						return false;
+					}
+				}
+				position = tail.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->item.set(std::move(item));
+		slot->sequence.store(position + 1, std::memory_order_release);
+
+		return true;
+	}
+
+private:
+	bool doIsPublished(const Sequence position) const
+	{
+		return slotList[position & mask].sequence.load(std::memory_order_acquire) == position + 1;
+	}
+
+	bool doIsFull(const Sequence position) const
+	{
+		return static_cast<std::intptr_t>(slotList[position & mask].sequence.load(std::memory_order_acquire))
+			- static_cast<std::intptr_t>(position) < 0;
+	}
+
+	// Claim up to maxCount published events before end, starting at position.
+	// Return the number of claimed events.
+	Sequence doClaim(Sequence & position, const Sequence end, const Sequence maxCount)
+	{
+		return doClaim(position, end, maxCount, ConsumerPolicy());
+	}
+
+	// The single consumer owns the head, it's moved when the slot is released.
+	Sequence doClaim(Sequence & position, const Sequence end, const Sequence /*maxCount*/, QueueSingleConsumer)
+	{
+		position = head.load(std::memory_order_relaxed);
+		return (position != end && doIsPublished(position)) ? 1 : 0;
+	}
+
+	Sequence doClaim(Sequence & position, const Sequence end, const Sequence maxCount, QueueMultipleConsumers)
+	{
+		position = head.load(std::memory_order_relaxed);
+		for(;;) {
+			Sequence count = 0;
+			while(count < maxCount
+				&& static_cast<std::intptr_t>(end - (position + count)) > 0
+				&& doIsPublished(position + count)
+			) {
+				++count;
+			}
+			if(count == 0) {
+				return 0;
+			}
+			// On failure position is reloaded and the slots are checked again.
+			if(head.compare_exchange_weak(position, position + count, std::memory_order_relaxed)) {
+				return count;
+			}
+		}
+	}
+
+	// Must be called by the consumer which claimed position.
+	void doReleaseSlot(const Sequence position)
+	{
+		slotList[position & mask].sequence.store(position + capacity, std::memory_order_release);
+		doAdvanceHead(position, ConsumerPolicy());
+	}
+
+	void doAdvanceHead(const Sequence position, QueueSingleConsumer)
+	{
+		head.store(position + 1, std::memory_order_release);
+	}
+
+	void doAdvanceHead(const Sequence /*position*/, QueueMultipleConsumers)
+	{
+	}
+
+	void doDispatchSlot(const Sequence position)
+	{
+		BufferedItem<QueuedItem> & item = slotList[position & mask].item;
+		doDispatchQueuedEvent(
+			item.get(),
+			typename MakeIndexSequence<sizeof...(Args)>::Type()
+		);
+		item.clear();
+		doReleaseSlot(position);
+	}
+
+	bool doWaitNotFull(const Sequence position, QueueFullBlock)
+	{
+		CounterGuard<Atomic> counterGuard(notFullWaiterCounter);
+		std::unique_lock<Mutex> notFullLock(notFullMutex);
+		notFullConditionVariable.wait(notFullLock, [this, position]() -> bool {
+			return ! doIsFull(position);
+		});
+		return true;
+	}
+
+	bool doWaitNotFull(const Sequence /*position*/, QueueFullSpin)
+	{
+		std::this_thread::yield();
+		return true;
+	}
+
+	bool doWaitNotFull(const Sequence /*position*/, QueueFullFail)
+	{
+		return false;
+	}
+
+	// The waiter counter is increased before the waiter checks the queue, and the
+	// queue is changed before the counter is checked here, so the fence guarantees
+	// either the waiter sees the change or it's seen here. Locking the mutex before
+	// notifying avoids missing a waiter which has checked the queue but not slept yet.
+	void doNotifyQueueAvailable()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(queueWaiterCounter.load(std::memory_order_relaxed) > 0 && doCanNotifyQueueAvailable()) {
+			{
+				std::lock_guard<Mutex> queueListLock(queueListMutex);
+			}
+			queueListConditionVariable.notify_one();
+		}
+	}
+
+	void doNotifyNotFull()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(notFullWaiterCounter.load(std::memory_order_relaxed) > 0) {
+			{
+				std::lock_guard<Mutex> notFullLock(notFullMutex);
+			}
+			notFullConditionVariable.notify_all();
+		}
+	}
+
+private:
+	std::unique_ptr<Slot[]> slotList;
+	// The producers write tail and the consumer writes head, keep them in
+	// different cache lines to avoid false sharing.
+	char tailPadding[cacheLineSize];
+	Atomic tail;
+	char headPadding[cacheLineSize];
+	Atomic head;
+	char waiterPadding[cacheLineSize];
+	mutable Atomic queueWaiterCounter;
+	Atomic notFullWaiterCounter;
+	typename Threading::template Atomic<int> queueNotifyCounter;
+	mutable ConditionVariable queueListConditionVariable;
+	mutable Mutex queueListMutex;
+	ConditionVariable notFullConditionVariable;
+	Mutex notFullMutex;
+	ConsumerMutex consumerMutex;
+};
+
+
+} //namespace internal_
+
+} //namespace eventpp
+
+
+#endif
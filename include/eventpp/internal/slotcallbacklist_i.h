@@ -0,0 +1,573 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SLOTCALLBACKLIST_I_H
+#define SLOTCALLBACKLIST_I_H
+
+#include "../eventpolicies.h"
+
+#include <functional>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+namespace eventpp {
+
+namespace internal_ {
+
+// CallbackList storage that keeps the callbacks in contiguous chunks of slots.
+// The slots are linked in calling order by raw pointers, so invoking walks the
+// chunks without touching any reference counter, and a handle is just the slot
+// index plus a generation number, so remove is O(1) without locking a weak_ptr.
+// A removed slot keeps its links and is only recycled when no invoking is in
+// progress, that's how removing during invoking stays safe.
+template <
+	typename Prototype,
+	typename PoliciesType
+>
+class SlotCallbackListBase;
+
+template <
+	typename PoliciesType,
+	typename ReturnType, typename ...Args
+>
+class SlotCallbackListBase<
+	ReturnType (Args...),
+	PoliciesType
+>
+{
+private:
+	using Policies = PoliciesType;
+
+	using Threading = typename SelectThreading<Policies, HasTypeThreading<Policies>::value>::Type;
+
+	using Callback_ = typename SelectCallback<
+		Policies,
+		HasTypeCallback<Policies>::value,
+		std::function<ReturnType (Args...)>
+	>::Type;
+
+	using CanContinueInvoking = typename SelectCanContinueInvoking<
+		Policies, HasFunctionCanContinueInvoking<Policies, Args...>::value
+	>::Type;
+
+	using Counter = unsigned int;
+	using Index = std::uint32_t;
+	using Generation = std::uint32_t;
+
+	enum : Counter {
+		removedCounter = 0
+	};
+
+	enum : Index {
+		invalidIndex = ~Index(0),
+		chunkShift = 6,
+		chunkSize = Index(1) << chunkShift,
+		chunkMask = chunkSize - 1
+	};
+
+	struct Slot
+	{
+		Slot()
+			:
+				callback(),
+				counter(removedCounter),
+				generation(0),
+				index(invalidIndex),
+				previous(nullptr),
+				next(nullptr)
+		{
+		}
+
+		Callback_ callback;
+		typename Threading::template Atomic<Counter> counter;
+		// Changed under the mutex, and read by the invoking which doesn't lock the mutex.
+		typename Threading::template Atomic<Generation> generation;
+		Index index;
+		Slot * previous;
+		typename Threading::template Atomic<Slot *> next;
+	};
+
+	using Chunk = std::unique_ptr<Slot[]>;
+
+	class Handle_
+	{
+	public:
+		Handle_() noexcept
+			: index(invalidIndex), generation(0)
+		{
+		}
+
+		operator bool () const noexcept {
+			return index != invalidIndex;
+		}
+
+		bool operator == (const Handle_ & other) const noexcept {
+			return index == other.index && generation == other.generation;
+		}
+
+		bool operator != (const Handle_ & other) const noexcept {
+			return ! operator == (other);
+		}
+
+	private:
+		Handle_(const Index index, const Generation generation) noexcept
+			: index(index), generation(generation)
+		{
+		}
+
+	private:
+		Index index;
+		Generation generation;
+
+		friend class SlotCallbackListBase;
+	};
+
+	// Marks the list as being invoked so removed slots are not recycled under the invoker.
+	class InvokingGuard
+	{
+	public:
+		explicit InvokingGuard(const SlotCallbackListBase & callbackList)
+			: callbackList(callbackList), slot(nullptr), counter(0), generation(0)
+		{
+			std::lock_guard<Mutex> lockGuard(callbackList.mutex);
+			++callbackList.invokingCount;
+			slot = callbackList.head.load(std::memory_order_acquire);
+			counter = callbackList.currentCounter.load(std::memory_order_acquire);
+		}
+
+		~InvokingGuard()
+		{
+			if(--callbackList.invokingCount == 0 && callbackList.hasRetiredSlots.load(std::memory_order_acquire)) {
+				std::lock_guard<Mutex> lockGuard(callbackList.mutex);
+				const_cast<SlotCallbackListBase &>(callbackList).doRecycleRetiredSlots();
+			}
+		}
+
+		// The generation is loaded before the counter. doFreeSlot stores the removed counter
+		// before the new generation, so if the generation is of the removed slot, the counter
+		// is removed too and the slot is skipped. The slot is not reused during the invoking.
+		Slot * nextSlot() {
+			Slot * result = slot;
+			while(result != nullptr) {
+				slot = result->next.load(std::memory_order_acquire);
+				generation = result->generation.load(std::memory_order_acquire);
+				const Counter slotCounter = result->counter.load(std::memory_order_acquire);
+				if(slotCounter != removedCounter && counter >= slotCounter) {
+					return result;
+				}
+				result = slot;
+			}
+			return nullptr;
+		}
+
+		// The generation of the slot returned by nextSlot.
+		Generation getGeneration() const {
+			return generation;
+		}
+
+	private:
+		const SlotCallbackListBase & callbackList;
+		Slot * slot;
+		Counter counter;
+		Generation generation;
+	};
+
+public:
+	using Callback = Callback_;
+	using Handle = Handle_;
+	using Mutex = typename Threading::Mutex;
+
+public:
+	SlotCallbackListBase() noexcept
+		:
+			chunkList(),
+			freeList(),
+			retiredList(),
+			head(nullptr),
+			tail(nullptr),
+			mutex(),
+			currentCounter(0),
+			invokingCount(0),
+			hasRetiredSlots(false)
+	{
+	}
+
+	SlotCallbackListBase(const SlotCallbackListBase & other)
+		: SlotCallbackListBase()
+	{
+		cloneFrom(other);
+	}
+
+	SlotCallbackListBase(SlotCallbackListBase && other) noexcept
+		: SlotCallbackListBase()
+	{
+		swap(other);
+	}
+
+	SlotCallbackListBase & operator = (const SlotCallbackListBase & other) {
+		if(this != &other) {
+			SlotCallbackListBase copied(other);
+			swap(copied);
+		}
+		return *this;
+	}
+
+	SlotCallbackListBase & operator = (SlotCallbackListBase && other) noexcept {
+		if(this != &other) {
+			SlotCallbackListBase moved(std::move(other));
+			swap(moved);
+		}
+		return *this;
+	}
+
+	void swap(SlotCallbackListBase & other) noexcept {
+		using std::swap;
+
+		swap(chunkList, other.chunkList);
+		swap(freeList, other.freeList);
+		swap(retiredList, other.retiredList);
+		swap(tail, other.tail);
+
+		Slot * const headValue = head.load();
+		head.store(other.head.load());
+		other.head.store(headValue);
+
+		const Counter counterValue = currentCounter.load();
+		currentCounter.store(other.currentCounter.load());
+		other.currentCounter.store(counterValue);
+
+		const bool retiredValue = hasRetiredSlots.load();
+		hasRetiredSlots.store(other.hasRetiredSlots.load());
+		other.hasRetiredSlots.store(retiredValue);
+	}
+
+	bool empty() const {
+		return head.load(std::memory_order_acquire) == nullptr;
+	}
+
+	operator bool() const {
+		return ! empty();
+	}
+
+	Handle append(const Callback & callback)
+	{
+		std::lock_guard<Mutex> lockGuard(mutex);
+
+		Slot * slot = doAllocateSlot(callback);
+		doLinkBefore(slot, nullptr);
+
+		return Handle(slot->index, slot->generation.load(std::memory_order_relaxed));
+	}
+
+	Handle append(Callback && callback)
+	{
+		std::lock_guard<Mutex> lockGuard(mutex);
+
+		Slot * slot = doAllocateSlot(std::move(callback));
+		doLinkBefore(slot, nullptr);
+
+		return Handle(slot->index, slot->generation.load(std::memory_order_relaxed));
+	}
+
+	Handle prepend(const Callback & callback)
+	{
+		std::lock_guard<Mutex> lockGuard(mutex);
+
+		Slot * slot = doAllocateSlot(callback);
+		doLinkBefore(slot, head.load(std::memory_order_relaxed));
+
+		return Handle(slot->index, slot->generation.load(std::memory_order_relaxed));
+	}
+
+	Handle prepend(Callback && callback)
+	{
+		std::lock_guard<Mutex> lockGuard(mutex);
+
+		Slot * slot = doAllocateSlot(std::move(callback));
+		doLinkBefore(slot, head.load(std::memory_order_relaxed));
+
+		return Handle(slot->index, slot->generation.load(std::memory_order_relaxed));
+	}
+
+	Handle insert(const Callback & callback, const Handle & before)
+	{
+		std::lock_guard<Mutex> lockGuard(mutex);
+
+		Slot * beforeSlot = doFindSlot(before);
+		Slot * slot = doAllocateSlot(callback);
+		doLinkBefore(slot, beforeSlot);
+
+		return Handle(slot->index, slot->generation.load(std::memory_order_relaxed));
+	}
+
+	Handle insert(Callback && callback, const Handle & before)
+	{
+		std::lock_guard<Mutex> lockGuard(mutex);
+
+		Slot * beforeSlot = doFindSlot(before);
+		Slot * slot = doAllocateSlot(std::move(callback));
+		doLinkBefore(slot, beforeSlot);
+
+		return Handle(slot->index, slot->generation.load(std::memory_order_relaxed));
+	}
+
+	bool remove(const Handle & handle)
+	{
+		std::lock_guard<Mutex> lockGuard(mutex);
+
+		Slot * slot = doFindSlot(handle);
+		if(slot != nullptr) {
+			doFreeSlot(slot);
+			return true;
+		}
+
+		return false;
+	}
+
+	bool ownsHandle(const Handle & handle) const
+	{
+		std::lock_guard<Mutex> lockGuard(mutex);
+
+		return doFindSlot(handle) != nullptr;
+	}
+
+	template <typename Func>
+	void forEach(Func && func) const
+	{
+		InvokingGuard guard(*this);
+		while(Slot * slot = guard.nextSlot()) {
+			doForEachInvoke<void>(func, slot, guard.getGeneration());
+		}
+	}
+
+	template <typename Func>
+	bool forEachIf(Func && func) const
+	{
+		InvokingGuard guard(*this);
+		while(Slot * slot = guard.nextSlot()) {
+			if(! doForEachInvoke<bool>(func, slot, guard.getGeneration())) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void operator() (Args ...args) const
+	{
+		InvokingGuard guard(*this);
+		while(Slot * slot = guard.nextSlot()) {
+			// Don't std::forward args, see the comment in CallbackListBase::operator().
+			slot->callback(args...);
+			if(! CanContinueInvoking::canContinueInvoking(args...)) {
+				break;
+			}
+		}
+	}
+
+private:
+	template <typename RT, typename Func>
+	auto doForEachInvoke(Func && func, Slot * slot, const Generation generation) const
+		-> typename std::enable_if<CanInvoke<Func, Handle, Callback &>::value, RT>::type
+	{
+		return func(Handle(slot->index, generation), slot->callback);
+	}
+
+	template <typename RT, typename Func>
+	auto doForEachInvoke(Func && func, Slot * slot, const Generation /*generation*/) const
+		-> typename std::enable_if<CanInvoke<Func, Callback &>::value, RT>::type
+	{
+		return func(slot->callback);
+	}
+
+	Slot * doGetSlot(const Index index) const
+	{
+		return &chunkList[index >> chunkShift][index & chunkMask];
+	}
+
+	// The mutex must be locked.
+	Slot * doFindSlot(const Handle & handle) const
+	{
+		if(handle.index >= chunkList.size() * chunkSize) {
+			return nullptr;
+		}
+
+		Slot * slot = doGetSlot(handle.index);
+		if(slot->generation.load(std::memory_order_relaxed) != handle.generation
+			|| slot->counter.load(std::memory_order_relaxed) == removedCounter) {
+			return nullptr;
+		}
+
+		return slot;
+	}
+
+	// The mutex must be locked.
+	template <typename C>
+	Slot * doAllocateSlot(C && callback)
+	{
+		doRecycleRetiredSlots();
+
+		Slot * slot;
+		if(! freeList.empty()) {
+			slot = doGetSlot(freeList.back());
+			freeList.pop_back();
+			// The handles to the removed callback never match the new one.
+			doIncreaseGeneration(slot);
+		}
+		else {
+			const Index index = static_cast<Index>(chunkList.size() * chunkSize);
+			chunkList.emplace_back(new Slot[chunkSize]);
+			for(Index i = chunkSize - 1; i > 0; --i) {
+				doGetSlot(index + i)->index = index + i;
+				freeList.push_back(index + i);
+			}
+			slot = doGetSlot(index);
+			slot->index = index;
+		}
+
+		slot->callback = std::forward<C>(callback);
+		slot->counter.store(doGetNextCounter(), std::memory_order_relaxed);
+
+		return slot;
+	}
+
+	// The mutex must be locked. If before is nullptr, slot is linked at the end.
+	void doLinkBefore(Slot * slot, Slot * before)
+	{
+		if(before == nullptr) {
+			slot->previous = tail;
+			slot->next.store(nullptr, std::memory_order_relaxed);
+			if(tail != nullptr) {
+				tail->next.store(slot, std::memory_order_release);
+			}
+			else {
+				head.store(slot, std::memory_order_release);
+			}
+			tail = slot;
+		}
+		else {
+			slot->previous = before->previous;
+			slot->next.store(before, std::memory_order_relaxed);
+			if(before->previous != nullptr) {
+				before->previous->next.store(slot, std::memory_order_release);
+			}
+			else {
+				head.store(slot, std::memory_order_release);
+			}
+			before->previous = slot;
+		}
+	}
+
+	// The mutex must be locked.
+	void doFreeSlot(Slot * slot)
+	{
+		Slot * next = slot->next.load(std::memory_order_relaxed);
+
+		if(next != nullptr) {
+			next->previous = slot->previous;
+		}
+		else {
+			tail = slot->previous;
+		}
+		if(slot->previous != nullptr) {
+			slot->previous->next.store(next, std::memory_order_release);
+		}
+		else {
+			head.store(next, std::memory_order_release);
+		}
+
+		slot->counter.store(removedCounter, std::memory_order_release);
+		// Invalidate all handles to the slot.
+		doIncreaseGeneration(slot);
+
+		// Don't modify slot->next, the slot may be still used in an invoking.
+		retiredList.push_back(slot->index);
+		hasRetiredSlots.store(true, std::memory_order_release);
+
+		doRecycleRetiredSlots();
+	}
+
+	// The mutex must be locked.
+	static void doIncreaseGeneration(Slot * slot)
+	{
+		slot->generation.store(slot->generation.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// The mutex must be locked.
+	// The invoking count must be checked under the lock, an invoking may start
+	// after the guard of the last invoking decreased the count and before it locks the mutex.
+	void doRecycleRetiredSlots()
+	{
+		if(retiredList.empty() || invokingCount.load(std::memory_order_acquire) != 0) {
+			return;
+		}
+
+		for(const Index index : retiredList) {
+			Slot * slot = doGetSlot(index);
+			slot->callback = Callback();
+			slot->previous = nullptr;
+			slot->next.store(nullptr, std::memory_order_relaxed);
+			freeList.push_back(index);
+		}
+		retiredList.clear();
+		hasRetiredSlots.store(false, std::memory_order_release);
+	}
+
+	// The mutex must be locked.
+	Counter doGetNextCounter()
+	{
+		Counter result = ++currentCounter;
+		if(result == 0) { // overflow, let's reset all slots' counters.
+			Slot * slot = head.load(std::memory_order_relaxed);
+			while(slot != nullptr) {
+				slot->counter.store(1, std::memory_order_relaxed);
+				slot = slot->next.load(std::memory_order_relaxed);
+			}
+			result = ++currentCounter;
+		}
+
+		return result;
+	}
+
+	void cloneFrom(const SlotCallbackListBase & other)
+	{
+		std::lock_guard<Mutex> otherLockGuard(other.mutex);
+
+		Slot * otherSlot = other.head.load(std::memory_order_acquire);
+		while(otherSlot != nullptr) {
+			Slot * slot = doAllocateSlot(otherSlot->callback);
+			doLinkBefore(slot, nullptr);
+			otherSlot = otherSlot->next.load(std::memory_order_acquire);
+		}
+	}
+
+private:
+	std::vector<Chunk> chunkList;
+	std::vector<Index> freeList;
+	std::vector<Index> retiredList;
+	typename Threading::template Atomic<Slot *> head;
+	Slot * tail;
+	mutable Mutex mutex;
+	typename Threading::template Atomic<Counter> currentCounter;
+	mutable typename Threading::template Atomic<int> invokingCount;
+	typename Threading::template Atomic<bool> hasRetiredSlots;
+};
+
+
+} //namespace internal_
+
+} //namespace eventpp
+
+#endif
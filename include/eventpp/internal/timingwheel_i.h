@@ -0,0 +1,386 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TIMINGWHEEL_I_H
+#define TIMINGWHEEL_I_H
+
+#include "eventqueue_i.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+namespace eventpp {
+
+namespace internal_ {
+
+// A handle of a delayed event in EventQueue, used to cancel the event.
+template <typename Node>
+class TimerHandle_
+{
+public:
+	TimerHandle_() : node(nullptr), id(0) {
+	}
+
+	explicit operator bool() const {
+		return node != nullptr;
+	}
+
+private:
+	TimerHandle_(Node * node, const std::uint64_t id) : node(node), id(id) {
+	}
+
+	Node * node;
+	std::uint64_t id;
+
+	template <typename T>
+	friend class TimingWheel;
+};
+
+// A hierarchical timing wheel, used by EventQueue for the delayed events.
+// The time is in ticks. Level 0 has 256 slots of one tick, levels 1 to 4 have
+// 64 slots each, a slot of level n covers all slots of level n - 1.
+// Adding and cancelling an item is O(1). When the wheel advances past the end
+// of a level, the next slot of the upper level is cascaded to the lower levels.
+// The items due at the same tick are expired in the adding order.
+// It's not thread safe, EventQueue locks it.
+template <typename T>
+class TimingWheel
+{
+public:
+	using Tick = std::uint64_t;
+
+private:
+	enum {
+		rootBits = 8,
+		levelBits = 6,
+		rootSize = 1 << rootBits,
+		levelSize = 1 << levelBits,
+		upperLevelCount = 4
+	};
+
+	struct Link
+	{
+		Link * previous;
+		Link * next;
+	};
+
+	struct Node : Link
+	{
+		Node() : Link(), tick(0), id(0), inRoot(false), item() {
+		}
+
+		Tick tick;
+		// 0 if the node is not in the wheel.
+		std::uint64_t id;
+		bool inRoot;
+		BufferedItem<T> item;
+	};
+
+public:
+	using Handle = TimerHandle_<Node>;
+
+	static constexpr Tick noTick = std::numeric_limits<Tick>::max();
+
+public:
+	TimingWheel()
+		:
+			rootSlotList(),
+			upperSlotList(),
+			nextTick(0),
+			itemCount(0),
+			rootItemCount(0),
+			nextId(0),
+			freeNodeList(nullptr)
+	{
+		for(Link & slot : rootSlotList) {
+			doResetSlot(&slot);
+		}
+		for(auto & slotList : upperSlotList) {
+			for(Link & slot : slotList) {
+				doResetSlot(&slot);
+			}
+		}
+	}
+
+	~TimingWheel()
+	{
+		for(Link & slot : rootSlotList) {
+			doDeleteSlot(&slot);
+		}
+		for(auto & slotList : upperSlotList) {
+			for(Link & slot : slotList) {
+				doDeleteSlot(&slot);
+			}
+		}
+		while(freeNodeList != nullptr) {
+			Node * node = freeNodeList;
+			freeNodeList = static_cast<Node *>(node->next);
+			delete node;
+		}
+	}
+
+	TimingWheel(const TimingWheel &) = delete;
+	TimingWheel & operator = (const TimingWheel &) = delete;
+
+	// The ticks before getNextTick() are already expired.
+	Tick getNextTick() const {
+		return nextTick;
+	}
+
+	bool empty() const {
+		return itemCount == 0;
+	}
+
+	// tick must not be less than getNextTick().
+	Handle add(const Tick tick, T && value) {
+		Node * node = freeNodeList;
+		if(node != nullptr) {
+			freeNodeList = static_cast<Node *>(node->next);
+		}
+		else {
+			node = new Node();
+		}
+
+		node->item.set(std::move(value));
+		node->tick = tick;
+		node->id = ++nextId;
+		doPlace(node);
+		++itemCount;
+
+		return Handle(node, node->id);
+	}
+
+	// Return false if the item is already expired or cancelled.
+	bool cancel(const Handle & handle) {
+		Node * node = handle.node;
+		if(node == nullptr || node->id != handle.id) {
+			return false;
+		}
+
+		doUnlink(node);
+		doFreeNode(node);
+		--itemCount;
+
+		return true;
+	}
+
+	// Expire all items due at or before nowTick, func is invoked with each item
+	// in the order of ticks.
+	template <typename F>
+	void advance(const Tick nowTick, F && func) {
+		while(nextTick <= nowTick) {
+			if(itemCount == 0) {
+				nextTick = nowTick + 1;
+				break;
+			}
+
+			// Skip the empty ticks. All slots before the due tick are empty, so
+			// they don't need to be cascaded.
+			if(rootItemCount == 0) {
+				const Tick dueTick = getDueTick();
+				if(dueTick > nextTick) {
+					nextTick = (dueTick <= nowTick ? dueTick : nowTick + 1);
+					continue;
+				}
+			}
+
+			const std::size_t index = static_cast<std::size_t>(nextTick & (rootSize - 1));
+			if(index == 0) {
+				for(unsigned int level = 0; level < upperLevelCount; ++level) {
+					const std::size_t upperIndex = doGetUpperIndex(nextTick, level);
+					doCascade(&upperSlotList[level][upperIndex]);
+					if(upperIndex != 0) {
+						break;
+					}
+				}
+			}
+
+			Link * slot = &rootSlotList[index];
+			while(slot->next != slot) {
+				Node * node = static_cast<Node *>(slot->next);
+				doUnlink(node);
+				--itemCount;
+				func(std::move(node->item.get()));
+				doFreeNode(node);
+			}
+
+			++nextTick;
+		}
+	}
+
+	// Invoke func with a reference to each item in the wheel, in no particular order.
+	template <typename F>
+	void forEach(F && func) {
+		doForEachInSlots(rootSlotList, func);
+		for(auto & slotList : upperSlotList) {
+			doForEachInSlots(slotList, func);
+		}
+	}
+
+	// Return a tick which is not after the earliest item, or noTick if the wheel is empty.
+	// It's exact if the earliest item is in level 0, otherwise it's the beginning of
+	// the upper slot which holds the item.
+	Tick getDueTick() const {
+		if(itemCount == 0) {
+			return noTick;
+		}
+
+		if(rootItemCount > 0) {
+			for(Tick tick = nextTick; tick < nextTick + rootSize; ++tick) {
+				const Link * slot = &rootSlotList[tick & (rootSize - 1)];
+				if(slot->next != slot) {
+					return tick;
+				}
+			}
+		}
+
+		Tick result = noTick;
+		for(unsigned int level = 0; level < upperLevelCount; ++level) {
+			const unsigned int shift = rootBits + levelBits * level;
+			const Tick current = nextTick >> shift;
+			// The current slot is cascaded when advancing to the beginning of the slot.
+			// If nextTick is at the beginning, the slot is not cascaded yet.
+			if((nextTick & ((Tick(1) << shift) - 1)) == 0) {
+				const Link * slot = &upperSlotList[level][current & (levelSize - 1)];
+				if(slot->next != slot) {
+					return nextTick;
+				}
+			}
+			for(Tick i = 1; i <= levelSize; ++i) {
+				const Link * slot = &upperSlotList[level][(current + i) & (levelSize - 1)];
+				if(slot->next != slot) {
+					const Tick tick = (current + i) << shift;
+					if(tick < result) {
+						result = tick;
+					}
+					break;
+				}
+			}
+		}
+
+		return result;
+	}
+
+private:
+	static std::size_t doGetUpperIndex(const Tick tick, const unsigned int level) {
+		return static_cast<std::size_t>((tick >> (rootBits + levelBits * level)) & (levelSize - 1));
+	}
+
+	void doPlace(Node * node) {
+		const Tick delta = node->tick - nextTick;
+		Link * slot;
+		node->inRoot = (delta < rootSize);
+		if(node->inRoot) {
+			slot = &rootSlotList[node->tick & (rootSize - 1)];
+			++rootItemCount;
+		}
+		else {
+			unsigned int level = 0;
+			while(level < upperLevelCount - 1
+				&& delta >= (Tick(1) << (rootBits + levelBits * (level + 1)))) {
+				++level;
+			}
+			Tick tick = node->tick;
+			// The items beyond the range are put in the farthest slot, they will
+			// be placed again when the slot is cascaded.
+			const Tick maxDelta = (Tick(1) << (rootBits + levelBits * upperLevelCount)) - 1;
+			if(delta > maxDelta) {
+				tick = nextTick + maxDelta;
+			}
+			slot = &upperSlotList[level][doGetUpperIndex(tick, level)];
+		}
+
+		node->previous = slot->previous;
+		node->next = slot;
+		slot->previous->next = node;
+		slot->previous = node;
+	}
+
+	void doCascade(Link * slot) {
+		if(slot->next == slot) {
+			return;
+		}
+
+		// Detach the whole slot first, the nodes may be placed in the same slot again.
+		Link * first = slot->next;
+		slot->previous->next = nullptr;
+		doResetSlot(slot);
+		while(first != nullptr) {
+			Node * node = static_cast<Node *>(first);
+			first = first->next;
+			doPlace(node);
+		}
+	}
+
+	void doFreeNode(Node * node) {
+		if(! node->item.empty()) {
+			node->item.clear();
+		}
+		node->id = 0;
+		node->next = freeNodeList;
+		freeNodeList = node;
+	}
+
+	void doUnlink(Node * node) {
+		if(node->inRoot) {
+			--rootItemCount;
+		}
+		node->previous->next = node->next;
+		node->next->previous = node->previous;
+	}
+
+	static void doResetSlot(Link * slot) {
+		slot->previous = slot;
+		slot->next = slot;
+	}
+
+	template <std::size_t size, typename F>
+	static void doForEachInSlots(Link (&slotList)[size], F & func) {
+		for(Link & slot : slotList) {
+			for(Link * link = slot.next; link != &slot; link = link->next) {
+				func(static_cast<Node *>(link)->item.get());
+			}
+		}
+	}
+
+	static void doDeleteSlot(Link * slot) {
+		Link * link = slot->next;
+		while(link != slot) {
+			Link * next = link->next;
+			delete static_cast<Node *>(link);
+			link = next;
+		}
+	}
+
+private:
+	Link rootSlotList[rootSize];
+	Link upperSlotList[upperLevelCount][levelSize];
+	Tick nextTick;
+	std::size_t itemCount;
+	std::size_t rootItemCount;
+	std::uint64_t nextId;
+	Node * freeNodeList;
+};
+
+template <typename T>
+constexpr typename TimingWheel<T>::Tick TimingWheel<T>::noTick;
+
+
+} //namespace internal_
+
+} //namespace eventpp
+
+#endif
+
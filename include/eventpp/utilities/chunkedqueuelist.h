@@ -0,0 +1,308 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CHUNKEDQUEUELIST_H_587201394856
+#define CHUNKEDQUEUELIST_H_587201394856
+
+#include "../eventpolicies.h"
+
+#include <atomic>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <new>
+#include <cstddef>
+
+namespace eventpp {
+
+// A doubly linked list which allocates the nodes in contiguous chunks.
+// The items are never moved, splice only relinks the nodes, so the non-movable
+// BufferedItem in EventQueue works. Each thread allocates the nodes from its
+// own current chunk, and a chunk is freed when all its nodes are destroyed.
+template <typename T, std::size_t ChunkSize = 256>
+class ChunkedQueueList
+{
+private:
+	static_assert(ChunkSize > 0, "ChunkSize of ChunkedQueueList must be greater than 0.");
+
+	struct Chunk;
+
+	struct Link
+	{
+		Link * previous;
+		Link * next;
+	};
+
+	struct Node : Link
+	{
+		Chunk * chunk;
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+		T & get() {
+			return *reinterpret_cast<T *>(&storage);
+		}
+	};
+
+	struct Chunk
+	{
+		Chunk() : referenceCount(1), allocatedCount(0) {
+		}
+
+		// The count of the live nodes, plus 1 while a thread is allocating from it.
+		std::atomic<std::size_t> referenceCount;
+		std::size_t allocatedCount;
+		Node nodeList[ChunkSize];
+	};
+
+	struct ChunkHolder
+	{
+		ChunkHolder() : chunk(nullptr) {
+		}
+
+		~ChunkHolder() {
+			if(chunk != nullptr) {
+				doReleaseChunk(chunk);
+			}
+		}
+
+		Chunk * chunk;
+	};
+
+	template <typename V, typename L>
+	class Iterator
+	{
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = V *;
+		using reference = V &;
+
+	public:
+		Iterator() : link(nullptr) {
+		}
+
+		explicit Iterator(L * link) : link(link) {
+		}
+
+		// iterator can convert to const_iterator.
+		template <typename V2, typename L2>
+		Iterator(const Iterator<V2, L2> & other) : link(other.link) {
+		}
+
+		reference operator * () const {
+			return static_cast<Node *>(const_cast<Link *>(link))->get();
+		}
+
+		pointer operator -> () const {
+			return &**this;
+		}
+
+		Iterator & operator ++ () {
+			link = link->next;
+			return *this;
+		}
+
+		Iterator operator ++ (int) {
+			Iterator result(*this);
+			link = link->next;
+			return result;
+		}
+
+		Iterator & operator -- () {
+			link = link->previous;
+			return *this;
+		}
+
+		Iterator operator -- (int) {
+			Iterator result(*this);
+			link = link->previous;
+			return result;
+		}
+
+		template <typename V2, typename L2>
+		bool operator == (const Iterator<V2, L2> & other) const {
+			return link == other.link;
+		}
+
+		template <typename V2, typename L2>
+		bool operator != (const Iterator<V2, L2> & other) const {
+			return link != other.link;
+		}
+
+	private:
+		L * link;
+
+		template <typename V2, typename L2>
+		friend class Iterator;
+		friend class ChunkedQueueList;
+	};
+
+public:
+	using value_type = T;
+	using reference = T &;
+	using const_reference = const T &;
+	using iterator = Iterator<T, Link>;
+	using const_iterator = Iterator<const T, const Link>;
+
+public:
+	ChunkedQueueList() : head() {
+		doReset();
+	}
+
+	~ChunkedQueueList() {
+		clear();
+	}
+
+	ChunkedQueueList(ChunkedQueueList && other) noexcept : head() {
+		doReset();
+		splice(end(), other);
+	}
+
+	ChunkedQueueList & operator = (ChunkedQueueList && other) noexcept {
+		if(this != &other) {
+			clear();
+			splice(end(), other);
+		}
+		return *this;
+	}
+
+	ChunkedQueueList(const ChunkedQueueList &) = delete;
+	ChunkedQueueList & operator = (const ChunkedQueueList &) = delete;
+
+	bool empty() const {
+		return head.next == &head;
+	}
+
+	iterator begin() {
+		return iterator(head.next);
+	}
+
+	const_iterator begin() const {
+		return const_iterator(head.next);
+	}
+
+	iterator end() {
+		return iterator(&head);
+	}
+
+	const_iterator end() const {
+		return const_iterator(&head);
+	}
+
+	reference front() {
+		return *begin();
+	}
+
+	const_reference front() const {
+		return *begin();
+	}
+
+	void swap(ChunkedQueueList & other) noexcept {
+		ChunkedQueueList temp(std::move(other));
+		other.splice(other.end(), *this);
+		splice(end(), temp);
+	}
+
+	template <typename ...A>
+	void emplace_back(A && ...args) {
+		Node * node = doAllocateNode();
+		new (&node->storage) T(std::forward<A>(args)...);
+		doLinkBefore(&head, node, node);
+	}
+
+	void clear() {
+		Link * link = head.next;
+		while(link != &head) {
+			Node * node = static_cast<Node *>(link);
+			link = link->next;
+			doFreeNode(node);
+		}
+		doReset();
+	}
+
+	// Move all items in other before pos.
+	void splice(const_iterator pos, ChunkedQueueList & other) {
+		if(! other.empty()) {
+			Link * first = other.head.next;
+			Link * last = other.head.previous;
+			other.doReset();
+			doLinkBefore(const_cast<Link *>(pos.link), first, last);
+		}
+	}
+
+	// Move the item it in other before pos.
+	void splice(const_iterator pos, ChunkedQueueList & /*other*/, const_iterator it) {
+		Link * link = const_cast<Link *>(it.link);
+		Link * position = const_cast<Link *>(pos.link);
+		if(link == position || link->next == position) {
+			return;
+		}
+		link->previous->next = link->next;
+		link->next->previous = link->previous;
+		doLinkBefore(position, link, link);
+	}
+
+	friend void swap(ChunkedQueueList & a, ChunkedQueueList & b) noexcept {
+		a.swap(b);
+	}
+
+private:
+	void doReset() {
+		head.previous = &head;
+		head.next = &head;
+	}
+
+	static void doLinkBefore(Link * position, Link * first, Link * last) {
+		first->previous = position->previous;
+		last->next = position;
+		position->previous->next = first;
+		position->previous = last;
+	}
+
+	static Node * doAllocateNode() {
+		static thread_local ChunkHolder holder;
+
+		if(holder.chunk == nullptr || holder.chunk->allocatedCount == ChunkSize) {
+			if(holder.chunk != nullptr) {
+				doReleaseChunk(holder.chunk);
+			}
+			holder.chunk = new Chunk();
+		}
+
+		Chunk * chunk = holder.chunk;
+		Node * node = &chunk->nodeList[chunk->allocatedCount++];
+		node->chunk = chunk;
+		chunk->referenceCount.fetch_add(1, std::memory_order_relaxed);
+		return node;
+	}
+
+	static void doFreeNode(Node * node) {
+		node->get().~T();
+		doReleaseChunk(node->chunk);
+	}
+
+	static void doReleaseChunk(Chunk * chunk) {
+		if(chunk->referenceCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			delete chunk;
+		}
+	}
+
+private:
+	Link head;
+};
+
+
+} //namespace eventpp
+
+#endif
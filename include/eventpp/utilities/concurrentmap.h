@@ -0,0 +1,356 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONCURRENTMAP_H_627580315946
+#define CONCURRENTMAP_H_627580315946
+
+#include "../eventpolicies.h"
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <iterator>
+#include <tuple>
+#include <cstddef>
+
+namespace eventpp {
+
+// An insert only hash map which can be read by any number of threads without lock,
+// while another thread is inserting.
+// The elements are never moved or removed until the map is destroyed, so the pointers
+// and references to the values are stable.
+// When the bucket table grows, the old tables are kept until the map is destroyed,
+// because a reader may be still walking them. All tables together use at most twice
+// the memory of the last table.
+// EventDispatcher, EventQueue and HeterEventDispatcher don't lock their listener mutex
+// for a map derived from TagConcurrentMap.
+template <
+	typename Key,
+	typename T,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>
+>
+class ConcurrentMap : public TagConcurrentMap
+{
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using value_type = std::pair<const Key, T>;
+	using size_type = std::size_t;
+
+private:
+	struct Node
+	{
+		template <typename K>
+		Node(K && key, const std::size_t hash)
+			: value(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple()),
+				hash(hash),
+				nextInserted(nullptr)
+		{
+		}
+
+		value_type value;
+		std::size_t hash;
+		// All nodes are linked in reverse inserting order, for iterating and destroying.
+		Node * nextInserted;
+	};
+
+	struct Entry
+	{
+		Node * node;
+		std::atomic<Entry *> next;
+	};
+
+	struct Table
+	{
+		explicit Table(const std::size_t bucketCount)
+			: bucketCount(bucketCount),
+				bucketList(new std::atomic<Entry *>[bucketCount]),
+				entryList(new Entry[bucketCount]),
+				entryCount(0)
+		{
+			for(std::size_t i = 0; i < bucketCount; ++i) {
+				bucketList[i].store(nullptr, std::memory_order_relaxed);
+			}
+		}
+
+		bool isFull() const {
+			return entryCount >= bucketCount;
+		}
+
+		// Must be called by the writer, and the table must not be full.
+		void add(Node * node) {
+			Entry * entry = &entryList[entryCount++];
+			entry->node = node;
+			std::atomic<Entry *> & bucket = bucketList[node->hash & (bucketCount - 1)];
+			entry->next.store(bucket.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			bucket.store(entry, std::memory_order_release);
+		}
+
+		std::size_t bucketCount;
+		std::unique_ptr<std::atomic<Entry *>[]> bucketList;
+		std::unique_ptr<Entry[]> entryList;
+		std::size_t entryCount;
+	};
+
+	enum {
+		initialBucketCount = 16
+	};
+
+	template <typename NodeType, typename ValueType>
+	class Iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = typename ConcurrentMap::value_type;
+		using difference_type = std::ptrdiff_t;
+		using pointer = ValueType *;
+		using reference = ValueType &;
+
+	public:
+		explicit Iterator(NodeType * node = nullptr) noexcept : node(node) {
+		}
+
+		template <typename N, typename V>
+		Iterator(const Iterator<N, V> & other) noexcept : node(other.node) {
+		}
+
+		reference operator * () const noexcept {
+			return node->value;
+		}
+
+		pointer operator -> () const noexcept {
+			return &node->value;
+		}
+
+		Iterator & operator ++ () noexcept {
+			node = node->nextInserted;
+			return *this;
+		}
+
+		Iterator operator ++ (int) noexcept {
+			Iterator result(*this);
+			node = node->nextInserted;
+			return result;
+		}
+
+		bool operator == (const Iterator & other) const noexcept {
+			return node == other.node;
+		}
+
+		bool operator != (const Iterator & other) const noexcept {
+			return node != other.node;
+		}
+
+	private:
+		template <typename N, typename V>
+		friend class Iterator;
+
+		NodeType * node;
+	};
+
+public:
+	using iterator = Iterator<Node, value_type>;
+	using const_iterator = Iterator<const Node, const value_type>;
+
+public:
+	ConcurrentMap()
+		: table(nullptr), tableList(), firstNode(nullptr), nodeCount(0), writeMutex()
+	{
+	}
+
+	ConcurrentMap(const ConcurrentMap & other)
+		: ConcurrentMap()
+	{
+		for(const value_type & item : other) {
+			(*this)[item.first] = item.second;
+		}
+	}
+
+	ConcurrentMap(ConcurrentMap && other) noexcept
+		: ConcurrentMap()
+	{
+		swap(other);
+	}
+
+	~ConcurrentMap()
+	{
+		doClear();
+	}
+
+	ConcurrentMap & operator = (const ConcurrentMap & other) {
+		if(this != &other) {
+			ConcurrentMap copied(other);
+			swap(copied);
+		}
+		return *this;
+	}
+
+	ConcurrentMap & operator = (ConcurrentMap && other) noexcept {
+		if(this != &other) {
+			ConcurrentMap moved(std::move(other));
+			swap(moved);
+		}
+		return *this;
+	}
+
+	// Not thread safe.
+	void swap(ConcurrentMap & other) noexcept {
+		using std::swap;
+
+		Table * const tableValue = table.load();
+		table.store(other.table.load());
+		other.table.store(tableValue);
+
+		Node * const nodeValue = firstNode.load();
+		firstNode.store(other.firstNode.load());
+		other.firstNode.store(nodeValue);
+
+		swap(tableList, other.tableList);
+		swap(nodeCount, other.nodeCount);
+	}
+
+	// Thread safe, lock free.
+	iterator find(const Key & key) {
+		return iterator(doFind(key));
+	}
+
+	// Thread safe, lock free.
+	const_iterator find(const Key & key) const {
+		return const_iterator(doFind(key));
+	}
+
+	// Thread safe. It locks the inner mutex if key is not in the map.
+	T & operator [] (const Key & key) {
+		Node * node = doFind(key);
+		if(node == nullptr) {
+			node = doInsert(key);
+		}
+		return node->value.second;
+	}
+
+	// Thread safe. Iterating sees the elements in reverse inserting order.
+	// The elements inserted during iterating may be not seen.
+	iterator begin() noexcept {
+		return iterator(firstNode.load(std::memory_order_acquire));
+	}
+
+	const_iterator begin() const noexcept {
+		return const_iterator(firstNode.load(std::memory_order_acquire));
+	}
+
+	iterator end() noexcept {
+		return iterator();
+	}
+
+	const_iterator end() const noexcept {
+		return const_iterator();
+	}
+
+	bool empty() const noexcept {
+		return firstNode.load(std::memory_order_acquire) == nullptr;
+	}
+
+	size_type size() const {
+		std::lock_guard<std::mutex> lockGuard(writeMutex);
+		return nodeCount;
+	}
+
+private:
+	Node * doFind(const Key & key) const {
+		const Table * currentTable = table.load(std::memory_order_acquire);
+		if(currentTable == nullptr) {
+			return nullptr;
+		}
+		const std::size_t hash = Hash()(key);
+		const Entry * entry = currentTable->bucketList[hash & (currentTable->bucketCount - 1)].load(std::memory_order_acquire);
+		while(entry != nullptr) {
+			if(entry->node->hash == hash && KeyEqual()(entry->node->value.first, key)) {
+				return entry->node;
+			}
+			entry = entry->next.load(std::memory_order_acquire);
+		}
+		return nullptr;
+	}
+
+	Node * doInsert(const Key & key) {
+		std::lock_guard<std::mutex> lockGuard(writeMutex);
+
+		// Another writer may have inserted it.
+		Node * node = doFind(key);
+		if(node != nullptr) {
+			return node;
+		}
+
+		std::unique_ptr<Node> newNode(new Node(key, Hash()(key)));
+		Table * currentTable = table.load(std::memory_order_relaxed);
+		if(currentTable == nullptr || currentTable->isFull()) {
+			currentTable = doGrow(currentTable);
+		}
+
+		node = newNode.release();
+		node->nextInserted = firstNode.load(std::memory_order_relaxed);
+		firstNode.store(node, std::memory_order_release);
+		currentTable->add(node);
+		++nodeCount;
+
+		return node;
+	}
+
+	Table * doGrow(const Table * currentTable) {
+		const std::size_t bucketCount = (currentTable == nullptr ? (std::size_t)initialBucketCount : currentTable->bucketCount * 2);
+		tableList.emplace_back(new Table(bucketCount));
+		Table * newTable = tableList.back().get();
+		for(Node * node = firstNode.load(std::memory_order_relaxed); node != nullptr; node = node->nextInserted) {
+			newTable->add(node);
+		}
+		table.store(newTable, std::memory_order_release);
+
+		return newTable;
+	}
+
+	void doClear() {
+		Node * node = firstNode.load();
+		while(node != nullptr) {
+			Node * next = node->nextInserted;
+			delete node;
+			node = next;
+		}
+		firstNode.store(nullptr);
+		table.store(nullptr);
+		tableList.clear();
+		nodeCount = 0;
+	}
+
+private:
+	std::atomic<Table *> table;
+	std::vector<std::unique_ptr<Table> > tableList;
+	std::atomic<Node *> firstNode;
+	std::size_t nodeCount;
+	mutable std::mutex writeMutex;
+};
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void swap(ConcurrentMap<Key, T, Hash, KeyEqual> & first, ConcurrentMap<Key, T, Hash, KeyEqual> & second) noexcept
+{
+	first.swap(second);
+}
+
+
+} //namespace eventpp
+
+#endif
+
@@ -0,0 +1,150 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DELEGATE_H_147256310489
+#define DELEGATE_H_147256310489
+
+#include <cstddef>
+#include <cassert>
+#include <utility>
+
+namespace eventpp {
+
+template <typename Prototype>
+class Delegate;
+
+// Delegate is a non-owning callback which holds an object pointer and a trampoline function.
+// It doesn't allocate memory, it's trivially copyable, and it can be compared for equality.
+template <typename RT, typename ...Args>
+class Delegate <RT (Args...)>
+{
+private:
+	union Data
+	{
+		void * object;
+		RT (*function)(Args...);
+	};
+
+	using Trampoline = RT (*)(const Data &, Args && ...);
+
+public:
+	template <typename C, RT (C::*method)(Args...)>
+	static Delegate fromMethod(C * object) noexcept {
+		Data data;
+		data.object = object;
+		return Delegate(data, &invokeMethod<C, method>);
+	}
+
+	template <typename C, RT (C::*method)(Args...) const>
+	static Delegate fromConstMethod(const C * object) noexcept {
+		Data data;
+		data.object = const_cast<C *>(object);
+		return Delegate(data, &invokeConstMethod<C, method>);
+	}
+
+	template <RT (*function)(Args...)>
+	static Delegate fromFunction() noexcept {
+		Data data;
+		data.object = nullptr;
+		return Delegate(data, &invokeStaticFunction<function>);
+	}
+
+	// The callable object is not copied, it must outlive the delegate.
+	template <typename F>
+	static Delegate fromCallable(F * callable) noexcept {
+		Data data;
+		data.object = const_cast<void *>(static_cast<const void *>(callable));
+		return Delegate(data, &invokeCallable<F>);
+	}
+
+public:
+	Delegate() noexcept
+		: data(), trampoline(nullptr)
+	{
+		data.object = nullptr;
+	}
+
+	Delegate(std::nullptr_t) noexcept
+		: Delegate()
+	{
+	}
+
+	Delegate(RT (*function)(Args...)) noexcept
+		: data(), trampoline(function == nullptr ? nullptr : &invokeFunction)
+	{
+		data.function = function;
+	}
+
+	explicit operator bool() const noexcept {
+		return trampoline != nullptr;
+	}
+
+	RT operator() (Args ...args) const {
+		assert(trampoline != nullptr);
+		return trampoline(data, std::forward<Args>(args)...);
+	}
+
+	bool operator == (const Delegate & other) const noexcept {
+		if(trampoline != other.trampoline) {
+			return false;
+		}
+		if(trampoline == &invokeFunction) {
+			return data.function == other.data.function;
+		}
+		return data.object == other.data.object;
+	}
+
+	bool operator != (const Delegate & other) const noexcept {
+		return ! (*this == other);
+	}
+
+private:
+	Delegate(const Data & data, const Trampoline trampoline) noexcept
+		: data(data), trampoline(trampoline)
+	{
+	}
+
+	template <typename C, RT (C::*method)(Args...)>
+	static RT invokeMethod(const Data & data, Args && ...args) {
+		return (static_cast<C *>(data.object)->*method)(std::forward<Args>(args)...);
+	}
+
+	template <typename C, RT (C::*method)(Args...) const>
+	static RT invokeConstMethod(const Data & data, Args && ...args) {
+		return (static_cast<const C *>(data.object)->*method)(std::forward<Args>(args)...);
+	}
+
+	template <RT (*function)(Args...)>
+	static RT invokeStaticFunction(const Data & /*data*/, Args && ...args) {
+		return function(std::forward<Args>(args)...);
+	}
+
+	static RT invokeFunction(const Data & data, Args && ...args) {
+		return data.function(std::forward<Args>(args)...);
+	}
+
+	template <typename F>
+	static RT invokeCallable(const Data & data, Args && ...args) {
+		return (*static_cast<F *>(data.object))(std::forward<Args>(args)...);
+	}
+
+private:
+	Data data;
+	Trampoline trampoline;
+};
+
+
+} //namespace eventpp
+
+#endif
+
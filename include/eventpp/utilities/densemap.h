@@ -0,0 +1,308 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DENSEMAP_H_382915640273
+#define DENSEMAP_H_382915640273
+
+#include <memory>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <tuple>
+#include <cstddef>
+#include <stdexcept>
+
+namespace eventpp {
+
+// A map for small non-negative integer or enum keys, the values are stored in an array
+// indexed by the key, so a lookup is a bound check and an array access.
+// If MaxKey is not 0, all keys must be less than MaxKey, the values are in one flat array
+// which is allocated on the first insertion.
+// If MaxKey is 0, the array grows in chunks to the largest key inserted at runtime.
+// The keys must be less than the maximum passed to the constructor, which defaults to
+// MaxKey, or defaultMaxKey if MaxKey is 0. operator [] throws std::out_of_range for a
+// negative or too large key, so a bad key doesn't allocate the array up to the key.
+// The values are never moved, so the pointers and references to the values are stable.
+// The value of every key in the allocated range is constructed, so T must be default
+// constructible and cheap to construct, such as a CallbackList.
+template <
+	typename Key,
+	typename T,
+	std::size_t MaxKey = 0
+>
+class DenseMap
+{
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using value_type = std::pair<const Key, T>;
+	using size_type = std::size_t;
+
+	enum : std::size_t {
+		defaultMaxKey = (MaxKey > 0 ? MaxKey : 65536)
+	};
+
+private:
+	struct Slot
+	{
+		explicit Slot(const Key & key)
+			: value(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple()),
+				used(false)
+		{
+		}
+
+		value_type value;
+		bool used;
+	};
+
+	using Chunk = std::vector<Slot>;
+	using ChunkPtr = std::unique_ptr<Chunk>;
+
+	enum : std::size_t {
+		chunkSize = (MaxKey > 0 ? MaxKey : 64)
+	};
+
+	template <typename MapType, typename ValueType>
+	class Iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = typename DenseMap::value_type;
+		using difference_type = std::ptrdiff_t;
+		using pointer = ValueType *;
+		using reference = ValueType &;
+
+	public:
+		Iterator() noexcept : map(nullptr), index(0) {
+		}
+
+		Iterator(MapType * map, const std::size_t index) noexcept : map(map), index(index) {
+		}
+
+		template <typename M, typename V>
+		Iterator(const Iterator<M, V> & other) noexcept : map(other.map), index(other.index) {
+		}
+
+		reference operator * () const noexcept {
+			return map->doGetSlot(index)->value;
+		}
+
+		pointer operator -> () const noexcept {
+			return &map->doGetSlot(index)->value;
+		}
+
+		Iterator & operator ++ () noexcept {
+			index = map->doFindUsedIndex(index + 1);
+			return *this;
+		}
+
+		Iterator operator ++ (int) noexcept {
+			Iterator result(*this);
+			++*this;
+			return result;
+		}
+
+		bool operator == (const Iterator & other) const noexcept {
+			return index == other.index;
+		}
+
+		bool operator != (const Iterator & other) const noexcept {
+			return index != other.index;
+		}
+
+	private:
+		template <typename M, typename V>
+		friend class Iterator;
+
+		MapType * map;
+		std::size_t index;
+	};
+
+public:
+	using iterator = Iterator<DenseMap, value_type>;
+	using const_iterator = Iterator<const DenseMap, const value_type>;
+
+public:
+	// The keys must be less than maxKey, it's limited to MaxKey if MaxKey is not 0.
+	explicit DenseMap(const std::size_t maxKey = defaultMaxKey)
+		: chunkList(), usedCount(0), maxKey((MaxKey > 0 && maxKey > MaxKey) ? MaxKey : maxKey)
+	{
+	}
+
+	DenseMap(const DenseMap & other)
+		: chunkList(), usedCount(other.usedCount), maxKey(other.maxKey)
+	{
+		chunkList.reserve(other.chunkList.size());
+		for(const ChunkPtr & chunk : other.chunkList) {
+			chunkList.emplace_back(new Chunk(*chunk));
+		}
+	}
+
+	DenseMap(DenseMap && other) noexcept
+		: DenseMap()
+	{
+		swap(other);
+	}
+
+	DenseMap & operator = (const DenseMap & other) {
+		if(this != &other) {
+			DenseMap copied(other);
+			swap(copied);
+		}
+		return *this;
+	}
+
+	DenseMap & operator = (DenseMap && other) noexcept {
+		if(this != &other) {
+			DenseMap moved(std::move(other));
+			swap(moved);
+		}
+		return *this;
+	}
+
+	void swap(DenseMap & other) noexcept {
+		using std::swap;
+
+		swap(chunkList, other.chunkList);
+		swap(usedCount, other.usedCount);
+		swap(maxKey, other.maxKey);
+	}
+
+	iterator find(const Key & key) {
+		const std::size_t index = static_cast<std::size_t>(key);
+		const Slot * slot = doGetSlot(index);
+		return (slot != nullptr && slot->used) ? iterator(this, index) : end();
+	}
+
+	const_iterator find(const Key & key) const {
+		const std::size_t index = static_cast<std::size_t>(key);
+		const Slot * slot = doGetSlot(index);
+		return (slot != nullptr && slot->used) ? const_iterator(this, index) : end();
+	}
+
+	T & operator [] (const Key & key) {
+		// A negative key is converted to a huge index, check it before the conversion.
+		if(static_cast<long long>(key) < 0) {
+			throw std::out_of_range("DenseMap: the key must not be negative.");
+		}
+		const std::size_t index = static_cast<std::size_t>(key);
+		// maxKey is not greater than MaxKey, checking MaxKey lets the compiler see the bound.
+		if((MaxKey > 0 && index >= MaxKey) || index >= maxKey) {
+			throw std::out_of_range("DenseMap: the key must be less than the maximum key.");
+		}
+		Slot * slot = doGetSlot(index);
+		if(slot == nullptr) {
+			doGrow(index);
+			slot = doGetSlot(index);
+		}
+		if(! slot->used) {
+			slot->used = true;
+			++usedCount;
+		}
+		return slot->value.second;
+	}
+
+	iterator begin() noexcept {
+		return iterator(this, doFindUsedIndex(0));
+	}
+
+	const_iterator begin() const noexcept {
+		return const_iterator(this, doFindUsedIndex(0));
+	}
+
+	iterator end() noexcept {
+		return iterator(this, doGetCapacity());
+	}
+
+	const_iterator end() const noexcept {
+		return const_iterator(this, doGetCapacity());
+	}
+
+	bool empty() const noexcept {
+		return usedCount == 0;
+	}
+
+	size_type size() const noexcept {
+		return usedCount;
+	}
+
+	std::size_t getMaxKey() const noexcept {
+		return maxKey;
+	}
+
+private:
+	template <typename M, typename V>
+	friend class Iterator;
+
+	std::size_t doGetCapacity() const noexcept {
+		return chunkList.size() * chunkSize;
+	}
+
+	Slot * doGetSlot(const std::size_t index) noexcept {
+		return const_cast<Slot *>(static_cast<const DenseMap *>(this)->doGetSlot(index));
+	}
+
+	const Slot * doGetSlot(const std::size_t index) const noexcept {
+		if(MaxKey > 0) {
+			// Only one chunk, avoid the division.
+			if(index >= MaxKey || chunkList.empty()) {
+				return nullptr;
+			}
+			return &(*chunkList.front())[index];
+		}
+		const std::size_t chunkIndex = index / chunkSize;
+		if(chunkIndex >= chunkList.size()) {
+			return nullptr;
+		}
+		return &(*chunkList[chunkIndex])[index % chunkSize];
+	}
+
+	std::size_t doFindUsedIndex(std::size_t index) const noexcept {
+		const std::size_t capacity = doGetCapacity();
+		while(index < capacity && ! doGetSlot(index)->used) {
+			++index;
+		}
+		return index;
+	}
+
+	void doGrow(const std::size_t index) {
+		while(doGetCapacity() <= index) {
+			const std::size_t firstKey = doGetCapacity();
+			ChunkPtr chunk(new Chunk());
+			chunk->reserve(chunkSize);
+			for(std::size_t i = 0; i < chunkSize; ++i) {
+				chunk->emplace_back(static_cast<Key>(firstKey + i));
+			}
+			chunkList.push_back(std::move(chunk));
+		}
+	}
+
+private:
+	// Each chunk is never resized after it's created, so the values don't move
+	// when the chunk list grows.
+	std::vector<ChunkPtr> chunkList;
+	std::size_t usedCount;
+	std::size_t maxKey;
+};
+
+template <typename Key, typename T, std::size_t MaxKey>
+void swap(DenseMap<Key, T, MaxKey> & first, DenseMap<Key, T, MaxKey> & second) noexcept
+{
+	first.swap(second);
+}
+
+
+} //namespace eventpp
+
+#endif
+
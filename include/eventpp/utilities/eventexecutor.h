@@ -0,0 +1,389 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EVENTEXECUTOR_H_730196485213
+#define EVENTEXECUTOR_H_730196485213
+
+#include "../eventqueue.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <type_traits>
+#include <cstddef>
+
+namespace eventpp {
+
+namespace internal_ {
+
+template <typename T, typename ...Args>
+struct HasFunctionGetKey
+{
+	template <typename C> static std::true_type test(decltype(C::getKey(std::declval<Args>()...)) *);
+	template <typename C> static std::false_type test(...);
+
+	enum { value = !! decltype(test<T>(0))() };
+};
+struct DefaultGetKey
+{
+	template <typename E, typename ...Args>
+	static const E & getKey(const E & e, const Args & ...) {
+		return e;
+	}
+};
+template <typename T, bool> struct SelectGetKey { using Type = T; };
+template <typename T> struct SelectGetKey<T, false> { using Type = DefaultGetKey; };
+
+// std::hash doesn't support enum before C++14.
+template <typename T>
+auto hashExecutorKey(const T & key)
+	-> typename std::enable_if<std::is_enum<T>::value, std::size_t>::type
+{
+	return std::hash<typename std::underlying_type<T>::type>()(
+		static_cast<typename std::underlying_type<T>::type>(key)
+	);
+}
+
+template <typename T>
+auto hashExecutorKey(const T & key)
+	-> typename std::enable_if<! std::is_enum<T>::value, std::size_t>::type
+{
+	return std::hash<T>()(key);
+}
+
+} //namespace internal_
+
+template <
+	typename Event_,
+	typename Prototype_,
+	typename Policies_ = DefaultPolicies
+>
+class EventExecutor;
+
+// Dispatches the enqueued events on a pool of worker threads.
+// The events are grouped by key into key groups, each key group is owned by a worker.
+// The events in the same key group are dispatched one by one in the enqueuing order,
+// the key groups are dispatched in parallel. An idle worker steals the ready key
+// groups from the other workers, and the stolen key group moves to the thief.
+template <
+	typename Event_,
+	typename Policies_,
+	typename ReturnType, typename ...Args
+>
+class EventExecutor <
+		Event_,
+		ReturnType (Args...),
+		Policies_
+	> : private EventQueue<Event_, ReturnType (Args...), Policies_>
+{
+private:
+	using super = EventQueue<Event_, ReturnType (Args...), Policies_>;
+	// Keeps the EventToken of the enqueued event.
+	using QueuedItem = typename super::QueuedItem;
+
+	using GetKey = typename internal_::SelectGetKey<
+		Policies_,
+		internal_::HasFunctionGetKey<
+			Policies_,
+			const typename super::Event &,
+			const typename std::decay<Args>::type & ...
+		>::value
+	>::Type;
+
+	struct KeyGroup
+	{
+		KeyGroup() : mutex(), eventList(), scheduled(false), workerIndex(0) {
+		}
+
+		std::mutex mutex;
+		std::vector<QueuedItem> eventList;
+		// True when the group is in a ready list or being processed.
+		bool scheduled;
+		std::size_t workerIndex;
+	};
+
+	struct Worker
+	{
+		Worker() : mutex(), conditionVariable(), readyList(), sleeping(false), thread() {
+		}
+
+		std::mutex mutex;
+		std::condition_variable conditionVariable;
+		std::deque<KeyGroup *> readyList;
+		bool sleeping;
+		std::thread thread;
+	};
+
+public:
+	using Event = typename super::Event;
+	using Handle = typename super::Handle;
+	using Callback = typename super::Callback;
+	using EventToken = typename super::EventToken;
+	using QueuedEvent = typename super::QueuedEvent;
+
+	using super::appendListener;
+	using super::prependListener;
+	using super::insertListener;
+	using super::removeListener;
+	using super::hasAnyListener;
+	using super::ownsHandle;
+	using super::forEach;
+	using super::forEachIf;
+	using super::getEventToken;
+
+public:
+	explicit EventExecutor(
+			const std::size_t threadCount = std::thread::hardware_concurrency(),
+			const std::size_t groupsPerThread = 16
+		)
+		:
+			super(),
+			workerList(threadCount > 0 ? threadCount : 1),
+			keyGroupList(workerList.size() * (groupsPerThread > 0 ? groupsPerThread : 1)),
+			readyGroupCount(0),
+			pendingEventCount(0),
+			stopping(false),
+			idleMutex(),
+			idleConditionVariable()
+	{
+		for(std::size_t i = 0; i < keyGroupList.size(); ++i) {
+			keyGroupList[i].workerIndex = i % workerList.size();
+		}
+		for(std::size_t i = 0; i < workerList.size(); ++i) {
+			workerList[i].thread = std::thread([this, i]() {
+				doWorkerLoop(i);
+			});
+		}
+	}
+
+	// All enqueued events are dispatched before the workers stop.
+	~EventExecutor()
+	{
+		waitForIdle();
+
+		stopping.store(true, std::memory_order_release);
+		for(Worker & worker : workerList) {
+			std::lock_guard<std::mutex> lock(worker.mutex);
+			worker.conditionVariable.notify_one();
+		}
+		for(Worker & worker : workerList) {
+			worker.thread.join();
+		}
+	}
+
+	EventExecutor(const EventExecutor &) = delete;
+	EventExecutor & operator = (const EventExecutor &) = delete;
+
+	template <typename ...A>
+	void enqueue(A && ...args)
+	{
+		doEnqueue(super::doMakeQueuedEvent(std::forward<A>(args)...));
+	}
+
+	// Block until all enqueued events are dispatched.
+	void waitForIdle() const
+	{
+		std::unique_lock<std::mutex> lock(idleMutex);
+		idleConditionVariable.wait(lock, [this]() -> bool {
+			return pendingEventCount.load(std::memory_order_acquire) == 0;
+		});
+	}
+
+	std::size_t getThreadCount() const
+	{
+		return workerList.size();
+	}
+
+private:
+	void doEnqueue(QueuedItem && item)
+	{
+		KeyGroup & group = doGetKeyGroup(item, typename internal_::MakeIndexSequence<sizeof...(Args)>::Type());
+		pendingEventCount.fetch_add(1, std::memory_order_relaxed);
+
+		bool schedule = false;
+		std::size_t workerIndex;
+		{
+			std::lock_guard<std::mutex> lock(group.mutex);
+			group.eventList.push_back(std::move(item));
+			if(! group.scheduled) {
+				group.scheduled = true;
+				schedule = true;
+			}
+			workerIndex = group.workerIndex;
+		}
+
+		if(schedule) {
+			doScheduleKeyGroup(&group, workerIndex);
+		}
+	}
+
+	template <size_t ...Indexes>
+	KeyGroup & doGetKeyGroup(const QueuedItem & item, internal_::IndexSequence<Indexes...>)
+	{
+		const auto & key = GetKey::getKey(item.event, std::get<Indexes>(item.arguments)...);
+		const std::size_t hash = internal_::hashExecutorKey<typename std::decay<decltype(key)>::type>(key);
+		return keyGroupList[hash % keyGroupList.size()];
+	}
+
+	void doScheduleKeyGroup(KeyGroup * group, const std::size_t workerIndex)
+	{
+		Worker & worker = workerList[workerIndex];
+		bool wokenUp = false;
+		{
+			std::lock_guard<std::mutex> lock(worker.mutex);
+			worker.readyList.push_back(group);
+			readyGroupCount.fetch_add(1, std::memory_order_release);
+			if(worker.sleeping) {
+				worker.sleeping = false;
+				worker.conditionVariable.notify_one();
+				wokenUp = true;
+			}
+		}
+
+		// The owner is busy, let a sleeping worker steal the group.
+		if(! wokenUp) {
+			for(std::size_t i = 1; i < workerList.size(); ++i) {
+				Worker & other = workerList[(workerIndex + i) % workerList.size()];
+				std::lock_guard<std::mutex> lock(other.mutex);
+				if(other.sleeping) {
+					other.sleeping = false;
+					other.conditionVariable.notify_one();
+					break;
+				}
+			}
+		}
+	}
+
+	KeyGroup * doTakeKeyGroup(const std::size_t workerIndex)
+	{
+		{
+			Worker & worker = workerList[workerIndex];
+			std::lock_guard<std::mutex> lock(worker.mutex);
+			if(! worker.readyList.empty()) {
+				KeyGroup * group = worker.readyList.front();
+				worker.readyList.pop_front();
+				readyGroupCount.fetch_sub(1, std::memory_order_relaxed);
+				return group;
+			}
+		}
+
+		for(std::size_t i = 1; i < workerList.size(); ++i) {
+			if(readyGroupCount.load(std::memory_order_acquire) == 0) {
+				break;
+			}
+
+			Worker & victim = workerList[(workerIndex + i) % workerList.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if(! victim.readyList.empty()) {
+				KeyGroup * group = victim.readyList.back();
+				victim.readyList.pop_back();
+				readyGroupCount.fetch_sub(1, std::memory_order_relaxed);
+
+				std::lock_guard<std::mutex> groupLock(group->mutex);
+				group->workerIndex = workerIndex;
+				return group;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void doProcessKeyGroup(KeyGroup * group, std::vector<QueuedItem> & eventList)
+	{
+		{
+			std::lock_guard<std::mutex> lock(group->mutex);
+			using std::swap;
+			swap(eventList, group->eventList);
+		}
+
+		for(const QueuedItem & item : eventList) {
+			this->doDispatchQueuedEvent(item, typename internal_::MakeIndexSequence<sizeof...(Args)>::Type());
+		}
+		const std::size_t count = eventList.size();
+		eventList.clear();
+
+		bool reschedule = false;
+		std::size_t workerIndex;
+		{
+			std::lock_guard<std::mutex> lock(group->mutex);
+			if(group->eventList.empty()) {
+				group->scheduled = false;
+			}
+			else {
+				reschedule = true;
+			}
+			workerIndex = group->workerIndex;
+		}
+
+		// Put the group back to the end of the ready list, so it doesn't starve the others.
+		if(reschedule) {
+			doScheduleKeyGroup(group, workerIndex);
+		}
+
+		if(pendingEventCount.fetch_sub(count, std::memory_order_acq_rel) == count) {
+			std::lock_guard<std::mutex> lock(idleMutex);
+			idleConditionVariable.notify_all();
+		}
+	}
+
+	void doWorkerLoop(const std::size_t workerIndex)
+	{
+		Worker & worker = workerList[workerIndex];
+		// Reused between the groups to keep the capacity.
+		std::vector<QueuedItem> eventList;
+
+		for(;;) {
+			KeyGroup * group = doTakeKeyGroup(workerIndex);
+			if(group != nullptr) {
+				doProcessKeyGroup(group, eventList);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(worker.mutex);
+			if(stopping.load(std::memory_order_acquire)) {
+				break;
+			}
+			if(! worker.readyList.empty() || readyGroupCount.load(std::memory_order_acquire) > 0) {
+				continue;
+			}
+			worker.sleeping = true;
+			worker.conditionVariable.wait(lock, [this, &worker]() -> bool {
+				return ! worker.sleeping
+					|| stopping.load(std::memory_order_acquire)
+					|| readyGroupCount.load(std::memory_order_acquire) > 0
+				;
+			});
+			worker.sleeping = false;
+		}
+	}
+
+private:
+	std::vector<Worker> workerList;
+	std::vector<KeyGroup> keyGroupList;
+	std::atomic<std::size_t> readyGroupCount;
+	std::atomic<std::size_t> pendingEventCount;
+	std::atomic<bool> stopping;
+	mutable std::mutex idleMutex;
+	mutable std::condition_variable idleConditionVariable;
+};
+
+
+} //namespace eventpp
+
+#endif
+
@@ -0,0 +1,345 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FLATHASHMAP_H_905183627401
+#define FLATHASHMAP_H_905183627401
+
+#include <memory>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <iterator>
+#include <tuple>
+#include <cstddef>
+#include <cstdint>
+
+namespace eventpp {
+
+// An open addressing hash map with Robin Hood probing. It's insert only, an element
+// can't be erased.
+// The bucket table is a contiguous array of 16 bytes entries (on 64 bit) holding the hash
+// and a pointer to the value. The values are stored in chunks which double in size, a chunk is never
+// moved or resized, so the pointers and references to the values are stable, and the
+// memory is allocated O(log N) times for N elements.
+template <
+	typename Key,
+	typename T,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>
+>
+class FlatHashMap
+{
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using value_type = std::pair<const Key, T>;
+	using size_type = std::size_t;
+
+private:
+	using Chunk = std::vector<value_type>;
+	using ChunkPtr = std::unique_ptr<Chunk>;
+
+	struct Entry
+	{
+		std::size_t hash;
+		// nullptr if the entry is empty.
+		value_type * value;
+	};
+
+	enum {
+		initialBucketCount = 16,
+		firstChunkSize = 16
+	};
+
+	template <typename MapType, typename ValueType>
+	class Iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = typename FlatHashMap::value_type;
+		using difference_type = std::ptrdiff_t;
+		using pointer = ValueType *;
+		using reference = ValueType &;
+
+	public:
+		Iterator() noexcept : map(nullptr), value(nullptr) {
+		}
+
+		// value is nullptr for end().
+		Iterator(MapType * map, pointer value) noexcept
+			: map(map), value(value)
+		{
+		}
+
+		template <typename M, typename V>
+		Iterator(const Iterator<M, V> & other) noexcept
+			: map(other.map), value(other.value)
+		{
+		}
+
+		reference operator * () const noexcept {
+			return *value;
+		}
+
+		pointer operator -> () const noexcept {
+			return value;
+		}
+
+		Iterator & operator ++ () noexcept {
+			value = map->doGetNextValue(value);
+			return *this;
+		}
+
+		Iterator operator ++ (int) noexcept {
+			Iterator result(*this);
+			++*this;
+			return result;
+		}
+
+		bool operator == (const Iterator & other) const noexcept {
+			return value == other.value;
+		}
+
+		bool operator != (const Iterator & other) const noexcept {
+			return ! (*this == other);
+		}
+
+	private:
+		template <typename M, typename V>
+		friend class Iterator;
+
+		MapType * map;
+		pointer value;
+	};
+
+public:
+	using iterator = Iterator<FlatHashMap, value_type>;
+	using const_iterator = Iterator<const FlatHashMap, const value_type>;
+
+public:
+	FlatHashMap()
+		: entryList(), bucketShift(0), chunkList(), elementCount(0)
+	{
+	}
+
+	FlatHashMap(const FlatHashMap & other)
+		: FlatHashMap()
+	{
+		for(const value_type & item : other) {
+			(*this)[item.first] = item.second;
+		}
+	}
+
+	FlatHashMap(FlatHashMap && other) noexcept
+		: FlatHashMap()
+	{
+		swap(other);
+	}
+
+	FlatHashMap & operator = (const FlatHashMap & other) {
+		if(this != &other) {
+			FlatHashMap copied(other);
+			swap(copied);
+		}
+		return *this;
+	}
+
+	FlatHashMap & operator = (FlatHashMap && other) noexcept {
+		if(this != &other) {
+			FlatHashMap moved(std::move(other));
+			swap(moved);
+		}
+		return *this;
+	}
+
+	void swap(FlatHashMap & other) noexcept {
+		using std::swap;
+
+		swap(entryList, other.entryList);
+		swap(bucketShift, other.bucketShift);
+		swap(chunkList, other.chunkList);
+		swap(elementCount, other.elementCount);
+	}
+
+	iterator find(const Key & key) {
+		const Entry * entry = doFindEntry(key, Hash()(key));
+		return iterator(this, entry == nullptr ? nullptr : entry->value);
+	}
+
+	const_iterator find(const Key & key) const {
+		const Entry * entry = doFindEntry(key, Hash()(key));
+		return const_iterator(this, entry == nullptr ? nullptr : entry->value);
+	}
+
+	T & operator [] (const Key & key) {
+		const std::size_t hash = Hash()(key);
+		const Entry * entry = doFindEntry(key, hash);
+		if(entry != nullptr) {
+			return entry->value->second;
+		}
+		return doInsert(key, hash)->second;
+	}
+
+	iterator begin() noexcept {
+		return iterator(this, chunkList.empty() ? nullptr : chunkList.front()->data());
+	}
+
+	const_iterator begin() const noexcept {
+		return const_iterator(this, chunkList.empty() ? nullptr : chunkList.front()->data());
+	}
+
+	iterator end() noexcept {
+		return iterator(this, nullptr);
+	}
+
+	const_iterator end() const noexcept {
+		return const_iterator(this, nullptr);
+	}
+
+	bool empty() const noexcept {
+		return elementCount == 0;
+	}
+
+	size_type size() const noexcept {
+		return elementCount;
+	}
+
+private:
+	template <typename M, typename V>
+	friend class Iterator;
+
+	// Fibonacci hashing spreads the bits, std::hash of integers is often the identity.
+	std::size_t doGetHomeIndex(const std::size_t hash) const noexcept {
+		return (std::size_t)(((std::uint64_t)hash * UINT64_C(11400714819323198485)) >> bucketShift);
+	}
+
+	std::size_t doGetMask() const noexcept {
+		return entryList.size() - 1;
+	}
+
+	const Entry * doFindEntry(const Key & key, const std::size_t hash) const {
+		if(entryList.empty()) {
+			return nullptr;
+		}
+		const std::size_t mask = doGetMask();
+		std::size_t index = doGetHomeIndex(hash);
+		for(std::size_t distance = 0; ; ++distance) {
+			const Entry & entry = entryList[index];
+			if(entry.value == nullptr) {
+				return nullptr;
+			}
+			// Robin Hood invariant, an element is never further from its home than the
+			// elements after it, so the search stops at the first richer entry.
+			if(((index - doGetHomeIndex(entry.hash)) & mask) < distance) {
+				return nullptr;
+			}
+			if(entry.hash == hash && KeyEqual()(entry.value->first, key)) {
+				return &entry;
+			}
+			index = (index + 1) & mask;
+		}
+	}
+
+	value_type * doInsert(const Key & key, const std::size_t hash) {
+		// The max load factor is 1/2. A higher load factor makes the probe count vary,
+		// the mispredicted branches cost more than the larger table.
+		if((elementCount + 1) * 2 > entryList.size()) {
+			doRehash(entryList.empty() ? (std::size_t)initialBucketCount : entryList.size() * 2);
+		}
+
+		if(chunkList.empty() || chunkList.back()->size() == chunkList.back()->capacity()) {
+			ChunkPtr chunk(new Chunk());
+			chunk->reserve(chunkList.empty() ? (std::size_t)firstChunkSize : chunkList.back()->capacity() * 2);
+			chunkList.push_back(std::move(chunk));
+		}
+		Chunk & chunk = *chunkList.back();
+		chunk.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+
+		Entry entry;
+		entry.hash = hash;
+		entry.value = &chunk.back();
+		doPlaceEntry(entry);
+		++elementCount;
+
+		return entry.value;
+	}
+
+	// Values are in inserting order, only the last chunk can be partially filled,
+	// and there is no empty chunk.
+	value_type * doGetNextValue(const value_type * value) const noexcept {
+		// Search from the last chunk, the most values are in the larger chunks.
+		const std::less<const value_type *> less;
+		for(std::size_t i = chunkList.size(); i > 0; --i) {
+			Chunk & chunk = *chunkList[i - 1];
+			// The chunks are not ordered by address, check the range.
+			if(! less(value, chunk.data()) && less(value, chunk.data() + chunk.size())) {
+				if(value + 1 != chunk.data() + chunk.size()) {
+					return &chunk[value - chunk.data() + 1];
+				}
+				return i < chunkList.size() ? chunkList[i]->data() : nullptr;
+			}
+		}
+		return nullptr;
+	}
+
+	void doPlaceEntry(Entry entry) {
+		const std::size_t mask = doGetMask();
+		std::size_t index = doGetHomeIndex(entry.hash);
+		for(std::size_t distance = 0; ; ++distance) {
+			Entry & current = entryList[index];
+			if(current.value == nullptr) {
+				current = entry;
+				return;
+			}
+			const std::size_t currentDistance = (index - doGetHomeIndex(current.hash)) & mask;
+			if(currentDistance < distance) {
+				std::swap(entry, current);
+				distance = currentDistance;
+			}
+			index = (index + 1) & mask;
+		}
+	}
+
+	void doRehash(const std::size_t bucketCount) {
+		// The entries are value initialized, so they are empty.
+		std::vector<Entry> oldEntryList(bucketCount);
+		oldEntryList.swap(entryList);
+		bucketShift = 64;
+		for(std::size_t count = bucketCount; count > 1; count >>= 1) {
+			--bucketShift;
+		}
+		for(const Entry & entry : oldEntryList) {
+			if(entry.value != nullptr) {
+				doPlaceEntry(entry);
+			}
+		}
+	}
+
+private:
+	std::vector<Entry> entryList;
+	unsigned int bucketShift;
+	std::vector<ChunkPtr> chunkList;
+	std::size_t elementCount;
+};
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void swap(FlatHashMap<Key, T, Hash, KeyEqual> & first, FlatHashMap<Key, T, Hash, KeyEqual> & second) noexcept
+{
+	first.swap(second);
+}
+
+
+} //namespace eventpp
+
+#endif
+
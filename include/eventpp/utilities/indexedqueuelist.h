@@ -0,0 +1,494 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INDEXEDQUEUELIST_H_304918275561
+#define INDEXEDQUEUELIST_H_304918275561
+
+#include "../eventpolicies.h"
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <map>
+#include <unordered_map>
+#include <cstddef>
+
+namespace eventpp {
+
+// A doubly linked list which also links the items of the same event in a lane.
+// The items are iterated in the order they are put in the list, the same as std::list.
+// spliceEvent moves the items of one event to another list, it costs as much as the
+// count of the moved items, so EventQueue::processEvent and EventQueue::clearEvents(event)
+// don't touch the items of the other events.
+// Each list keeps a map from the event to its lane. Moving all items of a list costs
+// as much as the count of the lanes if all items are indexed, otherwise as much as the
+// count of the items.
+// An item is indexed when it's put in a list, the empty items (the recycled items in the
+// free list of EventQueue) are not indexed. An item which is set after it's put in the list
+// is indexed when it's moved to another list.
+// The event type must be copyable and default constructible.
+template <typename T>
+class IndexedQueueList
+{
+private:
+	using Key = typename std::decay<decltype(std::declval<const T &>().get().event)>::type;
+
+	struct Link
+	{
+		Link * previous;
+		Link * next;
+	};
+
+	struct Node : Link
+	{
+		template <typename ...A>
+		explicit Node(A && ...args)
+			: Link(), lanePrevious(nullptr), laneNext(nullptr), key(), indexed(false), value(std::forward<A>(args)...)
+		{
+		}
+
+		Node * lanePrevious;
+		Node * laneNext;
+		// The key of the lane which the node is in, only valid if indexed is true.
+		// The item may be cleared while it's in the lane, so the key is kept here.
+		Key key;
+		bool indexed;
+		T value;
+	};
+
+	struct Lane
+	{
+		Node * first;
+		Node * last;
+		std::size_t count;
+	};
+
+	using LaneMap = typename std::conditional<
+		internal_::HasHash<Key>::value,
+		std::unordered_map<Key, Lane>,
+		std::map<Key, Lane>
+	>::type;
+
+	template <typename V, typename L>
+	class Iterator
+	{
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = V *;
+		using reference = V &;
+
+	public:
+		Iterator() : link(nullptr) {
+		}
+
+		explicit Iterator(L * link) : link(link) {
+		}
+
+		// iterator can convert to const_iterator.
+		template <typename V2, typename L2>
+		Iterator(const Iterator<V2, L2> & other) : link(other.link) {
+		}
+
+		reference operator * () const {
+			return static_cast<Node *>(const_cast<Link *>(link))->value;
+		}
+
+		pointer operator -> () const {
+			return &**this;
+		}
+
+		Iterator & operator ++ () {
+			link = link->next;
+			return *this;
+		}
+
+		Iterator operator ++ (int) {
+			Iterator result(*this);
+			link = link->next;
+			return result;
+		}
+
+		Iterator & operator -- () {
+			link = link->previous;
+			return *this;
+		}
+
+		Iterator operator -- (int) {
+			Iterator result(*this);
+			link = link->previous;
+			return result;
+		}
+
+		template <typename V2, typename L2>
+		bool operator == (const Iterator<V2, L2> & other) const {
+			return link == other.link;
+		}
+
+		template <typename V2, typename L2>
+		bool operator != (const Iterator<V2, L2> & other) const {
+			return link != other.link;
+		}
+
+	private:
+		L * link;
+
+		template <typename V2, typename L2>
+		friend class Iterator;
+		friend class IndexedQueueList;
+	};
+
+public:
+	using value_type = T;
+	using reference = T &;
+	using const_reference = const T &;
+	using iterator = Iterator<T, Link>;
+	using const_iterator = Iterator<const T, const Link>;
+
+public:
+	IndexedQueueList() : head(), laneMap(), unindexedCount(0) {
+		doReset();
+	}
+
+	~IndexedQueueList() {
+		clear();
+	}
+
+	IndexedQueueList(IndexedQueueList && other) noexcept : head(), laneMap(), unindexedCount(0) {
+		doReset();
+		doTakeAll(other);
+	}
+
+	IndexedQueueList & operator = (IndexedQueueList && other) noexcept {
+		if(this != &other) {
+			clear();
+			doTakeAll(other);
+		}
+		return *this;
+	}
+
+	IndexedQueueList(const IndexedQueueList &) = delete;
+	IndexedQueueList & operator = (const IndexedQueueList &) = delete;
+
+	bool empty() const {
+		return head.next == &head;
+	}
+
+	iterator begin() {
+		return iterator(head.next);
+	}
+
+	const_iterator begin() const {
+		return const_iterator(head.next);
+	}
+
+	iterator end() {
+		return iterator(&head);
+	}
+
+	const_iterator end() const {
+		return const_iterator(&head);
+	}
+
+	reference front() {
+		return *begin();
+	}
+
+	const_reference front() const {
+		return *begin();
+	}
+
+	void swap(IndexedQueueList & other) noexcept {
+		IndexedQueueList temp(std::move(other));
+		other.doTakeAll(*this);
+		doTakeAll(temp);
+	}
+
+	template <typename ...A>
+	void emplace_back(A && ...args) {
+		Node * node = new Node(std::forward<A>(args)...);
+		doLinkBefore(&head, node, node);
+		doIndex(node);
+		if(! node->indexed) {
+			++unindexedCount;
+		}
+	}
+
+	void clear() {
+		Link * link = head.next;
+		while(link != &head) {
+			Node * node = static_cast<Node *>(link);
+			link = link->next;
+			delete node;
+		}
+		doReset();
+		laneMap.clear();
+		unindexedCount = 0;
+	}
+
+	// Move all items in other before pos.
+	void splice(const_iterator pos, IndexedQueueList & other) {
+		if(other.empty() || &other == this) {
+			return;
+		}
+
+		Link * position = const_cast<Link *>(pos.link);
+		const bool toFront = (position != &head && position == head.next);
+		if(other.unindexedCount > 0 || (position != &head && ! toFront)) {
+			// Move the items one by one. Put them at the front from the last one,
+			// so each item is put at the front or the back of its lane.
+			if(toFront) {
+				while(! other.empty()) {
+					splice(begin(), other, std::prev(other.end()));
+				}
+			}
+			else {
+				while(! other.empty()) {
+					splice(pos, other, other.begin());
+				}
+			}
+			return;
+		}
+
+		for(auto & item : other.laneMap) {
+			const Lane & otherLane = item.second;
+			// The items are cleared after they are processed, don't index them in the free list.
+			if(otherLane.first->value.empty() && doUnindexClearedLane(otherLane)) {
+				continue;
+			}
+
+			auto it = laneMap.find(item.first);
+			if(it == laneMap.end()) {
+				laneMap.insert(item);
+			}
+			else if(toFront) {
+				Lane & lane = it->second;
+				otherLane.last->laneNext = lane.first;
+				lane.first->lanePrevious = otherLane.last;
+				lane.first = otherLane.first;
+				lane.count += otherLane.count;
+			}
+			else {
+				Lane & lane = it->second;
+				lane.last->laneNext = otherLane.first;
+				otherLane.first->lanePrevious = lane.last;
+				lane.last = otherLane.last;
+				lane.count += otherLane.count;
+			}
+		}
+		other.laneMap.clear();
+
+		Link * first = other.head.next;
+		Link * last = other.head.previous;
+		other.doReset();
+		doLinkBefore(position, first, last);
+	}
+
+	// Move the item it in other before pos.
+	void splice(const_iterator pos, IndexedQueueList & other, const_iterator it) {
+		Node * node = static_cast<Node *>(const_cast<Link *>(it.link));
+		Link * position = const_cast<Link *>(pos.link);
+		if(&other == this && (node == position || node->next == position)) {
+			return;
+		}
+
+		if(node->indexed) {
+			other.doUnindex(node);
+		}
+		else {
+			--other.unindexedCount;
+		}
+		node->previous->next = node->next;
+		node->next->previous = node->previous;
+		doLinkBefore(position, node, node);
+		doIndex(node);
+		if(! node->indexed) {
+			++unindexedCount;
+		}
+	}
+
+	// Move the items of event in other before pos, they keep their order.
+	// Return the count of the moved items.
+	std::size_t spliceEvent(const_iterator pos, IndexedQueueList & other, const Key & event) {
+		auto it = other.laneMap.find(event);
+		if(it == other.laneMap.end()) {
+			return 0;
+		}
+
+		const std::size_t count = it->second.count;
+		Node * node = it->second.first;
+		for(std::size_t i = 0; i < count; ++i) {
+			Node * next = node->laneNext;
+			splice(pos, other, const_iterator(node));
+			node = next;
+		}
+		return count;
+	}
+
+	// Return the count of the items of event.
+	std::size_t countEvent(const Key & event) const {
+		auto it = laneMap.find(event);
+		return it == laneMap.end() ? 0 : it->second.count;
+	}
+
+	friend void swap(IndexedQueueList & a, IndexedQueueList & b) noexcept {
+		a.swap(b);
+	}
+
+private:
+	void doReset() {
+		head.previous = &head;
+		head.next = &head;
+	}
+
+	// This list must be empty.
+	void doTakeAll(IndexedQueueList & other) {
+		if(! other.empty()) {
+			laneMap = std::move(other.laneMap);
+			other.laneMap.clear();
+			unindexedCount = other.unindexedCount;
+			other.unindexedCount = 0;
+
+			Link * first = other.head.next;
+			Link * last = other.head.previous;
+			other.doReset();
+			doLinkBefore(&head, first, last);
+		}
+	}
+
+	static void doLinkBefore(Link * position, Link * first, Link * last) {
+		first->previous = position->previous;
+		last->next = position;
+		position->previous->next = first;
+		position->previous = last;
+	}
+
+	// Put the node in its lane. The node is already linked in this list.
+	void doIndex(Node * node) {
+		if(node->value.empty()) {
+			return;
+		}
+
+		const Key & key = node->value.get().event;
+		auto it = laneMap.find(key);
+		if(it == laneMap.end()) {
+			Lane lane { node, node, 1 };
+			laneMap.insert(std::make_pair(key, lane));
+		}
+		else {
+			Lane & lane = it->second;
+			Node * next = nullptr;
+			if(node->next != &head && node->previous == &head) {
+				next = lane.first;
+			}
+			else if(node->next != &head) {
+				// Find the next item of the same event. It's only needed when the item
+				// is put in the middle of the list, EventQueue doesn't do that.
+				for(Link * link = node->next; link != &head; link = link->next) {
+					Node * other = static_cast<Node *>(link);
+					if(other->indexed && doIsSameKey(other->key, key, std::integral_constant<bool, internal_::HasHash<Key>::value>())) {
+						next = other;
+						break;
+					}
+				}
+			}
+
+			Node * previous = (next != nullptr ? next->lanePrevious : lane.last);
+			node->lanePrevious = previous;
+			node->laneNext = next;
+			if(previous != nullptr) {
+				previous->laneNext = node;
+			}
+			else {
+				lane.first = node;
+			}
+			if(next != nullptr) {
+				next->lanePrevious = node;
+			}
+			else {
+				lane.last = node;
+			}
+			++lane.count;
+		}
+
+		node->key = key;
+		node->indexed = true;
+	}
+
+	// The node must be indexed.
+	void doUnindex(Node * node) {
+		auto it = laneMap.find(node->key);
+		Lane & lane = it->second;
+		if(node->lanePrevious != nullptr) {
+			node->lanePrevious->laneNext = node->laneNext;
+		}
+		else {
+			lane.first = node->laneNext;
+		}
+		if(node->laneNext != nullptr) {
+			node->laneNext->lanePrevious = node->lanePrevious;
+		}
+		else {
+			lane.last = node->lanePrevious;
+		}
+		if(--lane.count == 0) {
+			laneMap.erase(it);
+		}
+
+		node->lanePrevious = nullptr;
+		node->laneNext = nullptr;
+		node->indexed = false;
+	}
+
+	// If all items in the lane are empty, remove them from the lane and return true.
+	// The lane must be in another list, the items are moved to this list.
+	bool doUnindexClearedLane(const Lane & lane) {
+		for(Node * node = lane.first; node != nullptr; node = node->laneNext) {
+			if(! node->value.empty()) {
+				return false;
+			}
+		}
+
+		Node * node = lane.first;
+		while(node != nullptr) {
+			Node * next = node->laneNext;
+			node->lanePrevious = nullptr;
+			node->laneNext = nullptr;
+			node->indexed = false;
+			node = next;
+		}
+		unindexedCount += lane.count;
+		return true;
+	}
+
+	bool doIsSameKey(const Key & a, const Key & b, std::true_type) const {
+		return laneMap.key_eq()(a, b);
+	}
+
+	bool doIsSameKey(const Key & a, const Key & b, std::false_type) const {
+		return ! laneMap.key_comp()(a, b) && ! laneMap.key_comp()(b, a);
+	}
+
+private:
+	Link head;
+	LaneMap laneMap;
+	// The count of the items which are not indexed.
+	std::size_t unindexedCount;
+};
+
+
+} //namespace eventpp
+
+#endif
+
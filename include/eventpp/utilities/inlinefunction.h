@@ -0,0 +1,367 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INLINEFUNCTION_H_790426152318
+#define INLINEFUNCTION_H_790426152318
+
+#include <type_traits>
+#include <cstddef>
+#include <cassert>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace eventpp {
+
+namespace inlinefunction_internal_ {
+
+template <typename T>
+struct RemoveCvRef
+{
+	using Type = typename std::remove_cv<typename std::remove_reference<T>::type>::type;
+};
+
+// The callable is invoked as an lvalue, and its result must be convertible to RT unless RT is void.
+template <typename T, typename RT, typename ...Args>
+struct IsInvocable
+{
+	template <typename U>
+	static auto test(int) -> decltype(std::declval<U &>()(std::declval<Args>()...));
+
+	template <typename U>
+	static auto test(...) -> void (*)(std::nullptr_t, std::nullptr_t);
+
+	using ResultType = decltype(test<T>(0));
+
+	static constexpr bool value =
+		! std::is_same<ResultType, void (*)(std::nullptr_t, std::nullptr_t)>::value
+		&& (std::is_void<RT>::value || std::is_convertible<ResultType, RT>::value)
+	;
+};
+
+template <typename RT, typename ...Args>
+struct InlineFunctionOperations
+{
+	RT (*invoke)(void *, Args && ...);
+	void (*destroy)(void *);
+	void (*moveConstruct)(void *, void *);
+	// nullptr if the callable is move only.
+	void (*copyConstruct)(const void *, void *);
+};
+
+// The callable is constructed in the buffer.
+template <typename T>
+struct InlineStorage
+{
+	template <typename F>
+	static void construct(void * buffer, F && f) {
+		new (buffer) T(std::forward<F>(f));
+	}
+
+	static T * get(void * buffer) {
+		return static_cast<T *>(buffer);
+	}
+
+	static void destroy(void * buffer) {
+		get(buffer)->~T();
+	}
+
+	static void moveConstruct(void * from, void * to) {
+		new (to) T(std::move(*get(from)));
+	}
+
+	static void copyConstruct(const void * from, void * to) {
+		new (to) T(*static_cast<const T *>(from));
+	}
+};
+
+// The buffer holds a pointer to the callable allocated on the heap.
+template <typename T>
+struct HeapStorage
+{
+	template <typename F>
+	static void construct(void * buffer, F && f) {
+		new (buffer) T *(new T(std::forward<F>(f)));
+	}
+
+	static T * get(void * buffer) {
+		return *static_cast<T **>(buffer);
+	}
+
+	static void destroy(void * buffer) {
+		delete get(buffer);
+	}
+
+	static void moveConstruct(void * from, void * to) {
+		new (to) T *(get(from));
+		*static_cast<T **>(from) = nullptr;
+	}
+
+	static void copyConstruct(const void * from, void * to) {
+		new (to) T *(new T(**static_cast<T * const *>(from)));
+	}
+};
+
+template <typename Storage, typename RT, typename ...Args>
+RT funcInvoke(void * buffer, Args && ...args)
+{
+	return static_cast<RT>((*Storage::get(buffer))(std::forward<Args>(args)...));
+}
+
+template <typename Storage, typename T>
+auto doGetCopyConstruct()
+	-> typename std::enable_if<std::is_copy_constructible<T>::value, void (*)(const void *, void *)>::type
+{
+	return &Storage::copyConstruct;
+}
+
+template <typename Storage, typename T>
+auto doGetCopyConstruct()
+	-> typename std::enable_if<! std::is_copy_constructible<T>::value, void (*)(const void *, void *)>::type
+{
+	return nullptr;
+}
+
+template <typename Storage, typename T, typename RT, typename ...Args>
+const InlineFunctionOperations<RT, Args...> * getInlineFunctionOperations()
+{
+	static const InlineFunctionOperations<RT, Args...> operations {
+		&funcInvoke<Storage, RT, Args...>,
+		&Storage::destroy,
+		&Storage::moveConstruct,
+		doGetCopyConstruct<Storage, T>()
+	};
+	return &operations;
+}
+
+template <typename T>
+auto isNullCallable(const T & f)
+	-> typename std::enable_if<std::is_pointer<T>::value || std::is_member_pointer<T>::value, bool>::type
+{
+	return f == nullptr;
+}
+
+template <typename T>
+auto isNullCallable(const T & /*f*/)
+	-> typename std::enable_if<! (std::is_pointer<T>::value || std::is_member_pointer<T>::value), bool>::type
+{
+	return false;
+}
+
+} //namespace inlinefunction_internal_
+
+constexpr std::size_t defaultInlineFunctionCapacity = sizeof(void *) * 4;
+
+template <
+	typename Prototype,
+	std::size_t Capacity = defaultInlineFunctionCapacity,
+	bool AllowHeap = false
+>
+class InlineFunction;
+
+template <
+	std::size_t Capacity,
+	bool AllowHeap,
+	typename RT, typename ...Args
+>
+class InlineFunction <RT (Args...), Capacity, AllowHeap>
+{
+private:
+	using Operations = inlinefunction_internal_::InlineFunctionOperations<RT, Args...>;
+
+	template <typename T>
+	struct FitsInline
+	{
+		static constexpr bool value = sizeof(T) <= Capacity
+			&& alignof(T) <= alignof(std::max_align_t)
+			&& std::is_nothrow_move_constructible<T>::value
+		;
+	};
+
+	template <typename T>
+	using SelectStorage = typename std::conditional<
+		FitsInline<T>::value,
+		inlinefunction_internal_::InlineStorage<T>,
+		inlinefunction_internal_::HeapStorage<T>
+	>::type;
+
+	template <typename F>
+	using EnableIfCallable = typename std::enable_if<
+		! std::is_same<typename inlinefunction_internal_::RemoveCvRef<F>::Type, InlineFunction>::value
+		&& ! std::is_same<typename inlinefunction_internal_::RemoveCvRef<F>::Type, std::nullptr_t>::value
+		&& inlinefunction_internal_::IsInvocable<typename std::decay<F>::type, RT, Args...>::value
+	>::type;
+
+	static_assert(Capacity >= sizeof(void *), "InlineFunction: Capacity must be at least the size of a pointer.");
+
+public:
+	InlineFunction() noexcept
+		: operations(nullptr), buffer()
+	{
+	}
+
+	InlineFunction(std::nullptr_t) noexcept
+		: InlineFunction()
+	{
+	}
+
+	template <typename F, typename = EnableIfCallable<F> >
+	InlineFunction(F && f)
+		: InlineFunction()
+	{
+		doConstruct(std::forward<F>(f));
+	}
+
+	InlineFunction(const InlineFunction & other)
+		: InlineFunction()
+	{
+		doCopyFrom(other);
+	}
+
+	InlineFunction(InlineFunction && other) noexcept
+		: InlineFunction()
+	{
+		doMoveFrom(other);
+	}
+
+	~InlineFunction() {
+		reset();
+	}
+
+	InlineFunction & operator = (const InlineFunction & other) {
+		if(this != &other) {
+			InlineFunction copied(other);
+			reset();
+			doMoveFrom(copied);
+		}
+		return *this;
+	}
+
+	InlineFunction & operator = (InlineFunction && other) noexcept {
+		if(this != &other) {
+			reset();
+			doMoveFrom(other);
+		}
+		return *this;
+	}
+
+	InlineFunction & operator = (std::nullptr_t) noexcept {
+		reset();
+		return *this;
+	}
+
+	template <typename F, typename = EnableIfCallable<F> >
+	InlineFunction & operator = (F && f) {
+		InlineFunction temp(std::forward<F>(f));
+		reset();
+		doMoveFrom(temp);
+		return *this;
+	}
+
+	void swap(InlineFunction & other) noexcept {
+		InlineFunction temp(std::move(other));
+		other = std::move(*this);
+		*this = std::move(temp);
+	}
+
+	explicit operator bool() const noexcept {
+		return operations != nullptr;
+	}
+
+	RT operator() (Args ...args) const {
+		assert(operations != nullptr);
+		return operations->invoke(const_cast<void *>(static_cast<const void *>(&buffer)), std::forward<Args>(args)...);
+	}
+
+	void reset() noexcept {
+		if(operations != nullptr) {
+			operations->destroy(&buffer);
+			operations = nullptr;
+		}
+	}
+
+private:
+	template <typename F>
+	void doConstruct(F && f) {
+		using T = typename std::decay<F>::type;
+		using Storage = SelectStorage<T>;
+
+		static_assert(AllowHeap || FitsInline<T>::value,
+			"InlineFunction: the callable is too large or its move constructor may throw, increase Capacity or set AllowHeap to true.");
+
+		if(inlinefunction_internal_::isNullCallable<T>(f)) {
+			return;
+		}
+		Storage::construct(&buffer, std::forward<F>(f));
+		operations = inlinefunction_internal_::getInlineFunctionOperations<Storage, T, RT, Args...>();
+	}
+
+	void doCopyFrom(const InlineFunction & other) {
+		if(other.operations != nullptr) {
+			// Don't silently produce an empty function, the copy would lose the callable.
+			if(other.operations->copyConstruct == nullptr) {
+				throw std::logic_error("InlineFunction: can't copy a move only callable.");
+			}
+			other.operations->copyConstruct(&other.buffer, &buffer);
+			operations = other.operations;
+		}
+	}
+
+	void doMoveFrom(InlineFunction & other) noexcept {
+		if(other.operations != nullptr) {
+			other.operations->moveConstruct(&other.buffer, &buffer);
+			operations = other.operations;
+			other.reset();
+		}
+	}
+
+private:
+	const Operations * operations;
+	typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type buffer;
+};
+
+template <typename Prototype, std::size_t Capacity, bool AllowHeap>
+void swap(InlineFunction<Prototype, Capacity, AllowHeap> & first, InlineFunction<Prototype, Capacity, AllowHeap> & second) noexcept
+{
+	first.swap(second);
+}
+
+template <typename Prototype, std::size_t Capacity, bool AllowHeap>
+bool operator == (const InlineFunction<Prototype, Capacity, AllowHeap> & f, std::nullptr_t) noexcept
+{
+	return ! f;
+}
+
+template <typename Prototype, std::size_t Capacity, bool AllowHeap>
+bool operator == (std::nullptr_t, const InlineFunction<Prototype, Capacity, AllowHeap> & f) noexcept
+{
+	return ! f;
+}
+
+template <typename Prototype, std::size_t Capacity, bool AllowHeap>
+bool operator != (const InlineFunction<Prototype, Capacity, AllowHeap> & f, std::nullptr_t) noexcept
+{
+	return !! f;
+}
+
+template <typename Prototype, std::size_t Capacity, bool AllowHeap>
+bool operator != (std::nullptr_t, const InlineFunction<Prototype, Capacity, AllowHeap> & f) noexcept
+{
+	return !! f;
+}
+
+
+} //namespace eventpp
+
+#endif
+
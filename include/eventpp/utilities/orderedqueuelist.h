@@ -16,7 +16,11 @@
 
 #include "../eventpolicies.h"
 
-#include <list>
+#include <iterator>
+#include <utility>
+#include <new>
+#include <cstddef>
+#include <cstdint>
 
 namespace eventpp {
 
@@ -28,50 +32,354 @@ struct OrderedQueueListCompare
 	}
 };
 
+// A skip list which keeps the items sorted by Compare.
+// Inserting an item is O(log n), taking the front item is O(1), and the items
+// are iterated in order. The equal items keep the inserting order.
+// The empty items (the recycled items in the free list of EventQueue) are put
+// at the front, their order doesn't matter.
 template <typename T, typename Compare = OrderedQueueListCompare>
-class OrderedQueueList : private std::list<T>
+class OrderedQueueList
 {
 private:
-	using super = std::list<T>;
+	enum { maxLevel = 16 };
+
+	struct NodeBase
+	{
+		// previousList[i] and nextList[i] are the links at level i.
+		NodeBase ** previousList;
+		NodeBase ** nextList;
+		unsigned int level;
+	};
+
+	struct Node : NodeBase
+	{
+		template <typename ...A>
+		explicit Node(A && ...args) : NodeBase(), value(std::forward<A>(args)...) {
+		}
+
+		T value;
+	};
+
+	template <typename V, typename N>
+	class Iterator
+	{
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = V *;
+		using reference = V &;
+
+	public:
+		Iterator() : node(nullptr) {
+		}
+
+		explicit Iterator(N * node) : node(node) {
+		}
+
+		// iterator can convert to const_iterator.
+		template <typename V2, typename N2>
+		Iterator(const Iterator<V2, N2> & other) : node(other.node) {
+		}
+
+		reference operator * () const {
+			return static_cast<Node *>(const_cast<NodeBase *>(node))->value;
+		}
+
+		pointer operator -> () const {
+			return &**this;
+		}
+
+		Iterator & operator ++ () {
+			node = node->nextList[0];
+			return *this;
+		}
+
+		Iterator operator ++ (int) {
+			Iterator result(*this);
+			node = node->nextList[0];
+			return result;
+		}
+
+		Iterator & operator -- () {
+			node = node->previousList[0];
+			return *this;
+		}
+
+		Iterator operator -- (int) {
+			Iterator result(*this);
+			node = node->previousList[0];
+			return result;
+		}
+
+		template <typename V2, typename N2>
+		bool operator == (const Iterator<V2, N2> & other) const {
+			return node == other.node;
+		}
+
+		template <typename V2, typename N2>
+		bool operator != (const Iterator<V2, N2> & other) const {
+			return node != other.node;
+		}
+
+	private:
+		N * node;
+
+		template <typename V2, typename N2>
+		friend class Iterator;
+		friend class OrderedQueueList;
+	};
+
+public:
+	using value_type = T;
+	using reference = T &;
+	using const_reference = const T &;
+	using iterator = Iterator<T, NodeBase>;
+	using const_iterator = Iterator<const T, const NodeBase>;
 
 public:
-	using iterator = typename super::iterator;
-	using const_iterator = typename super::const_iterator;
-	using super::empty;
-	using super::begin;
-	using super::end;
-	using super::front;
-	using super::swap;
-	using super::emplace_back;
+	OrderedQueueList() : head(), headPreviousList(), headNextList() {
+		head.previousList = headPreviousList;
+		head.nextList = headNextList;
+		head.level = maxLevel;
+		doReset();
+	}
+
+	~OrderedQueueList() {
+		clear();
+	}
+
+	OrderedQueueList(OrderedQueueList && other) noexcept : OrderedQueueList() {
+		doLinkAll(other, false);
+	}
+
+	OrderedQueueList & operator = (OrderedQueueList && other) noexcept {
+		if(this != &other) {
+			clear();
+			doLinkAll(other, false);
+		}
+		return *this;
+	}
+
+	OrderedQueueList(const OrderedQueueList &) = delete;
+	OrderedQueueList & operator = (const OrderedQueueList &) = delete;
+
+	bool empty() const {
+		return head.nextList[0] == &head;
+	}
+
+	iterator begin() {
+		return iterator(head.nextList[0]);
+	}
+
+	const_iterator begin() const {
+		return const_iterator(head.nextList[0]);
+	}
+
+	iterator end() {
+		return iterator(&head);
+	}
+
+	const_iterator end() const {
+		return const_iterator(&head);
+	}
+
+	reference front() {
+		return *begin();
+	}
+
+	const_reference front() const {
+		return *begin();
+	}
+
+	void swap(OrderedQueueList & other) noexcept {
+		OrderedQueueList temp(std::move(other));
+		other.doLinkAll(*this, false);
+		doLinkAll(temp, false);
+	}
+
+	// The item is put in order, not at the back.
+	template <typename ...A>
+	void emplace_back(A && ...args) {
+		doInsert(doCreateNode(std::forward<A>(args)...), false);
+	}
 
+	void clear() {
+		NodeBase * node = head.nextList[0];
+		while(node != &head) {
+			NodeBase * next = node->nextList[0];
+			doDestroyNode(static_cast<Node *>(node));
+			node = next;
+		}
+		doReset();
+	}
+
+	// Move all items in other to this list in order.
+	// If pos is begin(), the items are put before the equal items in this list,
+	// otherwise after the equal items. EventQueue puts the items back to the begin
+	// when they are older than the items in the list.
 	void splice(const_iterator pos, OrderedQueueList & other) {
-		super::splice(pos, other);
-		doSort();
+		if(other.empty()) {
+			return;
+		}
+
+		const bool beforeEqual = (pos == begin());
+		if(empty()
+			|| (beforeEqual && ! doLess(*head.nextList[0], *other.head.previousList[0]))
+			|| (! beforeEqual && ! doLess(*other.head.nextList[0], *head.previousList[0]))
+		) {
+			doLinkAll(other, beforeEqual);
+			return;
+		}
+
+		// Insert from the back when putting before the equal items, so the equal
+		// items in other keep their order.
+		while(! other.empty()) {
+			NodeBase * node = beforeEqual ? other.head.previousList[0] : other.head.nextList[0];
+			doUnlink(node);
+			doInsert(node, beforeEqual);
+		}
 	}
 
-	void splice(const_iterator pos, OrderedQueueList & other, const_iterator it) {
-		super::splice(pos, other, it);
-		doSort();
+	// Move the item it in other to this list in order.
+	void splice(const_iterator pos, OrderedQueueList & /*other*/, const_iterator it) {
+		NodeBase * node = const_cast<NodeBase *>(it.node);
+		const bool beforeEqual = (pos == begin());
+		doUnlink(node);
+		doInsert(node, beforeEqual);
+	}
+
+	friend void swap(OrderedQueueList & a, OrderedQueueList & b) noexcept {
+		a.swap(b);
 	}
 
 private:
-	void doSort() {
-		auto compare = Compare();
-		this->sort([compare](const T & a, const T & b) {
-			// a and b may be empty if they are recycled to free list.
-			if(a.empty()) {
-				if(b.empty()) {
-					return false;
+	void doReset() {
+		for(unsigned int i = 0; i < maxLevel; ++i) {
+			head.previousList[i] = &head;
+			head.nextList[i] = &head;
+		}
+	}
+
+	// a and b may be empty if they are recycled to free list.
+	static bool doLess(const NodeBase & a, const NodeBase & b) {
+		const T & itemA = static_cast<const Node &>(a).value;
+		const T & itemB = static_cast<const Node &>(b).value;
+		if(itemA.empty()) {
+			return ! itemB.empty();
+		}
+		else if(itemB.empty()) {
+			return false;
+		}
+
+		return Compare()(itemA.get(), itemB.get());
+	}
+
+	void doInsert(NodeBase * node, const bool beforeEqual) {
+		NodeBase * previousList[maxLevel];
+
+		if(static_cast<Node *>(node)->value.empty()) {
+			for(unsigned int i = 0; i < node->level; ++i) {
+				previousList[i] = &head;
+			}
+		}
+		else {
+			NodeBase * position = &head;
+			for(unsigned int i = maxLevel; i-- > 0; ) {
+				for(;;) {
+					NodeBase * next = position->nextList[i];
+					if(next == &head) {
+						break;
+					}
+					if(beforeEqual ? ! doLess(*next, *node) : doLess(*node, *next)) {
+						break;
+					}
+					position = next;
 				}
-				return true;
+				previousList[i] = position;
 			}
-			else if(b.empty()) {
-				return false;
+		}
+
+		for(unsigned int i = 0; i < node->level; ++i) {
+			NodeBase * previous = previousList[i];
+			node->previousList[i] = previous;
+			node->nextList[i] = previous->nextList[i];
+			previous->nextList[i]->previousList[i] = node;
+			previous->nextList[i] = node;
+		}
+	}
+
+	static void doUnlink(NodeBase * node) {
+		for(unsigned int i = 0; i < node->level; ++i) {
+			node->previousList[i]->nextList[i] = node->nextList[i];
+			node->nextList[i]->previousList[i] = node->previousList[i];
+		}
+	}
+
+	// Move all items in other to the front or back of this list, without comparing.
+	void doLinkAll(OrderedQueueList & other, const bool toFront) {
+		for(unsigned int i = 0; i < maxLevel; ++i) {
+			if(other.head.nextList[i] == &other.head) {
+				continue;
 			}
 
-			return compare(a.get(), b.get());
-		});
+			NodeBase * first = other.head.nextList[i];
+			NodeBase * last = other.head.previousList[i];
+			NodeBase * previous = toFront ? &head : head.previousList[i];
+			NodeBase * next = previous->nextList[i];
+			first->previousList[i] = previous;
+			last->nextList[i] = next;
+			previous->nextList[i] = first;
+			next->previousList[i] = last;
+		}
+		other.doReset();
 	}
+
+	static unsigned int doGetRandomLevel() {
+		// xorshift32, each level has 1/4 chance to go up.
+		// The seed is per thread because EventQueue creates the nodes in temporary lists.
+		static thread_local std::uint32_t randomSeed = 0x9e3779b9u;
+		randomSeed ^= randomSeed << 13;
+		randomSeed ^= randomSeed >> 17;
+		randomSeed ^= randomSeed << 5;
+
+		unsigned int level = 1;
+		std::uint32_t bits = randomSeed;
+		while((bits & 3) == 0 && level < maxLevel) {
+			++level;
+			bits >>= 2;
+		}
+		return level;
+	}
+
+	template <typename ...A>
+	static Node * doCreateNode(A && ...args) {
+		const unsigned int level = doGetRandomLevel();
+		void * memory = ::operator new(sizeof(Node) + sizeof(NodeBase *) * level * 2);
+		Node * node;
+		try {
+			node = new (memory) Node(std::forward<A>(args)...);
+		}
+		catch(...) {
+			::operator delete(memory);
+			throw;
+		}
+		NodeBase ** linkList = reinterpret_cast<NodeBase **>(static_cast<char *>(memory) + sizeof(Node));
+		node->previousList = linkList;
+		node->nextList = linkList + level;
+		node->level = level;
+		return node;
+	}
+
+	static void doDestroyNode(Node * node) {
+		node->~Node();
+		::operator delete(static_cast<void *>(node));
+	}
+
+private:
+	NodeBase head;
+	NodeBase * headPreviousList[maxLevel];
+	NodeBase * headNextList[maxLevel];
 };
 
 
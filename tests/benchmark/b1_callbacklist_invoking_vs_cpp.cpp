@@ -13,6 +13,10 @@
 
 #include "test.h"
 #include "eventpp/callbacklist.h"
+#include "eventpp/utilities/delegate.h"
+
+#include <thread>
+#include <vector>
 
 #if defined(_MSC_VER)
 #define NON_INLINE __declspec(noinline)
@@ -395,3 +399,152 @@ TEST_CASE("b1, CallbackList invoking vs C++ invoking")
 	}
 }
 
+
+namespace {
+
+template <typename Policies>
+uint64_t doInvokeCallbackList(const int iterateCount, const int callbackCount)
+{
+	eventpp::CallbackList<void (int, int), Policies> callbackList;
+	for(int c = 0; c < callbackCount; ++c) {
+		callbackList.append(&nonInlineGlobalFunction);
+	}
+	return measureElapsedTime([iterateCount, &callbackList]() {
+		for(int i = 0; i < iterateCount; ++i) {
+			callbackList(i, i);
+		}
+	});
+}
+
+} //unnamed namespace
+
+struct B1LinkedListSingleThreadingPolicies {
+	using Threading = eventpp::SingleThreading;
+	using CallbackListStorage = eventpp::CallbackListStorageLinkedList;
+};
+struct B1SlotMapSingleThreadingPolicies {
+	using Threading = eventpp::SingleThreading;
+	using CallbackListStorage = eventpp::CallbackListStorageSlotMap;
+};
+struct B1LinkedListMultiThreadingPolicies {
+	using Threading = eventpp::MultipleThreading;
+	using CallbackListStorage = eventpp::CallbackListStorageLinkedList;
+};
+struct B1SlotMapMultiThreadingPolicies {
+	using Threading = eventpp::MultipleThreading;
+	using CallbackListStorage = eventpp::CallbackListStorageSlotMap;
+};
+struct B1CopyOnWriteMultiThreadingPolicies {
+	using Threading = eventpp::MultipleThreading;
+	using CallbackListStorage = eventpp::CallbackListStorageCopyOnWrite;
+};
+
+namespace {
+
+template <typename Policies>
+uint64_t doInvokeCallbackListConcurrently(const int threadCount, const int iterateCount, const int callbackCount)
+{
+	eventpp::CallbackList<void (int, int), Policies> callbackList;
+	for(int c = 0; c < callbackCount; ++c) {
+		callbackList.append(&nonInlineGlobalFunction);
+	}
+	return measureElapsedTime([threadCount, iterateCount, &callbackList]() {
+		std::vector<std::thread> threadList;
+		for(int t = 0; t < threadCount; ++t) {
+			threadList.emplace_back([iterateCount, &callbackList]() {
+				for(int i = 0; i < iterateCount; ++i) {
+					callbackList(i, i);
+				}
+			});
+		}
+		for(auto & thread : threadList) {
+			thread.join();
+		}
+	});
+}
+
+} //unnamed namespace
+
+TEST_CASE("b1, CallbackList invoking, linked list vs slot map")
+{
+	std::cout << std::endl << "b1, CallbackList invoking, linked list vs slot map" << std::endl;
+
+	constexpr int totalCallCount = 1000 * 1000 * 100;
+
+	for(const int callbackCount : { 10, 50, 500 }) {
+		const int iterateCount = totalCallCount / callbackCount;
+		std::cout << "callbackCount " << callbackCount << ":"
+			<< " single threading " << doInvokeCallbackList<B1LinkedListSingleThreadingPolicies>(iterateCount, callbackCount)
+			<< " " << doInvokeCallbackList<B1SlotMapSingleThreadingPolicies>(iterateCount, callbackCount)
+			<< " multi threading " << doInvokeCallbackList<B1LinkedListMultiThreadingPolicies>(iterateCount, callbackCount)
+			<< " " << doInvokeCallbackList<B1SlotMapMultiThreadingPolicies>(iterateCount, callbackCount)
+			<< std::endl;
+	}
+}
+
+namespace {
+
+template <typename Policies, typename MakeCallback>
+uint64_t doInvokeMemberFunctions(const int iterateCount, const int callbackCount, MakeCallback && makeCallback)
+{
+	eventpp::CallbackList<void (int, int), Policies> callbackList;
+	for(int c = 0; c < callbackCount; ++c) {
+		callbackList.append(makeCallback());
+	}
+	return measureElapsedTime([iterateCount, &callbackList]() {
+		for(int i = 0; i < iterateCount; ++i) {
+			callbackList(i, i);
+		}
+	});
+}
+
+} //unnamed namespace
+
+struct B1DelegateSingleThreadingPolicies {
+	using Threading = eventpp::SingleThreading;
+	using Callback = eventpp::Delegate<void (int, int)>;
+};
+
+TEST_CASE("b1, CallbackList invoking member functions, std::function vs Delegate")
+{
+	std::cout << std::endl << "b1, CallbackList invoking member functions, std::function vs Delegate" << std::endl;
+
+	constexpr int iterateCount = 1000 * 1000 * 10;
+	constexpr int callbackCount = 10;
+
+	using D = eventpp::Delegate<void (int, int)>;
+	FunctionObject funcObject;
+
+	const uint64_t nonVirFunctionTime = doInvokeMemberFunctions<B1LinkedListSingleThreadingPolicies>(iterateCount, callbackCount, [&funcObject]() {
+		return std::bind(&FunctionObject::nonVirFunc, &funcObject, std::placeholders::_1, std::placeholders::_2);
+	});
+	const uint64_t nonVirDelegateTime = doInvokeMemberFunctions<B1DelegateSingleThreadingPolicies>(iterateCount, callbackCount, [&funcObject]() {
+		return D::fromMethod<FunctionObject, &FunctionObject::nonVirFunc>(&funcObject);
+	});
+	std::cout << "funcObject.nonVirFunc: " << nonVirFunctionTime << " " << nonVirDelegateTime << std::endl;
+
+	const uint64_t virFunctionTime = doInvokeMemberFunctions<B1LinkedListSingleThreadingPolicies>(iterateCount, callbackCount, [&funcObject]() {
+		return std::bind(&FunctionObject::nonInlineVirFunc, &funcObject, std::placeholders::_1, std::placeholders::_2);
+	});
+	const uint64_t virDelegateTime = doInvokeMemberFunctions<B1DelegateSingleThreadingPolicies>(iterateCount, callbackCount, [&funcObject]() {
+		return D::fromMethod<FunctionObject, &FunctionObject::nonInlineVirFunc>(&funcObject);
+	});
+	std::cout << "funcObject.nonInlineVirFunc: " << virFunctionTime << " " << virDelegateTime << std::endl;
+}
+
+TEST_CASE("b1, CallbackList concurrent invoking, linked list vs slot map vs copy on write")
+{
+	std::cout << std::endl << "b1, CallbackList concurrent invoking, linked list vs slot map vs copy on write" << std::endl;
+
+	constexpr int totalCallCount = 1000 * 1000 * 20;
+	constexpr int callbackCount = 20;
+
+	for(const int threadCount : { 1, 4, 16 }) {
+		const int iterateCount = totalCallCount / callbackCount / threadCount;
+		std::cout << "threadCount " << threadCount << ":"
+			<< " " << doInvokeCallbackListConcurrently<B1LinkedListMultiThreadingPolicies>(threadCount, iterateCount, callbackCount)
+			<< " " << doInvokeCallbackListConcurrently<B1SlotMapMultiThreadingPolicies>(threadCount, iterateCount, callbackCount)
+			<< " " << doInvokeCallbackListConcurrently<B1CopyOnWriteMultiThreadingPolicies>(threadCount, iterateCount, callbackCount)
+			<< std::endl;
+	}
+}
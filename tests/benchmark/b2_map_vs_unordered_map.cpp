@@ -12,11 +12,15 @@
 // limitations under the License.
 
 #include "test.h"
+#include "eventpp/utilities/densemap.h"
+#include "eventpp/utilities/flathashmap.h"
 
 #include <map>
 #include <unordered_map>
 #include <random>
 #include <string>
+#include <vector>
+#include <cstdint>
 
 namespace {
 
@@ -105,3 +109,92 @@ TEST_CASE("b2, std::map vs std::unordered_map")
 	std::cout << "UnordereMap: insert " << unorderedMapInsertTime << " lookup " << unorderedMapLookupTime << std::endl;
 }
 
+namespace {
+
+template <typename Map>
+void doMeasureSmallIntKeys(const std::string & name, const std::vector<int> & keyList, const int iterateCount)
+{
+	Map map;
+	const int keyCount = (int)keyList.size();
+	const uint64_t insertTime = measureElapsedTime([iterateCount, keyCount, &map, &keyList]() {
+		for(int i = 0; i < iterateCount; ++i) {
+			map[keyList[i % keyCount]] = i;
+		}
+	});
+
+	int found = 0;
+	const uint64_t lookupTime = measureElapsedTime([iterateCount, keyCount, &map, &keyList, &found]() {
+		for(int i = iterateCount - 1; i >= 0; --i) {
+			if(map.find(keyList[i % keyCount]) != map.end()) {
+				++found;
+			}
+		}
+	});
+	std::cout << name << ": insert " << insertTime << " lookup " << lookupTime << " (found " << found << ")" << std::endl;
+}
+
+} //unnamed namespace
+
+TEST_CASE("b2, std::map vs std::unordered_map vs DenseMap, small int keys")
+{
+	std::cout << std::endl << "b2, std::map vs std::unordered_map vs DenseMap, small int keys" << std::endl;
+
+	// Such as an enum with 300 values.
+	constexpr int keyCount = 300;
+	std::vector<int> keyList(keyCount * 16);
+	for(auto & key : keyList) {
+		key = getRandomeInt(keyCount);
+	}
+
+	constexpr int iterateCount = 1000 * 1000 * 10;
+
+	doMeasureSmallIntKeys<std::map<int, int> >("Map", keyList, iterateCount);
+	doMeasureSmallIntKeys<std::unordered_map<int, int> >("UnordereMap", keyList, iterateCount);
+	doMeasureSmallIntKeys<eventpp::DenseMap<int, int> >("DenseMap", keyList, iterateCount);
+	doMeasureSmallIntKeys<eventpp::DenseMap<int, int, keyCount> >("DenseMap, fixed max key", keyList, iterateCount);
+}
+
+namespace {
+
+template <typename Map>
+std::string doMeasureSparseKeys(const std::vector<std::uint64_t> & keyList, const int iterateCount)
+{
+	Map map;
+	const int keyCount = (int)keyList.size();
+	const uint64_t insertTime = measureElapsedTime([keyCount, &map, &keyList]() {
+		for(int i = 0; i < keyCount; ++i) {
+			map[keyList[i]] = i;
+		}
+	});
+
+	int found = 0;
+	const uint64_t lookupTime = measureElapsedTime([iterateCount, keyCount, &map, &keyList, &found]() {
+		for(int i = 0; i < iterateCount; ++i) {
+			// Stride over the keys so consecutive lookups don't hit the same cache lines.
+			if(map.find(keyList[(std::size_t)i * 7919 % keyCount]) != map.end()) {
+				++found;
+			}
+		}
+	});
+	return "insert " + std::to_string(insertTime) + " lookup " + std::to_string(lookupTime)
+		+ " (found " + std::to_string(found) + ")";
+}
+
+} //unnamed namespace
+
+TEST_CASE("b2, std::unordered_map vs FlatHashMap, sparse 64 bit keys")
+{
+	std::cout << std::endl << "b2, std::unordered_map vs FlatHashMap, sparse 64 bit keys" << std::endl;
+
+	constexpr int iterateCount = 1000 * 1000 * 10;
+
+	for(const int keyCount : { 1000, 1000 * 100, 1000 * 1000 }) {
+		std::vector<std::uint64_t> keyList(keyCount);
+		for(auto & key : keyList) {
+			key = ((std::uint64_t)getRandomeInt() << 32) ^ (std::uint64_t)getRandomeInt();
+		}
+		std::cout << "keyCount " << keyCount << ":" << std::endl;
+		std::cout << "UnordereMap: " << doMeasureSparseKeys<std::unordered_map<std::uint64_t, int> >(keyList, iterateCount) << std::endl;
+		std::cout << "FlatHashMap: " << doMeasureSparseKeys<eventpp::FlatHashMap<std::uint64_t, int> >(keyList, iterateCount) << std::endl;
+	}
+}
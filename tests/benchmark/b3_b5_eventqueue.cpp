@@ -13,9 +13,26 @@
 
 #include "test.h"
 #include "eventpp/eventqueue.h"
+#include "eventpp/utilities/chunkedqueuelist.h"
+#include "eventpp/utilities/orderedqueuelist.h"
+#include "eventpp/utilities/indexedqueuelist.h"
 
 #include <thread>
+#include <atomic>
 #include <vector>
+#include <fstream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <iterator>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 
 namespace {
 
@@ -152,58 +169,1058 @@ void doMultiThreadingExecuteEventQueue(
 }
 
 
-} //unnamed namespace
+// The consumer processes during enqueuing, so a bounded queue doesn't block the producers forever.
+template <typename Policies>
+void doMultiProducersExecuteEventQueue(
+		const std::string & message,
+		const size_t enqueueThreadCount,
+		const size_t totalEventCount,
+		const size_t eventCount
+	)
+{
+	using EQ = eventpp::EventQueue<size_t, void (size_t), Policies>;
+	EQ eventQueue;
 
-// To avoid warning "typedef locally defined but not used" in GCC,
-// let's move the policies outside of the test case functions
+	for(size_t i = 0; i < eventCount; ++i) {
+		eventQueue.appendListener(i, [](size_t) { });
+	}
 
-struct B3PoliciesMultiThreading {
-	using Threading = eventpp::MultipleThreading;
-};
-struct B3PoliciesSingleThreading {
-	using Threading = eventpp::SingleThreading;
-};
+	std::atomic<bool> start(false);
+	std::atomic<bool> stop(false);
+	std::vector<std::thread> enqueueThreadList;
+	for(size_t i = 0; i < enqueueThreadCount; ++i) {
+		const size_t count = totalEventCount / enqueueThreadCount;
+		enqueueThreadList.emplace_back([&start, count, &eventQueue, eventCount]() {
+			while(! start.load()) {
+			}
 
-TEST_CASE("b3, EventQueue, one thread")
+			for(size_t i = 0; i < count; ++i) {
+				eventQueue.enqueue(i % eventCount);
+			}
+		});
+	}
+
+	std::thread processThread([&start, &stop, &eventQueue]() {
+		while(! start.load()) {
+		}
+
+		while(! stop.load()) {
+			eventQueue.process();
+		}
+
+		while(eventQueue.process()) {
+		}
+	});
+
+	const uint64_t time = measureElapsedTime([&start, &stop, &enqueueThreadList, &processThread]{
+		start.store(true);
+
+		for(auto & thread : enqueueThreadList) {
+			thread.join();
+		}
+
+		stop.store(true);
+		processThread.join();
+	});
+
+	std::cout
+		<< message
+		<< " enqueueThreadCount: " << enqueueThreadCount
+		<< " totalEventCount: " << totalEventCount
+		<< " eventCount: " << eventCount
+		<< " Time: " << time
+		<< std::endl;
+	;
+}
+
+// Each listener does some work, so the throughput scales with the consumers.
+template <typename Policies>
+void doMultiConsumersExecuteEventQueue(
+		const std::string & message,
+		const size_t enqueueThreadCount,
+		const size_t processThreadCount,
+		const size_t totalEventCount,
+		const size_t eventCount
+	)
 {
-	std::cout << std::endl << "b3, EventQueue, one thread" << std::endl;
+	using EQ = eventpp::EventQueue<size_t, void (size_t), Policies>;
+	EQ eventQueue;
 
-	doExecuteEventQueue<B3PoliciesMultiThreading>("Multi threading", 100, 1000 * 100, 100);
-	doExecuteEventQueue<B3PoliciesMultiThreading>("Multi threading", 1000, 1000 * 100, 100);
-	doExecuteEventQueue<B3PoliciesMultiThreading>("Multi threading", 1000, 1000 * 100, 1000);
+	for(size_t i = 0; i < eventCount; ++i) {
+		eventQueue.appendListener(i, [](size_t) {
+			volatile size_t n = 0;
+			for(size_t k = 0; k < 200; ++k) {
+				n = n + k;
+			}
+		});
+	}
 
-	doExecuteEventQueue<B3PoliciesSingleThreading>("Single threading", 100, 1000 * 100, 100);
-	doExecuteEventQueue<B3PoliciesSingleThreading>("Single threading", 1000, 1000 * 100, 100);
-	doExecuteEventQueue<B3PoliciesSingleThreading>("Single threading", 1000, 1000 * 100, 1000);
+	std::atomic<bool> start(false);
+	std::atomic<bool> stop(false);
+	std::vector<std::thread> enqueueThreadList;
+	std::vector<std::thread> processThreadList;
+	for(size_t i = 0; i < enqueueThreadCount; ++i) {
+		const size_t count = totalEventCount / enqueueThreadCount;
+		enqueueThreadList.emplace_back([&start, count, &eventQueue, eventCount]() {
+			while(! start.load()) {
+			}
+
+			for(size_t i = 0; i < count; ++i) {
+				eventQueue.enqueue(i % eventCount);
+			}
+		});
+	}
+
+	for(size_t i = 0; i < processThreadCount; ++i) {
+		processThreadList.emplace_back([&start, &stop, &eventQueue]() {
+			while(! start.load()) {
+			}
+
+			while(! stop.load()) {
+				eventQueue.process();
+			}
+
+			while(eventQueue.process()) {
+			}
+		});
+	}
+
+	const uint64_t time = measureElapsedTime([&start, &stop, &enqueueThreadList, &processThreadList]{
+		start.store(true);
+
+		for(auto & thread : enqueueThreadList) {
+			thread.join();
+		}
+
+		stop.store(true);
+
+		for(auto & thread : processThreadList) {
+			thread.join();
+		}
+	});
+
+	std::cout
+		<< message
+		<< " enqueueThreadCount: " << enqueueThreadCount
+		<< " processThreadCount: " << processThreadCount
+		<< " totalEventCount: " << totalEventCount
+		<< " eventCount: " << eventCount
+		<< " Time: " << time
+		<< std::endl;
+	;
 }
 
-struct B4PoliciesMultiThreading {
-	using Threading = eventpp::GeneralThreading<std::mutex>;
-};
+// Return the resident memory in KB, or 0 if it's unknown.
+size_t getResidentMemory()
+{
+#if defined(__linux__)
+	std::ifstream file("/proc/self/statm");
+	size_t totalPages = 0;
+	size_t residentPages = 0;
+	if(file >> totalPages >> residentPages) {
+		return residentPages * 4;
+	}
+#endif
+	return 0;
+}
 
-TEST_CASE("b4, EventQueue, multi threads, mutex")
+// Run f in a child process on Linux, so the memory freed by the previous
+// benchmark doesn't hide the memory growth of f.
+template <typename F>
+void runIsolated(F f)
 {
-	std::cout << std::endl << "b4, EventQueue, multi threads, mutex" << std::endl;
+#if defined(__linux__)
+	std::cout.flush();
+	const pid_t pid = fork();
+	if(pid == 0) {
+		f();
+		std::cout.flush();
+		_exit(0);
+	}
+	if(pid > 0) {
+		waitpid(pid, nullptr, 0);
+		return;
+	}
+#endif
+	f();
+}
 
-	doMultiThreadingExecuteEventQueue<B4PoliciesMultiThreading>("Mutex", 1, 1, 1000 * 1000 * 10, 100);
-	doMultiThreadingExecuteEventQueue<B4PoliciesMultiThreading>("Mutex", 1, 3, 1000 * 1000 * 10, 100);
-	doMultiThreadingExecuteEventQueue<B4PoliciesMultiThreading>("Mutex", 2, 2, 1000 * 1000 * 10, 100);
-	doMultiThreadingExecuteEventQueue<B4PoliciesMultiThreading>("Mutex", 4, 4, 1000 * 1000 * 10, 100);
-	doMultiThreadingExecuteEventQueue<B4PoliciesMultiThreading>("Mutex", 16, 16, 1000 * 1000 * 10, 100);
+template <typename Policies>
+void doExecuteEventQueueBurst(
+		const std::string & message,
+		const size_t burstSize,
+		const size_t iterateCount
+	)
+{
+	using EQ = eventpp::EventQueue<size_t, void (size_t), Policies>;
+	const size_t residentBefore = getResidentMemory();
+	size_t residentAfter = 0;
+
+	{
+		EQ eventQueue;
+		size_t sum = 0;
+		eventQueue.appendListener(1, [&sum](size_t n) {
+			sum += n;
+		});
+
+		const uint64_t time = measureElapsedTime([burstSize, iterateCount, &eventQueue]{
+			for(size_t iterate = 0; iterate < iterateCount; ++iterate) {
+				for(size_t i = 0; i < burstSize; ++i) {
+					eventQueue.enqueue(1, i);
+				}
+				eventQueue.process();
+			}
+		});
+		residentAfter = getResidentMemory();
+
+		std::cout
+			<< message
+			<< " burstSize: " << burstSize
+			<< " iterateCount: " << iterateCount
+			<< " Time: " << time
+			<< " RSS growth(KB): " << (residentAfter - residentBefore)
+			<< std::endl;
+		;
+	}
 }
 
-struct B5PoliciesMultiThreading {
-	using Threading = eventpp::GeneralThreading<eventpp::SpinLock>;
-};
+// Each producer enqueues batchSize events at once, with enqueueBulk if useBulk is true,
+// otherwise with enqueue one by one.
+template <typename Policies>
+void doMultiProducersBulkExecuteEventQueue(
+		const std::string & message,
+		const size_t enqueueThreadCount,
+		const size_t totalEventCount,
+		const size_t batchSize,
+		const bool useBulk
+	)
+{
+	using EQ = eventpp::EventQueue<size_t, void (size_t), Policies>;
+	EQ eventQueue;
 
-TEST_CASE("b5, EventQueue, multi threads, spinlock")
+	constexpr size_t eventCount = 100;
+	for(size_t i = 0; i < eventCount; ++i) {
+		eventQueue.appendListener(i, [](size_t) { });
+	}
+
+	std::atomic<bool> start(false);
+	std::atomic<bool> stop(false);
+	std::vector<std::thread> enqueueThreadList;
+	for(size_t i = 0; i < enqueueThreadCount; ++i) {
+		const size_t count = totalEventCount / enqueueThreadCount / batchSize;
+		enqueueThreadList.emplace_back([&start, count, batchSize, useBulk, &eventQueue]() {
+			while(! start.load()) {
+			}
+
+			for(size_t i = 0; i < count; ++i) {
+				if(useBulk) {
+					eventQueue.enqueueBulk([batchSize](typename EQ::BulkEnqueuer & enqueuer) {
+						for(size_t k = 0; k < batchSize; ++k) {
+							enqueuer.enqueue(k % eventCount);
+						}
+					});
+				}
+				else {
+					for(size_t k = 0; k < batchSize; ++k) {
+						eventQueue.enqueue(k % eventCount);
+					}
+				}
+			}
+		});
+	}
+
+	std::thread processThread([&start, &stop, &eventQueue]() {
+		while(! start.load()) {
+		}
+
+		while(! stop.load()) {
+			eventQueue.process();
+		}
+
+		while(eventQueue.process()) {
+		}
+	});
+
+	const uint64_t time = measureElapsedTime([&start, &stop, &enqueueThreadList, &processThread]{
+		start.store(true);
+
+		for(auto & thread : enqueueThreadList) {
+			thread.join();
+		}
+
+		stop.store(true);
+		processThread.join();
+	});
+
+	std::cout
+		<< message
+		<< " enqueueThreadCount: " << enqueueThreadCount
+		<< " totalEventCount: " << totalEventCount
+		<< " batchSize: " << batchSize
+		<< " Time: " << time
+		<< std::endl;
+	;
+}
+
+// The producer enqueues one event and waits until the consumer processes it,
+// so the time is dominated by waking up the consumer.
+template <typename Policies>
+void doHandOffExecuteEventQueue(
+		const std::string & message,
+		const size_t roundCount
+	)
 {
-	std::cout << std::endl << "b5, EventQueue, multi threads, spinlock" << std::endl;
+	using EQ = eventpp::EventQueue<size_t, void (size_t), Policies>;
+	EQ eventQueue;
 
-	doMultiThreadingExecuteEventQueue<B5PoliciesMultiThreading>("Spinlock", 1, 1, 1000 * 1000 * 10, 100);
-	doMultiThreadingExecuteEventQueue<B5PoliciesMultiThreading>("Spinlock", 1, 3, 1000 * 1000 * 10, 100);
-	doMultiThreadingExecuteEventQueue<B5PoliciesMultiThreading>("Spinlock", 2, 2, 1000 * 1000 * 10, 100);
-	doMultiThreadingExecuteEventQueue<B5PoliciesMultiThreading>("Spinlock", 4, 4, 1000 * 1000 * 10, 100);
-	doMultiThreadingExecuteEventQueue<B5PoliciesMultiThreading>("Spinlock", 16, 16, 1000 * 1000 * 10, 100);
+	std::atomic<size_t> processedCount(0);
+	eventQueue.appendListener(0, [&processedCount](size_t) {
+		processedCount.fetch_add(1, std::memory_order_release);
+	});
+
+	std::atomic<bool> stop(false);
+	std::thread processThread([&stop, &eventQueue]() {
+		while(! stop.load()) {
+			eventQueue.waitFor(std::chrono::milliseconds(10));
+			eventQueue.process();
+		}
+	});
+
+	const uint64_t time = measureElapsedTime([roundCount, &processedCount, &eventQueue]{
+		for(size_t i = 0; i < roundCount; ++i) {
+			eventQueue.enqueue(0);
+			while(processedCount.load(std::memory_order_acquire) != i + 1) {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	stop.store(true);
+	processThread.join();
+
+	std::cout
+		<< message
+		<< " roundCount: " << roundCount
+		<< " Time: " << time
+		<< std::endl;
+	;
+}
+
+// Process the queue in frames of frameSize events, with processN or with processOne.
+template <typename Policies>
+void doFrameExecuteEventQueue(
+		const std::string & message,
+		const size_t totalEventCount,
+		const size_t frameSize,
+		const bool useProcessN
+	)
+{
+	using EQ = eventpp::EventQueue<size_t, void (size_t), Policies>;
+	EQ eventQueue;
+
+	constexpr size_t eventCount = 100;
+	for(size_t i = 0; i < eventCount; ++i) {
+		eventQueue.appendListener(i, [](size_t) { });
+	}
+	for(size_t i = 0; i < totalEventCount; ++i) {
+		eventQueue.enqueue(i % eventCount);
+	}
+
+	const uint64_t time = measureElapsedTime([frameSize, useProcessN, &eventQueue]{
+		if(useProcessN) {
+			while(eventQueue.processN(frameSize)) {
+			}
+		}
+		else {
+			for(;;) {
+				size_t count = 0;
+				while(count < frameSize && eventQueue.processOne()) {
+					++count;
+				}
+				if(count == 0) {
+					break;
+				}
+			}
+		}
+	});
+
+	std::cout
+		<< message
+		<< " totalEventCount: " << totalEventCount
+		<< " frameSize: " << frameSize
+		<< " Time: " << time
+		<< std::endl;
+	;
 }
 
+// Each producer enqueues through its own StagingBuffer.
+template <typename Policies>
+void doStagingExecuteEventQueue(
+		const std::string & message,
+		const size_t enqueueThreadCount,
+		const size_t totalEventCount,
+		const size_t publishThreshold
+	)
+{
+	using EQ = eventpp::EventQueue<size_t, void (size_t), Policies>;
+	EQ eventQueue;
+
+	constexpr size_t eventCount = 100;
+	for(size_t i = 0; i < eventCount; ++i) {
+		eventQueue.appendListener(i, [](size_t) { });
+	}
+
+	std::atomic<bool> start(false);
+	std::atomic<bool> stop(false);
+	std::vector<std::thread> enqueueThreadList;
+	for(size_t i = 0; i < enqueueThreadCount; ++i) {
+		const size_t count = totalEventCount / enqueueThreadCount;
+		enqueueThreadList.emplace_back([&start, count, publishThreshold, &eventQueue]() {
+			typename EQ::StagingBuffer stagingBuffer(&eventQueue, publishThreshold);
+
+			while(! start.load()) {
+			}
+
+			for(size_t i = 0; i < count; ++i) {
+				stagingBuffer.enqueue(i % eventCount);
+			}
+		});
+	}
+
+	std::thread processThread([&start, &stop, &eventQueue]() {
+		while(! start.load()) {
+		}
+
+		while(! stop.load()) {
+			eventQueue.process();
+		}
+
+		while(eventQueue.process()) {
+		}
+	});
+
+	const uint64_t time = measureElapsedTime([&start, &stop, &enqueueThreadList, &processThread]{
+		start.store(true);
+
+		for(auto & thread : enqueueThreadList) {
+			thread.join();
+		}
+
+		stop.store(true);
+		processThread.join();
+	});
+
+	std::cout
+		<< message
+		<< " enqueueThreadCount: " << enqueueThreadCount
+		<< " totalEventCount: " << totalEventCount
+		<< " publishThreshold: " << publishThreshold
+		<< " Time: " << time
+		<< std::endl;
+	;
+}
+
+// The previous OrderedQueueList, which sorts the whole list on each splice.
+template <typename T, typename Compare = eventpp::OrderedQueueListCompare>
+class SortOnSpliceQueueList : private std::list<T>
+{
+private:
+	using super = std::list<T>;
+
+public:
+	using iterator = typename super::iterator;
+	using const_iterator = typename super::const_iterator;
+	using super::empty;
+	using super::begin;
+	using super::end;
+	using super::front;
+	using super::swap;
+	using super::emplace_back;
+
+	void splice(const_iterator pos, SortOnSpliceQueueList & other) {
+		super::splice(pos, other);
+		doSort();
+	}
+
+	void splice(const_iterator pos, SortOnSpliceQueueList & other, const_iterator it) {
+		super::splice(pos, other, it);
+		doSort();
+	}
+
+private:
+	void doSort() {
+		auto compare = Compare();
+		this->sort([compare](const T & a, const T & b) {
+			if(a.empty()) {
+				return ! b.empty();
+			}
+			else if(b.empty()) {
+				return false;
+			}
+
+			return compare(a.get(), b.get());
+		});
+	}
+};
+
+// Keep a backlog of backlogSize events, enqueue one event and process one event in each round.
+template <typename Policies>
+void doOrderedExecuteEventQueue(
+		const std::string & message,
+		const size_t backlogSize,
+		const size_t roundCount
+	)
+{
+	using EQ = eventpp::EventQueue<size_t, void (size_t), Policies>;
+	EQ eventQueue;
+
+	constexpr size_t eventCount = 1000;
+	for(size_t i = 0; i < eventCount; ++i) {
+		eventQueue.appendListener(i, [](size_t) {});
+	}
+
+	std::mt19937 engine(1);
+	for(size_t i = 0; i < backlogSize; ++i) {
+		eventQueue.enqueue(engine() % eventCount, i);
+	}
+
+	const uint64_t time = measureElapsedTime([roundCount, &eventQueue, &engine]() {
+		for(size_t i = 0; i < roundCount; ++i) {
+			eventQueue.enqueue(engine() % eventCount, i);
+			eventQueue.processOne();
+		}
+		eventQueue.process();
+	});
+
+	std::cout
+		<< message
+		<< " backlogSize: " << backlogSize
+		<< " roundCount: " << roundCount
+		<< " Time: " << time
+		<< std::endl;
+	;
+}
+
+// Enqueue timerCount delayed events in random delays within maxDelayMs, then cancel half of them.
+void doTimerExecuteEventQueue(
+		const std::string & message,
+		const size_t timerCount,
+		const size_t maxDelayMs
+	)
+{
+	using EQ = eventpp::EventQueue<size_t, void (size_t)>;
+	EQ eventQueue;
+	std::vector<EQ::TimerHandle> handleList;
+	handleList.reserve(timerCount);
+
+	std::mt19937 engine(1);
+	const uint64_t enqueueTime = measureElapsedTime([timerCount, maxDelayMs, &eventQueue, &engine, &handleList]() {
+		for(size_t i = 0; i < timerCount; ++i) {
+			handleList.push_back(eventQueue.enqueueAfter(std::chrono::milliseconds(engine() % maxDelayMs + 1000), 1, i));
+		}
+	});
+	const uint64_t cancelTime = measureElapsedTime([timerCount, &eventQueue, &handleList]() {
+		for(size_t i = 0; i < timerCount; i += 2) {
+			eventQueue.cancelTimer(handleList[i]);
+		}
+	});
+
+	std::cout
+		<< message
+		<< " timerCount: " << timerCount
+		<< " enqueueAfter: " << enqueueTime
+		<< " cancelTimer: " << cancelTime
+		<< std::endl;
+	;
+}
+
+// The same as doTimerExecuteEventQueue, but keep the timers in a std::multimap locked by a mutex.
+void doTimerExecuteMultimap(
+		const std::string & message,
+		const size_t timerCount,
+		const size_t maxDelayMs
+	)
+{
+	using Map = std::multimap<std::chrono::steady_clock::time_point, size_t>;
+	Map timerMap;
+	std::mutex mutex;
+	std::vector<Map::iterator> handleList;
+	handleList.reserve(timerCount);
+
+	std::mt19937 engine(1);
+	const uint64_t enqueueTime = measureElapsedTime([timerCount, maxDelayMs, &timerMap, &mutex, &engine, &handleList]() {
+		for(size_t i = 0; i < timerCount; ++i) {
+			const auto timePoint = std::chrono::steady_clock::now() + std::chrono::milliseconds(engine() % maxDelayMs + 1000);
+			std::lock_guard<std::mutex> lock(mutex);
+			handleList.push_back(timerMap.emplace(timePoint, i));
+		}
+	});
+	const uint64_t cancelTime = measureElapsedTime([timerCount, &timerMap, &mutex, &handleList]() {
+		for(size_t i = 0; i < timerCount; i += 2) {
+			std::lock_guard<std::mutex> lock(mutex);
+			timerMap.erase(handleList[i]);
+		}
+	});
+
+	std::cout
+		<< message
+		<< " timerCount: " << timerCount
+		<< " enqueueAfter: " << enqueueTime
+		<< " cancelTimer: " << cancelTime
+		<< std::endl;
+	;
+}
+
+// Each round enqueues burstSize updates of keyCount keys, then processes the queue.
+template <typename Policies>
+void doCoalesceExecuteEventQueue(
+		const std::string & message,
+		const size_t keyCount,
+		const size_t burstSize,
+		const size_t roundCount
+	)
+{
+	using EQ = eventpp::EventQueue<size_t, void (size_t), Policies>;
+	EQ eventQueue;
+
+	size_t dispatchCount = 0;
+	for(size_t i = 0; i < keyCount; ++i) {
+		eventQueue.appendListener(i, [&dispatchCount](size_t) {
+			++dispatchCount;
+		});
+	}
+
+	std::mt19937 engine(1);
+	const uint64_t time = measureElapsedTime([keyCount, burstSize, roundCount, &eventQueue, &engine]() {
+		for(size_t round = 0; round < roundCount; ++round) {
+			for(size_t i = 0; i < burstSize; ++i) {
+				eventQueue.enqueue(engine() % keyCount, i);
+			}
+			eventQueue.process();
+		}
+	});
+
+	std::cout
+		<< message
+		<< " keyCount: " << keyCount
+		<< " burstSize: " << burstSize
+		<< " roundCount: " << roundCount
+		<< " dispatchCount: " << dispatchCount
+		<< " Time: " << time
+		<< std::endl;
+	;
+}
+
+template <typename Policies>
+void doBoundedExecuteEventQueue(
+		const std::string & message,
+		const size_t itemCount,
+		const size_t workCount
+	)
+{
+	using EQ = eventpp::EventQueue<size_t, void (size_t), Policies>;
+	EQ eventQueue;
+
+	// The listener is slower than the producer.
+	size_t dispatchCount = 0;
+	volatile size_t workResult = 0;
+	eventQueue.appendListener(1, [&dispatchCount, &workResult, workCount](const size_t value) {
+		++dispatchCount;
+		for(size_t i = 0; i < workCount; ++i) {
+			workResult = workResult + value * i;
+		}
+	});
+
+	const uint64_t time = measureElapsedTime([itemCount, &eventQueue]() {
+		std::atomic<bool> finished(false);
+		std::thread producer([itemCount, &eventQueue, &finished]() {
+			for(size_t i = 0; i < itemCount; ++i) {
+				eventQueue.enqueue(1, i);
+			}
+			finished = true;
+		});
+		while(! finished || ! eventQueue.emptyQueue()) {
+			eventQueue.waitFor(std::chrono::milliseconds(1));
+			eventQueue.process();
+		}
+		producer.join();
+	});
+
+	std::cout
+		<< message
+		<< " itemCount: " << itemCount
+		<< " dispatchCount: " << dispatchCount
+		<< " dropped: " << eventQueue.getDroppedEventCount()
+		<< " blocked: " << eventQueue.getBlockedEnqueueCount()
+		<< " Time: " << time
+		<< std::endl;
+	;
+}
+
+template <typename Policies>
+void doProcessEventExecuteEventQueue(
+		const std::string & message,
+		const size_t queueSize,
+		const size_t matchedCount,
+		const size_t roundCount
+	)
+{
+	using EQ = eventpp::EventQueue<size_t, void (size_t), Policies>;
+	EQ eventQueue;
+
+	// Event 0 is the selected event, the others stay in the queue.
+	constexpr size_t eventCount = 100;
+	size_t dispatchCount = 0;
+	for(size_t i = 0; i < eventCount; ++i) {
+		eventQueue.appendListener(i, [&dispatchCount](size_t) {
+			++dispatchCount;
+		});
+	}
+	for(size_t i = 0; i < queueSize; ++i) {
+		eventQueue.enqueue(i % (eventCount - 1) + 1, i);
+	}
+
+	const uint64_t time = measureElapsedTime([matchedCount, roundCount, &eventQueue]() {
+		for(size_t round = 0; round < roundCount; ++round) {
+			for(size_t i = 0; i < matchedCount; ++i) {
+				eventQueue.enqueue(0, i);
+			}
+			eventQueue.processEvent(0);
+		}
+	});
+
+	std::cout
+		<< message
+		<< " queueSize: " << queueSize
+		<< " matchedCount: " << matchedCount
+		<< " roundCount: " << roundCount
+		<< " dispatchCount: " << dispatchCount
+		<< " Time: " << time
+		<< std::endl;
+	;
+}
+
+template <typename Policies>
+void doTakeEventsExecuteEventQueue(
+		const std::string & message,
+		const size_t batchSize,
+		const size_t queueSize,
+		const size_t roundCount
+	)
+{
+	using EQ = eventpp::EventQueue<size_t, void (size_t), Policies>;
+	EQ eventQueue;
+
+	std::vector<typename EQ::QueuedEvent> eventList(batchSize);
+	size_t takenCount = 0;
+	const uint64_t time = measureElapsedTime([batchSize, queueSize, roundCount, &eventQueue, &eventList, &takenCount]() {
+		for(size_t round = 0; round < roundCount; ++round) {
+			for(size_t i = 0; i < queueSize; ++i) {
+				eventQueue.enqueue(i, i);
+			}
+			if(batchSize == 1) {
+				while(eventQueue.takeEvent(&eventList[0])) {
+					++takenCount;
+				}
+			}
+			else {
+				size_t count;
+				while((count = eventQueue.takeEvents(eventList.begin(), batchSize)) > 0) {
+					takenCount += count;
+				}
+			}
+		}
+	});
+
+	std::cout
+		<< message
+		<< " batchSize: " << batchSize
+		<< " queueSize: " << queueSize
+		<< " roundCount: " << roundCount
+		<< " takenCount: " << takenCount
+		<< " Time: " << time
+		<< std::endl;
+	;
+}
+
+struct B3Payload
+{
+	char data[200];
+};
+
+template <bool fillInPlace>
+void doEnqueueWithExecuteEventQueue(
+		const std::string & message,
+		const size_t queueSize,
+		const size_t roundCount
+	)
+{
+	using EQ = eventpp::EventQueue<size_t, void (const B3Payload &, const std::string &)>;
+	EQ eventQueue;
+
+	size_t dataSum = 0;
+	eventQueue.appendListener(1, [&dataSum](const B3Payload & payload, const std::string & s) {
+		dataSum += static_cast<size_t>(payload.data[0]) + s.size();
+	});
+
+	B3Payload payload;
+	std::fill(std::begin(payload.data), std::end(payload.data), 1);
+	const std::string text(40, 'a');
+
+	const uint64_t time = measureElapsedTime([queueSize, roundCount, &eventQueue, &payload, &text]() {
+		for(size_t round = 0; round < roundCount; ++round) {
+			for(size_t i = 0; i < queueSize; ++i) {
+				if(fillInPlace) {
+					eventQueue.enqueueWith(1, [&payload, &text](B3Payload & p, std::string & s) {
+						p = payload;
+						s = text;
+					});
+				}
+				else {
+					eventQueue.enqueue(1, payload, text);
+				}
+			}
+			eventQueue.process();
+		}
+	});
+
+	std::cout
+		<< message
+		<< " queueSize: " << queueSize
+		<< " roundCount: " << roundCount
+		<< " dataSum: " << dataSum
+		<< " Time: " << time
+		<< std::endl;
+	;
+}
+
+} //unnamed namespace
+
+// To avoid warning "typedef locally defined but not used" in GCC,
+// let's move the policies outside of the test case functions
+
+struct B3PoliciesMultiThreading {
+	using Threading = eventpp::MultipleThreading;
+};
+struct B3PoliciesSingleThreading {
+	using Threading = eventpp::SingleThreading;
+};
+
+TEST_CASE("b3, EventQueue, one thread")
+{
+	std::cout << std::endl << "b3, EventQueue, one thread" << std::endl;
+
+	doExecuteEventQueue<B3PoliciesMultiThreading>("Multi threading", 100, 1000 * 100, 100);
+	doExecuteEventQueue<B3PoliciesMultiThreading>("Multi threading", 1000, 1000 * 100, 100);
+	doExecuteEventQueue<B3PoliciesMultiThreading>("Multi threading", 1000, 1000 * 100, 1000);
+
+	doExecuteEventQueue<B3PoliciesSingleThreading>("Single threading", 100, 1000 * 100, 100);
+	doExecuteEventQueue<B3PoliciesSingleThreading>("Single threading", 1000, 1000 * 100, 100);
+	doExecuteEventQueue<B3PoliciesSingleThreading>("Single threading", 1000, 1000 * 100, 1000);
+}
+
+struct B4PoliciesMultiThreading {
+	using Threading = eventpp::GeneralThreading<std::mutex>;
+};
+
+TEST_CASE("b4, EventQueue, multi threads, mutex")
+{
+	std::cout << std::endl << "b4, EventQueue, multi threads, mutex" << std::endl;
+
+	doMultiThreadingExecuteEventQueue<B4PoliciesMultiThreading>("Mutex", 1, 1, 1000 * 1000 * 10, 100);
+	doMultiThreadingExecuteEventQueue<B4PoliciesMultiThreading>("Mutex", 1, 3, 1000 * 1000 * 10, 100);
+	doMultiThreadingExecuteEventQueue<B4PoliciesMultiThreading>("Mutex", 2, 2, 1000 * 1000 * 10, 100);
+	doMultiThreadingExecuteEventQueue<B4PoliciesMultiThreading>("Mutex", 4, 4, 1000 * 1000 * 10, 100);
+	doMultiThreadingExecuteEventQueue<B4PoliciesMultiThreading>("Mutex", 16, 16, 1000 * 1000 * 10, 100);
+}
+
+struct B5PoliciesMultiThreading {
+	using Threading = eventpp::GeneralThreading<eventpp::SpinLock>;
+};
+
+TEST_CASE("b5, EventQueue, multi threads, spinlock")
+{
+	std::cout << std::endl << "b5, EventQueue, multi threads, spinlock" << std::endl;
+
+	doMultiThreadingExecuteEventQueue<B5PoliciesMultiThreading>("Spinlock", 1, 1, 1000 * 1000 * 10, 100);
+	doMultiThreadingExecuteEventQueue<B5PoliciesMultiThreading>("Spinlock", 1, 3, 1000 * 1000 * 10, 100);
+	doMultiThreadingExecuteEventQueue<B5PoliciesMultiThreading>("Spinlock", 2, 2, 1000 * 1000 * 10, 100);
+	doMultiThreadingExecuteEventQueue<B5PoliciesMultiThreading>("Spinlock", 4, 4, 1000 * 1000 * 10, 100);
+	doMultiThreadingExecuteEventQueue<B5PoliciesMultiThreading>("Spinlock", 16, 16, 1000 * 1000 * 10, 100);
+}
+
+struct B3RingPolicies {
+	using EventQueueStorage = eventpp::EventQueueStorageRingBuffer<1024 * 16>;
+};
+
+TEST_CASE("b3, EventQueue, multi producers one consumer, list vs ring buffer")
+{
+	std::cout << std::endl << "b3, EventQueue, multi producers one consumer, list vs ring buffer" << std::endl;
+
+	doMultiProducersExecuteEventQueue<B3PoliciesMultiThreading>("List", 4, 1000 * 1000 * 10, 100);
+	doMultiProducersExecuteEventQueue<B3RingPolicies>("Ring buffer", 4, 1000 * 1000 * 10, 100);
+	doMultiProducersExecuteEventQueue<B3PoliciesMultiThreading>("List", 32, 1000 * 1000 * 10, 100);
+	doMultiProducersExecuteEventQueue<B3RingPolicies>("Ring buffer", 32, 1000 * 1000 * 10, 100);
+}
+
+struct B3RingMultipleConsumersPolicies {
+	using EventQueueStorage = eventpp::EventQueueStorageRingBuffer<1024 * 16, eventpp::QueueFullBlock, eventpp::QueueMultipleConsumers>;
+};
+
+TEST_CASE("b3, EventQueue, multiple consumers, ring buffer")
+{
+	std::cout << std::endl << "b3, EventQueue, multiple consumers, ring buffer" << std::endl;
+
+	doMultiConsumersExecuteEventQueue<B3PoliciesMultiThreading>("List", 4, 1, 1000 * 1000 * 2, 100);
+	doMultiConsumersExecuteEventQueue<B3PoliciesMultiThreading>("List", 4, 4, 1000 * 1000 * 2, 100);
+	doMultiConsumersExecuteEventQueue<B3RingMultipleConsumersPolicies>("Ring buffer", 4, 1, 1000 * 1000 * 2, 100);
+	doMultiConsumersExecuteEventQueue<B3RingMultipleConsumersPolicies>("Ring buffer", 4, 2, 1000 * 1000 * 2, 100);
+	doMultiConsumersExecuteEventQueue<B3RingMultipleConsumersPolicies>("Ring buffer", 4, 4, 1000 * 1000 * 2, 100);
+	doMultiConsumersExecuteEventQueue<B3RingMultipleConsumersPolicies>("Ring buffer", 4, 8, 1000 * 1000 * 2, 100);
+}
+
+struct B3ChunkedQueueListPolicies {
+	template <typename Item>
+	using QueueList = eventpp::ChunkedQueueList<Item>;
+};
+
+TEST_CASE("b3, EventQueue, bursts, std::list vs ChunkedQueueList")
+{
+	std::cout << std::endl << "b3, EventQueue, bursts, std::list vs ChunkedQueueList" << std::endl;
+
+	runIsolated([]() {
+		doExecuteEventQueueBurst<B3PoliciesMultiThreading>("std::list", 1000 * 1000, 10);
+	});
+	runIsolated([]() {
+		doExecuteEventQueueBurst<B3ChunkedQueueListPolicies>("ChunkedQueueList", 1000 * 1000, 10);
+	});
+}
+
+TEST_CASE("b3, EventQueue, multi producers, enqueue vs enqueueBulk")
+{
+	std::cout << std::endl << "b3, EventQueue, multi producers, enqueue vs enqueueBulk" << std::endl;
+
+	doMultiProducersBulkExecuteEventQueue<B3PoliciesMultiThreading>("enqueue", 4, 1000 * 1000 * 10, 16, false);
+	doMultiProducersBulkExecuteEventQueue<B3PoliciesMultiThreading>("enqueueBulk", 4, 1000 * 1000 * 10, 16, true);
+	doMultiProducersBulkExecuteEventQueue<B3PoliciesMultiThreading>("enqueue", 4, 1000 * 1000 * 10, 256, false);
+	doMultiProducersBulkExecuteEventQueue<B3PoliciesMultiThreading>("enqueueBulk", 4, 1000 * 1000 * 10, 256, true);
+	doMultiProducersBulkExecuteEventQueue<B3RingPolicies>("Ring buffer, enqueue", 4, 1000 * 1000 * 10, 256, false);
+	doMultiProducersBulkExecuteEventQueue<B3RingPolicies>("Ring buffer, enqueueBulk", 4, 1000 * 1000 * 10, 256, true);
+}
+
+struct B3SpinThenParkPolicies {
+	using QueueWait = eventpp::QueueWaitSpinThenPark<>;
+};
+
+TEST_CASE("b3, EventQueue, hand-off, QueueWaitBlock vs QueueWaitSpinThenPark")
+{
+	std::cout << std::endl << "b3, EventQueue, hand-off, QueueWaitBlock vs QueueWaitSpinThenPark" << std::endl;
+
+	doHandOffExecuteEventQueue<B3PoliciesMultiThreading>("QueueWaitBlock", 1000 * 100);
+	doHandOffExecuteEventQueue<B3SpinThenParkPolicies>("QueueWaitSpinThenPark", 1000 * 100);
+}
+
+TEST_CASE("b3, EventQueue, frames, processOne vs processN")
+{
+	std::cout << std::endl << "b3, EventQueue, frames, processOne vs processN" << std::endl;
+
+	doFrameExecuteEventQueue<B3PoliciesMultiThreading>("processOne", 1000 * 1000 * 5, 100, false);
+	doFrameExecuteEventQueue<B3PoliciesMultiThreading>("processN", 1000 * 1000 * 5, 100, true);
+	doFrameExecuteEventQueue<B3PoliciesMultiThreading>("processOne", 1000 * 1000 * 5, 1000, false);
+	doFrameExecuteEventQueue<B3PoliciesMultiThreading>("processN", 1000 * 1000 * 5, 1000, true);
+}
+
+TEST_CASE("b3, EventQueue, multi producers, enqueue vs StagingBuffer")
+{
+	std::cout << std::endl << "b3, EventQueue, multi producers, enqueue vs StagingBuffer" << std::endl;
+
+	doMultiProducersExecuteEventQueue<B3PoliciesMultiThreading>("enqueue", 4, 1000 * 1000 * 10, 100);
+	doStagingExecuteEventQueue<B3PoliciesMultiThreading>("StagingBuffer", 4, 1000 * 1000 * 10, 64);
+	doStagingExecuteEventQueue<B3PoliciesMultiThreading>("StagingBuffer", 4, 1000 * 1000 * 10, 1024);
+}
+
+struct B3SortOnSpliceQueueListPolicies {
+	template <typename Item>
+	using QueueList = SortOnSpliceQueueList<Item>;
+};
+struct B3OrderedQueueListPolicies {
+	template <typename Item>
+	using QueueList = eventpp::OrderedQueueList<Item>;
+};
+
+TEST_CASE("b3, EventQueue, ordered, sort on splice vs OrderedQueueList")
+{
+	std::cout << std::endl << "b3, EventQueue, ordered, sort on splice vs OrderedQueueList" << std::endl;
+
+	doOrderedExecuteEventQueue<B3SortOnSpliceQueueListPolicies>("Sort on splice", 1000, 1000 * 10);
+	doOrderedExecuteEventQueue<B3OrderedQueueListPolicies>("OrderedQueueList", 1000, 1000 * 10);
+	doOrderedExecuteEventQueue<B3OrderedQueueListPolicies>("OrderedQueueList", 1000 * 50, 1000 * 1000);
+	doOrderedExecuteEventQueue<B3PoliciesMultiThreading>("Unordered std::list", 1000 * 50, 1000 * 1000);
+}
+
+TEST_CASE("b3, EventQueue, delayed events, timing wheel vs std::multimap")
+{
+	std::cout << std::endl << "b3, EventQueue, delayed events, timing wheel vs std::multimap" << std::endl;
+
+	doTimerExecuteMultimap("std::multimap", 1000 * 1000 * 2, 1000 * 60);
+	doTimerExecuteEventQueue("Timing wheel", 1000 * 1000 * 2, 1000 * 60);
+}
+
+struct B3CoalescePolicies {
+	using QueueCoalesce = eventpp::QueueCoalesceLastValue;
+};
+
+TEST_CASE("b3, EventQueue, bursty updates, plain vs QueueCoalesceLastValue")
+{
+	std::cout << std::endl << "b3, EventQueue, bursty updates, plain vs QueueCoalesceLastValue" << std::endl;
+
+	doCoalesceExecuteEventQueue<B3PoliciesMultiThreading>("Plain", 100, 1000 * 10, 1000);
+	doCoalesceExecuteEventQueue<B3CoalescePolicies>("QueueCoalesceLastValue", 100, 1000 * 10, 1000);
+	doCoalesceExecuteEventQueue<B3PoliciesMultiThreading>("Plain", 1000 * 10, 1000 * 10, 1000);
+	doCoalesceExecuteEventQueue<B3CoalescePolicies>("QueueCoalesceLastValue", 1000 * 10, 1000 * 10, 1000);
+}
+
+struct B3BoundedBlockPolicies {
+	using QueueCapacity = eventpp::QueueBounded<1024, eventpp::QueueFullBlock>;
+};
+
+struct B3BoundedDropOldestPolicies {
+	using QueueCapacity = eventpp::QueueBounded<1024, eventpp::QueueFullDropOldest>;
+};
+
+TEST_CASE("b3, EventQueue, slow consumer, unbounded vs QueueBounded")
+{
+	std::cout << std::endl << "b3, EventQueue, slow consumer, unbounded vs QueueBounded" << std::endl;
+
+	doBoundedExecuteEventQueue<B3PoliciesMultiThreading>("Unbounded", 1000 * 1000, 100);
+	doBoundedExecuteEventQueue<B3BoundedBlockPolicies>("QueueFullBlock", 1000 * 1000, 100);
+	doBoundedExecuteEventQueue<B3BoundedDropOldestPolicies>("QueueFullDropOldest", 1000 * 1000, 100);
+}
+
+struct B3IndexedPolicies {
+	template <typename Item>
+	using QueueList = eventpp::IndexedQueueList<Item>;
+};
+
+TEST_CASE("b3, EventQueue, processEvent, std::list vs IndexedQueueList")
+{
+	std::cout << std::endl << "b3, EventQueue, processEvent, std::list vs IndexedQueueList" << std::endl;
+
+	doProcessEventExecuteEventQueue<B3PoliciesMultiThreading>("std::list", 1000 * 100, 10, 1000);
+	doProcessEventExecuteEventQueue<B3IndexedPolicies>("IndexedQueueList", 1000 * 100, 10, 1000);
+	doExecuteEventQueue<B3IndexedPolicies>("IndexedQueueList, process", 100, 1000 * 100, 100);
+	doExecuteEventQueue<B3PoliciesMultiThreading>("std::list, process", 100, 1000 * 100, 100);
+}
+
+TEST_CASE("b3, EventQueue, takeEvent vs takeEvents")
+{
+	doTakeEventsExecuteEventQueue<B3PoliciesMultiThreading>("takeEvent", 1, 1000 * 10, 100);
+	doTakeEventsExecuteEventQueue<B3PoliciesMultiThreading>("takeEvents", 64, 1000 * 10, 100);
+	doTakeEventsExecuteEventQueue<B3PoliciesMultiThreading>("takeEvents", 1024, 1000 * 10, 100);
+}
+
+TEST_CASE("b3, EventQueue, 200 bytes payload, enqueue vs enqueueWith")
+{
+	doEnqueueWithExecuteEventQueue<false>("enqueue", 1000 * 10, 100);
+	doEnqueueWithExecuteEventQueue<true>("enqueueWith", 1000 * 10, 100);
+}
@@ -14,15 +14,16 @@
 #include "test.h"
 #include "eventpp/callbacklist.h"
 
-TEST_CASE("b6, CallbackList add/remove callbacks")
-{
-	std::cout << std::endl << "b6, CallbackList add/remove callbacks" << std::endl;
+namespace {
 
-	using CL = eventpp::CallbackList<void ()>;
+template <typename Policies>
+void doAddRemoveCallbacks(const std::string & message)
+{
+	using CL = eventpp::CallbackList<void (), Policies>;
 	constexpr size_t callbackCount = 1000;
 	constexpr size_t iterateCount = 1000 * 100;
 	CL callbackList;
-	std::vector<CL::Handle> handleList(callbackCount);
+	std::vector<typename CL::Handle> handleList(callbackCount);
 	const uint64_t time = measureElapsedTime(
 		[callbackCount, iterateCount, &callbackList, &handleList]() {
 		for(size_t iterate = 0; iterate < iterateCount; ++iterate) {
@@ -36,10 +37,32 @@ TEST_CASE("b6, CallbackList add/remove callbacks")
 	});
 
 	std::cout
-		<< "CallbackList add/remove callbacks,"
+		<< message
+		<< " add/remove callbacks,"
 		<< " callbackCount: " << callbackCount
 		<< " iterateCount: " << iterateCount
 		<< " time: " << time
 		<< std::endl;
 }
 
+} //unnamed namespace
+
+struct B6LinkedListPolicies {
+	using CallbackListStorage = eventpp::CallbackListStorageLinkedList;
+};
+struct B6SlotMapPolicies {
+	using CallbackListStorage = eventpp::CallbackListStorageSlotMap;
+};
+struct B6PooledLinkedListPolicies {
+	using CallbackListStorage = eventpp::CallbackListStorageLinkedList;
+	using NodeAllocation = eventpp::NodeAllocationPooled;
+};
+
+TEST_CASE("b6, CallbackList add/remove callbacks")
+{
+	std::cout << std::endl << "b6, CallbackList add/remove callbacks" << std::endl;
+
+	doAddRemoveCallbacks<B6LinkedListPolicies>("Linked list");
+	doAddRemoveCallbacks<B6SlotMapPolicies>("Slot map");
+	doAddRemoveCallbacks<B6PooledLinkedListPolicies>("Linked list, pooled nodes");
+}
@@ -0,0 +1,102 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file is built into its own executable benchmark_allocation,
+// because it replaces the global operator new and operator delete,
+// which would affect all the other benchmarks in the same executable.
+
+#include "test.h"
+#include "eventpp/callbacklist.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Count the global allocations to show the allocations per add/remove cycle.
+std::atomic<std::uint64_t> allocationCount(0);
+
+} //unnamed namespace
+
+void * operator new(std::size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	void * p = std::malloc(size == 0 ? 1 : size);
+	if(p == nullptr) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void * p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void * p, std::size_t /*size*/) noexcept
+{
+	std::free(p);
+}
+
+namespace {
+
+template <typename Policies>
+void doCountAllocations(const std::string & message)
+{
+	using CL = eventpp::CallbackList<void (), Policies>;
+	constexpr size_t callbackCount = 1000;
+	constexpr size_t iterateCount = 1000;
+	CL callbackList;
+	std::vector<typename CL::Handle> handleList(callbackCount);
+	const std::uint64_t previousAllocationCount = allocationCount.load();
+	for(size_t iterate = 0; iterate < iterateCount; ++iterate) {
+		for(size_t i = 0; i < callbackCount; ++i) {
+			handleList[i] = callbackList.append([]() {});
+		}
+		for(size_t i = 0; i < callbackCount; ++i) {
+			callbackList.remove(handleList[i]);
+		}
+	}
+	const double allocationsPerCycle = (double)(allocationCount.load() - previousAllocationCount) / (double)(callbackCount * iterateCount);
+
+	std::cout
+		<< message
+		<< " add/remove callbacks,"
+		<< " callbackCount: " << callbackCount
+		<< " iterateCount: " << iterateCount
+		<< " allocations per add/remove: " << allocationsPerCycle
+		<< std::endl;
+}
+
+} //unnamed namespace
+
+struct B6AllocationLinkedListPolicies {
+	using CallbackListStorage = eventpp::CallbackListStorageLinkedList;
+};
+struct B6AllocationSlotMapPolicies {
+	using CallbackListStorage = eventpp::CallbackListStorageSlotMap;
+};
+struct B6AllocationPooledLinkedListPolicies {
+	using CallbackListStorage = eventpp::CallbackListStorageLinkedList;
+	using NodeAllocation = eventpp::NodeAllocationPooled;
+};
+
+TEST_CASE("b6, CallbackList allocations per add/remove")
+{
+	std::cout << std::endl << "b6, CallbackList allocations per add/remove" << std::endl;
+
+	doCountAllocations<B6AllocationLinkedListPolicies>("Linked list");
+	doCountAllocations<B6AllocationSlotMapPolicies>("Slot map");
+	doCountAllocations<B6AllocationPooledLinkedListPolicies>("Linked list, pooled nodes");
+}
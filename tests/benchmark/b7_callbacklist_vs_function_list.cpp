@@ -13,6 +13,7 @@
 
 #include "test.h"
 #include "eventpp/callbacklist.h"
+#include "eventpp/utilities/inlinefunction.h"
 
 #include <functional>
 #include <vector>
@@ -116,11 +117,16 @@ TEST_CASE("b7, CallbackList vs vector of functions")
 	struct PoliciesSingleThreading {
 		using Threading = eventpp::SingleThreading;
 	};
+	struct PoliciesInlineFunction {
+		using Threading = eventpp::SingleThreading;
+		using Callback = eventpp::InlineFunction<void (int, int)>;
+	};
 	
 	struct BenchmarkItem {
 		std::string message;
 		std::function<void (CLT<PoliciesMultiThreading> &)> addClMulti;
 		std::function<void (CLT<PoliciesSingleThreading> &)> addClSingle;
+		std::function<void (CLT<PoliciesInlineFunction> &)> addClInline;
 		std::function<void (FLT &)> addFl;
 	};
 	std::vector<BenchmarkItem> itemList {
@@ -132,6 +138,9 @@ TEST_CASE("b7, CallbackList vs vector of functions")
 			[](CLT<PoliciesSingleThreading> & cl) {
 				cl.append(&globalFunction);
 			},
+			[](CLT<PoliciesInlineFunction> & cl) {
+				cl.append(&globalFunction);
+			},
 			[](FLT & fl) {
 				fl.push_back(&globalFunction);
 			}
@@ -145,6 +154,9 @@ TEST_CASE("b7, CallbackList vs vector of functions")
 			[](CLT<PoliciesSingleThreading> & cl) {
 				cl.append(&nonInlineGlobalFunction);
 			},
+			[](CLT<PoliciesInlineFunction> & cl) {
+				cl.append(&nonInlineGlobalFunction);
+			},
 			[](FLT & fl) {
 				fl.push_back(&nonInlineGlobalFunction);
 			}
@@ -158,6 +170,9 @@ TEST_CASE("b7, CallbackList vs vector of functions")
 			[](CLT<PoliciesSingleThreading> & cl) {
 				cl.append(FunctionObject());
 			},
+			[](CLT<PoliciesInlineFunction> & cl) {
+				cl.append(FunctionObject());
+			},
 			[](FLT & fl) {
 				fl.push_back(FunctionObject());
 			}
@@ -171,5 +186,8 @@ TEST_CASE("b7, CallbackList vs vector of functions")
 	for(BenchmarkItem & item : itemList) {
 		doCallbackListVsFunctionList<PoliciesMultiThreading>("Multi thread, " + item.message, item.addClMulti, item.addFl);
 	}
+	for(BenchmarkItem & item : itemList) {
+		doCallbackListVsFunctionList<PoliciesInlineFunction>("Single thread, InlineFunction, " + item.message, item.addClInline, item.addFl);
+	}
 	
 }
@@ -0,0 +1,72 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/eventdispatcher.h"
+#include "eventpp/utilities/concurrentmap.h"
+
+#include <thread>
+#include <vector>
+#include <atomic>
+
+struct B9DefaultMapPolicies {
+};
+struct B9ConcurrentMapPolicies {
+	template <typename Key, typename T>
+	using Map = eventpp::ConcurrentMap<Key, T>;
+};
+
+namespace {
+
+template <typename Policies>
+uint64_t doDispatchConcurrently(const int threadCount, const int iterateCount, const int eventCount)
+{
+	eventpp::EventDispatcher<int, void (int), Policies> dispatcher;
+	std::atomic<int> total(0);
+	for(int e = 0; e < eventCount; ++e) {
+		dispatcher.appendListener(e, [&total](const int n) {
+			total.fetch_add(n, std::memory_order_relaxed);
+		});
+	}
+	return measureElapsedTime([threadCount, iterateCount, eventCount, &dispatcher]() {
+		std::vector<std::thread> threadList;
+		for(int t = 0; t < threadCount; ++t) {
+			threadList.emplace_back([t, iterateCount, eventCount, &dispatcher]() {
+				for(int i = 0; i < iterateCount; ++i) {
+					dispatcher.dispatch((i + t) % eventCount, 1);
+				}
+			});
+		}
+		for(auto & thread : threadList) {
+			thread.join();
+		}
+	});
+}
+
+} //unnamed namespace
+
+TEST_CASE("b9, EventDispatcher concurrent dispatching, std::unordered_map vs ConcurrentMap")
+{
+	std::cout << std::endl << "b9, EventDispatcher concurrent dispatching, std::unordered_map vs ConcurrentMap" << std::endl;
+
+	constexpr int totalDispatchCount = 1000 * 1000 * 10;
+	constexpr int eventCount = 100;
+
+	for(const int threadCount : { 1, 2, 4, 8, 16 }) {
+		const int iterateCount = totalDispatchCount / threadCount;
+		std::cout << "threadCount " << threadCount << ":"
+			<< " " << doDispatchConcurrently<B9DefaultMapPolicies>(threadCount, iterateCount, eventCount)
+			<< " " << doDispatchConcurrently<B9ConcurrentMapPolicies>(threadCount, iterateCount, eventCount)
+			<< std::endl;
+	}
+}
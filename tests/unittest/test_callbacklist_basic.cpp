@@ -566,3 +566,81 @@ TEST_CASE("CallbackList, no crash when doFreeNode(head)")
 		REQUIRE(false);
 	}
 }
+
+TEST_CASE("CallbackList, nodes removed during invoking are freed after the invoking")
+{
+	using CL = eventpp::CallbackList<void()>;
+	CL callbackList;
+	std::vector<CL::Handle> handleList;
+	bool stillAlive = true;
+
+	for(int i = 0; i < 5; ++i) {
+		handleList.push_back(callbackList.append([&callbackList, &handleList, &stillAlive]() {
+			for(auto & handle : handleList) {
+				callbackList.remove(handle);
+			}
+			// The removed nodes are still alive since the invoking is using them.
+			for(auto & handle : handleList) {
+				stillAlive = stillAlive && ! handle.expired();
+			}
+		}));
+	}
+
+	callbackList();
+	REQUIRE(stillAlive);
+	REQUIRE(callbackList.empty());
+	REQUIRE(checkAllWeakPtrAreFreed(handleList));
+}
+
+TEST_CASE("CallbackList, pooled nodes")
+{
+	struct Policies {
+		using NodeAllocation = eventpp::NodeAllocationPooled;
+	};
+	using CL = eventpp::CallbackList<void(int &), Policies>;
+	CL callbackList;
+
+	auto handle = callbackList.append([](int & n) {
+		n += 1;
+	});
+	callbackList.append([](int & n) {
+		n += 2;
+	});
+	const void * address = handle.lock().get();
+
+	int n = 0;
+	callbackList(n);
+	REQUIRE(n == 3);
+
+	// The memory is recycled after the node is removed and all handles are gone.
+	REQUIRE(callbackList.remove(handle));
+	handle.reset();
+	handle = callbackList.prepend([](int & n) {
+		n += 5;
+	});
+	REQUIRE(handle.lock().get() == address);
+
+	n = 0;
+	callbackList(n);
+	REQUIRE(n == 7);
+
+	// The node removed during invoking is not recycled until the invoking finishes.
+	CL::Handle removedHandle = handle;
+	const void * addressDuringInvoking = nullptr;
+	callbackList.append([&callbackList, &removedHandle, &addressDuringInvoking](int &) {
+		if(removedHandle) {
+			callbackList.remove(removedHandle);
+			removedHandle.reset();
+			addressDuringInvoking = callbackList.append([](int &) {}).lock().get();
+		}
+	});
+	handle.reset();
+	callbackList(n);
+	REQUIRE(addressDuringInvoking != nullptr);
+	REQUIRE(addressDuringInvoking != address);
+
+	CL copied(callbackList);
+	n = 0;
+	copied(n);
+	REQUIRE(n == 2);
+}
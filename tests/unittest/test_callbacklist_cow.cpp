@@ -0,0 +1,445 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/callbacklist.h"
+#include "eventpp/eventdispatcher.h"
+#include "eventpp/utilities/inlinefunction.h"
+
+#include <vector>
+#include <numeric>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace {
+
+struct CowPolicies
+{
+	using CallbackListStorage = eventpp::CallbackListStorageCopyOnWrite;
+};
+
+struct CowSingleThreadingPolicies
+{
+	using CallbackListStorage = eventpp::CallbackListStorageCopyOnWrite;
+	using Threading = eventpp::SingleThreading;
+};
+
+template <typename CL>
+std::vector<int> collectCallbacks(const CL & callbackList)
+{
+	std::vector<int> result;
+	callbackList.forEach([&result](const int callback) {
+		result.push_back(callback);
+	});
+	return result;
+}
+
+} //unnamed namespace
+
+TEST_CASE("CallbackList, copy on write, append/prepend/insert/remove")
+{
+	struct Policies
+	{
+		using CallbackListStorage = eventpp::CallbackListStorageCopyOnWrite;
+		using Callback = int;
+	};
+	using CL = eventpp::CallbackList<void(), Policies>;
+	CL callbackList;
+
+	REQUIRE(callbackList.empty());
+
+	auto h1 = callbackList.append(1);
+	auto h2 = callbackList.append(2);
+	auto h3 = callbackList.prepend(3);
+	auto h4 = callbackList.insert(4, h2);
+	REQUIRE(collectCallbacks(callbackList) == std::vector<int>{ 3, 1, 4, 2 });
+	REQUIRE(h1);
+
+	REQUIRE(callbackList.remove(h1));
+	REQUIRE(! callbackList.remove(h1));
+	REQUIRE(collectCallbacks(callbackList) == std::vector<int>{ 3, 4, 2 });
+
+	// A removed handle is still not empty, but it's not owned by the list any more.
+	REQUIRE(h1);
+	auto h5 = callbackList.append(5);
+	REQUIRE(! callbackList.ownsHandle(h1));
+	REQUIRE(callbackList.ownsHandle(h5));
+	REQUIRE(! callbackList.remove(h1));
+	REQUIRE(collectCallbacks(callbackList) == std::vector<int>{ 3, 4, 2, 5 });
+
+	// Insert before a removed handle appends the callback.
+	callbackList.insert(6, h1);
+	REQUIRE(collectCallbacks(callbackList) == std::vector<int>{ 3, 4, 2, 5, 6 });
+
+	REQUIRE(callbackList.remove(h3));
+	REQUIRE(callbackList.remove(h4));
+	REQUIRE(callbackList.remove(h2));
+	REQUIRE(collectCallbacks(callbackList) == std::vector<int>{ 5, 6 });
+
+	REQUIRE(! callbackList.ownsHandle(CL::Handle()));
+	REQUIRE(! CL::Handle());
+}
+
+TEST_CASE("CallbackList, copy on write, nested callbacks, new callbacks should not be triggered")
+{
+	using CL = eventpp::CallbackList<void(), CowPolicies>;
+	CL callbackList;
+	int a = 0, b = 0;
+
+	callbackList.append([&callbackList, &a, &b]() {
+		a = 1;
+
+		auto h1 = callbackList.append([&b] {
+			++b;
+		});
+		callbackList.prepend([&b] {
+			++b;
+		});
+		callbackList.insert([&b] {
+			++b;
+		}, h1);
+	});
+
+	callbackList();
+	REQUIRE(a == 1);
+	REQUIRE(b == 0);
+
+	callbackList();
+	REQUIRE(b == 3);
+}
+
+TEST_CASE("CallbackList, copy on write, remove inside callback")
+{
+	using CL = eventpp::CallbackList<void(), CowPolicies>;
+
+	constexpr int callbackCount = 7;
+	constexpr int removerIndex = 3;
+	const std::vector<std::vector<int> > removalList {
+		{ 0 }, { 2 }, { 3 }, { 4 }, { 6 },
+		{ 3, 4 }, { 4, 3 }, { 2, 4 }, { 4, 5 }, { 5, 4 },
+		{ 0, 1, 2, 3, 4, 5, 6 }, { 6, 5, 4, 3, 2, 1, 0 }
+	};
+
+	for(const auto & indexesToBeRemoved : removalList) {
+		CL callbackList;
+		std::vector<CL::Handle> handleList(callbackCount);
+		std::vector<int> dataList(callbackCount);
+
+		for(int i = 0; i < callbackCount; ++i) {
+			handleList[i] = callbackList.append([i, &dataList, &handleList, &callbackList, &indexesToBeRemoved]() {
+				dataList[i] = i + 1;
+				if(i == removerIndex) {
+					for(auto index : indexesToBeRemoved) {
+						callbackList.remove(handleList[index]);
+					}
+				}
+			});
+		}
+
+		callbackList();
+
+		std::vector<int> compareList(callbackCount);
+		std::iota(compareList.begin(), compareList.end(), 1);
+		for(auto index : indexesToBeRemoved) {
+			if(index > removerIndex) {
+				compareList[index] = 0;
+			}
+		}
+		REQUIRE(dataList == compareList);
+
+		for(auto index : indexesToBeRemoved) {
+			REQUIRE(! callbackList.ownsHandle(handleList[index]));
+		}
+		std::fill(dataList.begin(), dataList.end(), 0);
+		callbackList();
+		for(auto index : indexesToBeRemoved) {
+			REQUIRE(dataList[index] == 0);
+		}
+	}
+}
+
+TEST_CASE("CallbackList, copy on write, forEachIf and handles")
+{
+	using CL = eventpp::CallbackList<void(), CowSingleThreadingPolicies>;
+	CL callbackList;
+	std::vector<int> dataList(5);
+
+	for(int i = 0; i < 5; ++i) {
+		callbackList.append([&dataList, i]() {
+			++dataList[i];
+		});
+	}
+
+	int count = 0;
+	REQUIRE(! callbackList.forEachIf([&callbackList, &count](const CL::Handle & handle, const CL::Callback &) -> bool {
+		callbackList.remove(handle);
+		return ++count < 3;
+	}));
+	REQUIRE(count == 3);
+
+	callbackList();
+	REQUIRE(dataList == std::vector<int>{ 0, 0, 0, 1, 1 });
+}
+
+TEST_CASE("CallbackList, copy on write, copy, move and swap")
+{
+	using CL = eventpp::CallbackList<void(std::vector<int> &), CowPolicies>;
+	CL callbackList;
+	for(int i = 0; i < 100; ++i) {
+		callbackList.append([i](std::vector<int> & dataList) {
+			dataList.push_back(i);
+		});
+	}
+	std::vector<int> compareList(100);
+	std::iota(compareList.begin(), compareList.end(), 0);
+
+	CL copied(callbackList);
+	std::vector<int> dataList;
+	copied(dataList);
+	REQUIRE(dataList == compareList);
+
+	CL moved(std::move(copied));
+	REQUIRE(copied.empty());
+	dataList.clear();
+	moved(dataList);
+	REQUIRE(dataList == compareList);
+
+	CL other;
+	other.append([](std::vector<int> & dataList) {
+		dataList.push_back(-1);
+	});
+	swap(other, moved);
+	dataList.clear();
+	other(dataList);
+	REQUIRE(dataList == compareList);
+	dataList.clear();
+	moved(dataList);
+	REQUIRE(dataList == std::vector<int>{ -1 });
+
+	moved = callbackList;
+	dataList.clear();
+	moved(dataList);
+	REQUIRE(dataList == compareList);
+}
+
+TEST_CASE("CallbackList, copy on write, EventDispatcher")
+{
+	eventpp::EventDispatcher<int, void (int &), CowPolicies> dispatcher;
+	int value = 0;
+	auto handle = dispatcher.appendListener(3, [](int & value) {
+		value += 3;
+	});
+	dispatcher.appendListener(5, [](int & value) {
+		value += 5;
+	});
+
+	dispatcher.dispatch(3, value);
+	dispatcher.dispatch(5, value);
+	REQUIRE(value == 8);
+
+	REQUIRE(dispatcher.removeListener(3, handle));
+	dispatcher.dispatch(3, value);
+	REQUIRE(value == 8);
+}
+
+TEST_CASE("CallbackList, copy on write, multi threading, append/remove/invoke")
+{
+	using CL = eventpp::CallbackList<void(), CowPolicies>;
+	CL callbackList;
+
+	constexpr int threadCount = 8;
+	constexpr int taskCountPerThread = 256;
+
+	std::atomic<int> callCount(0);
+	std::atomic<int> removedCount(0);
+	std::atomic<bool> stop(false);
+	std::thread invoker([&callbackList, &stop]() {
+		while(! stop.load()) {
+			callbackList();
+		}
+	});
+
+	std::vector<std::thread> threadList;
+	for(int i = 0; i < threadCount; ++i) {
+		threadList.emplace_back([&callbackList, &callCount, &removedCount]() {
+			std::vector<CL::Handle> handleList;
+			for(int k = 0; k < taskCountPerThread; ++k) {
+				handleList.push_back(callbackList.append([&callCount]() {
+					++callCount;
+				}));
+			}
+			for(auto & handle : handleList) {
+				if(callbackList.remove(handle)) {
+					++removedCount;
+				}
+			}
+		});
+	}
+	for(auto & thread : threadList) {
+		thread.join();
+	}
+
+	stop.store(true);
+	invoker.join();
+
+	REQUIRE(removedCount == threadCount * taskCountPerThread);
+	REQUIRE(callbackList.empty());
+	callCount = 0;
+	callbackList();
+	REQUIRE(callCount == 0);
+}
+
+TEST_CASE("CallbackList, copy on write, removed callbacks are kept alive until the invoking finishes")
+{
+	using CL = eventpp::CallbackList<void(), CowPolicies>;
+	CL callbackList;
+
+	int count = 0;
+	CL::Handle handle;
+	std::shared_ptr<int> token(std::make_shared<int>(10));
+	std::weak_ptr<int> weakToken(token);
+	bool aliveDuringInvoking = false;
+	callbackList.append([&callbackList, &handle, &weakToken, &aliveDuringInvoking, &count]() {
+		++count;
+		callbackList.remove(handle);
+		aliveDuringInvoking = ! weakToken.expired();
+	});
+	handle = callbackList.append([&count, token]() {
+		count += *token;
+	});
+	token.reset();
+
+	callbackList();
+	REQUIRE(count == 1);
+	REQUIRE(aliveDuringInvoking);
+	REQUIRE(weakToken.expired());
+}
+
+TEST_CASE("CallbackList, copy on write, changes don't copy the callbacks")
+{
+	struct Counter
+	{
+		explicit Counter(int * copyCount) : copyCount(copyCount), value(0) {
+		}
+
+		Counter(const Counter & other) : copyCount(other.copyCount), value(other.value) {
+			++*copyCount;
+		}
+
+		void operator() (int & result) {
+			result = ++value;
+		}
+
+		int * copyCount;
+		int value;
+	};
+
+	using CL = eventpp::CallbackList<void(int &), CowPolicies>;
+	CL callbackList;
+
+	int copyCount = 0;
+	callbackList.append(Counter(&copyCount));
+	copyCount = 0;
+
+	int result = 0;
+	callbackList(result);
+	REQUIRE(result == 1);
+
+	CL::Handle handle = callbackList.append([](int &) {});
+	callbackList.prepend([](int &) {});
+	callbackList.remove(handle);
+	REQUIRE(copyCount == 0);
+
+	// The state in the callback is kept after the changes.
+	callbackList(result);
+	REQUIRE(result == 2);
+}
+
+TEST_CASE("CallbackList, copy on write, move only callbacks")
+{
+	struct MyPolicies
+	{
+		using CallbackListStorage = eventpp::CallbackListStorageCopyOnWrite;
+		using Callback = eventpp::InlineFunction<void (int &)>;
+	};
+	using CL = eventpp::CallbackList<void(int &), MyPolicies>;
+	CL callbackList;
+
+	std::unique_ptr<int> pointer(new int(3));
+	callbackList.append([pointer = std::move(pointer)](int & result) {
+		result += *pointer;
+	});
+	CL::Handle handle = callbackList.append([](int & result) {
+		result += 10;
+	});
+	callbackList.prepend([](int & result) {
+		result += 100;
+	});
+
+	int result = 0;
+	callbackList(result);
+	REQUIRE(result == 113);
+
+	REQUIRE(callbackList.remove(handle));
+	result = 0;
+	callbackList(result);
+	REQUIRE(result == 103);
+}
+
+TEST_CASE("CallbackList, copy on write, replaced snapshots are freed during overlapped invoking")
+{
+	using CL = eventpp::CallbackList<void(), CowPolicies>;
+	CL callbackList;
+
+	constexpr int invokerCount = 8;
+	constexpr int callbackCount = 64;
+
+	std::shared_ptr<int> token(std::make_shared<int>(1));
+	std::weak_ptr<int> weakToken(token);
+	std::vector<CL::Handle> handleList;
+	for(int i = 0; i < callbackCount; ++i) {
+		handleList.push_back(callbackList.append([token]() {}));
+	}
+	token.reset();
+
+	std::atomic<bool> stop(false);
+	std::vector<std::thread> threadList;
+	for(int i = 0; i < invokerCount; ++i) {
+		threadList.emplace_back([&callbackList, &stop]() {
+			while(! stop.load()) {
+				callbackList();
+			}
+		});
+	}
+
+	for(auto & handle : handleList) {
+		callbackList.remove(handle);
+		callbackList.append([]() {});
+	}
+
+	// The invokers never stop, but each snapshot is freed by the last invoking holding it.
+	const auto startTime = std::chrono::steady_clock::now();
+	while(! weakToken.expired() && std::chrono::steady_clock::now() - startTime < std::chrono::seconds(10)) {
+		std::this_thread::yield();
+	}
+	const bool freedDuringInvoking = weakToken.expired();
+
+	stop.store(true);
+	for(auto & thread : threadList) {
+		thread.join();
+	}
+
+	REQUIRE(freedDuringInvoking);
+}
@@ -15,6 +15,8 @@
 
 #include <thread>
 #include <random>
+#include <atomic>
+#include <chrono>
 
 TEST_CASE("CallbackList, multi threading, append")
 {
@@ -228,3 +230,99 @@ TEST_CASE("CallbackList, multi threading, insert")
 	verifyDisorderedLinkedList(callbackList, compareList);
 }
 
+
+TEST_CASE("CallbackList, multi threading, invoke and remove")
+{
+	using CL = eventpp::CallbackList<void()>;
+	CL callbackList;
+
+	constexpr int invokerCount = 8;
+	constexpr int callbackCount = 1024 * 4;
+
+	std::atomic<int> callCount(0);
+	std::vector<CL::Handle> handleList;
+	for(int i = 0; i < callbackCount; ++i) {
+		handleList.push_back(callbackList.append([&callCount]() {
+			++callCount;
+		}));
+	}
+	std::shuffle(handleList.begin(), handleList.end(), std::mt19937(std::random_device()()));
+
+	std::atomic<bool> stop(false);
+	std::vector<std::thread> threadList;
+	for(int i = 0; i < invokerCount; ++i) {
+		threadList.emplace_back([&callbackList, &stop]() {
+			while(! stop.load()) {
+				callbackList();
+			}
+		});
+	}
+
+	std::atomic<int> removedCount(0);
+	std::thread remover([&callbackList, &handleList, &removedCount]() {
+		for(auto & handle : handleList) {
+			if(callbackList.remove(handle)) {
+				++removedCount;
+			}
+		}
+	});
+	remover.join();
+
+	stop.store(true);
+	for(auto & thread : threadList) {
+		thread.join();
+	}
+
+	REQUIRE(removedCount == callbackCount);
+	REQUIRE(callbackList.empty());
+	REQUIRE(checkAllWeakPtrAreFreed(handleList));
+	callCount = 0;
+	callbackList();
+	REQUIRE(callCount == 0);
+}
+
+TEST_CASE("CallbackList, multi threading, removed nodes are freed during overlapped invoking")
+{
+	using CL = eventpp::CallbackList<void()>;
+	CL callbackList;
+
+	constexpr int invokerCount = 8;
+	constexpr int callbackCount = 1024;
+
+	std::vector<CL::Handle> handleList;
+	for(int i = 0; i < callbackCount; ++i) {
+		handleList.push_back(callbackList.append([]() {}));
+	}
+
+	std::atomic<bool> stop(false);
+	std::vector<std::thread> threadList;
+	for(int i = 0; i < invokerCount; ++i) {
+		threadList.emplace_back([&callbackList, &stop]() {
+			while(! stop.load()) {
+				callbackList();
+			}
+		});
+	}
+
+	for(auto & handle : handleList) {
+		callbackList.remove(handle);
+	}
+
+	// The invokers never stop, so there is always some invoking in progress,
+	// but the removed nodes must still be freed.
+	std::size_t retiredCount = callbackCount;
+	const auto startTime = std::chrono::steady_clock::now();
+	while(retiredCount > 8 && std::chrono::steady_clock::now() - startTime < std::chrono::seconds(10)) {
+		callbackList.remove(callbackList.append([]() {}));
+		std::lock_guard<CL::Mutex> lockGuard(callbackList.mutex);
+		retiredCount = callbackList.retiredList.size();
+	}
+
+	stop.store(true);
+	for(auto & thread : threadList) {
+		thread.join();
+	}
+
+	REQUIRE(retiredCount <= 8);
+	REQUIRE(checkAllWeakPtrAreFreed(handleList));
+}
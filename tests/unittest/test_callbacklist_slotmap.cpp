@@ -0,0 +1,413 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/callbacklist.h"
+#include "eventpp/eventdispatcher.h"
+
+#include <vector>
+#include <numeric>
+#include <thread>
+#include <atomic>
+
+namespace {
+
+struct SlotMapPolicies
+{
+	using CallbackListStorage = eventpp::CallbackListStorageSlotMap;
+};
+
+struct SlotMapSingleThreadingPolicies
+{
+	using CallbackListStorage = eventpp::CallbackListStorageSlotMap;
+	using Threading = eventpp::SingleThreading;
+};
+
+template <typename CL>
+std::vector<int> collectCallbacks(const CL & callbackList)
+{
+	std::vector<int> result;
+	callbackList.forEach([&result](const int callback) {
+		result.push_back(callback);
+	});
+	return result;
+}
+
+} //unnamed namespace
+
+TEST_CASE("CallbackList, slot map, append/prepend/insert/remove")
+{
+	struct Policies
+	{
+		using CallbackListStorage = eventpp::CallbackListStorageSlotMap;
+		using Callback = int;
+	};
+	using CL = eventpp::CallbackList<void(), Policies>;
+	CL callbackList;
+
+	REQUIRE(callbackList.empty());
+
+	auto h1 = callbackList.append(1);
+	auto h2 = callbackList.append(2);
+	auto h3 = callbackList.prepend(3);
+	auto h4 = callbackList.insert(4, h2);
+	REQUIRE(collectCallbacks(callbackList) == std::vector<int>{ 3, 1, 4, 2 });
+	REQUIRE(h1);
+	REQUIRE(h2 != h1);
+
+	REQUIRE(callbackList.remove(h1));
+	REQUIRE(! callbackList.remove(h1));
+	REQUIRE(collectCallbacks(callbackList) == std::vector<int>{ 3, 4, 2 });
+
+	// A stale handle doesn't hit the slot which is recycled for a new callback.
+	auto h5 = callbackList.append(5);
+	REQUIRE(! callbackList.ownsHandle(h1));
+	REQUIRE(callbackList.ownsHandle(h5));
+	REQUIRE(! callbackList.remove(h1));
+	REQUIRE(collectCallbacks(callbackList) == std::vector<int>{ 3, 4, 2, 5 });
+
+	// Insert before a removed handle appends the callback.
+	callbackList.insert(6, h1);
+	REQUIRE(collectCallbacks(callbackList) == std::vector<int>{ 3, 4, 2, 5, 6 });
+
+	REQUIRE(callbackList.remove(h3));
+	REQUIRE(callbackList.remove(h4));
+	REQUIRE(callbackList.remove(h2));
+	REQUIRE(collectCallbacks(callbackList) == std::vector<int>{ 5, 6 });
+
+	REQUIRE(! callbackList.ownsHandle(CL::Handle()));
+	REQUIRE(! CL::Handle());
+}
+
+TEST_CASE("CallbackList, slot map, nested callbacks, new callbacks should not be triggered")
+{
+	using CL = eventpp::CallbackList<void(), SlotMapPolicies>;
+	CL callbackList;
+	int a = 0, b = 0;
+
+	callbackList.append([&callbackList, &a, &b]() {
+		a = 1;
+
+		auto h1 = callbackList.append([&b] {
+			++b;
+		});
+		callbackList.prepend([&b] {
+			++b;
+		});
+		callbackList.insert([&b] {
+			++b;
+		}, h1);
+	});
+
+	callbackList();
+	REQUIRE(a == 1);
+	REQUIRE(b == 0);
+
+	callbackList();
+	REQUIRE(b == 3);
+}
+
+TEST_CASE("CallbackList, slot map, remove inside callback")
+{
+	using CL = eventpp::CallbackList<void(), SlotMapPolicies>;
+
+	constexpr int callbackCount = 7;
+	constexpr int removerIndex = 3;
+	const std::vector<std::vector<int> > removalList {
+		{ 0 }, { 2 }, { 3 }, { 4 }, { 6 },
+		{ 3, 4 }, { 4, 3 }, { 2, 4 }, { 4, 5 }, { 5, 4 },
+		{ 0, 1, 2, 3, 4, 5, 6 }, { 6, 5, 4, 3, 2, 1, 0 }
+	};
+
+	for(const auto & indexesToBeRemoved : removalList) {
+		CL callbackList;
+		std::vector<CL::Handle> handleList(callbackCount);
+		std::vector<int> dataList(callbackCount);
+
+		for(int i = 0; i < callbackCount; ++i) {
+			handleList[i] = callbackList.append([i, &dataList, &handleList, &callbackList, &indexesToBeRemoved]() {
+				dataList[i] = i + 1;
+				if(i == removerIndex) {
+					for(auto index : indexesToBeRemoved) {
+						callbackList.remove(handleList[index]);
+					}
+				}
+			});
+		}
+
+		callbackList();
+
+		std::vector<int> compareList(callbackCount);
+		std::iota(compareList.begin(), compareList.end(), 1);
+		for(auto index : indexesToBeRemoved) {
+			if(index > removerIndex) {
+				compareList[index] = 0;
+			}
+		}
+		REQUIRE(dataList == compareList);
+
+		// The removed slots are recycled after the invoking.
+		std::fill(dataList.begin(), dataList.end(), 0);
+		callbackList();
+		for(auto index : indexesToBeRemoved) {
+			REQUIRE(dataList[index] == 0);
+		}
+	}
+}
+
+TEST_CASE("CallbackList, slot map, forEachIf and handles")
+{
+	using CL = eventpp::CallbackList<void(), SlotMapSingleThreadingPolicies>;
+	CL callbackList;
+	std::vector<int> dataList(5);
+
+	for(int i = 0; i < 5; ++i) {
+		callbackList.append([&dataList, i]() {
+			++dataList[i];
+		});
+	}
+
+	int count = 0;
+	REQUIRE(! callbackList.forEachIf([&callbackList, &count](const CL::Handle & handle, const CL::Callback &) -> bool {
+		callbackList.remove(handle);
+		return ++count < 3;
+	}));
+	REQUIRE(count == 3);
+
+	callbackList();
+	REQUIRE(dataList == std::vector<int>{ 0, 0, 0, 1, 1 });
+}
+
+TEST_CASE("CallbackList, slot map, copy, move and swap")
+{
+	using CL = eventpp::CallbackList<void(std::vector<int> &), SlotMapPolicies>;
+	CL callbackList;
+	for(int i = 0; i < 100; ++i) {
+		callbackList.append([i](std::vector<int> & dataList) {
+			dataList.push_back(i);
+		});
+	}
+	std::vector<int> compareList(100);
+	std::iota(compareList.begin(), compareList.end(), 0);
+
+	CL copied(callbackList);
+	std::vector<int> dataList;
+	copied(dataList);
+	REQUIRE(dataList == compareList);
+
+	CL moved(std::move(copied));
+	REQUIRE(copied.empty());
+	dataList.clear();
+	moved(dataList);
+	REQUIRE(dataList == compareList);
+
+	CL other;
+	other.append([](std::vector<int> & dataList) {
+		dataList.push_back(-1);
+	});
+	swap(other, moved);
+	dataList.clear();
+	other(dataList);
+	REQUIRE(dataList == compareList);
+	dataList.clear();
+	moved(dataList);
+	REQUIRE(dataList == std::vector<int>{ -1 });
+
+	moved = callbackList;
+	dataList.clear();
+	moved(dataList);
+	REQUIRE(dataList == compareList);
+}
+
+TEST_CASE("CallbackList, slot map, EventDispatcher")
+{
+	eventpp::EventDispatcher<int, void (int &), SlotMapPolicies> dispatcher;
+	int value = 0;
+	auto handle = dispatcher.appendListener(3, [](int & value) {
+		value += 3;
+	});
+	dispatcher.appendListener(5, [](int & value) {
+		value += 5;
+	});
+
+	dispatcher.dispatch(3, value);
+	dispatcher.dispatch(5, value);
+	REQUIRE(value == 8);
+
+	REQUIRE(dispatcher.removeListener(3, handle));
+	dispatcher.dispatch(3, value);
+	REQUIRE(value == 8);
+}
+
+TEST_CASE("CallbackList, slot map, multi threading, append/remove/invoke")
+{
+	using CL = eventpp::CallbackList<void(), SlotMapPolicies>;
+	CL callbackList;
+
+	constexpr int threadCount = 64;
+	constexpr int taskCountPerThread = 1024;
+
+	std::atomic<int> callCount(0);
+	std::atomic<int> removedCount(0);
+	std::atomic<bool> stop(false);
+	std::thread invoker([&callbackList, &stop]() {
+		while(! stop.load()) {
+			callbackList();
+		}
+	});
+
+	std::vector<std::thread> threadList;
+	for(int i = 0; i < threadCount; ++i) {
+		threadList.emplace_back([&callbackList, &callCount, &removedCount]() {
+			std::vector<CL::Handle> handleList;
+			for(int k = 0; k < taskCountPerThread; ++k) {
+				handleList.push_back(callbackList.append([&callCount]() {
+					++callCount;
+				}));
+			}
+			for(auto & handle : handleList) {
+				if(callbackList.remove(handle)) {
+					++removedCount;
+				}
+			}
+		});
+	}
+	for(auto & thread : threadList) {
+		thread.join();
+	}
+
+	stop.store(true);
+	invoker.join();
+
+	REQUIRE(removedCount == threadCount * taskCountPerThread);
+	REQUIRE(callbackList.empty());
+	callCount = 0;
+	callbackList();
+	REQUIRE(callCount == 0);
+}
+
+TEST_CASE("CallbackList, slot map, multi threading, overlapped invoke/remove/append")
+{
+	using CL = eventpp::CallbackList<void(int &), SlotMapPolicies>;
+	CL callbackList;
+
+	constexpr int invokerCount = 8;
+	constexpr int threadCount = 8;
+	constexpr int taskCountPerThread = 1024 * 4;
+
+	// The sentinel is always the last callback, every invoking must reach it exactly once,
+	// no matter how the slots before it are removed and recycled.
+	callbackList.append([](int & sentinelCount) {
+		++sentinelCount;
+	});
+
+	std::atomic<bool> stop(false);
+	std::atomic<int> badInvokingCount(0);
+	std::vector<std::thread> invokerList;
+	for(int i = 0; i < invokerCount; ++i) {
+		invokerList.emplace_back([&callbackList, &stop, &badInvokingCount]() {
+			while(! stop.load()) {
+				int sentinelCount = 0;
+				callbackList(sentinelCount);
+				if(sentinelCount != 1) {
+					++badInvokingCount;
+				}
+			}
+		});
+	}
+
+	std::vector<std::thread> threadList;
+	for(int i = 0; i < threadCount; ++i) {
+		threadList.emplace_back([&callbackList]() {
+			for(int k = 0; k < taskCountPerThread; ++k) {
+				auto handle = callbackList.prepend([](int &) {});
+				callbackList.remove(handle);
+			}
+		});
+	}
+	for(auto & thread : threadList) {
+		thread.join();
+	}
+
+	stop.store(true);
+	for(auto & thread : invokerList) {
+		thread.join();
+	}
+
+	REQUIRE(badInvokingCount == 0);
+	int sentinelCount = 0;
+	callbackList(sentinelCount);
+	REQUIRE(sentinelCount == 1);
+}
+
+TEST_CASE("CallbackList, slot map, multi threading, handles passed to forEach don't match the reused slots")
+{
+	using CL = eventpp::CallbackList<void(), SlotMapPolicies>;
+	CL callbackList;
+
+	constexpr int readerCount = 4;
+	constexpr int threadCount = 4;
+	constexpr int taskCountPerThread = 1024 * 4;
+	constexpr std::size_t maxHandleCount = 1024 * 64;
+
+	std::atomic<bool> stop(false);
+	std::vector<std::vector<CL::Handle> > handleLists(readerCount);
+	std::vector<std::thread> readerList;
+	for(int i = 0; i < readerCount; ++i) {
+		readerList.emplace_back([&callbackList, &stop, &handleLists, i]() {
+			std::vector<CL::Handle> & handleList = handleLists[i];
+			while(! stop.load() && handleList.size() < maxHandleCount) {
+				callbackList.forEach([&handleList](const CL::Handle & handle, const CL::Callback &) {
+					handleList.push_back(handle);
+				});
+			}
+		});
+	}
+
+	std::vector<std::thread> threadList;
+	for(int i = 0; i < threadCount; ++i) {
+		threadList.emplace_back([&callbackList]() {
+			for(int k = 0; k < taskCountPerThread; ++k) {
+				auto handle = callbackList.append([]() {});
+				callbackList.remove(handle);
+			}
+		});
+	}
+	for(auto & thread : threadList) {
+		thread.join();
+	}
+
+	stop.store(true);
+	for(auto & thread : readerList) {
+		thread.join();
+	}
+
+	// All callbacks seen by forEach are removed, their handles must not match the
+	// callbacks which reuse the slots.
+	std::vector<CL::Handle> newHandleList;
+	for(int i = 0; i < 256; ++i) {
+		newHandleList.push_back(callbackList.append([]() {}));
+	}
+	int matchedCount = 0;
+	for(const auto & handleList : handleLists) {
+		for(const auto & handle : handleList) {
+			if(callbackList.ownsHandle(handle)) {
+				++matchedCount;
+			}
+		}
+	}
+	REQUIRE(matchedCount == 0);
+	for(const auto & handle : newHandleList) {
+		REQUIRE(callbackList.ownsHandle(handle));
+	}
+}
@@ -0,0 +1,192 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/utilities/concurrentmap.h"
+#include "eventpp/eventdispatcher.h"
+#include "eventpp/eventqueue.h"
+#include "eventpp/hetereventdispatcher.h"
+
+#include <thread>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+namespace {
+
+struct ConcurrentMapPolicies
+{
+	template <typename Key, typename T>
+	using Map = eventpp::ConcurrentMap<Key, T>;
+};
+
+} //unnamed namespace
+
+TEST_CASE("ConcurrentMap, basic")
+{
+	eventpp::ConcurrentMap<std::string, int> map;
+	REQUIRE(map.empty());
+	REQUIRE(map.size() == 0);
+	REQUIRE(map.find("a") == map.end());
+
+	map["a"] = 1;
+	map["b"] = 2;
+	REQUIRE(! map.empty());
+	REQUIRE(map.size() == 2);
+	REQUIRE(map.find("a")->second == 1);
+	REQUIRE(map.find("b")->second == 2);
+	REQUIRE(map.find("c") == map.end());
+
+	int * a = &map["a"];
+	for(int i = 0; i < 1000; ++i) {
+		map[std::to_string(i)] = i;
+	}
+	REQUIRE(map.size() == 1002);
+	// The values are pointer stable after growing.
+	REQUIRE(a == &map["a"]);
+	for(int i = 0; i < 1000; ++i) {
+		REQUIRE(map.find(std::to_string(i))->second == i);
+	}
+
+	int sum = 0;
+	for(const auto & item : map) {
+		sum += item.second;
+	}
+	REQUIRE(sum == 1 + 2 + 999 * 1000 / 2);
+
+	eventpp::ConcurrentMap<std::string, int> copied(map);
+	REQUIRE(copied.size() == 1002);
+	REQUIRE(copied.find("b")->second == 2);
+	copied["b"] = 5;
+	REQUIRE(map.find("b")->second == 2);
+
+	eventpp::ConcurrentMap<std::string, int> moved(std::move(copied));
+	REQUIRE(moved.size() == 1002);
+	REQUIRE(moved.find("b")->second == 5);
+	REQUIRE(copied.empty());
+}
+
+TEST_CASE("ConcurrentMap, EventDispatcher")
+{
+	eventpp::EventDispatcher<int, void (int &), ConcurrentMapPolicies> dispatcher;
+
+	int value = 0;
+	auto handle = dispatcher.appendListener(3, [](int & n) {
+		n += 3;
+	});
+	dispatcher.prependListener(5, [](int & n) {
+		n += 5;
+	});
+	REQUIRE(dispatcher.hasAnyListener(3));
+	REQUIRE(! dispatcher.hasAnyListener(4));
+
+	dispatcher.dispatch(3, value);
+	dispatcher.dispatch(4, value);
+	dispatcher.dispatch(5, value);
+	REQUIRE(value == 8);
+
+	REQUIRE(dispatcher.removeListener(3, handle));
+	dispatcher.dispatch(3, value);
+	REQUIRE(value == 8);
+}
+
+TEST_CASE("ConcurrentMap, EventQueue and HeterEventDispatcher")
+{
+	eventpp::EventQueue<int, void (int), ConcurrentMapPolicies> queue;
+	int total = 0;
+	queue.appendListener(1, [&total](const int n) {
+		total += n;
+	});
+	queue.enqueue(1, 2);
+	queue.enqueue(2, 5);
+	queue.enqueue(1, 3);
+	queue.process();
+	REQUIRE(total == 5);
+
+	eventpp::HeterEventDispatcher<int, eventpp::HeterTuple<void (), void (int)>, ConcurrentMapPolicies> dispatcher;
+	dispatcher.appendListener(1, [&total]() {
+		++total;
+	});
+	dispatcher.appendListener(1, [&total](const int n) {
+		total += n;
+	});
+	dispatcher.dispatch(1);
+	dispatcher.dispatch(1, 10);
+	REQUIRE(total == 16);
+}
+
+TEST_CASE("ConcurrentMap, multi threading, insert and find")
+{
+	eventpp::ConcurrentMap<int, int> map;
+
+	constexpr int threadCount = 8;
+	constexpr int keyCountPerThread = 1024 * 4;
+
+	std::atomic<int> missingCount(0);
+	std::vector<std::thread> threadList;
+	for(int i = 0; i < threadCount; ++i) {
+		threadList.emplace_back([i, &map, &missingCount]() {
+			for(int k = i * keyCountPerThread; k < (i + 1) * keyCountPerThread; ++k) {
+				map[k] = k;
+				auto it = map.find(k);
+				if(it == map.end() || it->second != k) {
+					++missingCount;
+				}
+				// The other threads may be inserting keys, the keys already inserted must be found.
+				auto it2 = map.find(i * keyCountPerThread);
+				if(it2 == map.end()) {
+					++missingCount;
+				}
+			}
+		});
+	}
+	for(auto & thread : threadList) {
+		thread.join();
+	}
+
+	REQUIRE(missingCount.load() == 0);
+	REQUIRE((int)map.size() == threadCount * keyCountPerThread);
+	for(int k = 0; k < threadCount * keyCountPerThread; ++k) {
+		REQUIRE(map.find(k)->second == k);
+	}
+}
+
+TEST_CASE("ConcurrentMap, EventDispatcher, multi threading, append and dispatch")
+{
+	using ED = eventpp::EventDispatcher<int, void (int), ConcurrentMapPolicies>;
+	ED dispatcher;
+
+	constexpr int threadCount = 8;
+	constexpr int eventCountPerThread = 1024;
+
+	std::atomic<int> total(0);
+	std::vector<std::thread> threadList;
+	for(int i = 0; i < threadCount; ++i) {
+		threadList.emplace_back([i, &dispatcher, &total]() {
+			for(int k = i * eventCountPerThread; k < (i + 1) * eventCountPerThread; ++k) {
+				dispatcher.appendListener(k, [&total](const int n) {
+					total += n;
+				});
+				dispatcher.dispatch(k, 1);
+				// Dispatching to the events of other threads, they may be not added yet.
+				dispatcher.dispatch((k + eventCountPerThread) % (threadCount * eventCountPerThread), 0);
+			}
+		});
+	}
+	for(auto & thread : threadList) {
+		thread.join();
+	}
+
+	REQUIRE(total.load() == threadCount * eventCountPerThread);
+}
@@ -0,0 +1,177 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/utilities/delegate.h"
+#include "eventpp/utilities/eventutil.h"
+#include "eventpp/callbacklist.h"
+#include "eventpp/eventdispatcher.h"
+#include "eventpp/eventqueue.h"
+
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+struct Receiver
+{
+	void onEvent(const int n) {
+		value += n;
+	}
+
+	void onOtherEvent(const int n) {
+		value -= n;
+	}
+
+	int getValue(const int n) const {
+		return value + n;
+	}
+
+	int value = 0;
+};
+
+int globalValue = 0;
+
+void globalOnEvent(const int n)
+{
+	globalValue += n;
+}
+
+using D = eventpp::Delegate<void (int)>;
+
+struct DelegatePolicies
+{
+	using Callback = D;
+};
+
+} //unnamed namespace
+
+TEST_CASE("Delegate, properties")
+{
+	REQUIRE(std::is_trivially_copyable<D>::value);
+	REQUIRE(sizeof(D) == sizeof(void *) * 2);
+}
+
+TEST_CASE("Delegate, invoke")
+{
+	Receiver receiver;
+
+	D d;
+	REQUIRE(! d);
+
+	d = D::fromMethod<Receiver, &Receiver::onEvent>(&receiver);
+	REQUIRE(d);
+	d(5);
+	REQUIRE(receiver.value == 5);
+
+	const Receiver & constReceiver = receiver;
+	auto getter = eventpp::Delegate<int (int)>::fromConstMethod<Receiver, &Receiver::getValue>(&constReceiver);
+	REQUIRE(getter(1) == 6);
+
+	globalValue = 0;
+	d = &globalOnEvent;
+	d(3);
+	REQUIRE(globalValue == 3);
+
+	d = D::fromFunction<&globalOnEvent>();
+	d(4);
+	REQUIRE(globalValue == 7);
+
+	int total = 0;
+	auto lambda = [&total](const int n) {
+		total += n;
+	};
+	d = D::fromCallable(&lambda);
+	d(2);
+	REQUIRE(total == 2);
+}
+
+TEST_CASE("Delegate, equality")
+{
+	Receiver r1;
+	Receiver r2;
+
+	REQUIRE(D() == D());
+	REQUIRE(D() == nullptr);
+	REQUIRE(D::fromMethod<Receiver, &Receiver::onEvent>(&r1) == D::fromMethod<Receiver, &Receiver::onEvent>(&r1));
+	REQUIRE(D::fromMethod<Receiver, &Receiver::onEvent>(&r1) != D::fromMethod<Receiver, &Receiver::onEvent>(&r2));
+	REQUIRE(D::fromMethod<Receiver, &Receiver::onEvent>(&r1) != D::fromMethod<Receiver, &Receiver::onOtherEvent>(&r1));
+	REQUIRE(D(&globalOnEvent) == D(&globalOnEvent));
+	REQUIRE(D(&globalOnEvent) != D::fromFunction<&globalOnEvent>());
+	REQUIRE(D::fromFunction<&globalOnEvent>() == D::fromFunction<&globalOnEvent>());
+	REQUIRE(D(&globalOnEvent) != D());
+}
+
+TEST_CASE("Delegate, CallbackList and eventutil")
+{
+	eventpp::CallbackList<void (int), DelegatePolicies> callbackList;
+	Receiver r1;
+	Receiver r2;
+
+	callbackList.append(D::fromMethod<Receiver, &Receiver::onEvent>(&r1));
+	callbackList.append(D::fromMethod<Receiver, &Receiver::onEvent>(&r2));
+	callbackList(3);
+	REQUIRE(r1.value == 3);
+	REQUIRE(r2.value == 3);
+
+	REQUIRE(eventpp::hasListener(callbackList, D::fromMethod<Receiver, &Receiver::onEvent>(&r1)));
+	REQUIRE(eventpp::removeListener(callbackList, D::fromMethod<Receiver, &Receiver::onEvent>(&r1)));
+	REQUIRE(! eventpp::hasListener(callbackList, D::fromMethod<Receiver, &Receiver::onEvent>(&r1)));
+	REQUIRE(! eventpp::removeListener(callbackList, D::fromMethod<Receiver, &Receiver::onOtherEvent>(&r2)));
+
+	callbackList(3);
+	REQUIRE(r1.value == 3);
+	REQUIRE(r2.value == 6);
+}
+
+TEST_CASE("Delegate, EventDispatcher and eventutil")
+{
+	eventpp::EventDispatcher<int, void (int), DelegatePolicies> dispatcher;
+	Receiver r1;
+	Receiver r2;
+
+	dispatcher.appendListener(1, D::fromMethod<Receiver, &Receiver::onEvent>(&r1));
+	dispatcher.appendListener(1, D::fromMethod<Receiver, &Receiver::onEvent>(&r2));
+	dispatcher.appendListener(2, D::fromMethod<Receiver, &Receiver::onOtherEvent>(&r1));
+
+	dispatcher.dispatch(1, 5);
+	dispatcher.dispatch(2, 1);
+	REQUIRE(r1.value == 4);
+	REQUIRE(r2.value == 5);
+
+	REQUIRE(eventpp::hasListener(dispatcher, 1, D::fromMethod<Receiver, &Receiver::onEvent>(&r2)));
+	REQUIRE(! eventpp::hasListener(dispatcher, 2, D::fromMethod<Receiver, &Receiver::onEvent>(&r2)));
+	REQUIRE(eventpp::removeListener(dispatcher, 1, D::fromMethod<Receiver, &Receiver::onEvent>(&r2)));
+	REQUIRE(! eventpp::hasListener(dispatcher, 1, D::fromMethod<Receiver, &Receiver::onEvent>(&r2)));
+
+	dispatcher.dispatch(1, 5);
+	REQUIRE(r1.value == 9);
+	REQUIRE(r2.value == 5);
+}
+
+TEST_CASE("Delegate, EventQueue")
+{
+	eventpp::EventQueue<int, void (int), DelegatePolicies> queue;
+	Receiver receiver;
+
+	queue.appendListener(1, D::fromMethod<Receiver, &Receiver::onEvent>(&receiver));
+	queue.enqueue(1, 2);
+	queue.enqueue(1, 3);
+	queue.process();
+	REQUIRE(receiver.value == 5);
+
+	REQUIRE(eventpp::removeListener(queue, 1, D::fromMethod<Receiver, &Receiver::onEvent>(&receiver)));
+	queue.enqueue(1, 2);
+	queue.process();
+	REQUIRE(receiver.value == 5);
+}
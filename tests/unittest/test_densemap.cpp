@@ -0,0 +1,223 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/utilities/densemap.h"
+#include "eventpp/eventdispatcher.h"
+#include "eventpp/eventqueue.h"
+
+#include <vector>
+#include <stdexcept>
+
+namespace {
+
+enum class EventType
+{
+	first,
+	second,
+	third,
+	count
+};
+
+struct DenseMapPolicies
+{
+	template <typename Key, typename T>
+	using Map = eventpp::DenseMap<Key, T>;
+};
+
+struct FixedDenseMapPolicies
+{
+	template <typename Key, typename T>
+	using Map = eventpp::DenseMap<Key, T, (std::size_t)EventType::count>;
+};
+
+template <typename Key, typename T>
+struct SmallDenseMap : eventpp::DenseMap<Key, T>
+{
+	SmallDenseMap() : eventpp::DenseMap<Key, T>(100) {
+	}
+};
+
+struct SmallDenseMapPolicies
+{
+	template <typename Key, typename T>
+	using Map = SmallDenseMap<Key, T>;
+};
+
+} //unnamed namespace
+
+TEST_CASE("DenseMap, growing")
+{
+	eventpp::DenseMap<int, int> map;
+	REQUIRE(map.empty());
+	REQUIRE(map.begin() == map.end());
+	REQUIRE(map.find(0) == map.end());
+
+	map[3] = 30;
+	REQUIRE(map.size() == 1);
+	REQUIRE(map.find(3)->first == 3);
+	REQUIRE(map.find(3)->second == 30);
+	// The keys in the allocated range are not in the map until they are inserted.
+	REQUIRE(map.find(2) == map.end());
+
+	int * value3 = &map[3];
+	map[1000] = 10000;
+	REQUIRE(map.size() == 2);
+	// The values are pointer stable after growing.
+	REQUIRE(value3 == &map[3]);
+	REQUIRE(map.find(1000)->second == 10000);
+	REQUIRE(map.find(999) == map.end());
+	REQUIRE(map.find(100000) == map.end());
+
+	std::vector<int> keyList;
+	for(const auto & item : map) {
+		keyList.push_back(item.first);
+	}
+	REQUIRE(keyList == std::vector<int>{ 3, 1000 });
+
+	eventpp::DenseMap<int, int> copied(map);
+	copied[3] = 5;
+	REQUIRE(copied.size() == 2);
+	REQUIRE(map.find(3)->second == 30);
+
+	eventpp::DenseMap<int, int> moved(std::move(copied));
+	REQUIRE(moved.find(3)->second == 5);
+	REQUIRE(copied.empty());
+	REQUIRE(copied.find(3) == copied.end());
+}
+
+TEST_CASE("DenseMap, fixed max key")
+{
+	eventpp::DenseMap<EventType, int, (std::size_t)EventType::count> map;
+	REQUIRE(map.find(EventType::second) == map.end());
+
+	map[EventType::second] = 2;
+	map[EventType::first] = 1;
+	REQUIRE(map.size() == 2);
+	REQUIRE(map.find(EventType::first)->second == 1);
+	REQUIRE(map.find(EventType::second)->second == 2);
+	REQUIRE(map.find(EventType::third) == map.end());
+	REQUIRE(map.find(EventType::count) == map.end());
+
+	REQUIRE_THROWS_AS(map[EventType::count], std::out_of_range);
+	REQUIRE(map.size() == 2);
+	REQUIRE(map.find(EventType::count) == map.end());
+}
+
+TEST_CASE("DenseMap, negative key")
+{
+	eventpp::DenseMap<int, int> map;
+	REQUIRE_THROWS_AS(map[-1], std::out_of_range);
+	REQUIRE(map.empty());
+	REQUIRE(map.find(-1) == map.end());
+
+	eventpp::EventDispatcher<int, void (int &), DenseMapPolicies> dispatcher;
+	REQUIRE_THROWS_AS(dispatcher.appendListener(-1, [](int & n) {
+		n += 1;
+	}), std::out_of_range);
+	int value = 0;
+	dispatcher.dispatch(-1, value);
+	REQUIRE(value == 0);
+}
+
+TEST_CASE("DenseMap, max key")
+{
+	using Map = eventpp::DenseMap<int, int>;
+	Map map;
+	REQUIRE(map.getMaxKey() == Map::defaultMaxKey);
+	map[Map::defaultMaxKey - 1] = 1;
+	REQUIRE_THROWS_AS(map[Map::defaultMaxKey], std::out_of_range);
+	REQUIRE(map.size() == 1);
+
+	eventpp::DenseMap<int, int> smallMap(10);
+	smallMap[9] = 9;
+	REQUIRE_THROWS_AS(smallMap[10], std::out_of_range);
+	eventpp::DenseMap<int, int> copied(smallMap);
+	REQUIRE(copied.getMaxKey() == 10);
+	REQUIRE_THROWS_AS(copied[10], std::out_of_range);
+
+	// The runtime maximum is limited to MaxKey.
+	eventpp::DenseMap<int, int, 4> fixedMap(100);
+	REQUIRE(fixedMap.getMaxKey() == 4);
+	eventpp::DenseMap<int, int, 4> smallFixedMap(2);
+	smallFixedMap[1] = 1;
+	REQUIRE_THROWS_AS(smallFixedMap[2], std::out_of_range);
+
+	eventpp::EventDispatcher<int, void (int &), SmallDenseMapPolicies> dispatcher;
+	dispatcher.appendListener(99, [](int & n) {
+		n += 1;
+	});
+	REQUIRE_THROWS_AS(dispatcher.appendListener(100, [](int & n) {
+		n += 2;
+	}), std::out_of_range);
+	int value = 0;
+	dispatcher.dispatch(99, value);
+	dispatcher.dispatch(100, value);
+	REQUIRE(value == 1);
+}
+
+TEST_CASE("DenseMap, EventDispatcher, key at MaxKey")
+{
+	eventpp::EventDispatcher<EventType, void (int &), FixedDenseMapPolicies> dispatcher;
+
+	int value = 0;
+	REQUIRE_THROWS_AS(dispatcher.appendListener(EventType::count, [](int & n) {
+		n += 1;
+	}), std::out_of_range);
+	REQUIRE(! dispatcher.hasAnyListener(EventType::count));
+	dispatcher.dispatch(EventType::count, value);
+	REQUIRE(value == 0);
+}
+
+TEST_CASE("DenseMap, EventDispatcher")
+{
+	eventpp::EventDispatcher<int, void (int &), DenseMapPolicies> dispatcher;
+
+	int value = 0;
+	auto handle = dispatcher.appendListener(3, [](int & n) {
+		n += 3;
+	});
+	dispatcher.appendListener(300, [](int & n) {
+		n += 300;
+	});
+	REQUIRE(dispatcher.hasAnyListener(3));
+	REQUIRE(! dispatcher.hasAnyListener(4));
+
+	dispatcher.dispatch(3, value);
+	dispatcher.dispatch(4, value);
+	dispatcher.dispatch(300, value);
+	dispatcher.dispatch(5000, value);
+	REQUIRE(value == 303);
+
+	REQUIRE(dispatcher.removeListener(3, handle));
+	dispatcher.dispatch(3, value);
+	REQUIRE(value == 303);
+}
+
+TEST_CASE("DenseMap, EventQueue, fixed max key")
+{
+	eventpp::EventQueue<EventType, void (EventType, int), FixedDenseMapPolicies> queue;
+
+	int total = 0;
+	queue.appendListener(EventType::first, [&total](EventType, const int n) {
+		total += n;
+	});
+	queue.appendListener(EventType::third, [&total](EventType, const int n) {
+		total += n * 10;
+	});
+	queue.enqueue(EventType::first, 1);
+	queue.enqueue(EventType::second, 2);
+	queue.enqueue(EventType::third, 3);
+	queue.process();
+	REQUIRE(total == 31);
+}
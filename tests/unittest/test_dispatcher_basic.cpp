@@ -543,3 +543,69 @@ TEST_CASE("EventDispatcher, explicit single threading, int, void (int)")
 	REQUIRE(b == 10);
 }
 
+
+TEST_CASE("EventDispatcher, EventToken")
+{
+	struct MyPolicies
+	{
+		using Mixins = eventpp::MixinList<eventpp::MixinFilter>;
+	};
+	using ED = eventpp::EventDispatcher<int, void (int, int), MyPolicies>;
+	ED dispatcher;
+
+	std::vector<int> dataList(3);
+
+	dispatcher.appendListener(1, [&dataList](int e, int n) {
+		dataList[e] += n;
+	});
+
+	ED::EventToken emptyToken;
+	REQUIRE(! emptyToken);
+
+	ED::EventToken token1 = dispatcher.getEventToken(1);
+	ED::EventToken token2 = dispatcher.getEventToken(2);
+	REQUIRE(token1);
+	REQUIRE(token2);
+	REQUIRE(token1.getEvent() == 1);
+	REQUIRE(token2.getEvent() == 2);
+
+	dispatcher.dispatch(token1, 1, 3);
+	REQUIRE(dataList == std::vector<int>{ 0, 3, 0 });
+
+	// Listeners added after the token is created are still triggered.
+	dispatcher.appendListener(2, [&dataList](int e, int n) {
+		dataList[e] += n;
+	});
+	dispatcher.dispatch(token2, 2, 5);
+	REQUIRE(dataList == std::vector<int>{ 0, 3, 5 });
+
+	// Dispatching with an empty token only runs the mixins.
+	dispatcher.dispatch(emptyToken, 0, 7);
+	REQUIRE(dataList == std::vector<int>{ 0, 3, 5 });
+
+	// The filters still run on tokens.
+	dispatcher.appendFilter([](int e, int & n) -> bool {
+		n *= 10;
+		return e != 2;
+	});
+	dispatcher.dispatch(token1, 1, 1);
+	dispatcher.dispatch(token2, 2, 1);
+	REQUIRE(dataList == std::vector<int>{ 0, 13, 5 });
+}
+
+TEST_CASE("EventDispatcher, EventToken, event excluded from arguments")
+{
+	using ED = eventpp::EventDispatcher<std::string, void (int)>;
+	ED dispatcher;
+
+	int value = 0;
+	dispatcher.appendListener("a", [&value](int n) {
+		value += n;
+	});
+
+	ED::EventToken token = dispatcher.getEventToken("a");
+	REQUIRE(token.getEvent() == "a");
+	dispatcher.dispatch(token, 2);
+	dispatcher.directDispatch(token, 3);
+	REQUIRE(value == 5);
+}
@@ -0,0 +1,192 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/utilities/eventexecutor.h"
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <chrono>
+
+TEST_CASE("EventExecutor, dispatch")
+{
+	eventpp::EventExecutor<int, void (int, const std::string &)> executor(4);
+	REQUIRE(executor.getThreadCount() == 4);
+
+	std::atomic<int> sum(0);
+	std::atomic<int> length(0);
+	const auto handle = executor.appendListener(3, [&sum, &length](const int n, const std::string & s) {
+		sum += n;
+		length += (int)s.size();
+	});
+	executor.appendListener(5, [&sum](const int n, const std::string &) {
+		sum += n * 100;
+	});
+
+	executor.enqueue(3, 1, "a");
+	executor.enqueue(5, 2, "bc");
+	executor.enqueue(3, 3, "def");
+	executor.enqueue(8, 4, "ghij");
+	executor.waitForIdle();
+	REQUIRE(sum == 204);
+	REQUIRE(length == 4);
+
+	executor.enqueue(executor.getEventToken(3), 5, "kl");
+	executor.waitForIdle();
+	REQUIRE(sum == 209);
+	REQUIRE(length == 6);
+
+	REQUIRE(executor.removeListener(3, handle));
+	executor.enqueue(3, 6, "mno");
+	executor.waitForIdle();
+	REQUIRE(sum == 209);
+}
+
+TEST_CASE("EventExecutor, events of the same key are dispatched in order")
+{
+	using EE = eventpp::EventExecutor<int, void (int, int)>;
+
+	constexpr int keyCount = 16;
+	constexpr int producerCount = 4;
+	constexpr int itemCountPerProducer = 1024 * 4;
+
+	// lastList[key][producer] is the last item dispatched, it's only touched by
+	// the listener of the key, so it doesn't need synchronization.
+	std::vector<std::vector<int> > lastList(keyCount, std::vector<int>(producerCount, -1));
+	std::atomic<int> outOfOrderCount(0);
+	// Count of the workers dispatching each key at the same time, it must be at most 1.
+	std::vector<std::atomic<int> > activeList(keyCount);
+	std::atomic<int> overlapCount(0);
+
+	{
+		EE executor(4, 2);
+		for(int key = 0; key < keyCount; ++key) {
+			executor.appendListener(key, [key, &lastList, &outOfOrderCount, &activeList, &overlapCount](const int producer, const int item) {
+				if(++activeList[key] != 1) {
+					++overlapCount;
+				}
+				int & last = lastList[key][producer];
+				if(item != last + 1) {
+					++outOfOrderCount;
+				}
+				last = item;
+				--activeList[key];
+			});
+		}
+
+		std::vector<std::thread> threadList;
+		for(int producer = 0; producer < producerCount; ++producer) {
+			threadList.emplace_back([producer, &executor]() {
+				for(int item = 0; item < itemCountPerProducer; ++item) {
+					executor.enqueue(item % keyCount, producer, item / keyCount);
+				}
+			});
+		}
+		for(auto & thread : threadList) {
+			thread.join();
+		}
+		// The destructor dispatches all pending events.
+	}
+
+	REQUIRE(outOfOrderCount == 0);
+	REQUIRE(overlapCount == 0);
+	for(int key = 0; key < keyCount; ++key) {
+		for(int producer = 0; producer < producerCount; ++producer) {
+			REQUIRE(lastList[key][producer] == itemCountPerProducer / keyCount - 1);
+		}
+	}
+}
+
+struct ExecutorKeyPolicies
+{
+	// Route by the first argument instead of the event.
+	static int getKey(const int /*e*/, const int key, const int /*value*/) {
+		return key;
+	}
+};
+
+TEST_CASE("EventExecutor, getKey policy")
+{
+	using EE = eventpp::EventExecutor<int, void (int, int), ExecutorKeyPolicies>;
+	EE executor(4);
+
+	constexpr int keyCount = 8;
+	constexpr int itemCount = 1024 * 8;
+	std::vector<int> lastList(keyCount, -1);
+	std::atomic<int> outOfOrderCount(0);
+
+	// Different events with the same key are still in order.
+	for(int event = 0; event < 4; ++event) {
+		executor.appendListener(event, [&lastList, &outOfOrderCount](const int key, const int value) {
+			if(value != lastList[key] + 1) {
+				++outOfOrderCount;
+			}
+			lastList[key] = value;
+		});
+	}
+
+	for(int i = 0; i < itemCount; ++i) {
+		executor.enqueue(i % 4, i % keyCount, i / keyCount);
+	}
+	executor.waitForIdle();
+
+	REQUIRE(outOfOrderCount == 0);
+	for(int key = 0; key < keyCount; ++key) {
+		REQUIRE(lastList[key] == itemCount / keyCount - 1);
+	}
+}
+
+TEST_CASE("EventExecutor, other keys are dispatched while a key is blocked")
+{
+	using EE = eventpp::EventExecutor<int, void (int)>;
+	EE executor(2);
+
+	std::atomic<bool> released(false);
+	std::atomic<int> blockedCount(0);
+	std::atomic<int> otherCount(0);
+	executor.appendListener(0, [&released, &blockedCount](int) {
+		++blockedCount;
+		while(! released.load()) {
+			std::this_thread::yield();
+		}
+	});
+	constexpr int keyCount = 64;
+	for(int key = 1; key < keyCount; ++key) {
+		executor.appendListener(key, [&otherCount](int) {
+			++otherCount;
+		});
+	}
+
+	executor.enqueue(0, 0);
+	while(blockedCount.load() == 0) {
+		std::this_thread::yield();
+	}
+	for(int key = 1; key < keyCount; ++key) {
+		executor.enqueue(key, key);
+	}
+
+	// Some keys share the key group of key 0 and wait for it, the others must be
+	// dispatched by the other worker, even if their key group is owned by the blocked one.
+	const auto start = std::chrono::steady_clock::now();
+	while(otherCount.load() < keyCount / 4 && std::chrono::steady_clock::now() - start < std::chrono::seconds(10)) {
+		std::this_thread::yield();
+	}
+	REQUIRE(otherCount.load() >= keyCount / 4);
+
+	released = true;
+	executor.waitForIdle();
+	REQUIRE(blockedCount == 1);
+	REQUIRE(otherCount == keyCount - 1);
+}
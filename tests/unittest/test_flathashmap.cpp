@@ -0,0 +1,163 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/utilities/flathashmap.h"
+#include "eventpp/eventdispatcher.h"
+#include "eventpp/eventqueue.h"
+#include "eventpp/hetereventdispatcher.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace {
+
+struct FlatHashMapPolicies
+{
+	template <typename Key, typename T>
+	using Map = eventpp::FlatHashMap<Key, T>;
+};
+
+// All keys collide, to test the probing.
+struct BadHash
+{
+	std::size_t operator() (const int /*key*/) const {
+		return 1;
+	}
+};
+
+} //unnamed namespace
+
+TEST_CASE("FlatHashMap, basic")
+{
+	eventpp::FlatHashMap<std::string, int> map;
+	REQUIRE(map.empty());
+	REQUIRE(map.begin() == map.end());
+	REQUIRE(map.find("a") == map.end());
+
+	map["a"] = 1;
+	map["b"] = 2;
+	REQUIRE(map.size() == 2);
+	REQUIRE(map.find("a")->second == 1);
+	REQUIRE(map.find("b")->second == 2);
+	REQUIRE(map.find("c") == map.end());
+
+	int * a = &map["a"];
+	for(int i = 0; i < 10000; ++i) {
+		map[std::to_string(i)] = i;
+	}
+	REQUIRE(map.size() == 10002);
+	// The values are pointer stable after growing.
+	REQUIRE(a == &map["a"]);
+	for(int i = 0; i < 10000; ++i) {
+		REQUIRE(map.find(std::to_string(i))->second == i);
+	}
+	REQUIRE(map.find("10000") == map.end());
+
+	// Iterating in inserting order.
+	std::vector<int> valueList;
+	for(const auto & item : map) {
+		valueList.push_back(item.second);
+	}
+	REQUIRE(valueList.size() == 10002);
+	REQUIRE(valueList[0] == 1);
+	REQUIRE(valueList[1] == 2);
+	REQUIRE(valueList[10001] == 9999);
+
+	eventpp::FlatHashMap<std::string, int> copied(map);
+	REQUIRE(copied.size() == 10002);
+	copied["b"] = 5;
+	REQUIRE(map.find("b")->second == 2);
+
+	eventpp::FlatHashMap<std::string, int> moved(std::move(copied));
+	REQUIRE(moved.find("b")->second == 5);
+	REQUIRE(copied.empty());
+	REQUIRE(copied.find("b") == copied.end());
+}
+
+TEST_CASE("FlatHashMap, collisions")
+{
+	eventpp::FlatHashMap<int, int, BadHash> map;
+	for(int i = 0; i < 100; ++i) {
+		map[i] = i * 2;
+	}
+	REQUIRE(map.size() == 100);
+	for(int i = 0; i < 100; ++i) {
+		REQUIRE(map.find(i)->second == i * 2);
+	}
+	REQUIRE(map.find(100) == map.end());
+}
+
+TEST_CASE("FlatHashMap, 64 bit keys")
+{
+	eventpp::FlatHashMap<std::uint64_t, int> map;
+	for(std::uint64_t i = 0; i < 1000; ++i) {
+		// Only the high bits are different.
+		map[i << 40] = (int)i;
+	}
+	REQUIRE(map.size() == 1000);
+	for(std::uint64_t i = 0; i < 1000; ++i) {
+		REQUIRE(map.find(i << 40)->second == (int)i);
+	}
+	REQUIRE(map.find(1) == map.end());
+}
+
+TEST_CASE("FlatHashMap, EventDispatcher")
+{
+	eventpp::EventDispatcher<int, void (int &), FlatHashMapPolicies> dispatcher;
+
+	int value = 0;
+	auto handle = dispatcher.appendListener(3, [](int & n) {
+		n += 3;
+	});
+	dispatcher.appendListener(-5, [](int & n) {
+		n += 5;
+	});
+	REQUIRE(dispatcher.hasAnyListener(3));
+	REQUIRE(! dispatcher.hasAnyListener(4));
+
+	dispatcher.dispatch(3, value);
+	dispatcher.dispatch(4, value);
+	dispatcher.dispatch(-5, value);
+	REQUIRE(value == 8);
+
+	REQUIRE(dispatcher.removeListener(3, handle));
+	dispatcher.dispatch(3, value);
+	REQUIRE(value == 8);
+}
+
+TEST_CASE("FlatHashMap, EventQueue and HeterEventDispatcher")
+{
+	eventpp::EventQueue<std::string, void (const std::string &, int), FlatHashMapPolicies> queue;
+	int total = 0;
+	queue.appendListener("a", [&total](const std::string &, const int n) {
+		total += n;
+	});
+	queue.enqueue("a", 2);
+	queue.enqueue("b", 5);
+	queue.enqueue("a", 3);
+	queue.process();
+	REQUIRE(total == 5);
+
+	eventpp::HeterEventDispatcher<int, eventpp::HeterTuple<void (), void (int)>, FlatHashMapPolicies> dispatcher;
+	dispatcher.appendListener(1, [&total]() {
+		++total;
+	});
+	dispatcher.appendListener(1, [&total](const int n) {
+		total += n;
+	});
+	dispatcher.dispatch(1);
+	dispatcher.dispatch(1, 10);
+	REQUIRE(total == 16);
+}
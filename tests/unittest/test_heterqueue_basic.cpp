@@ -223,3 +223,88 @@ TEST_CASE("HeterEventQueue, processIf")
 	REQUIRE(dataList == std::vector<int>{ 4, 4, 4 });
 }
 
+
+TEST_CASE("HeterEventQueue, enqueueBulk")
+{
+	using EQ = eventpp::HeterEventQueue<int, eventpp::HeterTuple<void (), void (int)> >;
+	EQ queue;
+
+	std::vector<int> dataList;
+
+	queue.appendListener(3, [&dataList]() {
+		dataList.push_back(0);
+	});
+	queue.appendListener(3, [&dataList](int n) {
+		dataList.push_back(n);
+	});
+
+	queue.enqueue(3, 1);
+	REQUIRE(queue.enqueueBulk([](EQ::BulkEnqueuer & enqueuer) {
+		enqueuer.enqueue(3);
+		enqueuer.enqueue(3, 2);
+	}) == 2);
+	queue.process();
+	REQUIRE(dataList == std::vector<int>{ 1, 0, 2 });
+
+	queue.enqueueBulk([](EQ::BulkEnqueuer & enqueuer) {
+		for(int i = 5; i < 10; ++i) {
+			enqueuer.enqueue(3, i);
+		}
+	});
+	queue.process();
+	REQUIRE(dataList == std::vector<int>{ 1, 0, 2, 5, 6, 7, 8, 9 });
+	REQUIRE(queue.emptyQueue());
+}
+
+TEST_CASE("HeterEventQueue, enqueueRange")
+{
+	eventpp::HeterEventQueue<int, eventpp::HeterTuple<void (), void (int)> > queue;
+
+	std::vector<int> dataList;
+
+	queue.appendListener(3, [&dataList]() {
+		dataList.push_back(3);
+	});
+	queue.appendListener(3, [&dataList](int n) {
+		dataList.push_back(n);
+	});
+
+	std::vector<std::tuple<int, int> > eventList {
+		std::make_tuple(3, 1),
+		std::make_tuple(3, 2)
+	};
+	REQUIRE(queue.enqueueRange(eventList.begin(), eventList.end()) == 2);
+
+	const int singleEventList[] = { 3, 3 };
+	REQUIRE(queue.enqueueRange(std::begin(singleEventList), std::end(singleEventList)) == 2);
+
+	queue.process();
+	REQUIRE(dataList == std::vector<int>{ 1, 2, 3, 3 });
+}
+
+TEST_CASE("HeterEventQueue, processN and processFor")
+{
+	eventpp::HeterEventQueue<int, eventpp::HeterTuple<void (), void (int)> > queue;
+
+	std::vector<int> dataList;
+
+	queue.appendListener(3, [&dataList]() {
+		dataList.push_back(0);
+	});
+	queue.appendListener(3, [&dataList](int n) {
+		dataList.push_back(n);
+	});
+
+	queue.enqueue(3, 1);
+	queue.enqueue(3);
+	queue.enqueue(3, 2);
+	queue.enqueue(3, 3);
+
+	REQUIRE(queue.processN(3));
+	REQUIRE(dataList == std::vector<int>{ 1, 0, 2 });
+
+	queue.enqueue(3, 4);
+	REQUIRE(queue.processFor(std::chrono::seconds(10)));
+	REQUIRE(dataList == std::vector<int>{ 1, 0, 2, 3, 4 });
+	REQUIRE(! queue.processFor(std::chrono::seconds(10)));
+}
@@ -0,0 +1,257 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/utilities/inlinefunction.h"
+#include "eventpp/callbacklist.h"
+#include "eventpp/eventdispatcher.h"
+
+#include <memory>
+#include <string>
+#include <array>
+
+namespace {
+
+int globalAdd(const int a, const int b)
+{
+	return a + b;
+}
+
+struct LiveCounter
+{
+	explicit LiveCounter(int * count) : count(count) {
+		++*count;
+	}
+
+	LiveCounter(const LiveCounter & other) : count(other.count) {
+		++*count;
+	}
+
+	LiveCounter(LiveCounter && other) noexcept : count(other.count) {
+		++*count;
+	}
+
+	~LiveCounter() {
+		--*count;
+	}
+
+	int operator() (const int n) const {
+		return n + *count;
+	}
+
+	int * count;
+};
+
+} //unnamed namespace
+
+TEST_CASE("InlineFunction, empty")
+{
+	eventpp::InlineFunction<void ()> f;
+	REQUIRE(! f);
+	REQUIRE(f == nullptr);
+
+	void (*nullFunction)() = nullptr;
+	f = nullFunction;
+	REQUIRE(! f);
+
+	f = []() {};
+	REQUIRE(f);
+	REQUIRE(f != nullptr);
+
+	f = nullptr;
+	REQUIRE(! f);
+}
+
+TEST_CASE("InlineFunction, invoke")
+{
+	eventpp::InlineFunction<int (int, int)> f(&globalAdd);
+	REQUIRE(f(3, 5) == 8);
+
+	f = globalAdd;
+	REQUIRE(f(1, 2) == 3);
+
+	int base = 10;
+	f = [base](const int a, const int b) {
+		return base + a + b;
+	};
+	REQUIRE(f(1, 2) == 13);
+
+	eventpp::InlineFunction<void (int &)> g([](int & n) {
+		n = 5;
+	});
+	int n = 0;
+	g(n);
+	REQUIRE(n == 5);
+}
+
+TEST_CASE("InlineFunction, the callable is stored inside the object")
+{
+	using F = eventpp::InlineFunction<int (int), 64>;
+	REQUIRE(sizeof(F) >= 64);
+
+	std::array<int, 12> data {};
+	data[11] = 7;
+	F f([data](const int n) {
+		return data[11] + n;
+	});
+	REQUIRE(f(1) == 8);
+}
+
+TEST_CASE("InlineFunction, copy, move, swap and destroy")
+{
+	using F = eventpp::InlineFunction<int (int)>;
+	int count = 0;
+	{
+		F f1(LiveCounter{ &count });
+		REQUIRE(count == 1);
+		REQUIRE(f1(1) == 2);
+
+		F f2(f1);
+		REQUIRE(count == 2);
+
+		F f3(std::move(f1));
+		REQUIRE(count == 2);
+		REQUIRE(! f1);
+		REQUIRE(f3);
+
+		f2 = nullptr;
+		REQUIRE(count == 1);
+
+		F f4([](const int n) {
+			return -n;
+		});
+		swap(f3, f4);
+		REQUIRE(f3(3) == -3);
+		REQUIRE(f4(3) == 4);
+		REQUIRE(count == 1);
+
+		f1 = f4;
+		REQUIRE(count == 2);
+	}
+	REQUIRE(count == 0);
+}
+
+TEST_CASE("InlineFunction, move only callable")
+{
+	using F = eventpp::InlineFunction<int ()>;
+	std::unique_ptr<int> ptr(new int(5));
+	F f1([ptr = std::move(ptr)]() {
+		return *ptr;
+	});
+	REQUIRE(f1() == 5);
+
+	F f2(std::move(f1));
+	REQUIRE(! f1);
+	REQUIRE(f2() == 5);
+
+	REQUIRE_THROWS_AS(F(f2), std::logic_error);
+	REQUIRE(f2() == 5);
+}
+
+TEST_CASE("InlineFunction, only accepts callables matching the prototype")
+{
+	using F = eventpp::InlineFunction<int (int)>;
+	REQUIRE(std::is_constructible<F, int (*)(int)>::value);
+	REQUIRE(std::is_constructible<F, short (*)(long)>::value);
+	REQUIRE(! std::is_constructible<F, int (*)()>::value);
+	REQUIRE(! std::is_constructible<F, int (*)(int, int)>::value);
+	REQUIRE(! std::is_constructible<F, std::string (*)(int)>::value);
+	REQUIRE(! std::is_constructible<F, int>::value);
+
+	using G = eventpp::InlineFunction<void (int)>;
+	REQUIRE(std::is_constructible<G, std::string (*)(int)>::value);
+}
+
+TEST_CASE("InlineFunction, heap fallback")
+{
+	using F = eventpp::InlineFunction<std::size_t (), sizeof(void *), true>;
+	const std::string text(100, 'a');
+	int count = 0;
+	{
+		F f1([text]() {
+			return text.size();
+		});
+		REQUIRE(f1() == 100);
+
+		F f2(f1);
+		REQUIRE(f2() == 100);
+
+		F f3(std::move(f1));
+		REQUIRE(! f1);
+		REQUIRE(f3() == 100);
+
+		f3 = [text, counter = LiveCounter{ &count }]() {
+			return text.size() + 1;
+		};
+		REQUIRE(count == 1);
+		REQUIRE(f3() == 101);
+	}
+	REQUIRE(count == 0);
+}
+
+TEST_CASE("InlineFunction, as Callback policy of CallbackList")
+{
+	struct Policies {
+		using Callback = eventpp::InlineFunction<void (int &)>;
+	};
+	using CL = eventpp::CallbackList<void (int &), Policies>;
+	CL callbackList;
+
+	std::unique_ptr<int> ptr(new int(3));
+	auto handle = callbackList.append([ptr = std::move(ptr)](int & n) {
+		n += *ptr;
+	});
+	callbackList.prepend([](int & n) {
+		n *= 2;
+	});
+	callbackList.insert([](int & n) {
+		n += 1;
+	}, handle);
+
+	int n = 1;
+	callbackList(n);
+	REQUIRE(n == 6);
+
+	// The copy can't silently drop the move only callback.
+	REQUIRE_THROWS_AS(CL(callbackList), std::logic_error);
+
+	callbackList.remove(handle);
+	n = 1;
+	callbackList(n);
+	REQUIRE(n == 3);
+
+	CL copied(callbackList);
+	n = 1;
+	copied(n);
+	REQUIRE(n == 3);
+}
+
+TEST_CASE("InlineFunction, as Callback policy of EventDispatcher")
+{
+	struct Policies {
+		using Callback = eventpp::InlineFunction<void (int &)>;
+	};
+	eventpp::EventDispatcher<int, void (int &), Policies> dispatcher;
+
+	std::unique_ptr<int> ptr(new int(3));
+	dispatcher.appendListener(1, [ptr = std::move(ptr)](int & n) {
+		n += *ptr;
+	});
+	dispatcher.prependListener(1, [](int & n) {
+		n *= 2;
+	});
+
+	int n = 1;
+	dispatcher.dispatch(1, n);
+	REQUIRE(n == 5);
+}
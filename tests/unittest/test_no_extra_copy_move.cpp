@@ -13,6 +13,7 @@
 
 #include "test.h"
 #include "eventpp/eventdispatcher.h"
+#include "eventpp/eventqueue.h"
 
 class CopyMoveCounter
 {
@@ -349,3 +350,39 @@ TEST_CASE("copymove, EventDispatcher<void(const &)>, callback(value)")
 	}
 }
 
+TEST_CASE("copymove, EventQueue<void(const &)>, enqueue constructs the arguments in place")
+{
+	using EQ = eventpp::EventQueue<int, void(const CopyMoveCounter &)>;
+	EQ queue;
+
+	int copied = -1;
+	int moved = -1;
+	queue.appendListener(1, [&copied, &moved](const CopyMoveCounter & obj) {
+		copied = obj.getCounter().copied;
+		moved = obj.getCounter().moved;
+		obj.called();
+	});
+
+	SECTION("enqueue: temporary object") {
+		queue.enqueue(1, CopyMoveCounter());
+		queue.process();
+		REQUIRE(copied == 0);
+		REQUIRE(moved == 1);
+	}
+	SECTION("enqueue: object variable") {
+		CopyMoveCounter obj1;
+		queue.enqueue(1, obj1);
+		queue.process();
+		REQUIRE(copied == 1);
+		REQUIRE(moved == 0);
+		REQUIRE(obj1.getCalledAndReset() > 0);
+	}
+	SECTION("enqueueWith") {
+		queue.enqueueWith(1, [](CopyMoveCounter & obj) {
+			REQUIRE(obj.getCalledAndReset() == 0);
+		});
+		queue.process();
+		REQUIRE(copied == 0);
+		REQUIRE(moved == 0);
+	}
+}
@@ -14,6 +14,11 @@
 #include "test.h"
 #include "eventpp/eventqueue.h"
 
+#include <thread>
+#include <numeric>
+#include <iterator>
+#include <string>
+
 TEST_CASE("EventQueue, std::string, void (const std::string &)")
 {
 	eventpp::EventQueue<std::string, void (const std::string &)> queue;
@@ -342,6 +347,157 @@ TEST_CASE("EventQueue, non-copyable but movable unique_ptr")
 		queue.process();
 		REQUIRE(dataList == std::vector<int>{ 0, 1, 1 });
 	}
+
+	SECTION("takeEvents/dispatch") {
+		std::vector<EQ::QueuedEvent> eventList;
+		REQUIRE(queue.takeEvents(std::back_inserter(eventList), 2) == 2);
+		REQUIRE(eventList.size() == 2);
+		queue.dispatch(eventList[1]);
+		REQUIRE(dataList == std::vector<int>{ 0, 1, 0 });
+		queue.process();
+		REQUIRE(dataList == std::vector<int>{ 0, 1, 1 });
+	}
+
+	SECTION("peekEvents") {
+		int sum = 0;
+		queue.peekEvents([&sum](const EQ::QueuedEvent & event) {
+			sum += *event.getArgument<0>();
+		});
+		REQUIRE(sum == 3);
+		queue.process();
+		REQUIRE(dataList == std::vector<int>{ 1, 1, 1 });
+	}
+}
+
+TEST_CASE("EventQueue, enqueueWith")
+{
+	using EQ = eventpp::EventQueue<int, void (const std::string &, int)>;
+	EQ queue;
+
+	std::vector<std::string> dataList;
+	queue.appendListener(3, [&dataList](const std::string & s, const int n) {
+		dataList.push_back(s + std::to_string(n));
+	});
+
+	queue.enqueue(3, "a", 1);
+	queue.enqueueWith(3, [](std::string & s, int & n) {
+		REQUIRE(s.empty());
+		REQUIRE(n == 0);
+		s = "b";
+		n = 2;
+	});
+	queue.process();
+	REQUIRE(dataList == std::vector<std::string>{ "a1", "b2" });
+
+	// The recycled items are filled again.
+	queue.enqueueWith(3, [](std::string & s, int & n) {
+		REQUIRE(s.empty());
+		s.append("c");
+		n = 3;
+	});
+	queue.process();
+	REQUIRE(dataList == std::vector<std::string>{ "a1", "b2", "c3" });
+}
+
+TEST_CASE("EventQueue, enqueueWith, the prototype includes the event")
+{
+	struct MyEvent
+	{
+		int type;
+		int value;
+	};
+	struct MyPolicies
+	{
+		static int getEvent(const MyEvent & e) {
+			return e.type;
+		}
+	};
+	struct MyIncludeEventPolicies
+	{
+		using ArgumentPassingMode = eventpp::ArgumentPassingIncludeEvent;
+
+		static int getEvent(const MyEvent & e) {
+			return e.type;
+		}
+	};
+
+	std::vector<std::string> dataList;
+	auto listener = [&dataList](const MyEvent & e) {
+		dataList.push_back(std::to_string(e.type) + "," + std::to_string(e.value));
+	};
+
+	SECTION("ArgumentPassingAutoDetect") {
+		eventpp::EventQueue<int, void (const MyEvent &), MyPolicies> queue;
+		queue.appendListener(3, listener);
+		queue.appendListener(5, listener);
+
+		queue.enqueueWith([](MyEvent & e) {
+			e.type = 3;
+			e.value = 7;
+		});
+		queue.enqueueWith([](MyEvent & e) {
+			e.type = 5;
+			e.value = 8;
+		});
+		queue.process();
+		REQUIRE(dataList == std::vector<std::string>{ "3,7", "5,8" });
+	}
+
+	SECTION("ArgumentPassingIncludeEvent") {
+		eventpp::EventQueue<int, void (const MyEvent &), MyIncludeEventPolicies> queue;
+		queue.appendListener(3, listener);
+
+		queue.enqueueWith([](MyEvent & e) {
+			e.type = 3;
+			e.value = 7;
+		});
+		queue.process();
+		REQUIRE(dataList == std::vector<std::string>{ "3,7" });
+	}
+}
+
+TEST_CASE("EventQueue, takeEvents/peekEvents")
+{
+	using EQ = eventpp::EventQueue<int, void (int)>;
+	EQ queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(3, [&dataList](const int value) {
+		dataList.push_back(value);
+	});
+
+	EQ::QueuedEvent eventList[4];
+	REQUIRE(queue.takeEvents(eventList, 4) == 0);
+
+	for(int i = 0; i < 10; ++i) {
+		queue.enqueue(3, i);
+	}
+
+	std::vector<int> peekedList;
+	queue.peekEvents([&peekedList](const EQ::QueuedEvent & event) -> bool {
+		peekedList.push_back(event.getArgument<0>());
+		return peekedList.size() < 3;
+	});
+	REQUIRE(peekedList == std::vector<int>{ 0, 1, 2 });
+
+	REQUIRE(queue.takeEvents(eventList, 0) == 0);
+	REQUIRE(queue.takeEvents(eventList, 4) == 4);
+	for(int i = 0; i < 4; ++i) {
+		REQUIRE(eventList[i].event == 3);
+		REQUIRE(eventList[i].getArgument<0>() == i);
+	}
+
+	std::vector<EQ::QueuedEvent> takenList;
+	REQUIRE(queue.takeEvents(std::back_inserter(takenList), 100) == 6);
+	REQUIRE(takenList.size() == 6);
+	REQUIRE(takenList.front().getArgument<0>() == 4);
+	REQUIRE(takenList.back().getArgument<0>() == 9);
+	REQUIRE(queue.emptyQueue());
+
+	// The recycled items are reused.
+	queue.enqueue(3, 10);
+	queue.process();
+	REQUIRE(dataList == std::vector<int>{ 10 });
 }
 
 TEST_CASE("EventQueue, copyable event object")
@@ -828,3 +984,283 @@ TEST_CASE("EventQueue, processUntil")
 	REQUIRE(! queue.processUntil([]() -> bool { return true; }));
 }
 
+
+TEST_CASE("EventQueue, EventToken")
+{
+	using EQ = eventpp::EventQueue<int, void (int, const std::string &)>;
+	EQ queue;
+
+	std::vector<std::string> dataList;
+
+	queue.appendListener(1, [&dataList](int e, const std::string & s) {
+		dataList.push_back(std::to_string(e) + s);
+	});
+	queue.appendListener(2, [&dataList](int e, const std::string & s) {
+		dataList.push_back(std::to_string(e) + s);
+	});
+
+	EQ::EventToken token1 = queue.getEventToken(1);
+	EQ::EventToken token2 = queue.getEventToken(2);
+
+	queue.enqueue(token2, 2, "a");
+	queue.enqueue(1, "b");
+	queue.enqueue(token1, 1, "c");
+	REQUIRE(dataList.empty());
+
+	queue.process();
+	REQUIRE(dataList == std::vector<std::string>{ "2a", "1b", "1c" });
+
+	dataList.clear();
+	queue.enqueue(token1, 1, "d");
+	EQ::QueuedEvent queuedEvent;
+	REQUIRE(queue.takeEvent(&queuedEvent));
+	REQUIRE(queuedEvent.getEvent() == 1);
+	queue.dispatch(queuedEvent);
+	REQUIRE(dataList == std::vector<std::string>{ "1d" });
+
+	// QueuedEvent doesn't keep the token, it's still an aggregate of the event and the arguments.
+	dataList.clear();
+	const EQ::QueuedEvent userEvent{ 2, std::make_tuple(2, std::string()) };
+	queue.dispatch(userEvent);
+	queue.dispatch(EQ::QueuedEvent{ 1, std::make_tuple(1, std::string("e")) });
+	REQUIRE(dataList == std::vector<std::string>{ "2", "1e" });
+}
+
+TEST_CASE("EventQueue, assign queue with pending EventToken events")
+{
+	using EQ = eventpp::EventQueue<int, void (int, const std::string &)>;
+
+	std::vector<std::string> dataList;
+
+	EQ source;
+	source.appendListener(1, [&dataList](int e, const std::string & s) {
+		dataList.push_back("source" + std::to_string(e) + s);
+	});
+
+	SECTION("move assignment") {
+		EQ queue;
+		queue.appendListener(1, [&dataList](int e, const std::string & s) {
+			dataList.push_back("queue" + std::to_string(e) + s);
+		});
+		queue.enqueue(queue.getEventToken(1), 1, "a");
+		source.enqueue(source.getEventToken(1), 1, "b");
+
+		queue = std::move(source);
+		queue.process();
+		REQUIRE(dataList == std::vector<std::string>{ "source1a" });
+
+		dataList.clear();
+		source.process();
+		REQUIRE(dataList.empty());
+	}
+
+	SECTION("copy assignment") {
+		EQ queue;
+		queue.appendListener(1, [&dataList](int e, const std::string & s) {
+			dataList.push_back("queue" + std::to_string(e) + s);
+		});
+		queue.enqueue(queue.getEventToken(1), 1, "a");
+
+		queue = source;
+		queue.process();
+		REQUIRE(dataList == std::vector<std::string>{ "source1a" });
+	}
+}
+
+TEST_CASE("EventQueue, enqueueBulk")
+{
+	using EQ = eventpp::EventQueue<int, void (int, const std::string &)>;
+	EQ queue;
+
+	std::vector<std::string> dataList;
+
+	queue.appendListener(1, [&dataList](int e, const std::string & s) {
+		dataList.push_back(std::to_string(e) + s);
+	});
+	queue.appendListener(2, [&dataList](int e, const std::string & s) {
+		dataList.push_back(std::to_string(e) + s);
+	});
+
+	queue.enqueue(1, "a");
+	REQUIRE(queue.enqueueBulk([](EQ::BulkEnqueuer & enqueuer) {
+		enqueuer.enqueue(2, "b");
+		enqueuer.enqueue(1, "c");
+	}) == 2);
+	REQUIRE(dataList.empty());
+
+	// Reuse the free items of the processed events.
+	queue.process();
+	REQUIRE(queue.enqueueBulk([&queue](EQ::BulkEnqueuer & enqueuer) {
+		enqueuer.enqueue(queue.getEventToken(2), 2, "d");
+		for(int i = 0; i < 5; ++i) {
+			enqueuer.enqueue(1, std::to_string(i));
+		}
+	}) == 6);
+	REQUIRE(queue.enqueueBulk([](EQ::BulkEnqueuer &) {
+	}) == 0);
+	queue.enqueue(2, "e");
+	queue.process();
+	REQUIRE(dataList == std::vector<std::string>{
+		"1a", "2b", "1c", "2d", "10", "11", "12", "13", "14", "2e"
+	});
+	REQUIRE(queue.emptyQueue());
+}
+
+TEST_CASE("EventQueue, enqueueRange")
+{
+	SECTION("tuple of arguments") {
+		using EQ = eventpp::EventQueue<int, void (int, const std::string &)>;
+		EQ queue;
+
+		std::vector<std::string> dataList;
+		queue.appendListener(1, [&dataList](int e, const std::string & s) {
+			dataList.push_back(std::to_string(e) + s);
+		});
+		queue.appendListener(2, [&dataList](int e, const std::string & s) {
+			dataList.push_back(std::to_string(e) + s);
+		});
+
+		std::vector<std::tuple<int, std::string> > eventList {
+			std::make_tuple(2, "a"),
+			std::make_tuple(1, "b"),
+			std::make_tuple(2, "c")
+		};
+		REQUIRE(queue.enqueueRange(eventList.begin(), eventList.end()) == 3);
+		REQUIRE(queue.enqueueRange(eventList.begin(), eventList.begin()) == 0);
+		queue.process();
+		REQUIRE(dataList == std::vector<std::string>{ "2a", "1b", "2c" });
+	}
+
+	SECTION("single argument") {
+		eventpp::EventQueue<int, void (int)> queue;
+
+		std::vector<int> dataList;
+		queue.appendListener(3, [&dataList](int e) {
+			dataList.push_back(e);
+		});
+		queue.appendListener(5, [&dataList](int e) {
+			dataList.push_back(e * 10);
+		});
+
+		const int eventList[] = { 5, 3, 3, 5 };
+		queue.enqueueRange(std::begin(eventList), std::end(eventList));
+		queue.process();
+		REQUIRE(dataList == std::vector<int>{ 50, 3, 3, 50 });
+	}
+}
+
+TEST_CASE("EventQueue, processN")
+{
+	eventpp::EventQueue<int, void (int)> queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](int n) {
+		dataList.push_back(n);
+	});
+	queue.appendListener(2, [&dataList](int n) {
+		dataList.push_back(n * 10);
+	});
+
+	REQUIRE(! queue.processN(3));
+
+	for(int i = 0; i < 5; ++i) {
+		queue.enqueue(1 + i % 2, i);
+	}
+
+	REQUIRE(! queue.processN(0));
+	REQUIRE(dataList.empty());
+
+	REQUIRE(queue.processN(2));
+	REQUIRE(dataList == std::vector<int>{ 0, 10 });
+
+	// The remaining events are processed before the new events.
+	queue.enqueue(1, 5);
+	REQUIRE(queue.processN(3));
+	REQUIRE(dataList == std::vector<int>{ 0, 10, 2, 30, 4 });
+
+	REQUIRE(queue.processN(100));
+	REQUIRE(dataList == std::vector<int>{ 0, 10, 2, 30, 4, 5 });
+	REQUIRE(queue.emptyQueue());
+}
+
+TEST_CASE("EventQueue, processFor")
+{
+	eventpp::EventQueue<int, void (int)> queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](int n) {
+		dataList.push_back(n);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	});
+
+	constexpr int itemCount = 100;
+	for(int i = 0; i < itemCount; ++i) {
+		queue.enqueue(1, i);
+	}
+
+	REQUIRE(queue.processFor(std::chrono::milliseconds(20)));
+	const int processedCount = (int)dataList.size();
+	// The clock is checked every 16 events.
+	REQUIRE(processedCount >= 16);
+	REQUIRE(processedCount < itemCount);
+	REQUIRE(processedCount % 16 == 0);
+
+	REQUIRE(queue.processFor(std::chrono::seconds(10)));
+	std::vector<int> expectedList(itemCount);
+	std::iota(expectedList.begin(), expectedList.end(), 0);
+	REQUIRE(dataList == expectedList);
+}
+
+TEST_CASE("EventQueue, StagingBuffer")
+{
+	using EQ = eventpp::EventQueue<int, void (int)>;
+	EQ queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](int n) {
+		dataList.push_back(n);
+	});
+
+	SECTION("publish at threshold") {
+		EQ::StagingBuffer stagingBuffer(&queue, 3);
+		stagingBuffer.enqueue(1, 1);
+		stagingBuffer.enqueue(1, 2);
+		REQUIRE(queue.emptyQueue());
+		stagingBuffer.enqueue(1, 3);
+		REQUIRE(! queue.emptyQueue());
+		stagingBuffer.enqueue(1, 4);
+
+		REQUIRE(queue.processOne());
+		REQUIRE(dataList == std::vector<int>{ 1 });
+		// process doesn't see the events which are not published.
+		REQUIRE(queue.process());
+		REQUIRE(dataList == std::vector<int>{ 1, 2, 3 });
+		REQUIRE(queue.emptyQueue());
+
+		REQUIRE(stagingBuffer.flush() == 1);
+		REQUIRE(stagingBuffer.flush() == 0);
+		REQUIRE(queue.process());
+		REQUIRE(dataList == std::vector<int>{ 1, 2, 3, 4 });
+	}
+
+	SECTION("flush") {
+		EQ::StagingBuffer stagingBuffer(&queue);
+		stagingBuffer.enqueue(1, 1);
+		stagingBuffer.enqueue(queue.getEventToken(1), 2);
+		REQUIRE(queue.emptyQueue());
+		REQUIRE(stagingBuffer.flush() == 2);
+		REQUIRE(! queue.emptyQueue());
+		queue.enqueue(1, 3);
+		REQUIRE(queue.process());
+		REQUIRE(dataList == std::vector<int>{ 1, 2, 3 });
+	}
+
+	SECTION("destructor flushes") {
+		{
+			EQ::StagingBuffer stagingBuffer(&queue);
+			stagingBuffer.enqueue(1, 1);
+		}
+		REQUIRE(queue.process());
+		REQUIRE(dataList == std::vector<int>{ 1 });
+	}
+}
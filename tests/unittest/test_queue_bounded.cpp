@@ -0,0 +1,375 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/eventqueue.h"
+#include "eventpp/hetereventqueue.h"
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <type_traits>
+
+namespace {
+
+template <typename QueueFull>
+struct BoundedPolicies
+{
+	using QueueCapacity = eventpp::QueueBounded<3, QueueFull>;
+};
+
+} //unnamed namespace
+
+TEST_CASE("EventQueue, QueueBounded, enqueue returns bool only if the queue is bounded")
+{
+	using BoundedQueue = eventpp::EventQueue<int, void (int), BoundedPolicies<eventpp::QueueFullFail> >;
+	using UnboundedQueue = eventpp::EventQueue<int, void (int)>;
+
+	REQUIRE(std::is_same<decltype(std::declval<BoundedQueue &>().enqueue(1, 2)), bool>::value);
+	REQUIRE(std::is_same<decltype(std::declval<UnboundedQueue &>().enqueue(1, 2)), void>::value);
+
+	UnboundedQueue queue;
+	REQUIRE(queue.getDroppedEventCount() == 0);
+	REQUIRE(queue.getBlockedEnqueueCount() == 0);
+	REQUIRE(queue.getOverflowEventCount() == 0);
+}
+
+TEST_CASE("EventQueue, QueueBounded, QueueFullFail")
+{
+	eventpp::EventQueue<int, void (int), BoundedPolicies<eventpp::QueueFullFail> > queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](const int value) {
+		dataList.push_back(value);
+	});
+
+	REQUIRE(queue.enqueue(1, 1));
+	REQUIRE(queue.enqueue(1, 2));
+	REQUIRE(queue.enqueue(1, 3));
+	REQUIRE(! queue.enqueue(1, 4));
+	REQUIRE(queue.getDroppedEventCount() == 1);
+
+	REQUIRE(queue.processOne());
+	REQUIRE(queue.enqueue(1, 5));
+	REQUIRE(! queue.enqueue(1, 6));
+	REQUIRE(queue.getDroppedEventCount() == 2);
+
+	queue.process();
+	REQUIRE(dataList == std::vector<int> { 1, 2, 3, 5 });
+
+	// The queue is empty after clearEvents.
+	REQUIRE(queue.enqueue(1, 7));
+	queue.clearEvents();
+	REQUIRE(queue.enqueue(1, 8));
+	REQUIRE(queue.enqueue(1, 9));
+	REQUIRE(queue.enqueue(1, 10));
+	REQUIRE(! queue.enqueue(1, 11));
+	REQUIRE(queue.getBlockedEnqueueCount() == 0);
+}
+
+TEST_CASE("EventQueue, QueueBounded, QueueFullFail, enqueueBulk returns the enqueued count")
+{
+	eventpp::EventQueue<int, void (int), BoundedPolicies<eventpp::QueueFullFail> > queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](const int value) {
+		dataList.push_back(value);
+	});
+
+	REQUIRE(queue.enqueue(1, 1));
+	REQUIRE(queue.enqueueBulk([](decltype(queue)::BulkEnqueuer & enqueuer) {
+		for(int i = 2; i <= 5; ++i) {
+			enqueuer.enqueue(1, i);
+		}
+	}) == 2);
+	REQUIRE(queue.getDroppedEventCount() == 2);
+
+	const int eventList[] = { 6, 7 };
+	REQUIRE(queue.enqueueRange(std::begin(eventList), std::end(eventList)) == 0);
+	REQUIRE(queue.getDroppedEventCount() == 4);
+
+	queue.process();
+	REQUIRE(dataList == std::vector<int> { 1, 2, 3 });
+	REQUIRE(queue.enqueueRange(std::begin(eventList), std::end(eventList)) == 2);
+}
+
+TEST_CASE("EventQueue, QueueBounded, QueueFullDropOldest")
+{
+	eventpp::EventQueue<int, void (int), BoundedPolicies<eventpp::QueueFullDropOldest> > queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](const int value) {
+		dataList.push_back(value);
+	});
+
+	for(int i = 1; i <= 5; ++i) {
+		REQUIRE(queue.enqueue(1, i));
+	}
+	REQUIRE(queue.getDroppedEventCount() == 2);
+
+	queue.process();
+	REQUIRE(dataList == std::vector<int> { 3, 4, 5 });
+
+	dataList.clear();
+	// The events dropped to make room were enqueued, so they are counted.
+	REQUIRE(queue.enqueueBulk([](decltype(queue)::BulkEnqueuer & enqueuer) {
+		for(int i = 6; i <= 10; ++i) {
+			enqueuer.enqueue(1, i);
+		}
+	}) == 5);
+	REQUIRE(queue.getDroppedEventCount() == 4);
+	queue.process();
+	REQUIRE(dataList == std::vector<int> { 8, 9, 10 });
+}
+
+TEST_CASE("EventQueue, QueueBounded, the events put back are counted")
+{
+	eventpp::EventQueue<int, void (int), BoundedPolicies<eventpp::QueueFullFail> > queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](const int value) {
+		dataList.push_back(value);
+	});
+	queue.appendListener(2, [&dataList](const int value) {
+		dataList.push_back(value);
+	});
+
+	REQUIRE(queue.enqueue(1, 1));
+	REQUIRE(queue.enqueue(2, 2));
+	REQUIRE(queue.enqueue(1, 3));
+
+	REQUIRE(queue.processN(1));
+	REQUIRE(queue.enqueue(2, 4));
+	REQUIRE(! queue.enqueue(2, 5));
+
+	REQUIRE(queue.processIf([](const int value) -> bool { return value == 2; }));
+	REQUIRE(queue.enqueue(1, 6));
+	REQUIRE(! queue.enqueue(1, 7));
+
+	queue.process();
+	REQUIRE(dataList == std::vector<int> { 1, 2, 3, 4, 6 });
+}
+
+TEST_CASE("EventQueue, QueueBounded, QueueFullBlock")
+{
+	using EQ = eventpp::EventQueue<int, void (int), BoundedPolicies<eventpp::QueueFullBlock> >;
+	EQ queue;
+
+	constexpr int itemCount = 1000;
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](const int value) {
+		dataList.push_back(value);
+	});
+
+	std::thread producer([&queue]() {
+		for(int i = 0; i < itemCount; ++i) {
+			queue.enqueue(1, i);
+		}
+	});
+
+	while(dataList.size() < itemCount) {
+		queue.wait();
+		queue.process();
+	}
+	producer.join();
+
+	REQUIRE(queue.getDroppedEventCount() == 0);
+	REQUIRE(queue.getBlockedEnqueueCount() > 0);
+	for(int i = 0; i < itemCount; ++i) {
+		REQUIRE(dataList[i] == i);
+	}
+}
+
+TEST_CASE("EventQueue, QueueBounded, QueueFullBlockFor")
+{
+	eventpp::EventQueue<int, void (int), BoundedPolicies<eventpp::QueueFullBlockFor<10> > > queue;
+
+	REQUIRE(queue.enqueue(1, 1));
+	REQUIRE(queue.enqueue(1, 2));
+	REQUIRE(queue.enqueue(1, 3));
+	REQUIRE(! queue.enqueue(1, 4));
+	REQUIRE(queue.getDroppedEventCount() == 1);
+	REQUIRE(queue.getBlockedEnqueueCount() == 1);
+
+	std::atomic<bool> queued(false);
+	std::thread producer([&queue, &queued]() {
+		queued = queue.enqueue(1, 5);
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	queue.processOne();
+	producer.join();
+	// The producer may time out before the event is processed on a loaded machine.
+	REQUIRE(queue.getDroppedEventCount() == (queued ? 1u : 2u));
+}
+
+TEST_CASE("EventQueue, QueueBounded, the consumer never blocks")
+{
+	using EQ = eventpp::EventQueue<int, void (int), BoundedPolicies<eventpp::QueueFullBlock> >;
+	EQ queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](const int value) {
+		dataList.push_back(value);
+	});
+
+	// The due delayed events are put in the queue by the consumer, it exceeds the capacity instead of blocking.
+	// The delay is long enough that the events are not due when they are enqueued, which would block.
+	for(int i = 1; i <= 5; ++i) {
+		queue.enqueueAfter(std::chrono::milliseconds(20), 1, i);
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	queue.process();
+	REQUIRE(dataList == std::vector<int> { 1, 2, 3, 4, 5 });
+	REQUIRE(queue.getBlockedEnqueueCount() == 0);
+	REQUIRE(queue.getOverflowEventCount() == 2);
+	REQUIRE(queue.getDroppedEventCount() == 0);
+}
+
+TEST_CASE("EventQueue, QueueBounded, the due delayed events follow QueueFullFail and QueueFullDropOldest")
+{
+	SECTION("QueueFullFail") {
+		eventpp::EventQueue<int, void (int), BoundedPolicies<eventpp::QueueFullFail> > queue;
+
+		std::vector<int> dataList;
+		queue.appendListener(1, [&dataList](const int value) {
+			dataList.push_back(value);
+		});
+
+		for(int i = 1; i <= 5; ++i) {
+			queue.enqueueAfter(std::chrono::milliseconds(1), 1, i);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		queue.process();
+		REQUIRE(dataList == std::vector<int> { 1, 2, 3 });
+		REQUIRE(queue.getDroppedEventCount() == 2);
+		REQUIRE(queue.getOverflowEventCount() == 0);
+	}
+
+	SECTION("QueueFullDropOldest") {
+		eventpp::EventQueue<int, void (int), BoundedPolicies<eventpp::QueueFullDropOldest> > queue;
+
+		std::vector<int> dataList;
+		queue.appendListener(1, [&dataList](const int value) {
+			dataList.push_back(value);
+		});
+
+		for(int i = 1; i <= 5; ++i) {
+			queue.enqueueAfter(std::chrono::milliseconds(1), 1, i);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		queue.process();
+		REQUIRE(dataList == std::vector<int> { 3, 4, 5 });
+		REQUIRE(queue.getDroppedEventCount() == 2);
+		REQUIRE(queue.getOverflowEventCount() == 0);
+	}
+}
+
+TEST_CASE("EventQueue, QueueBounded, StagingBuffer follows the QueueFull policy")
+{
+	using EQ = eventpp::EventQueue<int, void (int), BoundedPolicies<eventpp::QueueFullFail> >;
+	EQ queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](const int value) {
+		dataList.push_back(value);
+	});
+
+	{
+		EQ::StagingBuffer stagingBuffer(&queue);
+		for(int i = 1; i <= 5; ++i) {
+			stagingBuffer.enqueue(1, i);
+		}
+		REQUIRE(stagingBuffer.flush() == 3);
+		REQUIRE(queue.getDroppedEventCount() == 2);
+
+		queue.process();
+		REQUIRE(dataList == std::vector<int> { 1, 2, 3 });
+
+		// The rejected items are reused by the buffer.
+		stagingBuffer.enqueue(1, 6);
+	}
+	queue.process();
+	REQUIRE(dataList == std::vector<int> { 1, 2, 3, 6 });
+}
+
+TEST_CASE("EventQueue, QueueBounded with QueueCoalesceLastValue")
+{
+	struct Policies
+	{
+		using QueueCapacity = eventpp::QueueBounded<2, eventpp::QueueFullFail>;
+		using QueueCoalesce = eventpp::QueueCoalesceLastValue;
+	};
+	eventpp::EventQueue<int, void (int), Policies> queue;
+
+	std::vector<int> dataList;
+	for(int e = 1; e <= 3; ++e) {
+		queue.appendListener(e, [&dataList](const int value) {
+			dataList.push_back(value);
+		});
+	}
+
+	REQUIRE(queue.enqueue(1, 1));
+	REQUIRE(queue.enqueue(2, 2));
+	// Replacing a pending event doesn't need room.
+	REQUIRE(queue.enqueue(1, 3));
+	REQUIRE(! queue.enqueue(3, 4));
+	REQUIRE(queue.getDroppedEventCount() == 1);
+
+	queue.process();
+	REQUIRE(dataList == std::vector<int> { 3, 2 });
+}
+
+TEST_CASE("HeterEventQueue, QueueBounded")
+{
+	eventpp::HeterEventQueue<int, eventpp::HeterTuple<void (int), void (int, int)>, BoundedPolicies<eventpp::QueueFullFail> > queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](const int value) {
+		dataList.push_back(value);
+	});
+	queue.appendListener(2, [&dataList](const int a, const int b) {
+		dataList.push_back(a + b);
+	});
+
+	REQUIRE(queue.enqueue(1, 1));
+	REQUIRE(queue.enqueue(2, 2, 3));
+	REQUIRE(queue.enqueue(1, 6));
+	REQUIRE(! queue.enqueue(2, 7, 8));
+	REQUIRE(queue.getDroppedEventCount() == 1);
+
+	REQUIRE(queue.processN(1));
+	REQUIRE(queue.enqueue(1, 9));
+	REQUIRE(! queue.enqueue(1, 10));
+
+	queue.process();
+	REQUIRE(dataList == std::vector<int> { 1, 5, 6, 9 });
+}
+
+TEST_CASE("HeterEventQueue, QueueBounded, QueueFullDropOldest")
+{
+	eventpp::HeterEventQueue<int, eventpp::HeterTuple<void (int)>, BoundedPolicies<eventpp::QueueFullDropOldest> > queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](const int value) {
+		dataList.push_back(value);
+	});
+
+	for(int i = 1; i <= 5; ++i) {
+		REQUIRE(queue.enqueue(1, i));
+	}
+	REQUIRE(queue.getDroppedEventCount() == 2);
+
+	queue.process();
+	REQUIRE(dataList == std::vector<int> { 3, 4, 5 });
+}
@@ -0,0 +1,168 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/eventqueue.h"
+#include "eventpp/utilities/chunkedqueuelist.h"
+
+#include <thread>
+#include <memory>
+#include <vector>
+#include <string>
+
+namespace {
+
+template <typename List>
+std::vector<int> listToVector(const List & list)
+{
+	std::vector<int> result;
+	for(auto it = list.begin(); it != list.end(); ++it) {
+		result.push_back(*it);
+	}
+	return result;
+}
+
+} //unnamed namespace
+
+TEST_CASE("ChunkedQueueList, emplace_back and splice")
+{
+	using List = eventpp::ChunkedQueueList<int, 4>;
+	List a;
+	List b;
+
+	REQUIRE(a.empty());
+	for(int i = 0; i < 10; ++i) {
+		a.emplace_back(i);
+	}
+	REQUIRE(! a.empty());
+	REQUIRE(a.front() == 0);
+	REQUIRE(listToVector(a) == std::vector<int>{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 });
+
+	b.splice(b.end(), a, a.begin());
+	REQUIRE(listToVector(a) == std::vector<int>{ 1, 2, 3, 4, 5, 6, 7, 8, 9 });
+	REQUIRE(listToVector(b) == std::vector<int>{ 0 });
+
+	auto it = a.begin();
+	++it;
+	++it;
+	b.splice(b.begin(), a, it);
+	REQUIRE(listToVector(a) == std::vector<int>{ 1, 2, 4, 5, 6, 7, 8, 9 });
+	REQUIRE(listToVector(b) == std::vector<int>{ 3, 0 });
+
+	b.splice(b.end(), a);
+	REQUIRE(a.empty());
+	REQUIRE(listToVector(b) == std::vector<int>{ 3, 0, 1, 2, 4, 5, 6, 7, 8, 9 });
+
+	a.emplace_back(100);
+	a.splice(a.begin(), b);
+	REQUIRE(b.empty());
+	REQUIRE(listToVector(a) == std::vector<int>{ 3, 0, 1, 2, 4, 5, 6, 7, 8, 9, 100 });
+
+	b.emplace_back(200);
+	std::swap(a, b);
+	REQUIRE(listToVector(a) == std::vector<int>{ 200 });
+	REQUIRE(listToVector(b) == std::vector<int>{ 3, 0, 1, 2, 4, 5, 6, 7, 8, 9, 100 });
+	a.swap(b);
+	REQUIRE(listToVector(a) == std::vector<int>{ 3, 0, 1, 2, 4, 5, 6, 7, 8, 9, 100 });
+	REQUIRE(listToVector(b) == std::vector<int>{ 200 });
+}
+
+TEST_CASE("ChunkedQueueList, items are destroyed")
+{
+	using List = eventpp::ChunkedQueueList<std::shared_ptr<int>, 4>;
+
+	std::vector<std::weak_ptr<int> > ptrList;
+	{
+		List a;
+		List b;
+		for(int i = 0; i < 10; ++i) {
+			auto ptr = std::make_shared<int>(i);
+			ptrList.push_back(ptr);
+			a.emplace_back(ptr);
+		}
+		b.splice(b.end(), a, a.begin());
+		a.clear();
+		REQUIRE(a.empty());
+		REQUIRE(ptrList[0].lock());
+		REQUIRE(! ptrList[1].lock());
+	}
+	REQUIRE(checkAllWeakPtrAreFreed(ptrList));
+}
+
+struct ChunkedQueueListPolicies
+{
+	template <typename Item>
+	using QueueList = eventpp::ChunkedQueueList<Item, 8>;
+};
+
+TEST_CASE("EventQueue, ChunkedQueueList")
+{
+	using EQ = eventpp::EventQueue<int, void (int, const std::string &), ChunkedQueueListPolicies>;
+	EQ queue;
+
+	std::vector<std::string> dataList;
+	for(int i = 1; i <= 3; ++i) {
+		queue.appendListener(i, [&dataList](int e, const std::string & s) {
+			dataList.push_back(std::to_string(e) + s);
+		});
+	}
+
+	for(int k = 0; k < 5; ++k) {
+		dataList.clear();
+		for(int i = 0; i < 10; ++i) {
+			queue.enqueue(i % 3 + 1, std::to_string(i));
+		}
+		REQUIRE(queue.processOne());
+		REQUIRE(queue.processIf([](int e, const std::string &) -> bool {
+			return e == 2;
+		}));
+		REQUIRE(queue.process());
+		REQUIRE(queue.emptyQueue());
+		REQUIRE(dataList == std::vector<std::string>{
+			"10", "21", "24", "27", "32", "13", "35", "16", "38", "19"
+		});
+	}
+}
+
+TEST_CASE("EventQueue, ChunkedQueueList, multi threading")
+{
+	using EQ = eventpp::EventQueue<int, void (int), ChunkedQueueListPolicies>;
+	EQ queue;
+
+	constexpr int threadCount = 16;
+	constexpr int dataCountPerThread = 1024 * 4;
+	constexpr int itemCount = threadCount * dataCountPerThread;
+
+	std::vector<int> dataList(itemCount);
+	queue.appendListener(1, [&dataList](int index) {
+		++dataList[index];
+	});
+
+	std::vector<std::thread> threadList;
+	for(int i = 0; i < threadCount; ++i) {
+		threadList.emplace_back([i, dataCountPerThread, &queue]() {
+			for(int k = i * dataCountPerThread; k < (i + 1) * dataCountPerThread; ++k) {
+				queue.enqueue(1, k);
+			}
+			for(int k = 0; k < 10; ++k) {
+				queue.process();
+			}
+		});
+	}
+	for(auto & thread : threadList) {
+		thread.join();
+	}
+	queue.process();
+
+	REQUIRE(dataList == std::vector<int>(itemCount, 1));
+}
@@ -0,0 +1,261 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/eventqueue.h"
+
+#include <thread>
+#include <vector>
+#include <string>
+#include <utility>
+
+namespace {
+
+struct CoalescePolicies
+{
+	using QueueCoalesce = eventpp::QueueCoalesceLastValue;
+};
+
+struct CoalesceByEntityPolicies
+{
+	using QueueCoalesce = eventpp::QueueCoalesceLastValue;
+
+	// The key is the event and the entity id.
+	static std::pair<int, int> getCoalesceKey(const int e, const int entity, const int /*value*/) {
+		return std::make_pair(e, entity);
+	}
+};
+
+} //unnamed namespace
+
+TEST_CASE("EventQueue, QueueCoalesceLastValue, the last value wins")
+{
+	eventpp::EventQueue<int, void (const std::string &), CoalescePolicies> queue;
+
+	std::vector<std::pair<int, std::string> > dataList;
+	queue.appendListener(1, [&dataList](const std::string & s) {
+		dataList.push_back(std::make_pair(1, s));
+	});
+	queue.appendListener(2, [&dataList](const std::string & s) {
+		dataList.push_back(std::make_pair(2, s));
+	});
+
+	queue.enqueue(1, "a");
+	queue.enqueue(2, "b");
+	queue.enqueue(1, "c");
+	queue.enqueue(1, "d");
+	queue.enqueue(2, "e");
+
+	queue.process();
+	// The replaced event keeps its position.
+	REQUIRE(dataList == std::vector<std::pair<int, std::string> > {
+		{ 1, "d" }, { 2, "e" }
+	});
+
+	// The processed events don't coalesce the new events.
+	dataList.clear();
+	queue.enqueue(2, "f");
+	queue.enqueue(1, "g");
+	queue.process();
+	REQUIRE(dataList == std::vector<std::pair<int, std::string> > {
+		{ 2, "f" }, { 1, "g" }
+	});
+}
+
+TEST_CASE("EventQueue, QueueCoalesceLastValue, getCoalesceKey")
+{
+	eventpp::EventQueue<int, void (int, int), CoalesceByEntityPolicies> queue;
+
+	std::vector<std::pair<int, int> > dataList;
+	queue.appendListener(1, [&dataList](const int entity, const int value) {
+		dataList.push_back(std::make_pair(entity, value));
+	});
+
+	for(int i = 0; i < 100; ++i) {
+		queue.enqueue(1, i % 3, i);
+	}
+
+	queue.process();
+	REQUIRE(dataList == std::vector<std::pair<int, int> > {
+		{ 0, 99 }, { 1, 97 }, { 2, 98 }
+	});
+}
+
+TEST_CASE("EventQueue, QueueCoalesceLastValue, enqueueWith")
+{
+	eventpp::EventQueue<int, void (int, int), CoalesceByEntityPolicies> queue;
+
+	std::vector<std::pair<int, int> > dataList;
+	queue.appendListener(1, [&dataList](const int entity, const int value) {
+		dataList.push_back(std::make_pair(entity, value));
+	});
+
+	// The key is got after the arguments are filled.
+	for(int i = 0; i < 10; ++i) {
+		queue.enqueueWith(1, [i](int & entity, int & value) {
+			entity = i % 2;
+			value = i;
+		});
+	}
+
+	queue.process();
+	REQUIRE(dataList == std::vector<std::pair<int, int> > {
+		{ 0, 8 }, { 1, 9 }
+	});
+}
+
+TEST_CASE("EventQueue, QueueCoalesceLastValue, processOne, takeEvent, clearEvents")
+{
+	eventpp::EventQueue<int, void (int), CoalescePolicies> queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](const int value) {
+		dataList.push_back(value);
+	});
+
+	queue.enqueue(1, 1);
+	queue.enqueue(1, 2);
+	REQUIRE(queue.processOne());
+	REQUIRE(queue.emptyQueue());
+	REQUIRE(dataList == std::vector<int> { 2 });
+
+	queue.enqueue(1, 3);
+	decltype(queue)::QueuedEvent queuedEvent;
+	REQUIRE(queue.takeEvent(&queuedEvent));
+	REQUIRE(queuedEvent.getArgument<0>() == 3);
+	REQUIRE(queue.emptyQueue());
+
+	queue.enqueue(1, 4);
+	queue.clearEvents();
+	queue.enqueue(1, 5);
+	queue.enqueue(1, 6);
+	queue.process();
+	REQUIRE(dataList == std::vector<int> { 2, 6 });
+}
+
+TEST_CASE("EventQueue, QueueCoalesceLastValue, processIf and processN put back the events")
+{
+	eventpp::EventQueue<int, void (int), CoalescePolicies> queue;
+
+	std::vector<std::pair<int, int> > dataList;
+	queue.appendListener(1, [&dataList](const int value) {
+		dataList.push_back(std::make_pair(1, value));
+	});
+	queue.appendListener(2, [&dataList, &queue](const int value) {
+		dataList.push_back(std::make_pair(2, value));
+		if(value == 5) {
+			queue.enqueue(1, 100);
+		}
+	});
+
+	queue.enqueue(1, 1);
+	queue.enqueue(2, 2);
+	REQUIRE(queue.processIf([](const int value) -> bool { return value == 1; }));
+	REQUIRE(dataList == std::vector<std::pair<int, int> > { { 1, 1 } });
+
+	// Event 2 is pending again, so it's coalesced.
+	queue.enqueue(2, 3);
+	queue.enqueue(1, 4);
+	REQUIRE(queue.processN(1));
+	REQUIRE(dataList == std::vector<std::pair<int, int> > { { 1, 1 }, { 2, 3 } });
+
+	// The listener enqueues event 1 while the event 1 with 6 is taken for processIf.
+	// The event 1 which is put back is older than the new one, so it's dropped.
+	queue.enqueue(2, 5);
+	queue.enqueue(1, 6);
+	REQUIRE(queue.processIf([](const int value) -> bool { return value == 5; }));
+	queue.process();
+	REQUIRE(dataList == std::vector<std::pair<int, int> > {
+		{ 1, 1 }, { 2, 3 }, { 2, 5 }, { 1, 100 }
+	});
+}
+
+TEST_CASE("EventQueue, QueueCoalesceLastValue, enqueueBulk and StagingBuffer")
+{
+	using EQ = eventpp::EventQueue<int, void (int), CoalescePolicies>;
+	EQ queue;
+
+	std::vector<std::pair<int, int> > dataList;
+	for(int e = 0; e < 3; ++e) {
+		queue.appendListener(e, [&dataList, e](const int value) {
+			dataList.push_back(std::make_pair(e, value));
+		});
+	}
+
+	queue.enqueue(0, 1);
+	queue.enqueueBulk([](EQ::BulkEnqueuer & enqueuer) {
+		enqueuer.enqueue(1, 2);
+		enqueuer.enqueue(0, 3);
+		enqueuer.enqueue(1, 4);
+	});
+
+	{
+		EQ::StagingBuffer stagingBuffer(&queue, 2);
+		stagingBuffer.enqueue(2, 5);
+		stagingBuffer.enqueue(1, 6);
+		stagingBuffer.enqueue(2, 7);
+	}
+
+	queue.process();
+	REQUIRE(dataList == std::vector<std::pair<int, int> > {
+		{ 0, 3 }, { 1, 6 }, { 2, 7 }
+	});
+}
+
+TEST_CASE("EventQueue, QueueCoalesceLastValue, multiple threads")
+{
+	using EQ = eventpp::EventQueue<int, void (int), CoalescePolicies>;
+	EQ queue;
+
+	constexpr int threadCount = 4;
+	constexpr int eventCount = 256;
+	constexpr int iterateCount = 100;
+
+	std::vector<int> lastValueList(eventCount, -1);
+	std::vector<int> dispatchCountList(eventCount, 0);
+	for(int e = 0; e < eventCount; ++e) {
+		queue.appendListener(e, [&lastValueList, &dispatchCountList, e](const int value) {
+			lastValueList[e] = value;
+			++dispatchCountList[e];
+		});
+	}
+
+	std::vector<std::thread> threadList;
+	for(int t = 0; t < threadCount; ++t) {
+		threadList.emplace_back([&queue, t]() {
+			for(int i = 0; i < iterateCount; ++i) {
+				for(int e = 0; e < eventCount; ++e) {
+					queue.enqueue(e, i * threadCount + t);
+				}
+			}
+		});
+	}
+
+	// Process while producing, then drain.
+	for(int i = 0; i < 50; ++i) {
+		queue.process();
+		std::this_thread::yield();
+	}
+	for(std::thread & thread : threadList) {
+		thread.join();
+	}
+	queue.process();
+	REQUIRE(queue.emptyQueue());
+
+	for(int e = 0; e < eventCount; ++e) {
+		// The last dispatched value is the last value of one of the threads.
+		REQUIRE(lastValueList[e] / threadCount == iterateCount - 1);
+		REQUIRE(dispatchCountList[e] >= 1);
+		REQUIRE(dispatchCountList[e] <= threadCount * iterateCount);
+	}
+}
@@ -0,0 +1,251 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/eventqueue.h"
+#include "eventpp/utilities/indexedqueuelist.h"
+
+#include <thread>
+#include <vector>
+#include <string>
+#include <utility>
+
+namespace {
+
+struct IndexedPolicies
+{
+	template <typename Item>
+	using QueueList = eventpp::IndexedQueueList<Item>;
+};
+
+struct IndexedCoalesceBoundedPolicies
+{
+	template <typename Item>
+	using QueueList = eventpp::IndexedQueueList<Item>;
+	using QueueCoalesce = eventpp::QueueCoalesceLastValue;
+	using QueueCapacity = eventpp::QueueBounded<2, eventpp::QueueFullFail>;
+};
+
+// No std::hash, the lanes are in std::map.
+struct OrderedEvent
+{
+	int id;
+
+	OrderedEvent() : id(0) {
+	}
+
+	OrderedEvent(const int id) : id(id) {
+	}
+
+	bool operator < (const OrderedEvent & other) const {
+		return id < other.id;
+	}
+
+	bool operator == (const OrderedEvent & other) const {
+		return id == other.id;
+	}
+};
+
+using DataList = std::vector<std::pair<int, int> >;
+
+template <typename Queue>
+void appendDataListeners(Queue & queue, DataList & dataList, const int eventCount)
+{
+	for(int e = 1; e <= eventCount; ++e) {
+		queue.appendListener(e, [&dataList, e](const int value) {
+			dataList.push_back(std::make_pair(e, value));
+		});
+	}
+}
+
+template <typename Policies>
+void doTestProcessEvent()
+{
+	eventpp::EventQueue<int, void (int), Policies> queue;
+	DataList dataList;
+	appendDataListeners(queue, dataList, 3);
+
+	queue.enqueue(1, 1);
+	queue.enqueue(2, 2);
+	queue.enqueue(1, 3);
+	queue.enqueue(3, 4);
+	queue.enqueue(2, 5);
+	queue.enqueue(1, 6);
+
+	REQUIRE(queue.processEvent(1));
+	REQUIRE(dataList == DataList { { 1, 1 }, { 1, 3 }, { 1, 6 } });
+	REQUIRE(! queue.processEvent(1));
+	REQUIRE(! queue.processEvent(4));
+
+	queue.clearEvents(3);
+	queue.enqueue(1, 7);
+
+	dataList.clear();
+	REQUIRE(queue.process());
+	REQUIRE(dataList == DataList { { 2, 2 }, { 2, 5 }, { 1, 7 } });
+	REQUIRE(queue.emptyQueue());
+}
+
+} //unnamed namespace
+
+TEST_CASE("EventQueue, IndexedQueueList, processEvent and clearEvents(event)")
+{
+	doTestProcessEvent<IndexedPolicies>();
+}
+
+TEST_CASE("EventQueue, std::list, processEvent and clearEvents(event)")
+{
+	doTestProcessEvent<eventpp::DefaultPolicies>();
+}
+
+TEST_CASE("EventQueue, IndexedQueueList, keeps the order")
+{
+	eventpp::EventQueue<int, void (int), IndexedPolicies> queue;
+	DataList dataList;
+	appendDataListeners(queue, dataList, 4);
+
+	DataList expectedList;
+	for(int i = 0; i < 100; ++i) {
+		const int e = i % 4 + 1;
+		queue.enqueue(e, i);
+		expectedList.push_back(std::make_pair(e, i));
+	}
+	queue.process();
+	REQUIRE(dataList == expectedList);
+
+	// The recycled items are indexed again with the new events.
+	dataList.clear();
+	for(int i = 0; i < 100; ++i) {
+		queue.enqueue(4 - i % 4, i);
+	}
+	REQUIRE(queue.processEvent(2));
+	REQUIRE(dataList.size() == 25);
+	for(std::size_t i = 0; i < dataList.size(); ++i) {
+		REQUIRE(dataList[i] == std::make_pair(2, static_cast<int>(i * 4 + 2)));
+	}
+}
+
+TEST_CASE("EventQueue, IndexedQueueList, the events put back keep their lanes")
+{
+	eventpp::EventQueue<int, void (int), IndexedPolicies> queue;
+	DataList dataList;
+	appendDataListeners(queue, dataList, 2);
+
+	queue.enqueue(1, 1);
+	queue.enqueue(2, 2);
+	queue.enqueue(1, 3);
+	queue.enqueue(2, 4);
+
+	REQUIRE(queue.processN(1));
+	REQUIRE(dataList == DataList { { 1, 1 } });
+
+	queue.enqueue(1, 5);
+	REQUIRE(queue.processIf([](const int value) -> bool { return value == 4; }));
+	REQUIRE(dataList == DataList { { 1, 1 }, { 2, 4 } });
+
+	queue.enqueue(2, 6);
+	REQUIRE(queue.processEvent(1));
+	REQUIRE(dataList == DataList { { 1, 1 }, { 2, 4 }, { 1, 3 }, { 1, 5 } });
+
+	REQUIRE(queue.processEvent(2));
+	REQUIRE(dataList == DataList { { 1, 1 }, { 2, 4 }, { 1, 3 }, { 1, 5 }, { 2, 2 }, { 2, 6 } });
+	REQUIRE(queue.emptyQueue());
+}
+
+TEST_CASE("EventQueue, IndexedQueueList, event without std::hash")
+{
+	eventpp::EventQueue<OrderedEvent, void (const OrderedEvent &, int), IndexedPolicies> queue;
+	DataList dataList;
+	for(int e = 1; e <= 2; ++e) {
+		queue.appendListener(e, [&dataList](const OrderedEvent & event, const int value) {
+			dataList.push_back(std::make_pair(event.id, value));
+		});
+	}
+
+	queue.enqueue(OrderedEvent(2), 1);
+	queue.enqueue(OrderedEvent(1), 2);
+	queue.enqueue(OrderedEvent(2), 3);
+	REQUIRE(queue.processEvent(OrderedEvent(2)));
+	REQUIRE(dataList == DataList { { 2, 1 }, { 2, 3 } });
+	queue.process();
+	REQUIRE(dataList == DataList { { 2, 1 }, { 2, 3 }, { 1, 2 } });
+}
+
+TEST_CASE("EventQueue, IndexedQueueList, with QueueCoalesceLastValue and QueueBounded")
+{
+	eventpp::EventQueue<int, void (int), IndexedCoalesceBoundedPolicies> queue;
+	DataList dataList;
+	appendDataListeners(queue, dataList, 3);
+
+	REQUIRE(queue.enqueue(1, 1));
+	REQUIRE(queue.enqueue(2, 2));
+	REQUIRE(queue.enqueue(1, 3));
+	REQUIRE(! queue.enqueue(3, 4));
+
+	// The processed event is not pending any more, and it frees the room.
+	REQUIRE(queue.processEvent(1));
+	REQUIRE(queue.enqueue(1, 5));
+	REQUIRE(queue.enqueue(1, 6));
+	REQUIRE(! queue.enqueue(3, 7));
+
+	queue.process();
+	REQUIRE(dataList == DataList { { 1, 3 }, { 2, 2 }, { 1, 6 } });
+}
+
+TEST_CASE("EventQueue, IndexedQueueList, multiple threads")
+{
+	constexpr int threadCount = 4;
+	constexpr int eventCount = 8;
+	constexpr int itemCount = 1000;
+
+	eventpp::EventQueue<int, void (int), IndexedPolicies> queue;
+
+	std::vector<std::vector<int> > valueLists(eventCount);
+	for(int e = 0; e < eventCount; ++e) {
+		queue.appendListener(e, [&valueLists, e](const int value) {
+			valueLists[e].push_back(value);
+		});
+	}
+
+	std::vector<std::thread> threadList;
+	for(int t = 0; t < threadCount; ++t) {
+		threadList.emplace_back([&queue, t]() {
+			for(int i = 0; i < itemCount; ++i) {
+				queue.enqueue(i % eventCount, t * itemCount + i);
+			}
+		});
+	}
+
+	for(int i = 0; i < 100; ++i) {
+		queue.processEvent(i % eventCount);
+		std::this_thread::yield();
+	}
+	for(std::thread & thread : threadList) {
+		thread.join();
+	}
+	queue.process();
+	REQUIRE(queue.emptyQueue());
+
+	std::size_t totalCount = 0;
+	for(int e = 0; e < eventCount; ++e) {
+		// The events of each thread are dispatched in order.
+		std::vector<int> lastValueList(threadCount, -1);
+		for(const int value : valueLists[e]) {
+			REQUIRE(value % eventCount == e);
+			REQUIRE(value > lastValueList[value / itemCount]);
+			lastValueList[value / itemCount] = value;
+		}
+		totalCount += valueLists[e].size();
+	}
+	REQUIRE(totalCount == threadCount * itemCount);
+}
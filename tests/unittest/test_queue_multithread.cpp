@@ -212,3 +212,137 @@ TEST_CASE("EventQueue, multi threading, many threads wait")
 	REQUIRE(std::accumulate(dataList.begin(), dataList.end(), 0) == itemCount * 2);
 }
 
+
+namespace {
+
+template <typename QueueWait_>
+struct QueueWaitPolicies
+{
+	using QueueWait = QueueWait_;
+};
+
+template <typename QueueWait_, std::size_t Capacity>
+struct RingQueueWaitPolicies
+{
+	using QueueWait = QueueWait_;
+	using EventQueueStorage = eventpp::EventQueueStorageRingBuffer<Capacity>;
+};
+
+// The producer enqueues one event and waits until it's processed, so the consumer
+// goes to wait after each event, which exercises the hand-off between spinning,
+// parking and notifying.
+template <typename Policies>
+void doTestQueueWaitHandOff()
+{
+	using EQ = eventpp::EventQueue<int, void (int), Policies>;
+	EQ queue;
+
+	constexpr int stopEvent = 1;
+	constexpr int dataEvent = 2;
+	constexpr int itemCount = 1024 * 4;
+
+	std::atomic<int> processedCount(0);
+	bool shouldStop = false;
+	queue.appendListener(stopEvent, [&shouldStop](int) {
+		shouldStop = true;
+	});
+	queue.appendListener(dataEvent, [&processedCount](int) {
+		++processedCount;
+	});
+
+	std::thread consumer([&queue, &shouldStop]() {
+		while(! shouldStop) {
+			queue.wait();
+			queue.process();
+		}
+	});
+
+	for(int i = 0; i < itemCount; ++i) {
+		queue.enqueue(dataEvent, i);
+		while(processedCount.load() != i + 1) {
+			std::this_thread::yield();
+		}
+	}
+
+	queue.enqueue(stopEvent, 0);
+	consumer.join();
+
+	REQUIRE(processedCount.load() == itemCount);
+}
+
+} //unnamed namespace
+
+TEST_CASE("EventQueue, multi threading, QueueWaitSpinThenPark")
+{
+	doTestQueueWaitHandOff<QueueWaitPolicies<eventpp::QueueWaitSpinThenPark<> > >();
+	doTestQueueWaitHandOff<RingQueueWaitPolicies<eventpp::QueueWaitSpinThenPark<>, 64> >();
+}
+
+TEST_CASE("EventQueue, multi threading, QueueWaitSpinThenPark, always park")
+{
+	doTestQueueWaitHandOff<QueueWaitPolicies<eventpp::QueueWaitSpinThenPark<0, 0> > >();
+	doTestQueueWaitHandOff<RingQueueWaitPolicies<eventpp::QueueWaitSpinThenPark<0, 0>, 64> >();
+}
+
+TEST_CASE("EventQueue, QueueWaitSpinThenPark, waitFor")
+{
+	using EQ = eventpp::EventQueue<int, void (), QueueWaitPolicies<eventpp::QueueWaitSpinThenPark<> > >;
+	EQ queue;
+
+	REQUIRE(! queue.waitFor(std::chrono::nanoseconds(0)));
+	REQUIRE(! queue.waitFor(std::chrono::milliseconds(10)));
+	queue.enqueue(1);
+	REQUIRE(queue.waitFor(std::chrono::nanoseconds(0)));
+	REQUIRE(queue.waitFor(std::chrono::milliseconds(10)));
+
+	{
+		EQ::DisableQueueNotify disableNotify(&queue);
+		REQUIRE(! queue.waitFor(std::chrono::milliseconds(10)));
+	}
+	REQUIRE(queue.waitFor(std::chrono::milliseconds(10)));
+}
+
+TEST_CASE("EventQueue, multi threading, StagingBuffer keeps the order of each producer")
+{
+	using EQ = eventpp::EventQueue<int, void (int, int)>;
+	EQ queue;
+
+	constexpr int threadCount = 8;
+	constexpr int dataCountPerThread = 1024 * 16;
+
+	std::vector<int> lastDataList(threadCount, -1);
+	bool inOrder = true;
+	int processedCount = 0;
+	queue.appendListener(1, [&lastDataList, &inOrder, &processedCount](int thread, int data) {
+		if(data != lastDataList[thread] + 1) {
+			inOrder = false;
+		}
+		lastDataList[thread] = data;
+		++processedCount;
+	});
+
+	std::atomic<int> finishedCount(0);
+	std::vector<std::thread> threadList;
+	for(int i = 0; i < threadCount; ++i) {
+		threadList.emplace_back([i, dataCountPerThread, &queue, &finishedCount]() {
+			EQ::StagingBuffer stagingBuffer(&queue, 100);
+			for(int k = 0; k < dataCountPerThread; ++k) {
+				stagingBuffer.enqueue(1, i, k);
+			}
+			stagingBuffer.flush();
+			++finishedCount;
+		});
+	}
+
+	// The buffers are published at the threshold while the producers are running.
+	while(finishedCount.load() < threadCount) {
+		queue.process();
+	}
+	for(auto & thread : threadList) {
+		thread.join();
+	}
+	queue.process();
+
+	REQUIRE(inOrder);
+	REQUIRE(processedCount == threadCount * dataCountPerThread);
+}
@@ -17,6 +17,8 @@
 
 #include <vector>
 #include <numeric>
+#include <random>
+#include <algorithm>
 
 TEST_CASE("detectDataListOrder")
 {
@@ -146,3 +148,112 @@ TEST_CASE("EventQueue, ordered list, descend")
 	REQUIRE(detectDataListOrder(dataList.begin(), dataList.end()) == -1);
 }
 
+
+struct MyOrderedItem
+{
+	int priority;
+	int index;
+};
+
+struct MyCompareItemPriority
+{
+	template <typename T>
+	bool operator() (const T & a, const T & b) const {
+		return std::get<0>(a.arguments).priority > std::get<0>(b.arguments).priority;
+	}
+};
+
+struct MyPolicyItemPriority
+{
+	template <typename Item>
+	using QueueList = eventpp::OrderedQueueList<Item, MyCompareItemPriority >;
+};
+
+TEST_CASE("EventQueue, ordered list, equal items keep the enqueuing order")
+{
+	using EQ = eventpp::EventQueue<int, void (const MyOrderedItem &), MyPolicyItemPriority>;
+	EQ queue;
+
+	constexpr int count = 1024 * 4;
+	std::vector<MyOrderedItem> itemList;
+	std::mt19937 engine(3);
+	for(int i = 0; i < count; ++i) {
+		itemList.push_back(MyOrderedItem { (int)(engine() % 16), i });
+	}
+
+	std::vector<MyOrderedItem> dataList;
+	queue.appendListener(1, [&dataList](const MyOrderedItem & item) {
+		dataList.push_back(item);
+	});
+
+	for(const MyOrderedItem & item : itemList) {
+		queue.enqueue(1, item);
+	}
+	queue.process();
+
+	std::stable_sort(itemList.begin(), itemList.end(), [](const MyOrderedItem & a, const MyOrderedItem & b) {
+		return a.priority > b.priority;
+	});
+	REQUIRE(dataList.size() == itemList.size());
+	for(std::size_t i = 0; i < itemList.size(); ++i) {
+		REQUIRE(dataList[i].priority == itemList[i].priority);
+		REQUIRE(dataList[i].index == itemList[i].index);
+	}
+}
+
+TEST_CASE("EventQueue, ordered list, enqueue during processOne and processIf")
+{
+	using EQ = eventpp::EventQueue<int, void (const MyOrderedItem &), MyPolicyItemPriority>;
+	EQ queue;
+
+	std::vector<MyOrderedItem> dataList;
+	queue.appendListener(1, [&dataList](const MyOrderedItem & item) {
+		dataList.push_back(item);
+	});
+
+	queue.enqueue(1, MyOrderedItem { 1, 0 });
+	queue.enqueue(1, MyOrderedItem { 5, 1 });
+	queue.enqueue(1, MyOrderedItem { 3, 2 });
+	REQUIRE(queue.processOne());
+	REQUIRE(dataList.back().index == 1);
+
+	queue.enqueue(1, MyOrderedItem { 9, 3 });
+	queue.enqueue(1, MyOrderedItem { 3, 4 });
+	REQUIRE(queue.processOne());
+	REQUIRE(dataList.back().index == 3);
+
+	// The skipped items are older than the new items with the same priority.
+	queue.processIf([&queue](const MyOrderedItem & item) -> bool {
+		if(item.index == 2) {
+			queue.enqueue(1, MyOrderedItem { 3, 5 });
+		}
+		return item.priority != 3;
+	});
+	REQUIRE(dataList.back().index == 0);
+
+	queue.process();
+	REQUIRE(dataList.size() == 6);
+	REQUIRE(dataList[3].index == 2);
+	REQUIRE(dataList[4].index == 4);
+	REQUIRE(dataList[5].index == 5);
+}
+
+TEST_CASE("EventQueue, ordered list, enqueueBulk and takeEvent")
+{
+	using EQ = eventpp::EventQueue<int, void (const MyOrderedItem &), MyPolicyItemPriority>;
+	EQ queue;
+
+	queue.enqueue(1, MyOrderedItem { 2, 0 });
+	queue.enqueueBulk([](EQ::BulkEnqueuer & enqueuer) {
+		enqueuer.enqueue(1, MyOrderedItem { 1, 1 });
+		enqueuer.enqueue(1, MyOrderedItem { 3, 2 });
+		enqueuer.enqueue(1, MyOrderedItem { 2, 3 });
+	});
+
+	std::vector<int> indexList;
+	EQ::QueuedEvent queuedEvent;
+	while(queue.takeEvent(&queuedEvent)) {
+		indexList.push_back(std::get<0>(queuedEvent.arguments).index);
+	}
+	REQUIRE(indexList == std::vector<int> { 2, 0, 3, 1 });
+}
@@ -0,0 +1,582 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/eventqueue.h"
+
+#include <thread>
+#include <atomic>
+#include <numeric>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <iterator>
+
+TEST_CASE("EventQueue, ring buffer, process")
+{
+	struct MyPolicies
+	{
+		using EventQueueStorage = eventpp::EventQueueStorageRingBuffer<8>;
+	};
+	using EQ = eventpp::EventQueue<int, void (int, const std::string &), MyPolicies>;
+	EQ queue;
+
+	std::vector<std::string> dataList;
+	for(int i = 1; i <= 3; ++i) {
+		queue.appendListener(i, [&dataList](int e, const std::string & s) {
+			dataList.push_back(std::to_string(e) + s);
+		});
+	}
+
+	REQUIRE(queue.emptyQueue());
+	REQUIRE(! queue.process());
+
+	// Wrap around the ring a few times.
+	for(int k = 0; k < 5; ++k) {
+		dataList.clear();
+		REQUIRE(queue.enqueue(1, "a"));
+		REQUIRE(queue.enqueue(2, "b"));
+		REQUIRE(queue.enqueue(queue.getEventToken(3), 3, "c"));
+		REQUIRE(! queue.emptyQueue());
+		REQUIRE(dataList.empty());
+
+		REQUIRE(queue.process());
+		REQUIRE(queue.emptyQueue());
+		REQUIRE(dataList == std::vector<std::string>{ "1a", "2b", "3c" });
+	}
+
+	SECTION("processOne") {
+		dataList.clear();
+		queue.enqueue(1, "a");
+		queue.enqueue(2, "b");
+		REQUIRE(queue.processOne());
+		REQUIRE(dataList == std::vector<std::string>{ "1a" });
+		REQUIRE(queue.processOne());
+		REQUIRE(dataList == std::vector<std::string>{ "1a", "2b" });
+		REQUIRE(! queue.processOne());
+	}
+
+	SECTION("processIf keeps the order of the remaining events") {
+		dataList.clear();
+		queue.enqueue(1, "a");
+		queue.enqueue(2, "b");
+		queue.enqueue(3, "c");
+		queue.enqueue(1, "d");
+		queue.enqueue(2, "e");
+		REQUIRE(queue.processIf([](int e, const std::string &) -> bool {
+			return e == 2;
+		}));
+		REQUIRE(dataList == std::vector<std::string>{ "2b", "2e" });
+		REQUIRE(! queue.processIf([](int e, const std::string &) -> bool {
+			return e == 2;
+		}));
+
+		queue.enqueue(3, "f");
+		queue.process();
+		REQUIRE(dataList == std::vector<std::string>{ "2b", "2e", "1a", "3c", "1d", "3f" });
+	}
+
+	SECTION("processUntil") {
+		dataList.clear();
+		queue.enqueue(1, "a");
+		queue.enqueue(2, "b");
+		queue.enqueue(3, "c");
+		REQUIRE(queue.processUntil([](int e, const std::string &) -> bool {
+			return e == 3;
+		}));
+		REQUIRE(dataList == std::vector<std::string>{ "1a", "2b" });
+		queue.process();
+		REQUIRE(dataList == std::vector<std::string>{ "1a", "2b", "3c" });
+	}
+
+	SECTION("peekEvent, takeEvent, clearEvents") {
+		dataList.clear();
+		queue.enqueue(1, "a");
+		queue.enqueue(2, "b");
+		queue.enqueue(3, "c");
+
+		EQ::QueuedEvent queuedEvent;
+		REQUIRE(queue.peekEvent(&queuedEvent));
+		REQUIRE(queuedEvent.getEvent() == 1);
+		REQUIRE(queue.takeEvent(&queuedEvent));
+		REQUIRE(queuedEvent.getEvent() == 1);
+		REQUIRE(queuedEvent.getArgument<1>() == "a");
+		queue.dispatch(queuedEvent);
+		REQUIRE(dataList == std::vector<std::string>{ "1a" });
+
+		queue.clearEvents();
+		REQUIRE(queue.emptyQueue());
+		REQUIRE(! queue.process());
+		REQUIRE(dataList == std::vector<std::string>{ "1a" });
+	}
+}
+
+TEST_CASE("EventQueue, ring buffer, assign queue with pending EventToken events")
+{
+	struct MyPolicies
+	{
+		using EventQueueStorage = eventpp::EventQueueStorageRingBuffer<8>;
+	};
+	using EQ = eventpp::EventQueue<int, void (int, const std::string &), MyPolicies>;
+
+	std::vector<std::string> dataList;
+
+	EQ source;
+	source.appendListener(1, [&dataList](int e, const std::string & s) {
+		dataList.push_back("source" + std::to_string(e) + s);
+	});
+
+	EQ queue;
+	queue.appendListener(1, [&dataList](int e, const std::string & s) {
+		dataList.push_back("queue" + std::to_string(e) + s);
+	});
+	REQUIRE(queue.enqueue(queue.getEventToken(1), 1, "a"));
+
+	queue = std::move(source);
+	REQUIRE(queue.process());
+	REQUIRE(dataList == std::vector<std::string>{ "source1a" });
+}
+
+TEST_CASE("EventQueue, ring buffer, QueueFullFail")
+{
+	struct MyPolicies
+	{
+		using EventQueueStorage = eventpp::EventQueueStorageRingBuffer<4, eventpp::QueueFullFail>;
+	};
+	using EQ = eventpp::EventQueue<int, void (int), MyPolicies>;
+	EQ queue;
+
+	int sum = 0;
+	queue.appendListener(1, [&sum](int n) {
+		sum += n;
+	});
+
+	for(int i = 0; i < 4; ++i) {
+		REQUIRE(queue.enqueue(1, 1));
+	}
+	REQUIRE(! queue.enqueue(1, 1));
+
+	REQUIRE(queue.processOne());
+	REQUIRE(queue.enqueue(1, 1));
+	REQUIRE(! queue.enqueue(1, 1));
+
+	queue.process();
+	REQUIRE(sum == 5);
+	REQUIRE(queue.enqueue(1, 1));
+}
+
+TEST_CASE("EventQueue, ring buffer, no memory leak in queued arguments")
+{
+	struct MyPolicies
+	{
+		using EventQueueStorage = eventpp::EventQueueStorageRingBuffer<16>;
+	};
+	using EQ = eventpp::EventQueue<int, void (std::shared_ptr<int>), MyPolicies>;
+
+	std::vector<std::weak_ptr<int> > ptrList;
+	{
+		EQ queue;
+		queue.appendListener(1, [](std::shared_ptr<int>) {});
+
+		for(int i = 0; i < 10; ++i) {
+			auto ptr = std::make_shared<int>(i);
+			ptrList.push_back(ptr);
+			queue.enqueue(i & 1, ptr);
+		}
+		queue.processIf([](std::shared_ptr<int> ptr) -> bool {
+			return *ptr < 5;
+		});
+		queue.processOne();
+	}
+	REQUIRE(checkAllWeakPtrAreFreed(ptrList));
+}
+
+namespace {
+
+template <typename QueueFull>
+struct RingBufferPolicies
+{
+	using EventQueueStorage = eventpp::EventQueueStorageRingBuffer<64, QueueFull>;
+};
+
+template <typename QueueFull>
+void doTestRingBufferMultiProducers()
+{
+	using EQ = eventpp::EventQueue<int, void (int, int), RingBufferPolicies<QueueFull> >;
+	EQ queue;
+
+	constexpr int threadCount = 16;
+	constexpr int dataCountPerThread = 1024 * 8;
+	constexpr int stopEvent = 0;
+	constexpr int dataEvent = 1;
+
+	std::vector<int> lastDataList(threadCount, -1);
+	bool inOrder = true;
+	int processedCount = 0;
+	queue.appendListener(dataEvent, [&lastDataList, &inOrder, &processedCount](int thread, int data) {
+		if(data != lastDataList[thread] + 1) {
+			inOrder = false;
+		}
+		lastDataList[thread] = data;
+		++processedCount;
+	});
+	bool shouldStop = false;
+	queue.appendListener(stopEvent, [&shouldStop](int, int) {
+		shouldStop = true;
+	});
+
+	std::thread consumer([&queue, &shouldStop]() {
+		while(! shouldStop) {
+			queue.wait();
+			queue.process();
+		}
+	});
+
+	std::vector<std::thread> threadList;
+	for(int i = 0; i < threadCount; ++i) {
+		threadList.emplace_back([i, dataEvent, dataCountPerThread, &queue]() {
+			for(int k = 0; k < dataCountPerThread; ++k) {
+				queue.enqueue(dataEvent, i, k);
+			}
+		});
+	}
+	for(auto & thread : threadList) {
+		thread.join();
+	}
+	queue.enqueue(stopEvent, 0, 0);
+	consumer.join();
+
+	REQUIRE(inOrder);
+	REQUIRE(processedCount == threadCount * dataCountPerThread);
+	REQUIRE(lastDataList == std::vector<int>(threadCount, dataCountPerThread - 1));
+}
+
+} //unnamed namespace
+
+TEST_CASE("EventQueue, ring buffer, multi producers, QueueFullBlock")
+{
+	doTestRingBufferMultiProducers<eventpp::QueueFullBlock>();
+}
+
+TEST_CASE("EventQueue, ring buffer, multi producers, QueueFullSpin")
+{
+	doTestRingBufferMultiProducers<eventpp::QueueFullSpin>();
+}
+
+TEST_CASE("EventQueue, ring buffer, waitFor")
+{
+	struct MyPolicies
+	{
+		using EventQueueStorage = eventpp::EventQueueStorageRingBuffer<4>;
+	};
+	using EQ = eventpp::EventQueue<int, void (), MyPolicies>;
+	EQ queue;
+
+	REQUIRE(! queue.waitFor(std::chrono::milliseconds(10)));
+	queue.enqueue(1);
+	REQUIRE(queue.waitFor(std::chrono::milliseconds(10)));
+
+	{
+		EQ::DisableQueueNotify disableNotify(&queue);
+		REQUIRE(! queue.waitFor(std::chrono::milliseconds(10)));
+	}
+	REQUIRE(queue.waitFor(std::chrono::milliseconds(10)));
+}
+
+namespace {
+
+template <typename QueueFull>
+struct MultipleConsumersPolicies
+{
+	using EventQueueStorage = eventpp::EventQueueStorageRingBuffer<256, QueueFull, eventpp::QueueMultipleConsumers>;
+};
+
+template <typename QueueFull>
+void doTestRingBufferMultipleConsumers()
+{
+	using EQ = eventpp::EventQueue<int, void (int), MultipleConsumersPolicies<QueueFull> >;
+	EQ queue;
+
+	constexpr int producerCount = 8;
+	constexpr int consumerCount = 4;
+	constexpr int dataCountPerThread = 1024 * 8;
+	constexpr int itemCount = producerCount * dataCountPerThread;
+
+	std::vector<std::atomic<int> > hitList(itemCount);
+	std::atomic<int> processedCount(0);
+	for(int i = 0; i < producerCount; ++i) {
+		queue.appendListener(i, [&hitList, &processedCount](int index) {
+			++hitList[index];
+			++processedCount;
+		});
+	}
+
+	std::vector<std::thread> threadList;
+	for(int i = 0; i < consumerCount; ++i) {
+		threadList.emplace_back([&queue, &processedCount, itemCount]() {
+			while(processedCount.load() < itemCount) {
+				queue.waitFor(std::chrono::milliseconds(10));
+				queue.process();
+			}
+		});
+	}
+	for(int i = 0; i < producerCount; ++i) {
+		threadList.emplace_back([i, dataCountPerThread, &queue]() {
+			for(int k = i * dataCountPerThread; k < (i + 1) * dataCountPerThread; ++k) {
+				while(! queue.enqueue(i, k)) {
+				}
+			}
+		});
+	}
+	for(auto & thread : threadList) {
+		thread.join();
+	}
+
+	REQUIRE(processedCount.load() == itemCount);
+	REQUIRE(std::all_of(hitList.begin(), hitList.end(), [](const std::atomic<int> & hit) {
+		return hit.load() == 1;
+	}));
+	REQUIRE(queue.emptyQueue());
+}
+
+} //unnamed namespace
+
+TEST_CASE("EventQueue, ring buffer, multiple consumers, QueueFullBlock")
+{
+	doTestRingBufferMultipleConsumers<eventpp::QueueFullBlock>();
+}
+
+TEST_CASE("EventQueue, ring buffer, multiple consumers, QueueFullFail")
+{
+	doTestRingBufferMultipleConsumers<eventpp::QueueFullFail>();
+}
+
+TEST_CASE("EventQueue, ring buffer, multiple consumers, processOne and takeEvent")
+{
+	using EQ = eventpp::EventQueue<int, void (int), MultipleConsumersPolicies<eventpp::QueueFullBlock> >;
+	EQ queue;
+
+	int sum = 0;
+	queue.appendListener(1, [&sum](int n) {
+		sum += n;
+	});
+
+	queue.enqueue(1, 2);
+	queue.enqueue(1, 3);
+	queue.enqueue(1, 5);
+
+	REQUIRE(queue.processOne());
+	REQUIRE(sum == 2);
+
+	EQ::QueuedEvent queuedEvent;
+	REQUIRE(queue.takeEvent(&queuedEvent));
+	REQUIRE(queuedEvent.getArgument<0>() == 3);
+
+	queue.clearEvents();
+	REQUIRE(queue.emptyQueue());
+	REQUIRE(! queue.process());
+	REQUIRE(sum == 2);
+}
+
+TEST_CASE("EventQueue, ring buffer, takeEvents and peekEvents")
+{
+	struct MyPolicies
+	{
+		using EventQueueStorage = eventpp::EventQueueStorageRingBuffer<8>;
+	};
+	using EQ = eventpp::EventQueue<int, void (int), MyPolicies>;
+	EQ queue;
+
+	// Wrap around the ring.
+	for(int i = 0; i < 5; ++i) {
+		queue.enqueue(1, -1);
+	}
+	queue.clearEvents();
+
+	for(int i = 0; i < 6; ++i) {
+		REQUIRE(queue.enqueue(1, i));
+	}
+
+	int sum = 0;
+	queue.peekEvents([&sum](const EQ::QueuedEvent & event) {
+		sum += event.getArgument<0>();
+	});
+	REQUIRE(sum == 15);
+
+	std::vector<EQ::QueuedEvent> eventList;
+	REQUIRE(queue.takeEvents(std::back_inserter(eventList), 4) == 4);
+	REQUIRE(queue.takeEvents(std::back_inserter(eventList), 4) == 2);
+	REQUIRE(queue.takeEvents(std::back_inserter(eventList), 4) == 0);
+	REQUIRE(eventList.size() == 6);
+	for(int i = 0; i < 6; ++i) {
+		REQUIRE(eventList[i].getArgument<0>() == i);
+	}
+	REQUIRE(queue.emptyQueue());
+}
+
+TEST_CASE("EventQueue, ring buffer, multiple consumers, takeEvents")
+{
+	using EQ = eventpp::EventQueue<int, void (int), MultipleConsumersPolicies<eventpp::QueueFullBlock> >;
+	EQ queue;
+
+	constexpr int consumerCount = 4;
+	constexpr int itemCount = 1024 * 8;
+
+	std::vector<std::atomic<int> > hitList(itemCount);
+	std::atomic<int> takenCount(0);
+
+	std::thread producer([&queue]() {
+		for(int i = 0; i < itemCount; ++i) {
+			queue.enqueue(1, i);
+		}
+	});
+
+	std::vector<std::thread> consumerList;
+	for(int i = 0; i < consumerCount; ++i) {
+		consumerList.emplace_back([&queue, &hitList, &takenCount]() {
+			std::vector<EQ::QueuedEvent> eventList;
+			while(takenCount.load() < itemCount) {
+				eventList.clear();
+				const std::size_t count = queue.takeEvents(std::back_inserter(eventList), 20);
+				for(const EQ::QueuedEvent & event : eventList) {
+					++hitList[event.getArgument<0>()];
+				}
+				takenCount += static_cast<int>(count);
+				if(count == 0) {
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	producer.join();
+	for(std::thread & thread : consumerList) {
+		thread.join();
+	}
+
+	REQUIRE(takenCount.load() == itemCount);
+	for(int i = 0; i < itemCount; ++i) {
+		REQUIRE(hitList[i].load() == 1);
+	}
+}
+
+TEST_CASE("EventQueue, ring buffer, enqueueBulk")
+{
+	struct MyPolicies
+	{
+		using EventQueueStorage = eventpp::EventQueueStorageRingBuffer<4, eventpp::QueueFullFail>;
+	};
+	using EQ = eventpp::EventQueue<int, void (int), MyPolicies>;
+	EQ queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](int n) {
+		dataList.push_back(n);
+	});
+
+	REQUIRE(queue.enqueueBulk([](EQ::BulkEnqueuer & enqueuer) {
+		for(int i = 0; i < 3; ++i) {
+			REQUIRE(enqueuer.enqueue(1, i));
+		}
+	}) == 3);
+
+	const int eventList[] = { 1, 1, 1 };
+	REQUIRE(queue.enqueueRange(std::begin(eventList), std::end(eventList)) == 1);
+
+	queue.process();
+	REQUIRE(dataList == std::vector<int>{ 0, 1, 2, 1 });
+}
+
+TEST_CASE("EventQueue, ring buffer, enqueueBulk larger than the capacity")
+{
+	struct MyPolicies
+	{
+		using EventQueueStorage = eventpp::EventQueueStorageRingBuffer<8>;
+	};
+	using EQ = eventpp::EventQueue<int, void (int), MyPolicies>;
+	EQ queue;
+
+	constexpr int itemCount = 1000;
+	int sum = 0;
+	int processedCount = 0;
+	queue.appendListener(1, [&sum, &processedCount](int n) {
+		sum += n;
+		++processedCount;
+	});
+
+	// The consumer only processes after it's notified, so the producer must
+	// notify it before blocking on the full queue.
+	std::thread consumer([&queue, &processedCount, itemCount]() {
+		while(processedCount < itemCount) {
+			queue.wait();
+			queue.process();
+		}
+	});
+
+	std::vector<int> dataList(itemCount);
+	std::iota(dataList.begin(), dataList.end(), 0);
+	REQUIRE(queue.enqueueBulk([&dataList](EQ::BulkEnqueuer & enqueuer) {
+		for(int n : dataList) {
+			enqueuer.enqueue(1, n);
+		}
+	}) == itemCount);
+	consumer.join();
+
+	REQUIRE(sum == itemCount * (itemCount - 1) / 2);
+}
+
+TEST_CASE("EventQueue, ring buffer, processN and processFor")
+{
+	struct MyPolicies
+	{
+		using EventQueueStorage = eventpp::EventQueueStorageRingBuffer<8>;
+	};
+	using EQ = eventpp::EventQueue<int, void (int), MyPolicies>;
+	EQ queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](int n) {
+		dataList.push_back(n);
+	});
+
+	for(int i = 0; i < 5; ++i) {
+		queue.enqueue(1, i);
+	}
+	REQUIRE(! queue.processN(0));
+	REQUIRE(queue.processN(3));
+	REQUIRE(dataList == std::vector<int>{ 0, 1, 2 });
+
+	queue.enqueue(1, 5);
+	REQUIRE(queue.processFor(std::chrono::seconds(10)));
+	REQUIRE(dataList == std::vector<int>{ 0, 1, 2, 3, 4, 5 });
+	REQUIRE(queue.emptyQueue());
+}
+
+TEST_CASE("EventQueue, ring buffer, multiple consumers, processN")
+{
+	using EQ = eventpp::EventQueue<int, void (int), MultipleConsumersPolicies<eventpp::QueueFullBlock> >;
+	EQ queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(1, [&dataList](int n) {
+		dataList.push_back(n);
+	});
+
+	for(int i = 0; i < 40; ++i) {
+		queue.enqueue(1, i);
+	}
+	REQUIRE(queue.processN(20));
+	REQUIRE(dataList.size() == 20);
+	REQUIRE(queue.processN(100));
+	REQUIRE(dataList.size() == 40);
+}
@@ -0,0 +1,271 @@
+// eventpp library
+// Copyright (C) 2018 Wang Qi (wqking)
+// Github: https://github.com/wqking/eventpp
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//   http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test.h"
+#include "eventpp/eventqueue.h"
+
+#include <thread>
+#include <random>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <iterator>
+
+TEST_CASE("TimingWheel, items expire at their ticks")
+{
+	using Wheel = eventpp::internal_::TimingWheel<std::uint64_t>;
+	Wheel wheel;
+
+	std::mt19937_64 engine(5);
+	std::vector<std::uint64_t> tickList;
+	for(int i = 0; i < 1024 * 4; ++i) {
+		// Cover all levels, and the ticks beyond the range of the wheel.
+		const unsigned int bits = 1 + (unsigned int)(engine() % 34);
+		tickList.push_back(engine() % (std::uint64_t(1) << bits));
+	}
+	for(const std::uint64_t tick : tickList) {
+		wheel.add(tick, std::uint64_t(tick));
+	}
+
+	std::uint64_t expiredCount = 0;
+	std::uint64_t lastTick = 0;
+	std::uint64_t now = 0;
+	while(! wheel.empty()) {
+		const std::uint64_t dueTick = wheel.getDueTick();
+		REQUIRE(dueTick != Wheel::noTick);
+		REQUIRE(dueTick >= wheel.getNextTick());
+		// The due tick is not after the earliest item.
+		now = dueTick;
+		wheel.advance(now, [&expiredCount, &lastTick, now](std::uint64_t && tick) {
+			REQUIRE(tick <= now);
+			REQUIRE(tick >= lastTick);
+			// Nothing is expired late.
+			REQUIRE(tick == now);
+			lastTick = tick;
+			++expiredCount;
+		});
+	}
+	REQUIRE(expiredCount == tickList.size());
+	REQUIRE(wheel.getDueTick() == Wheel::noTick);
+}
+
+TEST_CASE("TimingWheel, cancel")
+{
+	using Wheel = eventpp::internal_::TimingWheel<int>;
+	Wheel wheel;
+
+	Wheel::Handle a = wheel.add(10, 1);
+	Wheel::Handle b = wheel.add(10, 2);
+	Wheel::Handle c = wheel.add(1000, 3);
+	REQUIRE(a);
+	REQUIRE(! Wheel::Handle());
+
+	REQUIRE(wheel.cancel(b));
+	REQUIRE(! wheel.cancel(b));
+
+	std::vector<int> dataList;
+	wheel.advance(100, [&dataList](int && n) {
+		dataList.push_back(n);
+	});
+	REQUIRE(dataList == std::vector<int> { 1 });
+	// a is expired, its node may be reused by d, the handle must not cancel d.
+	REQUIRE(! wheel.cancel(a));
+	Wheel::Handle d = wheel.add(200, 4);
+	REQUIRE(! wheel.cancel(a));
+
+	REQUIRE(wheel.cancel(c));
+	wheel.advance(1000, [&dataList](int && n) {
+		dataList.push_back(n);
+	});
+	REQUIRE(dataList == std::vector<int> { 1, 4 });
+	REQUIRE(! wheel.cancel(d));
+	REQUIRE(wheel.empty());
+}
+
+TEST_CASE("EventQueue, enqueueAfter and enqueueAt")
+{
+	using EQ = eventpp::EventQueue<int, void (int)>;
+	EQ queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(3, [&dataList](const int n) {
+		dataList.push_back(n);
+	});
+
+	queue.enqueueAfter(std::chrono::milliseconds(60), 3, 2);
+	queue.enqueueAfter(std::chrono::milliseconds(30), 3, 1);
+	// A time point in the past is enqueued at once.
+	queue.enqueueAt(std::chrono::steady_clock::now() - std::chrono::seconds(1), 3, 0);
+	REQUIRE(! queue.emptyQueue());
+	REQUIRE(queue.process());
+	REQUIRE(dataList == std::vector<int> { 0 });
+
+	REQUIRE(! queue.process());
+	REQUIRE(queue.emptyQueue());
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	REQUIRE(queue.process());
+	REQUIRE(dataList == std::vector<int> { 0, 1, 2 });
+}
+
+TEST_CASE("EventQueue, cancelTimer")
+{
+	using EQ = eventpp::EventQueue<int, void (int)>;
+	EQ queue;
+
+	std::vector<int> dataList;
+	queue.appendListener(3, [&dataList](const int n) {
+		dataList.push_back(n);
+	});
+
+	REQUIRE(! queue.cancelTimer(EQ::TimerHandle()));
+
+	EQ::TimerHandle a = queue.enqueueAfter(std::chrono::milliseconds(10), 3, 1);
+	EQ::TimerHandle b = queue.enqueueAfter(std::chrono::milliseconds(10), 3, 2);
+	REQUIRE(a);
+	REQUIRE(queue.cancelTimer(b));
+	REQUIRE(! queue.cancelTimer(b));
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(30));
+	REQUIRE(queue.processOne());
+	REQUIRE(dataList == std::vector<int> { 1 });
+	REQUIRE(! queue.cancelTimer(a));
+	REQUIRE(! queue.processOne());
+}
+
+TEST_CASE("EventQueue, waitFor returns when a delayed event is due")
+{
+	using EQ = eventpp::EventQueue<int, void (int)>;
+	EQ queue;
+
+	int sum = 0;
+	queue.appendListener(3, [&sum](const int n) {
+		sum += n;
+	});
+
+	REQUIRE(! queue.waitFor(std::chrono::milliseconds(10)));
+
+	queue.enqueueAfter(std::chrono::milliseconds(30), 3, 5);
+	const auto start = std::chrono::steady_clock::now();
+	while(! queue.process()) {
+		REQUIRE(queue.waitFor(std::chrono::seconds(10)));
+	}
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+	REQUIRE(sum == 5);
+	REQUIRE(elapsed >= std::chrono::milliseconds(25));
+	REQUIRE(elapsed < std::chrono::seconds(5));
+}
+
+TEST_CASE("EventQueue, takeEvent after waitFor gets the due delayed event")
+{
+	using EQ = eventpp::EventQueue<int, void (int)>;
+	EQ queue;
+
+	queue.enqueueAfter(std::chrono::milliseconds(20), 3, 5);
+	REQUIRE(queue.emptyQueue());
+
+	// waitFor returns true when the event is due, takeEvent must see it, or the loop spins.
+	EQ::QueuedEvent queuedEvent;
+	int waitCount = 0;
+	while(! queue.takeEvent(&queuedEvent)) {
+		REQUIRE(queue.waitFor(std::chrono::seconds(10)));
+		++waitCount;
+		REQUIRE(waitCount < 1000);
+	}
+	REQUIRE(queuedEvent.getEvent() == 3);
+	REQUIRE(queuedEvent.getArgument<0>() == 5);
+	REQUIRE(queue.emptyQueue());
+
+	// A due event is not in the queue yet, but the queue is not empty.
+	queue.enqueueAfter(std::chrono::milliseconds(1), 3, 6);
+	queue.enqueueAfter(std::chrono::milliseconds(1), 3, 7);
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	REQUIRE(! queue.emptyQueue());
+	std::vector<int> dataList;
+	queue.peekEvents([&dataList](const EQ::QueuedEvent & event) {
+		dataList.push_back(event.getArgument<0>());
+	});
+	REQUIRE(dataList == std::vector<int> { 6, 7 });
+
+	std::vector<EQ::QueuedEvent> eventList;
+	REQUIRE(queue.takeEvents(std::back_inserter(eventList), 10) == 2);
+	REQUIRE(queue.emptyQueue());
+
+	int sum = 0;
+	queue.appendListener(3, [&sum](const int n) {
+		sum += n;
+	});
+	queue.enqueueAfter(std::chrono::milliseconds(1), 3, 8);
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	REQUIRE(queue.processUntil([]() -> bool { return false; }));
+	REQUIRE(sum == 8);
+}
+
+TEST_CASE("EventQueue, enqueueAfter wakes up the waiting thread")
+{
+	using EQ = eventpp::EventQueue<int, void (int)>;
+	EQ queue;
+
+	std::atomic<int> sum(0);
+	queue.appendListener(3, [&sum](const int n) {
+		sum += n;
+	});
+
+	std::thread thread([&queue, &sum]() {
+		while(sum.load() < 3) {
+			queue.wait();
+			queue.process();
+		}
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	// The thread is waiting without a deadline, the first delayed event must wake it up.
+	queue.enqueueAfter(std::chrono::milliseconds(20), 3, 1);
+	queue.enqueueAfter(std::chrono::milliseconds(10), 3, 2);
+	thread.join();
+
+	REQUIRE(sum == 3);
+}
+
+TEST_CASE("EventQueue, many delayed events")
+{
+	using EQ = eventpp::EventQueue<int, void (int)>;
+	EQ queue;
+
+	constexpr int count = 1000 * 100;
+	int processedCount = 0;
+	queue.appendListener(3, [&processedCount](int) {
+		++processedCount;
+	});
+
+	std::vector<EQ::TimerHandle> handleList;
+	for(int i = 0; i < count; ++i) {
+		handleList.push_back(queue.enqueueAfter(std::chrono::milliseconds(i % 50), 3, i));
+	}
+	// The events due at once are not delayed, and can't be cancelled.
+	int cancelledCount = 0;
+	for(int i = 0; i < count; i += 2) {
+		if(queue.cancelTimer(handleList[i])) {
+			++cancelledCount;
+		}
+	}
+	REQUIRE(cancelledCount >= count / 2 - 100);
+
+	const auto start = std::chrono::steady_clock::now();
+	while(processedCount < count - cancelledCount && std::chrono::steady_clock::now() - start < std::chrono::seconds(10)) {
+		queue.waitFor(std::chrono::milliseconds(100));
+		queue.process();
+	}
+	REQUIRE(processedCount == count - cancelledCount);
+	REQUIRE(! queue.process());
+}